@@ -0,0 +1,217 @@
+#include "activos.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+#include "archivo_mapeado.h"
+#include "hash.h"
+
+using namespace std;
+
+AlmacenActivos::AlmacenActivos(const string& dir, unsigned numeroHilos)
+    : directorio(dir), archivoCache((filesystem::path(dir) / ".cache_activos").string()),
+      hilos(numeroHilos != 0 ? numeroHilos : max(1u, thread::hardware_concurrency())),
+      cacheModificada(false) {
+    cargarCache();
+}
+
+// Formato: una linea por imagen con "hash<TAB>tamano<TAB>modificacion<TAB>ruta".
+// Las lineas que no se entienden se saltan: esa imagen se vuelve a hashear.
+void AlmacenActivos::cargarCache() {
+    ifstream archivo(archivoCache);
+    string linea;
+    while (getline(archivo, linea)) {
+        istringstream campos(linea);
+        string hash, ruta;
+        EntradaCacheActivo entrada;
+        if (getline(campos, hash, '\t') && campos >> entrada.tamano && campos.get() == '\t' &&
+            campos >> entrada.modificacion && campos.get() == '\t' && getline(campos, ruta)) {
+            size_t fin = 0;
+            try {
+                entrada.hash = stoull(hash, &fin, 16);
+            } catch (const exception&) {
+                continue;
+            }
+            if (fin != hash.size() || hash.size() > 16) continue;
+            cache[ruta] = entrada;
+        }
+    }
+}
+
+void AlmacenActivos::guardarCache() {
+    lock_guard<mutex> bloqueo(cerrojo);
+    if (!cacheModificada) return;
+
+    filesystem::create_directories(directorio);
+    string temporal = archivoCache + ".tmp";
+    {
+        ofstream archivo(temporal);
+        if (!archivo.is_open()) {
+            throw runtime_error("No se pudo escribir la cache de activos: " + archivoCache);
+        }
+        for (const auto& item : cache) {
+            archivo << hashHex(item.second.hash) << '\t' << item.second.tamano << '\t'
+                    << item.second.modificacion << '\t' << item.first << '\n';
+        }
+    }
+    filesystem::rename(temporal, archivoCache);
+    cacheModificada = false;
+}
+
+namespace {
+
+// Copia 'origen' en 'destino' (que no existe) compartiendo los bloques de
+// datos (reflink) si el sistema de archivos lo admite; devuelve false si no.
+bool clonarArchivo(const string& origen, const string& destino) {
+#if defined(__linux__) && defined(FICLONE)
+    int entrada = open(origen.c_str(), O_RDONLY | O_CLOEXEC);
+    if (entrada < 0) return false;
+    int salida = open(destino.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (salida < 0) {
+        close(entrada);
+        return false;
+    }
+    bool clonado = ioctl(salida, FICLONE, entrada) == 0;
+    close(entrada);
+    close(salida);
+    if (!clonado) unlink(destino.c_str());
+    return clonado;
+#else
+    (void)origen;
+    (void)destino;
+    return false;
+#endif
+}
+
+} // namespace
+
+// Coloca el contenido de 'origen' en 'destino' si todavia no existe,
+// copiandolo (o clonandolo con reflink) a un temporal que se renombra de
+// forma atomica. Nunca con un hardlink: el activo compartiria el inodo de la
+// imagen y editarla en su sitio cambiaria un archivo que se nombra por su
+// hash. Un activo con mas de un enlace (publicado asi por una version
+// anterior) se separa de la imagen de la misma manera.
+void AlmacenActivos::publicar(const string& origen, const string& destino) {
+    error_code error;
+    string fuente = origen;
+    if (filesystem::exists(destino, error)) {
+        if (filesystem::hard_link_count(destino, error) <= 1 || error) return;
+        fuente = destino;
+    }
+
+    ostringstream temporal;
+    temporal << destino << ".tmp" << this_thread::get_id();
+    bool clonado = clonarArchivo(fuente, temporal.str());
+    if (!clonado) {
+        filesystem::copy_file(fuente, temporal.str(), filesystem::copy_options::overwrite_existing);
+    }
+    filesystem::rename(temporal.str(), destino);
+
+    lock_guard<mutex> bloqueo(cerrojo);
+    if (clonado) {
+        estadisticas.clonados++;
+    } else {
+        estadisticas.copiados++;
+    }
+}
+
+vector<string> AlmacenActivos::resolver(const vector<string>& rutas) {
+    vector<string> claves(rutas.size());
+    vector<EntradaCacheActivo> entradas(rutas.size());
+    vector<size_t> porHashear;
+
+    // Tamano y fecha de cada imagen; solo se leen las que cambiaron
+    for (size_t i = 0; i < rutas.size(); i++) {
+        error_code error;
+        claves[i] = filesystem::absolute(rutas[i], error).lexically_normal().string();
+        entradas[i].tamano = filesystem::file_size(rutas[i], error);
+        if (error) {
+            throw runtime_error("No se encontro la imagen: " + rutas[i]);
+        }
+        entradas[i].modificacion = static_cast<long long>(
+            filesystem::last_write_time(rutas[i], error).time_since_epoch().count());
+
+        lock_guard<mutex> bloqueo(cerrojo);
+        auto it = cache.find(claves[i]);
+        if (it != cache.end() && it->second.tamano == entradas[i].tamano &&
+            it->second.modificacion == entradas[i].modificacion) {
+            entradas[i].hash = it->second.hash;
+            estadisticas.desdeCache++;
+        } else {
+            porHashear.push_back(i);
+        }
+    }
+
+    // Hash del contenido en paralelo
+    if (!porHashear.empty()) {
+        atomic<size_t> siguiente(0);
+        mutex cerrojoError;
+        exception_ptr primerError;
+
+        auto trabajador = [&]() {
+            for (size_t k = siguiente++; k < porHashear.size(); k = siguiente++) {
+                size_t i = porHashear[k];
+                try {
+                    ArchivoMapeado archivo(rutas[i]);
+                    entradas[i].hash = hashContenido(archivo.contenido());
+                } catch (...) {
+                    lock_guard<mutex> bloqueo(cerrojoError);
+                    if (!primerError) primerError = current_exception();
+                }
+            }
+        };
+
+        unsigned numero = min<unsigned>(hilos, static_cast<unsigned>(porHashear.size()));
+        vector<thread> trabajadores;
+        for (unsigned i = 1; i < numero; i++) {
+            trabajadores.emplace_back(trabajador);
+        }
+        trabajador();
+        for (auto& t : trabajadores) {
+            t.join();
+        }
+        if (primerError) {
+            rethrow_exception(primerError);
+        }
+
+        lock_guard<mutex> bloqueo(cerrojo);
+        for (size_t i : porHashear) {
+            cache[claves[i]] = entradas[i];
+            estadisticas.hasheados++;
+            estadisticas.bytesHasheados += entradas[i].tamano;
+        }
+        cacheModificada = true;
+    }
+
+    filesystem::create_directories(directorio);
+
+    vector<string> resultado(rutas.size());
+    for (size_t i = 0; i < rutas.size(); i++) {
+        string extension = filesystem::path(rutas[i]).extension().string();
+        transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        resultado[i] = (filesystem::path(directorio) / (hashHex(entradas[i].hash) + extension)).string();
+        publicar(rutas[i], resultado[i]);
+    }
+
+    lock_guard<mutex> bloqueo(cerrojo);
+    estadisticas.resueltos += rutas.size();
+    return resultado;
+}
+
+EstadisticasActivos AlmacenActivos::getEstadisticas() {
+    lock_guard<mutex> bloqueo(cerrojo);
+    return estadisticas;
+}
@@ -0,0 +1,73 @@
+#ifndef ACTIVOS_H
+#define ACTIVOS_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// ===============================
+// ALMACEN DE ACTIVOS (IMAGENES DE FIGURAS)
+// ===============================
+//
+// Las imagenes referenciadas por figura() se copian a un directorio de
+// activos compartido con el nombre <hash del contenido>.<extension>, asi que
+// un mismo archivo usado por muchos documentos se guarda una sola vez. Se
+// clona (reflink) cuando el sistema de archivos lo permite y se copia si no;
+// nunca se enlaza con un hardlink, que cambiaria al editar la imagen.
+//
+// Una cache persistente (ruta -> tamano, fecha de modificacion, hash) evita
+// volver a leer las imagenes que no cambiaron entre ejecuciones.
+
+struct EntradaCacheActivo {
+    uintmax_t tamano = 0;
+    long long modificacion = 0;
+    uint64_t hash = 0;
+};
+
+struct EstadisticasActivos {
+    size_t resueltos = 0;
+    size_t desdeCache = 0;
+    size_t hasheados = 0;
+    uintmax_t bytesHasheados = 0;
+    size_t clonados = 0;
+    size_t copiados = 0;
+};
+
+class AlmacenActivos {
+private:
+    string directorio;
+    string archivoCache;
+    unsigned hilos;
+
+    mutex cerrojo;
+    unordered_map<string, EntradaCacheActivo> cache;
+    EstadisticasActivos estadisticas;
+    bool cacheModificada;
+
+    void cargarCache();
+    void publicar(const string& origen, const string& destino);
+
+public:
+    // directorio: carpeta de activos compartida; hilos: hilos para calcular
+    // hashes en paralelo (0 = uno por nucleo).
+    explicit AlmacenActivos(const string& directorio, unsigned hilos = 0);
+
+    // Devuelve, para cada ruta de imagen, la ruta del activo publicado en el
+    // directorio compartido. Lanza runtime_error si una imagen no existe.
+    vector<string> resolver(const vector<string>& rutas);
+
+    // Persiste la cache de tamano/fecha/hash para la siguiente ejecucion.
+    void guardarCache();
+
+    const string& getDirectorio() const {
+        return directorio;
+    }
+
+    EstadisticasActivos getEstadisticas();
+};
+
+#endif
@@ -0,0 +1,362 @@
+#ifndef ANALIZADOR_LEXICO_H
+#define ANALIZADOR_LEXICO_H
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tabla_simbolos.h"
+#include "token.h"
+#include "utf8.h"
+
+using namespace std;
+
+// ===============================
+// ANALIZADOR LEXICO
+// ===============================
+
+class AnalizadorLexico {
+private:
+    string entrada;
+    size_t posicion;
+    int linea;
+    int columna;
+    TablaSimbolos tablaSimbolos;
+    string palabraPlegada; // bufer de plegarPalabra, reutilizado
+
+    char mirarSiguiente() {
+        return posicion < entrada.length() ? entrada[posicion] : '\0';
+    }
+
+    // Las columnas cuentan caracteres: los bytes de continuacion UTF-8
+    // (10xxxxxx) no avanzan la columna.
+    static bool iniciaCaracter(char c) {
+        return (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+    }
+
+    char avanzar() {
+        if (posicion >= entrada.length()) return '\0';
+        char c = entrada[posicion++];
+        if (c == '\n') {
+            linea++;
+            columna = 1;
+        } else if (iniciaCaracter(c)) {
+            columna++;
+        }
+        return c;
+    }
+
+    // Avanza hasta 'fin' actualizando linea y columna.
+    void avanzarHasta(size_t fin) {
+        while (posicion < fin) {
+            char c = entrada[posicion++];
+            if (c == '\n') {
+                linea++;
+                columna = 1;
+            } else if (iniciaCaracter(c)) {
+                columna++;
+            }
+        }
+    }
+
+    void saltarEspacios() {
+        while (isspace(static_cast<unsigned char>(mirarSiguiente())) && mirarSiguiente() != '\n') {
+            avanzar();
+        }
+    }
+
+    // Bytes de la letra, digito o '_' que empieza en 'pos'; 0 si no hay.
+    // Solo los bytes altos se decodifican como UTF-8.
+    size_t longitudCaracterPalabra(size_t pos) const {
+        if (pos >= entrada.length()) return 0;
+        unsigned char c = static_cast<unsigned char>(entrada[pos]);
+        if (c < 0x80) return isalnum(c) || c == '_' ? 1 : 0;
+        size_t longitud;
+        return esLetraUtf8(decodificarUtf8(entrada, pos, longitud)) ? longitud : 0;
+    }
+
+    bool iniciaPalabra(size_t pos) const {
+        if (pos >= entrada.length()) return false;
+        unsigned char c = static_cast<unsigned char>(entrada[pos]);
+        if (c < 0x80) return isalpha(c) || c == '_';
+        return longitudCaracterPalabra(pos) > 0;
+    }
+
+    // Lee una palabra (letras, digitos y '_') desde la posicion actual. La
+    // vista apunta a la entrada: vale hasta el proximo reiniciar().
+    string_view leerPalabra() {
+        size_t inicio = posicion;
+        size_t fin = posicion;
+        while (size_t longitud = longitudCaracterPalabra(fin)) {
+            fin += longitud;
+        }
+        avanzarHasta(fin);
+        return string_view(entrada).substr(inicio, fin - inicio);
+    }
+
+    const Atributos* buscarPalabraClave(string_view palabra) {
+        plegarPalabra(palabra, palabraPlegada);
+        return tablaSimbolos.BuscarPalabraClave(palabraPlegada);
+    }
+
+    void saltarComentario() {
+        while (mirarSiguiente() != '\n' && mirarSiguiente() != '\0') {
+            avanzar();
+        }
+    }
+
+    Token leerCadena() {
+        avanzar(); // saltar comilla inicial
+        string valor;
+        int lineaInicio = linea;
+        int columnaInicio = columna;
+
+        while (mirarSiguiente() != '"' && mirarSiguiente() != '\0') {
+            if (mirarSiguiente() == '\\') {
+                avanzar(); // saltar barra invertida
+                switch (mirarSiguiente()) {
+                    case 'n': valor += '\n'; break;
+                    case 't': valor += '\t'; break;
+                    case '"': valor += '"'; break;
+                    case '\\': valor += '\\'; break;
+                    default: valor += '\\'; valor += mirarSiguiente(); break;
+                }
+                avanzar();
+            } else {
+                // Copiar de una vez el tramo hasta la siguiente comilla o escape
+                size_t fin = entrada.find_first_of(string("\"\\\0", 3), posicion);
+                if (fin == string::npos) fin = entrada.length();
+                valor.append(entrada, posicion, fin - posicion);
+                avanzarHasta(fin);
+            }
+        }
+
+        if (mirarSiguiente() == '"') {
+            avanzar();
+        } else {
+            throw runtime_error("Cadena sin cerrar en linea " + to_string(lineaInicio));
+        }
+
+        return Token(TipoToken::CADENA, move(valor), lineaInicio, columnaInicio);
+    }
+
+    Token leerIdentificador() {
+        int lineaInicio = linea;
+        int columnaInicio = columna;
+        string_view valor = leerPalabra();
+
+        // Minusculas y sin tildes: "Sección" es la palabra clave seccion
+        if (const Atributos* attr = buscarPalabraClave(valor)) {
+            return Token(static_cast<TipoToken>(attr->token), string(valor), lineaInicio, columnaInicio);
+        }
+
+        // Si no es palabra clave, es identificador
+        tablaSimbolos.Insertar(valor, static_cast<int>(TipoToken::IDENTIFICADOR), "identificador", "nulo", "no_asignado");
+        return Token(TipoToken::IDENTIFICADOR, string(valor), lineaInicio, columnaInicio);
+    }
+
+    Token leerNumero() {
+        string valor;
+        int lineaInicio = linea;
+        int columnaInicio = columna;
+
+        while (isdigit(static_cast<unsigned char>(mirarSiguiente())) || mirarSiguiente() == '.') {
+            valor += avanzar();
+        }
+
+        tablaSimbolos.Insertar(valor, static_cast<int>(TipoToken::NUMERO), "numero", valor, "asignado");
+        return Token(TipoToken::NUMERO, move(valor), lineaInicio, columnaInicio);
+    }
+
+    // El texto es un tramo contiguo de la entrada: se recorre sin copiar y
+    // se copia una sola vez al final.
+    Token leerTextoSimple() {
+        size_t inicio = posicion;
+        int lineaInicio = linea;
+        int columnaInicio = columna;
+
+        while (mirarSiguiente() != ';' && mirarSiguiente() != '\n' && mirarSiguiente() != '\0') {
+            if (iniciaPalabra(posicion)) {
+                size_t posicionGuardada = posicion;
+                int lineaGuardada = linea;
+                int columnaGuardada = columna;
+
+                string_view posiblePalabraClave = leerPalabra();
+
+                // Una palabra clave solo corta el texto cuando inicia una
+                // sentencia, p. ej. "parrafo uno negrita(...)"; dentro de una
+                // frase ("un parrafo sin comillas") se conserva como texto.
+                if (buscarPalabraClave(posiblePalabraClave) != nullptr && iniciaSentencia()) {
+                    posicion = posicionGuardada;
+                    linea = lineaGuardada;
+                    columna = columnaGuardada;
+                    break;
+                }
+            } else {
+                // El caracter entero: un byte de continuacion UTF-8 no debe
+                // tomarse como el inicio de una palabra
+                size_t longitud;
+                decodificarUtf8(entrada, posicion, longitud);
+                avanzarHasta(posicion + longitud);
+            }
+        }
+
+        size_t fin = posicion;
+        while (fin > inicio && isspace(static_cast<unsigned char>(entrada[fin - 1]))) {
+            fin--;
+        }
+        string valor = entrada.substr(inicio, fin - inicio);
+
+        if (!valor.empty()) {
+            tablaSimbolos.Insertar(valor, static_cast<int>(TipoToken::TEXTO_SIMPLE), "texto", valor, "asignado");
+        }
+
+        return Token(TipoToken::TEXTO_SIMPLE, move(valor), lineaInicio, columnaInicio);
+    }
+
+    static bool aceptaTextoSimple(TipoToken tipo) {
+        return tipo == TipoToken::PARRAFO || tipo == TipoToken::NEGRITA ||
+               tipo == TipoToken::CURSIVA || tipo == TipoToken::SUBRAYADO ||
+               tipo == TipoToken::TACHADO || tipo == TipoToken::ELEMENTO;
+    }
+
+    bool iniciaSentencia() const {
+        size_t i = posicion;
+        while (i < entrada.length() && (entrada[i] == ' ' || entrada[i] == '\t')) {
+            i++;
+        }
+        return i < entrada.length() && (entrada[i] == '(' || entrada[i] == ';');
+    }
+
+    static bool esElemento(char c) {
+        return c != '\0' && strchr("(){}[]=,;.%$&", c) != nullptr;
+    }
+
+public:
+    // La entrada se mueve al analizador: quien ya no la necesita la pasa
+    // con move() y no se copia.
+    AnalizadorLexico(string entrada)
+        : entrada(move(entrada)), posicion(0), linea(1), columna(1) {
+
+        // Inicializar tabla de simbolos con palabras reservadas y simbolos
+        for (const PalabraReservada& palabra : PALABRAS_RESERVADAS) {
+            tablaSimbolos.Insertar(palabra.lexema, static_cast<int>(palabra.tipo), "pclave", "-", "-");
+        }
+        for (const PalabraReservada& simbolo : SIMBOLOS) {
+            tablaSimbolos.Insertar(simbolo.lexema, static_cast<int>(simbolo.tipo), "pclave", "-", "-");
+        }
+        tablaSimbolos.FijarEntradas();
+    }
+
+    // Reutiliza el analizador (y su tabla de simbolos) sobre otro texto. El
+    // editor interactivo relexa asi solo las lineas que cambian. El texto se
+    // copia sobre la capacidad que ya tenia la entrada.
+    void reiniciar(string_view texto) {
+        entrada.assign(texto.data(), texto.size());
+        posicion = 0;
+        linea = 1;
+        columna = 1;
+    }
+
+    // Deja en la tabla de simbolos solo las palabras clave y los simbolos,
+    // para empezar otro documento (ContextoCompilacion).
+    void vaciarTablaSimbolos() {
+        tablaSimbolos.Vaciar();
+    }
+
+    // Libera la copia de la entrada, p. ej. tras analizar un documento
+    // grande que no conviene retener hasta el proximo.
+    void liberarEntrada() {
+        string().swap(entrada);
+        posicion = 0;
+    }
+
+    // Lanza runtime_error si la entrada no es UTF-8 valido (p. ej. un archivo
+    // guardado en Latin-1/ANSI) o tiene una cadena sin cerrar.
+    vector<Token> analizar() {
+        vector<Token> tokens;
+        analizar(tokens);
+        return tokens;
+    }
+
+    // Igual, pero deja los tokens en 'tokens' (que se vacia antes) y
+    // aprovecha su capacidad.
+    void analizar(vector<Token>& tokens) {
+        tokens.clear();
+
+        ValidacionUtf8 validacion = validarUtf8(entrada);
+        if (validacion.invalido != string_view::npos) {
+            avanzarHasta(validacion.invalido);
+            throw runtime_error("Texto no valido en UTF-8 en linea " + to_string(linea) + ", columna " +
+                                to_string(columna) + " (guarde el archivo con codificacion UTF-8)");
+        }
+        // Marca de orden de bytes que agregan algunos editores de Windows
+        if (posicion == 0 && entrada.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+            posicion = 3;
+        }
+
+        while (posicion < entrada.length()) {
+            saltarEspacios();
+
+            char c = mirarSiguiente();
+            if (c == '\0') break;
+
+            int lineaActual = linea;
+            int columnaActual = columna;
+
+            if (c == '"') {
+                tokens.push_back(leerCadena());
+            } else if (iniciaPalabra(posicion)) {
+                tokens.push_back(leerIdentificador());
+                // parrafo Texto sin comillas; -> el resto es TEXTO_SIMPLE
+                if (aceptaTextoSimple(tokens.back().tipo)) {
+                    saltarEspacios();
+                    char siguiente = mirarSiguiente();
+                    if (siguiente != '(' && siguiente != ';' && siguiente != '\n' && siguiente != '\0') {
+                        Token tokenTexto = leerTextoSimple();
+                        if (!tokenTexto.valor.empty()) {
+                            tokens.push_back(move(tokenTexto));
+                        }
+                    }
+                }
+            } else if (isdigit(static_cast<unsigned char>(c))) {
+                tokens.push_back(leerNumero());
+            } else if (c == '%') {
+                saltarComentario();
+            } else if (esElemento(c)) {
+                if (const Atributos* attr = tablaSimbolos.BuscarPalabraClave(string_view(&c, 1))) {
+                    tokens.emplace_back(static_cast<TipoToken>(attr->token), string(1, c), lineaActual, columnaActual);
+                    avanzar();
+                } else {
+                    avanzar();
+                }
+            } else if (c == '\n') {
+                avanzar();
+            } else {
+                Token tokenTexto = leerTextoSimple();
+                if (!tokenTexto.valor.empty()) {
+                    tokens.push_back(move(tokenTexto));
+                } else {
+                    avanzar();
+                }
+            }
+        }
+
+        tokens.emplace_back(TipoToken::FIN_ARCHIVO, "", linea, columna);
+    }
+
+    void mostrarTablaSimbolos(ostream& os) {
+        tablaSimbolos.Mostrar(os);
+    }
+
+    TablaSimbolos& getTablaSimbolos() {
+        return tablaSimbolos;
+    }
+};
+
+#endif
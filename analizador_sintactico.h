@@ -0,0 +1,595 @@
+#ifndef ANALIZADOR_SINTACTICO_H
+#define ANALIZADOR_SINTACTICO_H
+
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ast.h"
+#include "diagnostico.h"
+#include "token.h"
+
+using namespace std;
+
+// ===============================
+// ANALIZADOR SINTACTICO CON TABLA DE TRANSICIONES
+// ===============================
+
+class AnalizadorSintactico {
+private:
+    vector<Token> tokens;
+    size_t actual;
+    int estado;
+    bool moverCadenas = false;
+    int tTransicion[100][100];
+    vector<Diagnostico> diagnosticos;
+
+    void inicializarTablaTransiciones() {
+        // Inicializar toda la tabla con ERROR
+        for (int i = 0; i < 100; i++) {
+            for (int j = 0; j < 100; j++) {
+                tTransicion[i][j] = ERROR_SINTACTICO;
+            }
+        }
+
+        // ===============================
+        // TABLA DE TRANSICIONES - ESTILO INGENIERO
+        // ===============================
+
+        // documento_inicio ;
+        tTransicion[0][static_cast<int>(TipoToken::DOCUMENTO_INICIO)] = 1;
+        tTransicion[1][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+
+        // titulo|autor|fecha ("texto") ;
+        tTransicion[2][static_cast<int>(TipoToken::TITULO)] = 3;
+        tTransicion[2][static_cast<int>(TipoToken::AUTOR)] = 3;
+        tTransicion[2][static_cast<int>(TipoToken::FECHA)] = 3;
+        tTransicion[3][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 4;
+        tTransicion[4][static_cast<int>(TipoToken::CADENA)] = 5;
+        tTransicion[5][static_cast<int>(TipoToken::PARENTESIS_DER)] = 6;
+        tTransicion[6][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+
+        // configurar ("clave", "valor") ;
+        tTransicion[2][static_cast<int>(TipoToken::CONFIGURAR)] = 7;
+        tTransicion[7][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 8;
+        tTransicion[8][static_cast<int>(TipoToken::CADENA)] = 9;
+        tTransicion[9][static_cast<int>(TipoToken::COMA)] = 10;
+        tTransicion[10][static_cast<int>(TipoToken::CADENA)] = 11;
+        tTransicion[11][static_cast<int>(TipoToken::PARENTESIS_DER)] = 12;
+        tTransicion[12][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+
+        // seccion|subseccion|etc ("titulo") ;
+        tTransicion[2][static_cast<int>(TipoToken::SECCION)] = 13;
+        tTransicion[2][static_cast<int>(TipoToken::SUBSECCION)] = 13;
+        tTransicion[2][static_cast<int>(TipoToken::SUBSUBSECCION)] = 13;
+        tTransicion[2][static_cast<int>(TipoToken::CAPITULO)] = 13;
+        tTransicion[13][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 14;
+        tTransicion[14][static_cast<int>(TipoToken::CADENA)] = 15;
+        tTransicion[15][static_cast<int>(TipoToken::PARENTESIS_DER)] = 16;
+        tTransicion[16][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+
+        // parrafo|negrita|cursiva ("texto") ;
+        tTransicion[2][static_cast<int>(TipoToken::PARRAFO)] = 17;
+        tTransicion[2][static_cast<int>(TipoToken::NEGRITA)] = 17;
+        tTransicion[2][static_cast<int>(TipoToken::CURSIVA)] = 17;
+        tTransicion[2][static_cast<int>(TipoToken::SUBRAYADO)] = 17;
+        tTransicion[2][static_cast<int>(TipoToken::TACHADO)] = 17;
+        tTransicion[17][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 18;
+        tTransicion[18][static_cast<int>(TipoToken::CADENA)] = 19;
+        tTransicion[19][static_cast<int>(TipoToken::PARENTESIS_DER)] = 20;
+        tTransicion[20][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+
+        // parrafo|negrita|cursiva texto_simple ;
+        tTransicion[17][static_cast<int>(TipoToken::TEXTO_SIMPLE)] = 21;
+        tTransicion[21][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+
+        // lista_simple|lista_numerada ;
+        tTransicion[2][static_cast<int>(TipoToken::LISTA_SIMPLE)] = 22;
+        tTransicion[2][static_cast<int>(TipoToken::LISTA_NUMERADA)] = 22;
+        tTransicion[22][static_cast<int>(TipoToken::PUNTO_COMA)] = 23;
+
+        // elemento ("texto") ;
+        tTransicion[23][static_cast<int>(TipoToken::ELEMENTO)] = 24;
+        tTransicion[24][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 25;
+        tTransicion[25][static_cast<int>(TipoToken::CADENA)] = 26;
+        tTransicion[26][static_cast<int>(TipoToken::PARENTESIS_DER)] = 27;
+        tTransicion[27][static_cast<int>(TipoToken::PUNTO_COMA)] = 23;
+
+        // elemento texto_simple ;
+        tTransicion[24][static_cast<int>(TipoToken::TEXTO_SIMPLE)] = 28;
+        tTransicion[28][static_cast<int>(TipoToken::PUNTO_COMA)] = 23;
+
+        // fin_lista ;
+        tTransicion[23][static_cast<int>(TipoToken::FIN_LISTA)] = 29;
+        tTransicion[29][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+
+        // ecuacion|formula ("contenido") ;
+        tTransicion[2][static_cast<int>(TipoToken::ECUACION)] = 30;
+        tTransicion[2][static_cast<int>(TipoToken::FORMULA)] = 30;
+        tTransicion[30][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 31;
+        tTransicion[31][static_cast<int>(TipoToken::CADENA)] = 32;
+        tTransicion[32][static_cast<int>(TipoToken::PARENTESIS_DER)] = 33;
+        tTransicion[33][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+
+        // salto_linea|salto_pagina|nueva_pagina ;
+        tTransicion[2][static_cast<int>(TipoToken::SALTO_LINEA)] = 34;
+        tTransicion[2][static_cast<int>(TipoToken::SALTO_PAGINA)] = 34;
+        tTransicion[2][static_cast<int>(TipoToken::NUEVA_PAGINA)] = 34;
+        tTransicion[34][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+
+        // documento_fin ;
+        tTransicion[2][static_cast<int>(TipoToken::DOCUMENTO_FIN)] = 35;
+        tTransicion[35][static_cast<int>(TipoToken::PUNTO_COMA)] = 36; // ESTADO FINAL
+
+        // Parentesis vacios opcionales: documento_inicio(); lista_simple(); ...
+        tTransicion[1][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 37;
+        tTransicion[37][static_cast<int>(TipoToken::PARENTESIS_DER)] = 38;
+        tTransicion[38][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+        tTransicion[22][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 39;
+        tTransicion[39][static_cast<int>(TipoToken::PARENTESIS_DER)] = 40;
+        tTransicion[40][static_cast<int>(TipoToken::PUNTO_COMA)] = 23;
+        tTransicion[29][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 41;
+        tTransicion[41][static_cast<int>(TipoToken::PARENTESIS_DER)] = 42;
+        tTransicion[42][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+        tTransicion[34][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 43;
+        tTransicion[43][static_cast<int>(TipoToken::PARENTESIS_DER)] = 44;
+        tTransicion[44][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+        tTransicion[35][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 45;
+        tTransicion[45][static_cast<int>(TipoToken::PARENTESIS_DER)] = 46;
+        tTransicion[46][static_cast<int>(TipoToken::PUNTO_COMA)] = 36;
+
+        // tabla_csv ("archivo.csv" {, "opcion=valor"}) ;
+        tTransicion[2][static_cast<int>(TipoToken::TABLA)] = 47;
+        tTransicion[47][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 48;
+        tTransicion[48][static_cast<int>(TipoToken::CADENA)] = 49;
+        tTransicion[49][static_cast<int>(TipoToken::COMA)] = 50;
+        tTransicion[50][static_cast<int>(TipoToken::CADENA)] = 49;
+        tTransicion[49][static_cast<int>(TipoToken::PARENTESIS_DER)] = 51;
+        tTransicion[51][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+
+        // figura ("ruta" [, "leyenda"]) ;
+        tTransicion[2][static_cast<int>(TipoToken::FIGURA)] = 52;
+        tTransicion[52][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 53;
+        tTransicion[53][static_cast<int>(TipoToken::CADENA)] = 54;
+        tTransicion[54][static_cast<int>(TipoToken::COMA)] = 55;
+        tTransicion[55][static_cast<int>(TipoToken::CADENA)] = 56;
+        tTransicion[54][static_cast<int>(TipoToken::PARENTESIS_DER)] = 57;
+        tTransicion[56][static_cast<int>(TipoToken::PARENTESIS_DER)] = 57;
+        tTransicion[57][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+
+        // etiqueta|referencia ("clave") ;
+        tTransicion[2][static_cast<int>(TipoToken::ETIQUETA)] = 58;
+        tTransicion[2][static_cast<int>(TipoToken::REFERENCIA)] = 58;
+        tTransicion[58][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 59;
+        tTransicion[59][static_cast<int>(TipoToken::CADENA)] = 60;
+        tTransicion[60][static_cast<int>(TipoToken::PARENTESIS_DER)] = 61;
+        tTransicion[61][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+
+        // indice [()] ;
+        tTransicion[2][static_cast<int>(TipoToken::INDICE)] = 62;
+        tTransicion[62][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+        tTransicion[62][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 63;
+        tTransicion[63][static_cast<int>(TipoToken::PARENTESIS_DER)] = 64;
+        tTransicion[64][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+
+        // bibliografia ("archivo.bib" {, "archivo.bib"}) ;
+        tTransicion[2][static_cast<int>(TipoToken::BIBLIOGRAFIA)] = 65;
+        tTransicion[65][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 66;
+        tTransicion[66][static_cast<int>(TipoToken::CADENA)] = 67;
+        tTransicion[67][static_cast<int>(TipoToken::COMA)] = 68;
+        tTransicion[68][static_cast<int>(TipoToken::CADENA)] = 67;
+        tTransicion[67][static_cast<int>(TipoToken::PARENTESIS_DER)] = 69;
+        tTransicion[69][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+
+        // cita ("clave[,clave...]" [, "nota"]) ;
+        tTransicion[2][static_cast<int>(TipoToken::CITA)] = 70;
+        tTransicion[70][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 71;
+        tTransicion[71][static_cast<int>(TipoToken::CADENA)] = 72;
+        tTransicion[72][static_cast<int>(TipoToken::COMA)] = 73;
+        tTransicion[73][static_cast<int>(TipoToken::CADENA)] = 74;
+        tTransicion[72][static_cast<int>(TipoToken::PARENTESIS_DER)] = 75;
+        tTransicion[74][static_cast<int>(TipoToken::PARENTESIS_DER)] = 75;
+        tTransicion[75][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+
+        // definir ("nombre", "cuerpo") ;
+        tTransicion[2][static_cast<int>(TipoToken::DEFINIR)] = 76;
+        tTransicion[76][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 77;
+        tTransicion[77][static_cast<int>(TipoToken::CADENA)] = 78;
+        tTransicion[78][static_cast<int>(TipoToken::COMA)] = 79;
+        tTransicion[79][static_cast<int>(TipoToken::CADENA)] = 80;
+        tTransicion[80][static_cast<int>(TipoToken::PARENTESIS_DER)] = 81;
+        tTransicion[81][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+
+        // usar ("nombre" {, "argumento"}) ;
+        tTransicion[2][static_cast<int>(TipoToken::USAR)] = 82;
+        tTransicion[82][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 83;
+        tTransicion[83][static_cast<int>(TipoToken::CADENA)] = 84;
+        tTransicion[84][static_cast<int>(TipoToken::COMA)] = 85;
+        tTransicion[85][static_cast<int>(TipoToken::CADENA)] = 84;
+        tTransicion[84][static_cast<int>(TipoToken::PARENTESIS_DER)] = 86;
+        tTransicion[86][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
+    }
+
+    Token& mirarSiguiente() {
+        return tokens[actual];
+    }
+
+    Token& avanzar() {
+        if (!estaAlFinal()) actual++;
+        return tokens[actual - 1];
+    }
+
+    bool estaAlFinal() {
+        return mirarSiguiente().tipo == TipoToken::FIN_ARCHIVO;
+    }
+
+    // Método para análisis con tabla de transiciones
+    bool analizarConTablaTransiciones() {
+        estado = 0;
+        actual = 0;
+        diagnosticos.clear();
+
+        while (!estaAlFinal()) {
+            Token& token = mirarSiguiente();
+            int tokenType = token.getTokenValue();
+
+            int nuevoEstado = tTransicion[estado][tokenType];
+
+            if (nuevoEstado == ERROR_SINTACTICO) {
+                diagnosticos.emplace_back(Severidad::ERROR, token.linea, token.columna,
+                    "Transicion no definida (estado " + to_string(estado) +
+                    ", token " + to_string(tokenType) + " - " + token.toString() + ")");
+                return false;
+            }
+
+            estado = nuevoEstado;
+            avanzar();
+
+            // Estado final aceptado
+            if (estado == ESTADO_FINAL) {
+                return true;
+            }
+        }
+
+        if (estado != ESTADO_FINAL) {
+            Token& token = mirarSiguiente();
+            diagnosticos.emplace_back(Severidad::ERROR, token.linea, token.columna,
+                "Documento incompleto - estado final no alcanzado");
+            return false;
+        }
+
+        return true;
+    }
+
+    Token& consumir(TipoToken tipo, const string& mensaje) {
+        if (mirarSiguiente().tipo == tipo) {
+            return avanzar();
+        }
+        Token& token = mirarSiguiente();
+        throw runtime_error(mensaje + " en linea " + to_string(token.linea) +
+                            ", columna " + to_string(token.columna));
+    }
+
+    // Valor del token para el arbol: se mueve si los tokens ya no se van a
+    // leer despues (ver analizar()), si no se copia.
+    string valorDe(Token& token) {
+        if (moverCadenas) return move(token.valor);
+        return token.valor;
+    }
+
+    void consumirFinSentencia() {
+        if (mirarSiguiente().tipo == TipoToken::PARENTESIS_IZQ) {
+            avanzar();
+            consumir(TipoToken::PARENTESIS_DER, "Se esperaba )");
+        }
+        consumir(TipoToken::PUNTO_COMA, "Se esperaba ;");
+    }
+
+    // ("texto") | texto_simple
+    string leerArgumentoTexto() {
+        if (mirarSiguiente().tipo == TipoToken::TEXTO_SIMPLE) {
+            return valorDe(avanzar());
+        }
+        consumir(TipoToken::PARENTESIS_IZQ, "Se esperaba (");
+        string valor = valorDe(consumir(TipoToken::CADENA, "Se esperaba una cadena"));
+        consumir(TipoToken::PARENTESIS_DER, "Se esperaba )");
+        return valor;
+    }
+
+    static string estiloDeToken(TipoToken tipo) {
+        switch (tipo) {
+            case TipoToken::NEGRITA: return "negrita";
+            case TipoToken::CURSIVA: return "cursiva";
+            case TipoToken::SUBRAYADO: return "subrayado";
+            case TipoToken::TACHADO: return "tachado";
+            default: return "normal";
+        }
+    }
+
+    unique_ptr<NodoAST> analizarDeclaracion() {
+        Token& token = avanzar();
+
+        switch (token.tipo) {
+            case TipoToken::DOCUMENTO_INICIO:
+                consumirFinSentencia();
+                return make_unique<NodoComando>("inicio_documento");
+
+            case TipoToken::DOCUMENTO_FIN:
+                consumirFinSentencia();
+                return make_unique<NodoComando>("fin_documento");
+
+            case TipoToken::TITULO:
+            case TipoToken::AUTOR:
+            case TipoToken::FECHA: {
+                string tipo = token.tipo == TipoToken::TITULO ? "titulo" :
+                              token.tipo == TipoToken::AUTOR ? "autor" : "fecha";
+                string contenido = leerArgumentoTexto();
+                consumir(TipoToken::PUNTO_COMA, "Se esperaba ;");
+                return make_unique<NodoMetadatos>(move(tipo), move(contenido));
+            }
+
+            case TipoToken::CONFIGURAR: {
+                consumir(TipoToken::PARENTESIS_IZQ, "Se esperaba ( despues de configurar");
+                string clave = valorDe(consumir(TipoToken::CADENA, "Se esperaba cadena para clave"));
+                consumir(TipoToken::COMA, "Se esperaba ,");
+                string valor = valorDe(consumir(TipoToken::CADENA, "Se esperaba cadena para valor"));
+                consumir(TipoToken::PARENTESIS_DER, "Se esperaba )");
+                consumir(TipoToken::PUNTO_COMA, "Se esperaba ;");
+                return make_unique<NodoConfiguracion>(move(clave), move(valor));
+            }
+
+            case TipoToken::SECCION:
+            case TipoToken::SUBSECCION:
+            case TipoToken::SUBSUBSECCION:
+            case TipoToken::CAPITULO: {
+                string nivel = token.tipo == TipoToken::SECCION ? "seccion" :
+                               token.tipo == TipoToken::SUBSECCION ? "subseccion" :
+                               token.tipo == TipoToken::SUBSUBSECCION ? "subsubseccion" : "capitulo";
+                string titulo = leerArgumentoTexto();
+                consumir(TipoToken::PUNTO_COMA, "Se esperaba ;");
+                return make_unique<NodoSeccion>(move(nivel), move(titulo));
+            }
+
+            case TipoToken::PARRAFO:
+            case TipoToken::NEGRITA:
+            case TipoToken::CURSIVA:
+            case TipoToken::SUBRAYADO:
+            case TipoToken::TACHADO: {
+                string contenido = leerArgumentoTexto();
+                consumir(TipoToken::PUNTO_COMA, "Se esperaba ;");
+                return make_unique<NodoTexto>(move(contenido), estiloDeToken(token.tipo));
+            }
+
+            case TipoToken::LISTA_SIMPLE:
+            case TipoToken::LISTA_NUMERADA: {
+                auto lista = make_unique<NodoLista>();
+                lista->tipo = token.tipo == TipoToken::LISTA_SIMPLE ? "simple" : "numerada";
+                consumirFinSentencia();
+                while (mirarSiguiente().tipo == TipoToken::ELEMENTO) {
+                    avanzar();
+                    string contenido = leerArgumentoTexto();
+                    consumir(TipoToken::PUNTO_COMA, "Se esperaba ;");
+                    lista->elementos.push_back(make_unique<NodoTexto>(move(contenido)));
+                }
+                consumir(TipoToken::FIN_LISTA, "Se esperaba fin_lista");
+                consumirFinSentencia();
+                return lista;
+            }
+
+            case TipoToken::ECUACION:
+            case TipoToken::FORMULA: {
+                consumir(TipoToken::PARENTESIS_IZQ, "Se esperaba ( despues de ecuacion/formula");
+                string contenido = valorDe(consumir(TipoToken::CADENA, "Se esperaba cadena para ecuacion"));
+                consumir(TipoToken::PARENTESIS_DER, "Se esperaba )");
+                consumir(TipoToken::PUNTO_COMA, "Se esperaba ;");
+                return make_unique<NodoEcuacion>(move(contenido),
+                    token.tipo == TipoToken::ECUACION ? "ecuacion" : "formula");
+            }
+
+            case TipoToken::TABLA: {
+                consumir(TipoToken::PARENTESIS_IZQ, "Se esperaba ( despues de tabla_csv");
+                auto tabla = make_unique<NodoTablaCsv>(
+                    valorDe(consumir(TipoToken::CADENA, "Se esperaba la ruta del archivo CSV")));
+                while (mirarSiguiente().tipo == TipoToken::COMA) {
+                    avanzar();
+                    tabla->opciones.push_back(
+                        valorDe(consumir(TipoToken::CADENA, "Se esperaba una opcion de tabla_csv")));
+                }
+                consumir(TipoToken::PARENTESIS_DER, "Se esperaba )");
+                consumir(TipoToken::PUNTO_COMA, "Se esperaba ;");
+                return tabla;
+            }
+
+            case TipoToken::FIGURA: {
+                consumir(TipoToken::PARENTESIS_IZQ, "Se esperaba ( despues de figura");
+                auto figura = make_unique<NodoFigura>(
+                    valorDe(consumir(TipoToken::CADENA, "Se esperaba la ruta de la imagen")));
+                if (mirarSiguiente().tipo == TipoToken::COMA) {
+                    avanzar();
+                    figura->leyenda = valorDe(consumir(TipoToken::CADENA, "Se esperaba la leyenda"));
+                }
+                consumir(TipoToken::PARENTESIS_DER, "Se esperaba )");
+                consumir(TipoToken::PUNTO_COMA, "Se esperaba ;");
+                return figura;
+            }
+
+            case TipoToken::ETIQUETA:
+            case TipoToken::REFERENCIA: {
+                consumir(TipoToken::PARENTESIS_IZQ, "Se esperaba (");
+                string clave = valorDe(consumir(TipoToken::CADENA, "Se esperaba la clave"));
+                consumir(TipoToken::PARENTESIS_DER, "Se esperaba )");
+                consumir(TipoToken::PUNTO_COMA, "Se esperaba ;");
+                if (token.tipo == TipoToken::ETIQUETA) {
+                    return make_unique<NodoEtiqueta>(move(clave));
+                }
+                return make_unique<NodoReferencia>(move(clave));
+            }
+
+            case TipoToken::INDICE:
+                consumirFinSentencia();
+                return make_unique<NodoIndice>();
+
+            case TipoToken::BIBLIOGRAFIA: {
+                consumir(TipoToken::PARENTESIS_IZQ, "Se esperaba ( despues de bibliografia");
+                auto bibliografia = make_unique<NodoBibliografia>();
+                bibliografia->rutas.push_back(
+                    valorDe(consumir(TipoToken::CADENA, "Se esperaba la ruta del archivo .bib")));
+                while (mirarSiguiente().tipo == TipoToken::COMA) {
+                    avanzar();
+                    bibliografia->rutas.push_back(
+                        valorDe(consumir(TipoToken::CADENA, "Se esperaba la ruta del archivo .bib")));
+                }
+                consumir(TipoToken::PARENTESIS_DER, "Se esperaba )");
+                consumir(TipoToken::PUNTO_COMA, "Se esperaba ;");
+                return bibliografia;
+            }
+
+            case TipoToken::CITA: {
+                consumir(TipoToken::PARENTESIS_IZQ, "Se esperaba ( despues de cita");
+                auto cita = make_unique<NodoCita>(valorDe(consumir(TipoToken::CADENA, "Se esperaba la clave")));
+                if (mirarSiguiente().tipo == TipoToken::COMA) {
+                    avanzar();
+                    cita->nota = valorDe(consumir(TipoToken::CADENA, "Se esperaba la nota de la cita"));
+                }
+                consumir(TipoToken::PARENTESIS_DER, "Se esperaba )");
+                consumir(TipoToken::PUNTO_COMA, "Se esperaba ;");
+                return cita;
+            }
+
+            case TipoToken::DEFINIR: {
+                consumir(TipoToken::PARENTESIS_IZQ, "Se esperaba ( despues de definir");
+                string nombre = valorDe(consumir(TipoToken::CADENA, "Se esperaba el nombre de la macro"));
+                consumir(TipoToken::COMA, "Se esperaba ,");
+                string cuerpo = valorDe(consumir(TipoToken::CADENA, "Se esperaba el cuerpo de la macro"));
+                consumir(TipoToken::PARENTESIS_DER, "Se esperaba )");
+                consumir(TipoToken::PUNTO_COMA, "Se esperaba ;");
+                return make_unique<NodoDefinicion>(move(nombre), move(cuerpo));
+            }
+
+            case TipoToken::USAR: {
+                consumir(TipoToken::PARENTESIS_IZQ, "Se esperaba ( despues de usar");
+                auto uso = make_unique<NodoUso>(
+                    valorDe(consumir(TipoToken::CADENA, "Se esperaba el nombre de la macro")));
+                while (mirarSiguiente().tipo == TipoToken::COMA) {
+                    avanzar();
+                    uso->argumentos.push_back(
+                        valorDe(consumir(TipoToken::CADENA, "Se esperaba un argumento de la macro")));
+                }
+                consumir(TipoToken::PARENTESIS_DER, "Se esperaba )");
+                consumir(TipoToken::PUNTO_COMA, "Se esperaba ;");
+                return uso;
+            }
+
+            case TipoToken::SALTO_LINEA:
+                consumirFinSentencia();
+                return make_unique<NodoComando>("nueva_linea");
+
+            case TipoToken::SALTO_PAGINA:
+                consumirFinSentencia();
+                return make_unique<NodoComando>("salto_pagina");
+
+            case TipoToken::NUEVA_PAGINA:
+                consumirFinSentencia();
+                return make_unique<NodoComando>("nueva_pagina");
+
+            default:
+                throw runtime_error("Sentencia inesperada " + token.toString() +
+                                    " en linea " + to_string(token.linea));
+        }
+    }
+
+public:
+    // Estado al que vuelve el automata al cerrar cada sentencia, y estado
+    // final (tras "documento_fin;").
+    static const int ESTADO_INICIO_SENTENCIA = 2;
+    static const int ESTADO_FINAL = 36;
+
+    // Los tokens se copian; quien ya no los necesite puede pasarlos con
+    // move() para no tenerlos dos veces en memoria.
+    AnalizadorSintactico(vector<Token> tokens)
+        : tokens(move(tokens)), actual(0), estado(0) {
+        inicializarTablaTransiciones();
+    }
+
+    // Analiza otros tokens con la tabla de transiciones ya armada.
+    void reiniciar(vector<Token> nuevosTokens) {
+        tokens = move(nuevosTokens);
+        actual = 0;
+        estado = 0;
+        moverCadenas = false;
+        diagnosticos.clear();
+    }
+
+    // Entrega el vector de tokens (con su capacidad) para reutilizarlo; el
+    // analizador queda sin tokens hasta el proximo reiniciar().
+    vector<Token> devolverTokens() {
+        vector<Token> devueltos = move(tokens);
+        tokens.clear();
+        return devueltos;
+    }
+
+    // Método principal que usa la tabla de transiciones
+    bool analizarSintaxis() {
+        return analizarConTablaTransiciones();
+    }
+
+    // Un paso del automata: estado siguiente o ERROR_SINTACTICO. Permite
+    // reanudar la validacion desde un estado guardado (editor interactivo).
+    int transicion(int estadoActual, const Token& token) const {
+        return tTransicion[estadoActual][token.getTokenValue()];
+    }
+
+    int transicion(int estadoActual, TipoToken tipo) const {
+        return tTransicion[estadoActual][static_cast<int>(tipo)];
+    }
+
+    // Construye el arbol sintactico. Lanza runtime_error ante una sentencia
+    // mal formada; conviene validar antes con analizarSintaxis().
+    // Con 'moverCadenas' los valores de los tokens pasan al arbol sin
+    // copiarse y getTokens() los devuelve vacios: solo para quien ya no los
+    // necesita (sin cache de AST ni listado de tokens).
+    unique_ptr<NodoDocumento> analizar(bool moverCadenas = false) {
+        auto documento = make_unique<NodoDocumento>();
+        actual = 0;
+        this->moverCadenas = moverCadenas;
+
+        while (!estaAlFinal()) {
+            const Token& inicio = mirarSiguiente();
+            bool esFin = inicio.tipo == TipoToken::DOCUMENTO_FIN;
+            int linea = inicio.linea;
+            int columna = inicio.columna;
+
+            unique_ptr<NodoAST> nodo = analizarDeclaracion();
+            nodo->linea = linea;
+            nodo->columna = columna;
+            documento->hijos.push_back(move(nodo));
+            if (esFin) break;
+        }
+
+        return documento;
+    }
+
+    const vector<Diagnostico>& getDiagnosticos() const {
+        return diagnosticos;
+    }
+
+    const vector<Token>& getTokens() const {
+        return tokens;
+    }
+
+    void mostrarTokens(ostream& os) {
+        os << "\nTOKENS RECONOCIDOS:\n";
+        os << "===================\n";
+        for (size_t i = 0; i < tokens.size() && i < 50; ++i) {
+            os << "Linea " << tokens[i].linea << ", Col " << tokens[i].columna
+               << ": " << tokens[i].toString() << "\n";
+        }
+        if (tokens.size() > 50) {
+            os << "... y " << (tokens.size() - 50) << " tokens mas.\n";
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include "archivo_mapeado.h"
+
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <sstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#if defined(_WIN32)
+
+ArchivoMapeado::ArchivoMapeado(const string& ruta) : datos(nullptr), tamano(0) {
+    ifstream archivo(ruta, ios::binary);
+    if (!archivo.is_open()) {
+        throw runtime_error("No se pudo abrir el archivo: " + ruta);
+    }
+    stringstream buffer;
+    buffer << archivo.rdbuf();
+    respaldo = buffer.str();
+    datos = respaldo.data();
+    tamano = respaldo.size();
+}
+
+ArchivoMapeado::~ArchivoMapeado() {}
+
+#else
+
+ArchivoMapeado::ArchivoMapeado(const string& ruta) : datos(nullptr), tamano(0) {
+    int descriptor = open(ruta.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw runtime_error("No se pudo abrir el archivo: " + ruta);
+    }
+
+    struct stat info;
+    if (fstat(descriptor, &info) != 0) {
+        close(descriptor);
+        throw runtime_error("No se pudo consultar el archivo: " + ruta);
+    }
+
+    tamano = static_cast<size_t>(info.st_size);
+    if (tamano > 0) {
+        void* mapa = mmap(nullptr, tamano, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapa == MAP_FAILED) {
+            close(descriptor);
+            throw runtime_error("No se pudo mapear el archivo: " + ruta);
+        }
+        madvise(mapa, tamano, MADV_SEQUENTIAL);
+        datos = static_cast<const char*>(mapa);
+    }
+    close(descriptor);
+}
+
+ArchivoMapeado::~ArchivoMapeado() {
+    if (datos != nullptr && tamano > 0) {
+        munmap(const_cast<char*>(datos), tamano);
+    }
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef ARCHIVO_MAPEADO_H
+#define ARCHIVO_MAPEADO_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// ===============================
+// ARCHIVO MAPEADO EN MEMORIA
+// ===============================
+//
+// Proyecta un archivo de solo lectura con mmap; el sistema trae las paginas
+// bajo demanda, asi que recorrerlo secuencialmente no requiere reservar un
+// buffer del tamano del archivo. En plataformas sin mmap se lee completo.
+
+class ArchivoMapeado {
+private:
+    const char* datos;
+    size_t tamano;
+    string respaldo;
+
+public:
+    // Lanza runtime_error si el archivo no se puede abrir.
+    explicit ArchivoMapeado(const string& ruta);
+    ~ArchivoMapeado();
+
+    ArchivoMapeado(const ArchivoMapeado&) = delete;
+    ArchivoMapeado& operator=(const ArchivoMapeado&) = delete;
+
+    string_view contenido() const {
+        return string_view(datos, tamano);
+    }
+};
+
+#endif
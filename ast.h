@@ -0,0 +1,216 @@
+#ifndef AST_H
+#define AST_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// ===============================
+// ESTRUCTURAS DEL ARBOL SINTACTICO
+// ===============================
+//
+// Los constructores reciben las cadenas por valor y las mueven: el
+// analizador sintactico les pasa con move() lo que ya leyo de los tokens.
+
+struct NodoAST {
+    // Posicion de la sentencia en el .texes, para los diagnosticos
+    int linea = 0;
+    int columna = 0;
+    // La sentencia viene de expandir un usar() (macros.h): linea y columna
+    // son las del usar(), no las del cuerpo de la macro.
+    bool expandido = false;
+
+    virtual ~NodoAST() = default;
+    virtual string toString() const = 0;
+};
+
+struct NodoDocumento : public NodoAST {
+    vector<unique_ptr<NodoAST>> hijos;
+
+    string toString() const override {
+        return "Documento(" + to_string(hijos.size()) + " hijos)";
+    }
+};
+
+struct NodoConfiguracion : public NodoAST {
+    string clave;
+    string valor;
+    NodoConfiguracion(string k, string v) : clave(move(k)), valor(move(v)) {}
+
+    string toString() const override {
+        return "Configurar(" + clave + " = " + valor + ")";
+    }
+};
+
+struct NodoSeccion : public NodoAST {
+    string nivel;
+    string titulo;
+    string numero; // asignado al resolver referencias, p. ej. "2.1"
+    NodoSeccion(string l, string t) : nivel(move(l)), titulo(move(t)) {}
+
+    string toString() const override {
+        return nivel + "(\"" + titulo + "\")";
+    }
+};
+
+struct NodoTexto : public NodoAST {
+    string contenido;
+    string estilo;
+    string alineacion;
+    NodoTexto(string c, string s = "normal", string a = "justificar")
+        : contenido(move(c)), estilo(move(s)), alineacion(move(a)) {}
+
+    string toString() const override {
+        return "Texto[" + estilo + "](\"" + contenido + "\")";
+    }
+};
+
+struct NodoLista : public NodoAST {
+    string tipo;
+    vector<unique_ptr<NodoAST>> elementos;
+
+    string toString() const override {
+        return "Lista[" + tipo + "](" + to_string(elementos.size()) + " elementos)";
+    }
+};
+
+struct NodoEcuacion : public NodoAST {
+    string contenido;
+    string tipo;
+    string numero;
+    NodoEcuacion(string c, string t = "ecuacion") : contenido(move(c)), tipo(move(t)) {}
+
+    string toString() const override {
+        return "Ecuacion[" + tipo + "](" + contenido + ")";
+    }
+};
+
+struct NodoMetadatos : public NodoAST {
+    string tipo;
+    string contenido;
+    NodoMetadatos(string t, string c) : tipo(move(t)), contenido(move(c)) {}
+
+    string toString() const override {
+        return tipo + "(\"" + contenido + "\")";
+    }
+};
+
+struct NodoComando : public NodoAST {
+    string comando;
+    string contenido;
+    NodoComando(string cmd, string c = "") : comando(move(cmd)), contenido(move(c)) {}
+
+    string toString() const override {
+        return "Comando(" + comando + ")";
+    }
+};
+
+struct NodoTablaCsv : public NodoAST {
+    string ruta;
+    vector<string> opciones; // "clave=valor": separador, encabezado, columnas
+    NodoTablaCsv(string r) : ruta(move(r)) {}
+
+    string toString() const override {
+        return "TablaCsv(\"" + ruta + "\")";
+    }
+};
+
+struct NodoFigura : public NodoAST {
+    string ruta;
+    string leyenda;
+    string numero;
+    NodoFigura(string r, string l = "") : ruta(move(r)), leyenda(move(l)) {}
+
+    string toString() const override {
+        return "Figura(\"" + ruta + "\")";
+    }
+};
+
+struct NodoEtiqueta : public NodoAST {
+    string clave;
+    NodoEtiqueta(string c) : clave(move(c)) {}
+
+    string toString() const override {
+        return "Etiqueta(" + clave + ")";
+    }
+};
+
+struct NodoReferencia : public NodoAST {
+    string clave;
+    string numero; // vacio si la etiqueta no existe
+    NodoReferencia(string c) : clave(move(c)) {}
+
+    string toString() const override {
+        return "Referencia(" + clave + ")";
+    }
+};
+
+struct EntradaIndice {
+    string nivel;
+    string numero;
+    string titulo;
+};
+
+struct NodoIndice : public NodoAST {
+    vector<EntradaIndice> entradas;
+
+    string toString() const override {
+        return "Indice(" + to_string(entradas.size()) + " entradas)";
+    }
+};
+
+struct NodoCita : public NodoAST {
+    string claves; // una o varias, separadas por comas
+    string nota;   // "p. 12", opcional
+    string numero; // "3" o "1, 4"; vacio si ninguna clave existe
+    NodoCita(string c) : claves(move(c)) {}
+
+    string toString() const override {
+        return "Cita(" + claves + ")";
+    }
+};
+
+// La entrada ya formateada, partida alrededor del unico tramo en cursiva
+// (revista o titulo del libro) para que cada salida use su propia marca.
+struct EntradaBibliografia {
+    string clave;
+    string numero;
+    string antes;
+    string enfasis;
+    string despues;
+};
+
+struct NodoBibliografia : public NodoAST {
+    vector<string> rutas;
+    vector<EntradaBibliografia> entradas; // las citadas, en orden de cita
+
+    string toString() const override {
+        return "Bibliografia(" + to_string(entradas.size()) + " entradas)";
+    }
+};
+
+// definir("nombre", "cuerpo"); desaparece del arbol al expandir las macros
+struct NodoDefinicion : public NodoAST {
+    string nombre;
+    string cuerpo;
+    NodoDefinicion(string n, string c) : nombre(move(n)), cuerpo(move(c)) {}
+
+    string toString() const override {
+        return "Definir(" + nombre + ")";
+    }
+};
+
+// usar("nombre", "arg1", ...); se reemplaza por las sentencias de la macro
+struct NodoUso : public NodoAST {
+    string nombre;
+    vector<string> argumentos;
+    NodoUso(string n) : nombre(move(n)) {}
+
+    string toString() const override {
+        return "Usar(" + nombre + ", " + to_string(argumentos.size()) + " argumentos)";
+    }
+};
+
+#endif
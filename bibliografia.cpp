@@ -0,0 +1,682 @@
+#include "bibliografia.h"
+
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#include "hash.h"
+
+using namespace std;
+
+namespace {
+
+bool esEspacio(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+char minuscula(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+string minusculas(string_view texto) {
+    string resultado(texto);
+    for (char& c : resultado) c = minuscula(c);
+    return resultado;
+}
+
+bool igualesSinMayusculas(string_view a, string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (minuscula(a[i]) != minuscula(b[i])) return false;
+    }
+    return true;
+}
+
+string_view recortar(string_view texto) {
+    size_t inicio = 0, fin = texto.size();
+    while (inicio < fin && esEspacio(texto[inicio])) inicio++;
+    while (fin > inicio && esEspacio(texto[fin - 1])) fin--;
+    return texto.substr(inicio, fin - inicio);
+}
+
+uint64_t hashClave(string_view clave) {
+    return hashContenido(minusculas(clave));
+}
+
+int64_t fechaArchivo(const string& ruta) {
+    error_code error;
+    auto fecha = filesystem::last_write_time(ruta, error);
+    return error ? 0 : static_cast<int64_t>(fecha.time_since_epoch().count());
+}
+
+// ===============================
+// RECORRIDO DEL .bib
+// ===============================
+
+// Cabecera "@tipo{" o "@tipo(": deja el tipo en minusculas y la posicion
+// del delimitador de apertura.
+bool leerCabecera(string_view texto, size_t arroba, string& tipo, size_t& apertura) {
+    size_t i = arroba + 1;
+    while (i < texto.size() && esEspacio(texto[i])) i++;
+    size_t inicioTipo = i;
+    while (i < texto.size() && (isalnum(static_cast<unsigned char>(texto[i])) || texto[i] == '_')) i++;
+    if (i == inicioTipo) return false;
+    tipo = minusculas(texto.substr(inicioTipo, i - inicioTipo));
+    while (i < texto.size() && esEspacio(texto[i])) i++;
+    if (i >= texto.size() || (texto[i] != '{' && texto[i] != '(')) return false;
+    apertura = i;
+    return true;
+}
+
+// Posicion del delimitador que cierra la entrada abierta en 'apertura', o
+// npos si el archivo termina antes. Las llaves de los valores estan
+// equilibradas en cualquier .bib valido, asi que basta con contarlas.
+size_t buscarCierre(string_view texto, size_t apertura) {
+    char cierre = texto[apertura] == '{' ? '}' : ')';
+    int profundidad = 0;
+    for (size_t i = apertura + 1; i < texto.size(); i++) {
+        char c = texto[i];
+        if (c == '{') {
+            profundidad++;
+        } else if (c == '}') {
+            if (profundidad == 0) return cierre == '}' ? i : string_view::npos;
+            profundidad--;
+        } else if (c == cierre && profundidad == 0) {
+            return i;
+        }
+    }
+    return string_view::npos;
+}
+
+// Clave de una entrada (hasta la coma) o nombre de una macro @string (hasta
+// el '='), a partir del texto completo de la entrada.
+string_view claveEntrada(string_view entrada, bool macro) {
+    size_t apertura = entrada.find_first_of("{(");
+    if (apertura == string_view::npos) return string_view();
+    size_t inicio = apertura + 1;
+    size_t fin = entrada.find(macro ? '=' : ',', inicio);
+    if (fin == string_view::npos) fin = entrada.size() - 1;
+    return recortar(entrada.substr(inicio, fin - inicio));
+}
+
+struct EntradaEncontrada {
+    uint64_t hash;
+    size_t desplazamiento;
+    size_t longitud;
+    bool macro;
+};
+
+vector<EntradaEncontrada> recorrerBib(string_view texto) {
+    vector<EntradaEncontrada> encontradas;
+    string tipo;
+    size_t i = 0;
+    while ((i = texto.find('@', i)) != string_view::npos) {
+        size_t apertura;
+        if (!leerCabecera(texto, i, tipo, apertura)) {
+            i++;
+            continue;
+        }
+        size_t cierre = buscarCierre(texto, apertura);
+        if (cierre == string_view::npos) break;
+
+        string_view entrada = texto.substr(i, cierre + 1 - i);
+        if (tipo != "comment" && tipo != "preamble") {
+            bool macro = tipo == "string";
+            string_view clave = claveEntrada(entrada, macro);
+            if (!clave.empty()) {
+                encontradas.push_back(EntradaEncontrada{hashClave(clave), i, entrada.size(), macro});
+            }
+        }
+        i = cierre + 1;
+    }
+    return encontradas;
+}
+
+} // namespace
+
+string nombreIndiceBibliografia(const string& rutaBib) {
+    return rutaBib + ".idx";
+}
+
+// ===============================
+// INDICE EN DISCO
+// ===============================
+
+BaseBibliografica::BaseBibliografica(const string& ruta) : ruta(ruta) {
+    // La fecha se toma antes de proyectar: si el .bib cambia entre medias,
+    // el indice queda con la fecha vieja y se reconstruye la proxima vez.
+    int64_t fecha = fechaArchivo(ruta);
+    bib = make_unique<ArchivoMapeado>(ruta);
+    uint64_t tamano = bib->contenido().size();
+    if (!cargarIndice(tamano, fecha)) {
+        reconstruir(tamano, fecha);
+    }
+}
+
+bool BaseBibliografica::cargarIndice(uint64_t tamano, int64_t fecha) {
+    string rutaIndice = nombreIndiceBibliografia(ruta);
+    error_code error;
+    if (!filesystem::exists(rutaIndice, error)) return false;
+    try {
+        archivoIndice = make_unique<ArchivoMapeado>(rutaIndice);
+    } catch (const runtime_error&) {
+        return false;
+    }
+
+    string_view datos = archivoIndice->contenido();
+    if (datos.size() < sizeof(CabeceraIndiceBib)) return false;
+    const auto* cabecera = reinterpret_cast<const CabeceraIndiceBib*>(datos.data());
+    if (memcmp(cabecera->magia, "LATEXBIB", 8) != 0 || cabecera->version != VERSION_INDICE_BIB ||
+        cabecera->ordenBytes != ORDEN_BYTES_INDICE_BIB || cabecera->tamanoBib != tamano ||
+        cabecera->fechaBib != fecha) {
+        return false;
+    }
+    uint64_t numero = cabecera->numeroCubetas;
+    if (numero == 0 || (numero & (numero - 1)) != 0 ||
+        numero > (datos.size() - sizeof(CabeceraIndiceBib)) / sizeof(CubetaIndiceBib) ||
+        datos.size() != sizeof(CabeceraIndiceBib) + numero * sizeof(CubetaIndiceBib)) {
+        return false;
+    }
+
+    cubetas = reinterpret_cast<const CubetaIndiceBib*>(datos.data() + sizeof(CabeceraIndiceBib));
+    mascara = static_cast<size_t>(numero - 1);
+    entradas = static_cast<size_t>(cabecera->numeroEntradas);
+    return true;
+}
+
+void BaseBibliografica::reconstruir(uint64_t tamano, int64_t fecha) {
+    archivoIndice.reset();
+    reconstruido = true;
+
+    string_view texto = bib->contenido();
+    vector<EntradaEncontrada> encontradas = recorrerBib(texto);
+
+    // Carga maxima de 3/4
+    size_t numero = 16;
+    while (numero * 3 < encontradas.size() * 4) numero *= 2;
+    indiceMemoria.assign(numero, CubetaIndiceBib{0, 0, 0, 0});
+    mascara = numero - 1;
+    entradas = 0;
+
+    for (const auto& encontrada : encontradas) {
+        string_view clave = claveEntrada(texto.substr(encontrada.desplazamiento, encontrada.longitud),
+                                         encontrada.macro);
+        size_t i = encontrada.hash & mascara;
+        bool duplicada = false;
+        while (indiceMemoria[i].longitud != 0) {
+            const CubetaIndiceBib& ocupada = indiceMemoria[i];
+            // BibTeX se queda con la primera definicion
+            if (ocupada.hashClave == encontrada.hash && (ocupada.macro != 0) == encontrada.macro &&
+                igualesSinMayusculas(claveEntrada(texto.substr(ocupada.desplazamiento, ocupada.longitud),
+                                                  encontrada.macro), clave)) {
+                duplicada = true;
+                break;
+            }
+            i = (i + 1) & mascara;
+        }
+        if (duplicada) continue;
+        indiceMemoria[i] = CubetaIndiceBib{encontrada.hash, encontrada.desplazamiento,
+                                           static_cast<uint32_t>(encontrada.longitud),
+                                           encontrada.macro ? 1u : 0u};
+        if (!encontrada.macro) entradas++;
+    }
+    cubetas = indiceMemoria.data();
+
+    // Se guarda en un temporal que luego se renombra: otro proceso que
+    // compile a la vez nunca ve un indice a medio escribir.
+    CabeceraIndiceBib cabecera;
+    memset(&cabecera, 0, sizeof(cabecera));
+    memcpy(cabecera.magia, "LATEXBIB", 8);
+    cabecera.version = VERSION_INDICE_BIB;
+    cabecera.ordenBytes = ORDEN_BYTES_INDICE_BIB;
+    cabecera.tamanoBib = tamano;
+    cabecera.fechaBib = fecha;
+    cabecera.numeroCubetas = numero;
+    cabecera.numeroEntradas = entradas;
+
+    string rutaIndice = nombreIndiceBibliografia(ruta);
+    ostringstream temporal;
+    temporal << rutaIndice << ".tmp" << this_thread::get_id();
+    {
+        ofstream archivo(temporal.str(), ios::binary);
+        if (!archivo.is_open()) return;
+        archivo.write(reinterpret_cast<const char*>(&cabecera), sizeof(cabecera));
+        archivo.write(reinterpret_cast<const char*>(indiceMemoria.data()),
+                      static_cast<streamsize>(indiceMemoria.size() * sizeof(CubetaIndiceBib)));
+        archivo.close();
+        if (!archivo) {
+            error_code error;
+            filesystem::remove(temporal.str(), error);
+            return;
+        }
+    }
+    error_code error;
+    filesystem::rename(temporal.str(), rutaIndice, error);
+    if (error) filesystem::remove(temporal.str(), error);
+}
+
+string_view BaseBibliografica::buscarCubeta(string_view nombre, bool macro) const {
+    if (cubetas == nullptr || nombre.empty()) return string_view();
+    string_view texto = bib->contenido();
+    uint64_t hash = hashClave(nombre);
+    for (size_t i = hash & mascara, intentos = 0; intentos <= mascara; i = (i + 1) & mascara, intentos++) {
+        const CubetaIndiceBib& cubeta = cubetas[i];
+        if (cubeta.longitud == 0) break;
+        if (cubeta.hashClave != hash || (cubeta.macro != 0) != macro) continue;
+        if (cubeta.desplazamiento > texto.size() || cubeta.longitud > texto.size() - cubeta.desplazamiento) {
+            continue;
+        }
+        string_view entrada = texto.substr(cubeta.desplazamiento, cubeta.longitud);
+        if (entrada[0] == '@' && igualesSinMayusculas(claveEntrada(entrada, macro), nombre)) {
+            return entrada;
+        }
+    }
+    return string_view();
+}
+
+// ===============================
+// CAMPOS DE UNA ENTRADA
+// ===============================
+
+namespace {
+
+const int PROFUNDIDAD_MAXIMA_MACROS = 8;
+
+struct CamposBib {
+    string tipo;
+    unordered_map<string, string> valores;
+
+    const string& operator[](const char* nombre) const {
+        static const string vacio;
+        auto it = valores.find(nombre);
+        return it == valores.end() ? vacio : it->second;
+    }
+};
+
+// Agrega el texto reduciendo cada secuencia de espacios y saltos de linea
+// a un espacio.
+void agregarNormalizado(string_view texto, string& destino) {
+    for (char c : texto) {
+        if (esEspacio(c)) {
+            if (!destino.empty() && destino.back() != ' ') destino += ' ';
+        } else {
+            destino += c;
+        }
+    }
+}
+
+bool leerValor(string_view texto, size_t& i, size_t fin, const BaseBibliografica& base, int profundidad,
+               string& destino);
+
+// Valor de una macro @string: lo que sigue al '=' de su definicion.
+void expandirMacro(string_view nombre, const BaseBibliografica& base, int profundidad, string& destino) {
+    if (profundidad >= PROFUNDIDAD_MAXIMA_MACROS) return;
+    string_view definicion = base.buscarMacro(nombre);
+    if (definicion.empty()) return;
+    size_t i = definicion.find('=');
+    if (i == string_view::npos) return;
+    i++;
+    leerValor(definicion, i, definicion.size() - 1, base, profundidad + 1, destino);
+}
+
+// Valor de un campo: partes {..}, "..", numeros o macros unidas con '#'.
+// Deja 'i' en la coma o el cierre que lo termina.
+bool leerValor(string_view texto, size_t& i, size_t fin, const BaseBibliografica& base, int profundidad,
+               string& destino) {
+    while (true) {
+        while (i < fin && esEspacio(texto[i])) i++;
+        if (i >= fin) return false;
+
+        char c = texto[i];
+        if (c == '{' || c == '"') {
+            char cierre = c == '{' ? '}' : '"';
+            int llaves = 0;
+            size_t inicio = ++i;
+            for (; i < fin; i++) {
+                if (texto[i] == '{') {
+                    llaves++;
+                } else if (texto[i] == '}') {
+                    if (llaves == 0) break;
+                    llaves--;
+                } else if (texto[i] == '"' && cierre == '"' && llaves == 0) {
+                    break;
+                }
+            }
+            if (i >= fin || texto[i] != cierre) return false;
+            agregarNormalizado(texto.substr(inicio, i - inicio), destino);
+            i++;
+        } else {
+            size_t inicio = i;
+            while (i < fin && !esEspacio(texto[i]) && texto[i] != ',' && texto[i] != '#') i++;
+            string_view palabra = texto.substr(inicio, i - inicio);
+            if (palabra.empty()) return false;
+            if (isdigit(static_cast<unsigned char>(palabra[0]))) {
+                destino.append(palabra);
+            } else {
+                expandirMacro(palabra, base, profundidad, destino);
+            }
+        }
+
+        while (i < fin && esEspacio(texto[i])) i++;
+        if (i < fin && texto[i] == '#') {
+            i++;
+            continue;
+        }
+        return true;
+    }
+}
+
+bool leerCampos(string_view entrada, const BaseBibliografica& base, CamposBib& campos) {
+    size_t apertura;
+    if (!leerCabecera(entrada, 0, campos.tipo, apertura)) return false;
+    size_t fin = entrada.size() - 1;
+    size_t i = entrada.find(',', apertura);
+    if (i == string_view::npos) return true; // entrada sin campos
+
+    while (++i < fin) {
+        while (i < fin && (esEspacio(entrada[i]) || entrada[i] == ',')) i++;
+        if (i >= fin) break;
+        size_t inicioNombre = i;
+        while (i < fin && entrada[i] != '=' && !esEspacio(entrada[i]) && entrada[i] != ',') i++;
+        string nombre = minusculas(entrada.substr(inicioNombre, i - inicioNombre));
+        while (i < fin && esEspacio(entrada[i])) i++;
+        if (i >= fin || entrada[i] != '=' || nombre.empty()) return false;
+        i++;
+
+        string valor;
+        if (!leerValor(entrada, i, fin, base, 0, valor)) return false;
+        campos.valores.emplace(move(nombre), string(recortar(valor)));
+        if (i < fin && entrada[i] != ',') return false;
+    }
+    return true;
+}
+
+} // namespace
+
+// ===============================
+// FORMATO DE LAS ENTRADAS
+// ===============================
+
+namespace {
+
+// Parte 'texto' en cada " and " que no este entre llaves.
+vector<string> separarNombres(const string& texto) {
+    vector<string> nombres;
+    int llaves = 0;
+    size_t inicio = 0;
+    for (size_t i = 0; i < texto.size(); i++) {
+        if (texto[i] == '{') {
+            llaves++;
+        } else if (texto[i] == '}') {
+            llaves--;
+        } else if (llaves == 0 && texto[i] == ' ' && i + 5 <= texto.size() &&
+                   igualesSinMayusculas(string_view(texto).substr(i, 5), " and ")) {
+            nombres.emplace_back(recortar(string_view(texto).substr(inicio, i - inicio)));
+            inicio = i + 5;
+            i += 4;
+        }
+    }
+    nombres.emplace_back(recortar(string_view(texto).substr(inicio)));
+    return nombres;
+}
+
+// "Apellido, Nombre" -> "Nombre Apellido"; "von Apellido, Jr, Nombre" ->
+// "Nombre von Apellido Jr". Sin comas se deja como esta.
+string ordenarNombre(const string& nombre) {
+    vector<string_view> partes;
+    int llaves = 0;
+    size_t inicio = 0;
+    for (size_t i = 0; i < nombre.size(); i++) {
+        if (nombre[i] == '{') llaves++;
+        else if (nombre[i] == '}') llaves--;
+        else if (nombre[i] == ',' && llaves == 0) {
+            partes.push_back(recortar(string_view(nombre).substr(inicio, i - inicio)));
+            inicio = i + 1;
+        }
+    }
+    partes.push_back(recortar(string_view(nombre).substr(inicio)));
+
+    string resultado;
+    auto agregar = [&](string_view parte) {
+        if (parte.empty()) return;
+        if (!resultado.empty()) resultado += ' ';
+        resultado.append(parte);
+    };
+    if (partes.size() == 2) {
+        agregar(partes[1]);
+        agregar(partes[0]);
+    } else if (partes.size() >= 3) {
+        agregar(partes[2]);
+        agregar(partes[0]);
+        agregar(partes[1]);
+    } else {
+        agregar(partes[0]);
+    }
+    return resultado;
+}
+
+// "A and B and C" -> "A, B y C"; "A and others" -> "A et al."
+string formatearAutores(const string& texto) {
+    if (texto.empty()) return string();
+    vector<string> nombres = separarNombres(texto);
+    bool otros = nombres.size() > 1 && igualesSinMayusculas(nombres.back(), "others");
+    if (otros) nombres.pop_back();
+
+    string resultado;
+    for (size_t i = 0; i < nombres.size(); i++) {
+        if (i > 0) resultado += (i + 1 == nombres.size() && !otros) ? " y " : ", ";
+        resultado += ordenarNombre(nombres[i]);
+    }
+    if (otros) resultado += " et al.";
+    return resultado;
+}
+
+// "12-34" -> "12--34"
+string formatearPaginas(const string& paginas) {
+    string resultado;
+    for (size_t i = 0; i < paginas.size(); i++) {
+        resultado += paginas[i];
+        if (paginas[i] == '-' && (i + 1 >= paginas.size() || paginas[i + 1] != '-') &&
+            (i == 0 || paginas[i - 1] != '-')) {
+            resultado += '-';
+        }
+    }
+    return resultado;
+}
+
+bool terminaEnPunto(const string& texto) {
+    size_t fin = texto.size();
+    while (fin > 0 && texto[fin - 1] == '}') fin--;
+    return fin > 0 && (texto[fin - 1] == '.' || texto[fin - 1] == '?' || texto[fin - 1] == '!');
+}
+
+// La frase seguida de ". " (o solo " " si ya termina en punto).
+string oracion(const string& texto) {
+    if (texto.empty()) return string();
+    return texto + (terminaEnPunto(texto) ? " " : ". ");
+}
+
+string unir(const vector<string>& partes) {
+    string resultado;
+    for (const auto& parte : partes) {
+        if (parte.empty()) continue;
+        if (!resultado.empty()) resultado += ", ";
+        resultado += parte;
+    }
+    return resultado;
+}
+
+// antes + enfasis + separador + datos + "."
+void componer(EntradaBibliografia& entrada, string antes, const string& enfasis, const char* separador,
+              const string& datos) {
+    entrada.enfasis = enfasis;
+    if (!enfasis.empty()) {
+        entrada.despues = datos.empty() ? "." : separador + datos + ".";
+        if (datos.empty() && terminaEnPunto(enfasis)) entrada.despues.clear();
+    } else {
+        if (!datos.empty()) antes += datos + ".";
+        while (!antes.empty() && antes.back() == ' ') antes.pop_back();
+    }
+    entrada.antes = move(antes);
+}
+
+} // namespace
+
+bool formatearEntradaBib(string_view texto, const BaseBibliografica& base, EntradaBibliografia& entrada) {
+    CamposBib campos;
+    if (!leerCampos(texto, base, campos)) return false;
+
+    string autores = formatearAutores(campos["author"]);
+    if (autores.empty() && !campos["editor"].empty()) {
+        autores = formatearAutores(campos["editor"]) + " (ed.)";
+    }
+    const string& tipo = campos.tipo;
+    const string& titulo = campos["title"];
+    const string& anio = campos["year"];
+
+    if (tipo == "article") {
+        string volumen = campos["volume"];
+        if (!campos["number"].empty()) volumen += "(" + campos["number"] + ")";
+        if (!campos["pages"].empty()) {
+            volumen += (volumen.empty() ? "" : ":") + formatearPaginas(campos["pages"]);
+        }
+        componer(entrada, oracion(autores) + oracion(titulo), campos["journal"], ", ", unir({volumen, anio}));
+    } else if (tipo == "book" || tipo == "booklet" || tipo == "manual") {
+        componer(entrada, oracion(autores), titulo, ". ",
+                 unir({campos["edition"].empty() ? "" : campos["edition"] + " ed.", campos["publisher"],
+                       campos["address"], anio}));
+    } else if (tipo == "inproceedings" || tipo == "incollection" || tipo == "conference") {
+        string paginas = campos["pages"].empty() ? "" : "pp. " + formatearPaginas(campos["pages"]);
+        componer(entrada, oracion(autores) + oracion(titulo) + "En ", campos["booktitle"], ", ",
+                 unir({paginas, campos["publisher"], anio}));
+    } else if (tipo == "phdthesis" || tipo == "mastersthesis") {
+        componer(entrada, oracion(autores), titulo, ". ",
+                 unir({tipo == "phdthesis" ? "Tesis doctoral" : "Tesis de maestría", campos["school"], anio}));
+    } else {
+        componer(entrada, oracion(autores) + oracion(titulo), "", "",
+                 unir({campos["howpublished"], campos["institution"], campos["organization"],
+                       campos["publisher"], campos["school"], anio}));
+    }
+    return true;
+}
+
+vector<string> separarClaves(const string& claves) {
+    vector<string> resultado;
+    size_t inicio = 0;
+    while (inicio <= claves.size()) {
+        size_t coma = claves.find(',', inicio);
+        if (coma == string::npos) coma = claves.size();
+        string_view clave = recortar(string_view(claves).substr(inicio, coma - inicio));
+        if (!clave.empty()) resultado.emplace_back(clave);
+        inicio = coma + 1;
+    }
+    return resultado;
+}
+
+string anclaBib(const string& clave) {
+    return "bib-" + minusculas(clave);
+}
+
+string textoPlanoBib(string_view texto) {
+    string resultado;
+    resultado.reserve(texto.size());
+    for (size_t i = 0; i < texto.size(); i++) {
+        char c = texto[i];
+        if (c == '{' || c == '}') continue;
+        if (c == '~') {
+            resultado += ' ';
+        } else if (c == '-' && i + 1 < texto.size() && texto[i + 1] == '-') {
+            resultado += "\xE2\x80\x93"; // raya corta
+            while (i + 1 < texto.size() && texto[i + 1] == '-') i++;
+        } else if (c == '\\' && i + 1 < texto.size() && strchr("&%$#_", texto[i + 1]) != nullptr) {
+            resultado += texto[++i];
+        } else {
+            resultado += c;
+        }
+    }
+    return resultado;
+}
+
+// ===============================
+// RESOLUCION
+// ===============================
+
+vector<Diagnostico> resolverBibliografia(NodoDocumento* documento, const string& directorioBase) {
+    vector<Diagnostico> diagnosticos;
+
+    NodoBibliografia* bibliografia = nullptr;
+    vector<NodoCita*> citas;
+    for (auto& hijo : documento->hijos) {
+        if (auto cita = dynamic_cast<NodoCita*>(hijo.get())) {
+            citas.push_back(cita);
+        } else if (auto b = dynamic_cast<NodoBibliografia*>(hijo.get())) {
+            if (bibliografia == nullptr) {
+                bibliografia = b;
+            } else {
+                diagnosticos.emplace_back(Severidad::ADVERTENCIA, b->linea, b->columna,
+                    "Solo se usa la primera bibliografia() del documento");
+            }
+        }
+    }
+    if (bibliografia == nullptr) {
+        for (NodoCita* cita : citas) {
+            diagnosticos.emplace_back(Severidad::ADVERTENCIA, cita->linea, cita->columna,
+                "cita() sin bibliografia() en el documento");
+        }
+        return diagnosticos;
+    }
+
+    vector<unique_ptr<BaseBibliografica>> bases;
+    for (const auto& ruta : bibliografia->rutas) {
+        string completa = directorioBase.empty() ? ruta : (filesystem::path(directorioBase) / ruta).string();
+        bases.push_back(make_unique<BaseBibliografica>(completa));
+    }
+
+    // Numero de cada clave ya citada (en minusculas); "?" si no existe
+    unordered_map<string, string> numeros;
+    bibliografia->entradas.clear();
+    for (NodoCita* cita : citas) {
+        string numero;
+        for (const auto& clave : separarClaves(cita->claves)) {
+            string minuscula = minusculas(clave);
+            auto it = numeros.find(minuscula);
+            if (it == numeros.end()) {
+                string_view texto;
+                const BaseBibliografica* encontrada = nullptr;
+                for (const auto& base : bases) {
+                    texto = base->buscar(clave);
+                    if (!texto.empty()) {
+                        encontrada = base.get();
+                        break;
+                    }
+                }
+
+                EntradaBibliografia entrada;
+                entrada.clave = clave;
+                if (encontrada == nullptr) {
+                    diagnosticos.emplace_back(Severidad::ADVERTENCIA, cita->linea, cita->columna,
+                        "Cita a una clave inexistente: \"" + clave + "\"");
+                    it = numeros.emplace(minuscula, "?").first;
+                } else if (!formatearEntradaBib(texto, *encontrada, entrada)) {
+                    diagnosticos.emplace_back(Severidad::ADVERTENCIA, cita->linea, cita->columna,
+                        "Entrada mal formada en " + encontrada->getRuta() + ": \"" + clave + "\"");
+                    it = numeros.emplace(minuscula, "?").first;
+                } else {
+                    entrada.numero = to_string(bibliografia->entradas.size() + 1);
+                    it = numeros.emplace(minuscula, entrada.numero).first;
+                    bibliografia->entradas.push_back(move(entrada));
+                }
+            }
+            if (!numero.empty()) numero += ", ";
+            numero += it->second;
+        }
+        cita->numero = numero;
+    }
+
+    return diagnosticos;
+}
@@ -0,0 +1,134 @@
+#ifndef BIBLIOGRAFIA_H
+#define BIBLIOGRAFIA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "archivo_mapeado.h"
+#include "ast.h"
+#include "diagnostico.h"
+
+using namespace std;
+
+// ===============================
+// BIBLIOGRAFIA (bibliografia() Y cita())
+// ===============================
+//
+// El compilador resuelve las citas sin BibTeX ni pasadas extra de
+// pdflatex: busca cada clave citada en los .bib, numera las entradas en
+// orden de primera cita y escribe el entorno thebibliography ya formateado.
+//
+// Un .bib de cientos de miles de entradas no se analiza entero en cada
+// compilacion. Junto a el se guarda un indice ("refs.bib.idx"): una tabla
+// hash de direccionamiento abierto con el hash de cada clave y la posicion
+// de su entrada en el .bib. El indice se proyecta con mmap y cada busqueda
+// lee una o dos cubetas y la entrada citada; solo se reconstruye (una pasada
+// lineal) cuando cambian el tamano o la fecha del .bib. Si el directorio no
+// admite escritura, el indice se arma en memoria en cada compilacion.
+//
+//   CabeceraIndiceBib
+//   CubetaIndiceBib[numeroCubetas]   numeroCubetas es potencia de dos
+//
+// Las claves se comparan sin distinguir mayusculas, como en BibTeX, y cada
+// acierto se confirma contra el .bib: una colision de hash o un indice
+// desactualizado nunca devuelven otra entrada.
+
+const uint32_t VERSION_INDICE_BIB = 1;
+const uint32_t ORDEN_BYTES_INDICE_BIB = 0x01020304;
+
+struct CabeceraIndiceBib {
+    char magia[8];           // "LATEXBIB"
+    uint32_t version;
+    uint32_t ordenBytes;
+    uint64_t tamanoBib;
+    int64_t fechaBib;        // last_write_time del .bib
+    uint64_t numeroCubetas;
+    uint64_t numeroEntradas;
+};
+
+// Cubeta vacia: longitud 0.
+struct CubetaIndiceBib {
+    uint64_t hashClave;
+    uint64_t desplazamiento; // del '@' dentro del .bib
+    uint32_t longitud;       // hasta la llave que cierra la entrada, incluida
+    uint32_t macro;          // 1 si es un @string (el hash es de su nombre)
+};
+
+static_assert(sizeof(CabeceraIndiceBib) == 48, "CabeceraIndiceBib debe ocupar 48 bytes");
+static_assert(sizeof(CubetaIndiceBib) == 24, "CubetaIndiceBib debe ocupar 24 bytes");
+
+// "refs.bib" -> "refs.bib.idx"
+string nombreIndiceBibliografia(const string& rutaBib);
+
+// Un .bib abierto con su indice.
+class BaseBibliografica {
+private:
+    string ruta;
+    unique_ptr<ArchivoMapeado> bib;
+    unique_ptr<ArchivoMapeado> archivoIndice;
+    vector<CubetaIndiceBib> indiceMemoria;
+    const CubetaIndiceBib* cubetas = nullptr;
+    size_t mascara = 0;
+    size_t entradas = 0;
+    bool reconstruido = false;
+
+    bool cargarIndice(uint64_t tamano, int64_t fecha);
+    void reconstruir(uint64_t tamano, int64_t fecha);
+    string_view buscarCubeta(string_view nombre, bool macro) const;
+
+public:
+    // Lanza runtime_error si el .bib no se puede abrir.
+    explicit BaseBibliografica(const string& ruta);
+
+    const string& getRuta() const {
+        return ruta;
+    }
+
+    // Texto de la entrada con esa clave, desde '@' hasta la llave que la
+    // cierra; vacio si no existe.
+    string_view buscar(string_view clave) const {
+        return buscarCubeta(clave, false);
+    }
+
+    // Entrada @string que define la macro.
+    string_view buscarMacro(string_view nombre) const {
+        return buscarCubeta(nombre, true);
+    }
+
+    size_t numeroEntradas() const {
+        return entradas;
+    }
+
+    // true si el indice del disco no servia y se volvio a construir.
+    bool indiceReconstruido() const {
+        return reconstruido;
+    }
+};
+
+// Da formato a la entrada con su clave; el texto conserva el marcado TeX
+// del .bib (llaves, acentos). Devuelve false si la entrada esta mal formada.
+bool formatearEntradaBib(string_view entrada, const BaseBibliografica& base, EntradaBibliografia& destino);
+
+// "a, b,c" -> {"a", "b", "c"}
+vector<string> separarClaves(const string& claves);
+
+// "Knuth84" -> "bib-knuth84": ancla de una entrada en las salidas HTML y
+// Markdown. Las claves se comparan sin mayusculas, asi que la cita y la
+// entrada pueden escribirla distinto.
+string anclaBib(const string& clave);
+
+// Texto de una entrada sin el marcado TeX mas comun (llaves, "--", "~"),
+// para las salidas HTML y Markdown.
+string textoPlanoBib(string_view texto);
+
+// Numera las citas en orden de aparicion y llena la bibliografia con las
+// entradas citadas. Las rutas de los .bib son relativas a directorioBase.
+// Las claves inexistentes y las citas sin bibliografia() se informan como
+// advertencias y se imprimen como "?"; un .bib que no existe es un error.
+vector<Diagnostico> resolverBibliografia(NodoDocumento* documento, const string& directorioBase);
+
+#endif
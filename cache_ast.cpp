@@ -0,0 +1,393 @@
+#include "cache_ast.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+using namespace std;
+
+// ===============================
+// ESCRITURA
+// ===============================
+
+namespace {
+
+class EscritorCacheAst {
+private:
+    vector<RegistroTokenCache> tokens;
+    vector<RegistroNodoCache> nodos;
+    vector<CadenaCache> listas;
+    string cadenas;
+    unordered_map<string, CadenaCache> cadenasVistas;
+
+    CadenaCache agregarCadena(const string& texto) {
+        auto it = cadenasVistas.find(texto);
+        if (it != cadenasVistas.end()) return it->second;
+        if (cadenas.size() + texto.size() > UINT32_MAX) {
+            throw runtime_error("El documento es demasiado grande para la cache de AST");
+        }
+        CadenaCache cadena{static_cast<uint32_t>(cadenas.size()), static_cast<uint32_t>(texto.size())};
+        cadenas += texto;
+        cadenasVistas.emplace(texto, cadena);
+        return cadena;
+    }
+
+    static RegistroNodoCache registro(TipoNodoCache tipo, const NodoAST& nodo) {
+        RegistroNodoCache r;
+        memset(&r, 0, sizeof(r));
+        r.tipo = tipo;
+        r.linea = nodo.linea;
+        r.columna = nodo.columna;
+        return r;
+    }
+
+    void campos(RegistroNodoCache& r, const string& a, const string& b = string(),
+                const string& c = string()) {
+        r.campos[0] = agregarCadena(a);
+        r.campos[1] = agregarCadena(b);
+        r.campos[2] = agregarCadena(c);
+    }
+
+    // Convierte un nodo en registro; los elementos de una lista se agregan
+    // al final del arreglo de nodos y se enlazan por indice.
+    RegistroNodoCache convertir(const NodoAST* nodo, vector<pair<const NodoLista*, size_t>>& pendientes,
+                                size_t indice) {
+        if (auto n = dynamic_cast<const NodoConfiguracion*>(nodo)) {
+            RegistroNodoCache r = registro(TipoNodoCache::CONFIGURACION, *n);
+            campos(r, n->clave, n->valor);
+            return r;
+        } else if (auto n = dynamic_cast<const NodoSeccion*>(nodo)) {
+            RegistroNodoCache r = registro(TipoNodoCache::SECCION, *n);
+            campos(r, n->nivel, n->titulo, n->numero);
+            return r;
+        } else if (auto n = dynamic_cast<const NodoTexto*>(nodo)) {
+            RegistroNodoCache r = registro(TipoNodoCache::TEXTO, *n);
+            campos(r, n->contenido, n->estilo, n->alineacion);
+            return r;
+        } else if (auto n = dynamic_cast<const NodoLista*>(nodo)) {
+            RegistroNodoCache r = registro(TipoNodoCache::LISTA, *n);
+            campos(r, n->tipo);
+            pendientes.emplace_back(n, indice);
+            return r;
+        } else if (auto n = dynamic_cast<const NodoEcuacion*>(nodo)) {
+            RegistroNodoCache r = registro(TipoNodoCache::ECUACION, *n);
+            campos(r, n->contenido, n->tipo, n->numero);
+            return r;
+        } else if (auto n = dynamic_cast<const NodoMetadatos*>(nodo)) {
+            RegistroNodoCache r = registro(TipoNodoCache::METADATOS, *n);
+            campos(r, n->tipo, n->contenido);
+            return r;
+        } else if (auto n = dynamic_cast<const NodoComando*>(nodo)) {
+            RegistroNodoCache r = registro(TipoNodoCache::COMANDO, *n);
+            campos(r, n->comando, n->contenido);
+            return r;
+        } else if (auto n = dynamic_cast<const NodoTablaCsv*>(nodo)) {
+            RegistroNodoCache r = registro(TipoNodoCache::TABLA_CSV, *n);
+            campos(r, n->ruta);
+            r.primero = static_cast<uint32_t>(listas.size());
+            r.cantidad = static_cast<uint32_t>(n->opciones.size());
+            for (const auto& opcion : n->opciones) listas.push_back(agregarCadena(opcion));
+            return r;
+        } else if (auto n = dynamic_cast<const NodoFigura*>(nodo)) {
+            RegistroNodoCache r = registro(TipoNodoCache::FIGURA, *n);
+            campos(r, n->ruta, n->leyenda, n->numero);
+            return r;
+        } else if (auto n = dynamic_cast<const NodoEtiqueta*>(nodo)) {
+            RegistroNodoCache r = registro(TipoNodoCache::ETIQUETA, *n);
+            campos(r, n->clave);
+            return r;
+        } else if (auto n = dynamic_cast<const NodoReferencia*>(nodo)) {
+            RegistroNodoCache r = registro(TipoNodoCache::REFERENCIA, *n);
+            campos(r, n->clave, n->numero);
+            return r;
+        } else if (auto n = dynamic_cast<const NodoIndice*>(nodo)) {
+            RegistroNodoCache r = registro(TipoNodoCache::INDICE, *n);
+            campos(r, string());
+            r.primero = static_cast<uint32_t>(listas.size());
+            r.cantidad = static_cast<uint32_t>(n->entradas.size() * 3);
+            for (const auto& entrada : n->entradas) {
+                listas.push_back(agregarCadena(entrada.nivel));
+                listas.push_back(agregarCadena(entrada.numero));
+                listas.push_back(agregarCadena(entrada.titulo));
+            }
+            return r;
+        } else if (auto n = dynamic_cast<const NodoCita*>(nodo)) {
+            RegistroNodoCache r = registro(TipoNodoCache::CITA, *n);
+            campos(r, n->claves, n->nota, n->numero);
+            return r;
+        } else if (auto n = dynamic_cast<const NodoBibliografia*>(nodo)) {
+            RegistroNodoCache r = registro(TipoNodoCache::BIBLIOGRAFIA, *n);
+            campos(r, string());
+            r.primero = static_cast<uint32_t>(listas.size());
+            r.cantidad = static_cast<uint32_t>(n->rutas.size() + n->entradas.size() * 5);
+            r.reservado = static_cast<uint32_t>(n->rutas.size());
+            for (const auto& ruta : n->rutas) listas.push_back(agregarCadena(ruta));
+            for (const auto& entrada : n->entradas) {
+                listas.push_back(agregarCadena(entrada.clave));
+                listas.push_back(agregarCadena(entrada.numero));
+                listas.push_back(agregarCadena(entrada.antes));
+                listas.push_back(agregarCadena(entrada.enfasis));
+                listas.push_back(agregarCadena(entrada.despues));
+            }
+            return r;
+        }
+        throw runtime_error("Nodo sin representacion en la cache de AST: " + nodo->toString());
+    }
+
+    template <typename T>
+    static void agregarSeccion(string& salida, const vector<T>& elementos) {
+        salida.append(reinterpret_cast<const char*>(elementos.data()), elementos.size() * sizeof(T));
+        salida.resize((salida.size() + 7) & ~size_t(7), '\0');
+    }
+
+public:
+    string serializar(const vector<Token>& entrada, const NodoDocumento& documento, uint64_t hashFuente) {
+        tokens.reserve(entrada.size());
+        for (const auto& token : entrada) {
+            tokens.push_back(RegistroTokenCache{static_cast<uint32_t>(token.tipo), token.linea,
+                                                token.columna, agregarCadena(token.valor)});
+        }
+
+        vector<pair<const NodoLista*, size_t>> listasPendientes;
+        for (const auto& hijo : documento.hijos) {
+            nodos.push_back(convertir(hijo.get(), listasPendientes, nodos.size()));
+        }
+        // Elementos de las listas, contiguos por lista. Se recorre con indice
+        // porque convertir() puede agregar listas anidadas.
+        for (size_t k = 0; k < listasPendientes.size(); k++) {
+            const NodoLista* lista = listasPendientes[k].first;
+            size_t indiceLista = listasPendientes[k].second;
+            uint32_t primero = static_cast<uint32_t>(nodos.size());
+            for (const auto& elemento : lista->elementos) {
+                nodos.push_back(convertir(elemento.get(), listasPendientes, nodos.size()));
+            }
+            nodos[indiceLista].primero = primero;
+            nodos[indiceLista].cantidad = static_cast<uint32_t>(lista->elementos.size());
+        }
+
+        CabeceraCacheAst cabecera;
+        memset(&cabecera, 0, sizeof(cabecera));
+        memcpy(cabecera.magia, "LATEXAST", 8);
+        cabecera.version = VERSION_CACHE_AST;
+        cabecera.ordenBytes = ORDEN_BYTES_CACHE_AST;
+        cabecera.hashFuente = hashFuente;
+        cabecera.numeroTokens = static_cast<uint32_t>(tokens.size());
+        cabecera.numeroNodos = static_cast<uint32_t>(nodos.size());
+        cabecera.numeroRaiz = static_cast<uint32_t>(documento.hijos.size());
+        cabecera.numeroListas = static_cast<uint32_t>(listas.size());
+
+        string salida(sizeof(cabecera), '\0');
+        cabecera.inicioTokens = salida.size();
+        agregarSeccion(salida, tokens);
+        cabecera.inicioNodos = salida.size();
+        agregarSeccion(salida, nodos);
+        cabecera.inicioListas = salida.size();
+        agregarSeccion(salida, listas);
+        cabecera.inicioCadenas = salida.size();
+        cabecera.tamanoCadenas = cadenas.size();
+        salida += cadenas;
+
+        memcpy(&salida[0], &cabecera, sizeof(cabecera));
+        return salida;
+    }
+};
+
+} // namespace
+
+string serializarCacheAst(const vector<Token>& tokens, const NodoDocumento& documento,
+                          uint64_t hashFuente) {
+    EscritorCacheAst escritor;
+    return escritor.serializar(tokens, documento, hashFuente);
+}
+
+string nombreArchivoCacheAst(const string& archivoTex) {
+    return archivoTex + "ast";
+}
+
+// ===============================
+// LECTURA
+// ===============================
+
+CacheAst::CacheAst(const string& ruta) : archivo(ruta) {
+    string_view datos = archivo.contenido();
+    base = datos.data();
+    cabecera = reinterpret_cast<const CabeceraCacheAst*>(base);
+
+    auto invalido = [&](const string& motivo) {
+        return runtime_error("Cache de AST no valida (" + motivo + "): " + ruta);
+    };
+
+    if (datos.size() < sizeof(CabeceraCacheAst) || memcmp(cabecera->magia, "LATEXAST", 8) != 0) {
+        throw invalido("no es un archivo .texast");
+    }
+    if (cabecera->ordenBytes != ORDEN_BYTES_CACHE_AST) {
+        throw invalido("orden de bytes distinto");
+    }
+    if (cabecera->version != VERSION_CACHE_AST) {
+        throw invalido("version " + to_string(cabecera->version) + ", se esperaba " +
+                       to_string(VERSION_CACHE_AST));
+    }
+
+    auto dentro = [&](uint64_t inicio, uint64_t bytes) {
+        return inicio % 4 == 0 && inicio <= datos.size() && bytes <= datos.size() - inicio;
+    };
+    if (!dentro(cabecera->inicioTokens, uint64_t(cabecera->numeroTokens) * sizeof(RegistroTokenCache)) ||
+        !dentro(cabecera->inicioNodos, uint64_t(cabecera->numeroNodos) * sizeof(RegistroNodoCache)) ||
+        !dentro(cabecera->inicioListas, uint64_t(cabecera->numeroListas) * sizeof(CadenaCache)) ||
+        !dentro(cabecera->inicioCadenas, cabecera->tamanoCadenas) ||
+        cabecera->numeroRaiz > cabecera->numeroNodos) {
+        throw invalido("secciones fuera del archivo");
+    }
+
+    // Las cadenas y los enlaces se validan una vez aqui para que los
+    // accesores no tengan que comprobar limites
+    auto cadenaValida = [&](const CadenaCache& c) {
+        return uint64_t(c.desplazamiento) + c.longitud <= cabecera->tamanoCadenas;
+    };
+    for (size_t i = 0; i < numeroTokens(); i++) {
+        if (!cadenaValida(token(i).valor)) throw invalido("cadena fuera del bloque");
+    }
+    for (size_t i = 0; i < numeroListas(); i++) {
+        if (!cadenaValida(lista(i))) throw invalido("cadena fuera del bloque");
+    }
+    for (size_t i = 0; i < numeroNodos(); i++) {
+        const RegistroNodoCache& n = nodo(i);
+        for (const auto& campo : n.campos) {
+            if (!cadenaValida(campo)) throw invalido("cadena fuera del bloque");
+        }
+        uint64_t fin = uint64_t(n.primero) + n.cantidad;
+        if (n.tipo == TipoNodoCache::LISTA && n.cantidad > 0 && (n.primero <= i || fin > numeroNodos())) {
+            throw invalido("elementos de lista fuera del arreglo");
+        }
+        if ((n.tipo == TipoNodoCache::TABLA_CSV || n.tipo == TipoNodoCache::INDICE ||
+             n.tipo == TipoNodoCache::BIBLIOGRAFIA) &&
+            fin > numeroListas()) {
+            throw invalido("lista de cadenas fuera del arreglo");
+        }
+        if (n.tipo == TipoNodoCache::BIBLIOGRAFIA && n.reservado > n.cantidad) {
+            throw invalido("rutas de bibliografia fuera de la lista");
+        }
+    }
+}
+
+vector<Token> CacheAst::tokens() const {
+    vector<Token> resultado;
+    resultado.reserve(numeroTokens());
+    for (size_t i = 0; i < numeroTokens(); i++) {
+        const RegistroTokenCache& t = token(i);
+        resultado.emplace_back(static_cast<TipoToken>(t.tipo), string(cadena(t.valor)), t.linea, t.columna);
+    }
+    return resultado;
+}
+
+static unique_ptr<NodoAST> construirNodo(const CacheAst& cache, size_t indice) {
+    const RegistroNodoCache& r = cache.nodo(indice);
+    string a(cache.cadena(r.campos[0]));
+    string b(cache.cadena(r.campos[1]));
+    string c(cache.cadena(r.campos[2]));
+
+    unique_ptr<NodoAST> nodo;
+    switch (r.tipo) {
+        case TipoNodoCache::CONFIGURACION:
+            nodo = make_unique<NodoConfiguracion>(move(a), move(b));
+            break;
+        case TipoNodoCache::SECCION: {
+            auto n = make_unique<NodoSeccion>(move(a), move(b));
+            n->numero = move(c);
+            nodo = move(n);
+            break;
+        }
+        case TipoNodoCache::TEXTO:
+            nodo = make_unique<NodoTexto>(move(a), move(b), move(c));
+            break;
+        case TipoNodoCache::LISTA: {
+            auto n = make_unique<NodoLista>();
+            n->tipo = move(a);
+            for (uint32_t i = 0; i < r.cantidad; i++) {
+                n->elementos.push_back(construirNodo(cache, r.primero + i));
+            }
+            nodo = move(n);
+            break;
+        }
+        case TipoNodoCache::ECUACION: {
+            auto n = make_unique<NodoEcuacion>(move(a), move(b));
+            n->numero = move(c);
+            nodo = move(n);
+            break;
+        }
+        case TipoNodoCache::METADATOS:
+            nodo = make_unique<NodoMetadatos>(move(a), move(b));
+            break;
+        case TipoNodoCache::COMANDO:
+            nodo = make_unique<NodoComando>(move(a), move(b));
+            break;
+        case TipoNodoCache::TABLA_CSV: {
+            auto n = make_unique<NodoTablaCsv>(move(a));
+            for (uint32_t i = 0; i < r.cantidad; i++) {
+                n->opciones.emplace_back(cache.cadena(cache.lista(r.primero + i)));
+            }
+            nodo = move(n);
+            break;
+        }
+        case TipoNodoCache::FIGURA: {
+            auto n = make_unique<NodoFigura>(move(a), move(b));
+            n->numero = move(c);
+            nodo = move(n);
+            break;
+        }
+        case TipoNodoCache::ETIQUETA:
+            nodo = make_unique<NodoEtiqueta>(move(a));
+            break;
+        case TipoNodoCache::REFERENCIA: {
+            auto n = make_unique<NodoReferencia>(move(a));
+            n->numero = move(b);
+            nodo = move(n);
+            break;
+        }
+        case TipoNodoCache::INDICE: {
+            auto n = make_unique<NodoIndice>();
+            for (uint32_t i = 0; i + 2 < r.cantidad; i += 3) {
+                n->entradas.push_back(EntradaIndice{string(cache.cadena(cache.lista(r.primero + i))),
+                                                    string(cache.cadena(cache.lista(r.primero + i + 1))),
+                                                    string(cache.cadena(cache.lista(r.primero + i + 2)))});
+            }
+            nodo = move(n);
+            break;
+        }
+        case TipoNodoCache::CITA: {
+            auto n = make_unique<NodoCita>(move(a));
+            n->nota = move(b);
+            n->numero = move(c);
+            nodo = move(n);
+            break;
+        }
+        case TipoNodoCache::BIBLIOGRAFIA: {
+            auto n = make_unique<NodoBibliografia>();
+            auto elemento = [&](uint32_t i) { return string(cache.cadena(cache.lista(r.primero + i))); };
+            for (uint32_t i = 0; i < r.reservado; i++) {
+                n->rutas.push_back(elemento(i));
+            }
+            for (uint32_t i = r.reservado; i + 4 < r.cantidad; i += 5) {
+                n->entradas.push_back(EntradaBibliografia{elemento(i), elemento(i + 1), elemento(i + 2),
+                                                          elemento(i + 3), elemento(i + 4)});
+            }
+            nodo = move(n);
+            break;
+        }
+        default:
+            throw runtime_error("Tipo de nodo desconocido en la cache de AST: " +
+                                to_string(static_cast<uint32_t>(r.tipo)));
+    }
+    nodo->linea = r.linea;
+    nodo->columna = r.columna;
+    return nodo;
+}
+
+unique_ptr<NodoDocumento> CacheAst::documento() const {
+    auto documento = make_unique<NodoDocumento>();
+    for (size_t i = 0; i < numeroRaiz(); i++) {
+        documento->hijos.push_back(construirNodo(*this, i));
+    }
+    return documento;
+}
@@ -0,0 +1,174 @@
+#ifndef CACHE_AST_H
+#define CACHE_AST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "archivo_mapeado.h"
+#include "ast.h"
+#include "token.h"
+
+using namespace std;
+
+// ===============================
+// CACHE BINARIA DE TOKENS Y AST (.texast)
+// ===============================
+//
+// Formato pensado para proyectarse con mmap y usarse sin deserializar:
+// registros de tamano fijo, desplazamientos en lugar de punteros (el archivo
+// es reubicable) y todas las cadenas en un solo bloque, sin repetir.
+//
+//   CabeceraCacheAst
+//   RegistroTokenCache[numeroTokens]
+//   RegistroNodoCache[numeroNodos]   los numeroRaiz primeros son los hijos
+//                                    del documento; luego los anidados
+//   CadenaCache[numeroListas]        listas de cadenas (opciones, indice)
+//   bloque de cadenas (UTF-8, sin terminador)
+//
+// Todos los enteros van en el orden de bytes de la maquina que escribio el
+// archivo; el lector lo comprueba con 'ordenBytes' y la version, y rechaza
+// archivos de otra version en lugar de interpretarlos mal.
+
+const uint32_t VERSION_CACHE_AST = 3;
+const uint32_t ORDEN_BYTES_CACHE_AST = 0x01020304;
+
+struct CadenaCache {
+    uint32_t desplazamiento; // dentro del bloque de cadenas
+    uint32_t longitud;
+};
+
+struct CabeceraCacheAst {
+    char magia[8];           // "LATEXAST"
+    uint32_t version;
+    uint32_t ordenBytes;
+    uint64_t hashFuente;     // hashContenido() del .texes compilado
+    uint32_t numeroTokens;
+    uint32_t numeroNodos;
+    uint32_t numeroRaiz;
+    uint32_t numeroListas;
+    uint64_t inicioTokens;
+    uint64_t inicioNodos;
+    uint64_t inicioListas;
+    uint64_t inicioCadenas;
+    uint64_t tamanoCadenas;
+};
+
+struct RegistroTokenCache {
+    uint32_t tipo;           // TipoToken
+    int32_t linea;
+    int32_t columna;
+    CadenaCache valor;
+};
+
+enum class TipoNodoCache : uint32_t {
+    CONFIGURACION = 1,
+    SECCION,
+    TEXTO,
+    LISTA,
+    ECUACION,
+    METADATOS,
+    COMANDO,
+    TABLA_CSV,
+    FIGURA,
+    ETIQUETA,
+    REFERENCIA,
+    INDICE,
+    CITA,
+    BIBLIOGRAFIA
+};
+
+// Campos por tipo de nodo (sin usar: longitud 0):
+//   CONFIGURACION clave, valor        SECCION    nivel, titulo, numero
+//   TEXTO   contenido, estilo, alineacion
+//   LISTA   tipo; primero/cantidad: elementos (indices de nodo)
+//   ECUACION contenido, tipo, numero  METADATOS  tipo, contenido
+//   COMANDO comando, contenido        FIGURA     ruta, leyenda, numero
+//   TABLA_CSV ruta; primero/cantidad: opciones (indices de lista)
+//   ETIQUETA clave                    REFERENCIA clave, numero
+//   INDICE  primero/cantidad: nivel, numero y titulo de cada entrada, de a tres
+//   CITA    claves, nota, numero
+//   BIBLIOGRAFIA primero/cantidad: las 'reservado' rutas y luego clave,
+//           numero, antes, enfasis y despues de cada entrada, de a cinco
+struct RegistroNodoCache {
+    TipoNodoCache tipo;
+    int32_t linea;
+    int32_t columna;
+    uint32_t primero;
+    uint32_t cantidad;
+    uint32_t reservado;
+    CadenaCache campos[3];
+};
+
+static_assert(sizeof(CadenaCache) == 8, "CadenaCache debe ocupar 8 bytes");
+static_assert(sizeof(CabeceraCacheAst) == 80, "CabeceraCacheAst debe ocupar 80 bytes");
+static_assert(sizeof(RegistroTokenCache) == 20, "RegistroTokenCache debe ocupar 20 bytes");
+static_assert(sizeof(RegistroNodoCache) == 48, "RegistroNodoCache debe ocupar 48 bytes");
+
+// Serializa los tokens y el AST (ya resuelto) de un documento.
+string serializarCacheAst(const vector<Token>& tokens, const NodoDocumento& documento,
+                          uint64_t hashFuente);
+
+// "doc.tex" -> "doc.texast"
+string nombreArchivoCacheAst(const string& archivoTex);
+
+// Vista de solo lectura sobre un archivo .texast proyectado en memoria.
+// Los accesores devuelven referencias dentro de la proyeccion: no se copia
+// nada hasta que se pide un Token o un NodoDocumento.
+class CacheAst {
+private:
+    ArchivoMapeado archivo;
+    const char* base;
+    const CabeceraCacheAst* cabecera;
+
+public:
+    // Lanza runtime_error si el archivo no existe, no es una cache de esta
+    // version o sus desplazamientos salen del archivo.
+    explicit CacheAst(const string& ruta);
+
+    uint64_t hashFuente() const {
+        return cabecera->hashFuente;
+    }
+
+    size_t numeroTokens() const {
+        return cabecera->numeroTokens;
+    }
+
+    size_t numeroNodos() const {
+        return cabecera->numeroNodos;
+    }
+
+    size_t numeroListas() const {
+        return cabecera->numeroListas;
+    }
+
+    // Nodos hijos directos del documento: indices [0, numeroRaiz()).
+    size_t numeroRaiz() const {
+        return cabecera->numeroRaiz;
+    }
+
+    const RegistroTokenCache& token(size_t i) const {
+        return reinterpret_cast<const RegistroTokenCache*>(base + cabecera->inicioTokens)[i];
+    }
+
+    const RegistroNodoCache& nodo(size_t i) const {
+        return reinterpret_cast<const RegistroNodoCache*>(base + cabecera->inicioNodos)[i];
+    }
+
+    const CadenaCache& lista(size_t i) const {
+        return reinterpret_cast<const CadenaCache*>(base + cabecera->inicioListas)[i];
+    }
+
+    string_view cadena(const CadenaCache& c) const {
+        return string_view(base + cabecera->inicioCadenas + c.desplazamiento, c.longitud);
+    }
+
+    // Copias como estructuras del compilador, para quien las necesite.
+    vector<Token> tokens() const;
+    unique_ptr<NodoDocumento> documento() const;
+};
+
+#endif
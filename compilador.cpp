@@ -0,0 +1,506 @@
+#include "compilador.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "activos.h"
+#include "formatos.h"
+#include "analizador_lexico.h"
+#include "cache_ast.h"
+#include "contadores.h"
+#include "analizador_sintactico.h"
+#include "bibliografia.h"
+#include "emisor_html.h"
+#include "emisor_markdown.h"
+#include "generador_latex.h"
+#include "hash.h"
+#include "latencias.h"
+#include "macros.h"
+#include "memoria.h"
+#include "referencias.h"
+#include "traza.h"
+#include "validador_matematicas.h"
+
+using namespace std;
+
+// Publica las imagenes del documento en el almacen de activos y devuelve la
+// ruta con la que el .tex (escrito en directorioBase) debe incluir cada una.
+static unordered_map<string, string> publicarFiguras(NodoDocumento* ast, const OpcionesCompilacion& opciones) {
+    vector<string> originales;
+    vector<string> rutas;
+    for (auto& hijo : ast->hijos) {
+        if (auto figura = dynamic_cast<NodoFigura*>(hijo.get())) {
+            originales.push_back(figura->ruta);
+            rutas.push_back(opciones.directorioBase.empty() ? figura->ruta :
+                (filesystem::path(opciones.directorioBase) / figura->ruta).string());
+        }
+    }
+
+    unordered_map<string, string> rutasFiguras;
+    if (rutas.empty()) return rutasFiguras;
+
+    vector<string> activos = opciones.activos->resolver(rutas);
+    filesystem::path base = opciones.directorioBase.empty() ? "." : opciones.directorioBase;
+    for (size_t i = 0; i < activos.size(); i++) {
+        error_code error;
+        filesystem::path relativa = filesystem::relative(activos[i], base, error);
+        rutasFiguras[originales[i]] = (error || relativa.empty())
+            ? filesystem::absolute(activos[i]).generic_string()
+            : relativa.generic_string();
+    }
+    return rutasFiguras;
+}
+
+// Lanza runtime_error si lo que se preve para una fase supera memoriaMaxima,
+// antes de reservarlo.
+static void comprobarMemoria(const OpcionesCompilacion& opciones, const char* fase, size_t bytes) {
+    if (opciones.memoriaMaxima != 0 && bytes > opciones.memoriaMaxima) {
+        throw runtime_error(string("Memoria insuficiente en la fase '") + fase + "': se estiman " +
+                            formatearBytes(bytes) + " y el limite es " +
+                            formatearBytes(opciones.memoriaMaxima));
+    }
+}
+
+// Registra la memoria medida de una fase (maximo de la fase y del documento).
+static void registrarMemoria(ResultadoCompilacion& resultado, const OpcionesCompilacion& opciones,
+                             const char* fase, size_t bytes, size_t& maximoFase) {
+    maximoFase = max(maximoFase, bytes);
+    resultado.estadisticas.memoriaPico = max(resultado.estadisticas.memoriaPico, bytes);
+    comprobarMemoria(opciones, fase, bytes);
+}
+
+static unique_ptr<Emisor> crearEmisor(const string& formato, const string& directorioBase) {
+    if (formato == "html") return make_unique<EmisorHtml>(directorioBase);
+    if (formato == "markdown" || formato == "md") return make_unique<EmisorMarkdown>(directorioBase);
+    return nullptr;
+}
+
+bool esFormatoSalida(const string& formato) {
+    return crearEmisor(formato, "") != nullptr;
+}
+
+ResultadoCompilacion compilar(string_view entrada, const OpcionesCompilacion& opciones) {
+    ContextoCompilacion contexto;
+    return contexto.compilar(entrada, opciones);
+}
+
+// ===============================
+// CONTEXTO DE COMPILACION REUTILIZABLE
+// ===============================
+
+// Un documento cuya entrada supera esto no deja sus buferes (copia de la
+// entrada, vector de tokens) retenidos en el contexto: se liberan al
+// terminar, como si el contexto fuera nuevo.
+static const size_t BYTES_RETENIDOS_MAXIMOS = 1 << 20;
+
+// Hilo de un emisor adicional. Vive lo que el contexto y atiende un
+// documento tras otro, asi que el hilo, su pista en la traza y su grupo de
+// contadores de hardware (uno por hilo, contadores.h) se crean una vez y no
+// en cada documento.
+class HiloEmisor {
+private:
+    mutex cerrojo;
+    condition_variable cambio;
+    function<void()> tarea; // no nula mientras hay un documento en curso
+    bool detener = false;
+    thread hilo;            // al final: arranca con lo demas ya construido
+
+    void trabajar() {
+        unique_lock<mutex> bloqueo(cerrojo);
+        while (true) {
+            cambio.wait(bloqueo, [&] { return detener || tarea; });
+            if (!tarea) return;
+            bloqueo.unlock();
+            tarea();
+            bloqueo.lock();
+            tarea = nullptr;
+            cambio.notify_all();
+        }
+    }
+
+public:
+    // Solo las usa el propio hilo: con que nombre figura en que traza
+    Traza* trazaNombrada = nullptr;
+    string nombreEnTraza;
+
+    HiloEmisor() : hilo([this] { trabajar(); }) {}
+
+    ~HiloEmisor() {
+        {
+            lock_guard<mutex> bloqueo(cerrojo);
+            detener = true;
+        }
+        cambio.notify_all();
+        hilo.join();
+    }
+
+    HiloEmisor(const HiloEmisor&) = delete;
+    HiloEmisor& operator=(const HiloEmisor&) = delete;
+
+    // 'nueva' no debe lanzar excepciones.
+    void lanzar(function<void()> nueva) {
+        {
+            lock_guard<mutex> bloqueo(cerrojo);
+            tarea = move(nueva);
+        }
+        cambio.notify_all();
+    }
+
+    void esperar() {
+        unique_lock<mutex> bloqueo(cerrojo);
+        cambio.wait(bloqueo, [&] { return !tarea; });
+    }
+};
+
+struct ContextoCompilacion::Analizadores {
+    AnalizadorLexico lexico{string()};
+    AnalizadorSintactico sintactico{vector<Token>()};
+    vector<Token> tokens;
+    // Analiza los cuerpos de las macros; se crea con el primer usar()
+    unique_ptr<AnalizadorSintactico> sintacticoMacros;
+    // Uno por salida adicional; se crean con el primer documento que las pide
+    vector<unique_ptr<HiloEmisor>> hilosEmisores;
+};
+
+ContextoCompilacion::ContextoCompilacion() : analizadores(make_unique<Analizadores>()) {}
+
+ContextoCompilacion::~ContextoCompilacion() = default;
+
+// Recupera el vector de tokens del analizador sintactico (o el que dejo a
+// medias el lexico si fallo) y vacia lo que es del documento. Se puede
+// llamar mas de una vez.
+void ContextoCompilacion::terminarDocumento(size_t bytesEntrada) {
+    vector<Token> devueltos = analizadores->sintactico.devolverTokens();
+    if (devueltos.capacity() > analizadores->tokens.capacity()) {
+        analizadores->tokens = move(devueltos);
+    }
+    analizadores->tokens.clear();
+    analizadores->lexico.vaciarTablaSimbolos();
+    if (bytesEntrada > BYTES_RETENIDOS_MAXIMOS) {
+        analizadores->lexico.liberarEntrada();
+        vector<Token>().swap(analizadores->tokens);
+    }
+}
+
+ResultadoCompilacion ContextoCompilacion::compilar(string_view entrada, const OpcionesCompilacion& opciones) {
+    ResultadoCompilacion resultado;
+    resultado.estadisticas.bytesEntrada = entrada.size();
+
+    Traza* traza = opciones.traza;
+    ContadoresHardware* contadores = opciones.contadores;
+    bool volcadoIniciado = false;
+
+    // Al salir por cualquier camino (exito, error o excepcion) el contexto
+    // queda listo para el siguiente documento
+    struct FinDocumento {
+        ContextoCompilacion& contexto;
+        size_t bytes;
+        ~FinDocumento() {
+            contexto.terminarDocumento(bytes);
+        }
+    } finDocumento{*this, entrada.size()};
+
+    try {
+        // Los tokens y la tabla de simbolos solo viven mientras se usan: la
+        // tabla se vacia al terminar el analisis lexico (y la copia de la
+        // entrada se libera si el documento es grande), y los tokens pasan al
+        // sintactico y se vacian al terminar el AST. Lo que queda en el
+        // contexto es capacidad vacia.
+        comprobarMemoria(opciones, "lexico", memoriaPrevistaAnalisis(entrada.size()));
+        vector<Token>& tokens = analizadores->tokens;
+        {
+            MedicionTiempo tiempo(resultado.estadisticas.lexicoNs);
+            AnalizadorLexico& lexico = analizadores->lexico;
+            lexico.reiniciar(entrada);
+            SpanTraza span(traza, "AnalizadorLexico::analizar");
+            MedicionHardware medicion(contadores, "lexico", entrada.size());
+            lexico.analizar(tokens);
+            span.argumento("bytes", static_cast<long long>(entrada.size()));
+            span.argumento("tokens", static_cast<long long>(tokens.size()));
+            resultado.estadisticas.simbolos = lexico.getTablaSimbolos().tamano();
+            registrarMemoria(resultado, opciones, "lexico",
+                             2 * entrada.size() + memoriaTokens(tokens) +
+                                 lexico.getTablaSimbolos().bytesAproximados(),
+                             resultado.estadisticas.memoriaLexico);
+            lexico.vaciarTablaSimbolos();
+            if (entrada.size() > BYTES_RETENIDOS_MAXIMOS) {
+                lexico.liberarEntrada();
+            }
+        }
+        resultado.estadisticas.tokens = tokens.size();
+
+        unique_ptr<NodoDocumento> ast;
+        {
+            size_t bytesTokens = memoriaTokens(tokens);
+            AnalizadorSintactico& sintactico = analizadores->sintactico;
+            sintactico.reiniciar(move(tokens));
+            registrarMemoria(resultado, opciones, "sintaxis",
+                             entrada.size() + bytesTokens + sizeof(AnalizadorSintactico),
+                             resultado.estadisticas.memoriaSintaxis);
+            if (opciones.validarSintaxis) {
+                SpanTraza span(traza, "analizarSintaxis");
+                MedicionTiempo tiempo(resultado.estadisticas.sintaxisNs);
+                MedicionHardware medicion(contadores, "sintaxis", entrada.size());
+                span.argumento("tokens", static_cast<long long>(resultado.estadisticas.tokens));
+                if (!sintactico.analizarSintaxis()) {
+                    resultado.diagnosticos = sintactico.getDiagnosticos();
+                    return resultado;
+                }
+            }
+
+            {
+                SpanTraza span(traza, "construirAST");
+                MedicionTiempo tiempo(resultado.estadisticas.sintaxisNs);
+                MedicionHardware medicion(contadores, "AST", entrada.size());
+                ast = sintactico.analizar(!opciones.cacheAst);
+                span.argumento("tokens", static_cast<long long>(resultado.estadisticas.tokens));
+                span.argumento("nodos", static_cast<long long>(ast->hijos.size()));
+            }
+
+            {
+                SpanTraza span(traza, "expandirMacros");
+                MedicionTiempo tiempo(resultado.estadisticas.sintaxisNs);
+                MedicionHardware medicion(contadores, "macros", entrada.size());
+                vector<Diagnostico> avisos =
+                    expandirMacros(ast.get(), opciones.macros, analizadores->sintacticoMacros,
+                                   resultado.estadisticas.usosMacros, opciones.memoriaMaxima);
+                span.argumento("usos", static_cast<long long>(resultado.estadisticas.usosMacros));
+                bool hayErrores = any_of(avisos.begin(), avisos.end(), [](const Diagnostico& diagnostico) {
+                    return diagnostico.severidad == Severidad::ERROR;
+                });
+                resultado.diagnosticos.insert(resultado.diagnosticos.end(), avisos.begin(), avisos.end());
+                if (hayErrores) return resultado;
+            }
+            resultado.estadisticas.nodosAST = ast->hijos.size();
+
+            {
+                SpanTraza span(traza, "resolverReferencias");
+                MedicionTiempo tiempo(resultado.estadisticas.analisisNs);
+                MedicionHardware medicion(contadores, "referencias", entrada.size());
+                vector<Diagnostico> avisos = resolverReferencias(ast.get());
+                resultado.diagnosticos.insert(resultado.diagnosticos.end(), avisos.begin(), avisos.end());
+            }
+
+            {
+                SpanTraza span(traza, "resolverBibliografia");
+                MedicionTiempo tiempo(resultado.estadisticas.analisisNs);
+                MedicionHardware medicion(contadores, "bibliografia", entrada.size());
+                vector<Diagnostico> avisos = resolverBibliografia(ast.get(), opciones.directorioBase);
+                resultado.diagnosticos.insert(resultado.diagnosticos.end(), avisos.begin(), avisos.end());
+            }
+
+            if (opciones.validarMatematicas) {
+                SpanTraza span(traza, "validarMatematicas");
+                MedicionTiempo tiempo(resultado.estadisticas.analisisNs);
+                MedicionHardware medicion(contadores, "matematicas", entrada.size());
+                vector<Diagnostico> errores = validarMatematicas(ast.get(), entrada);
+                span.argumento("errores", static_cast<long long>(errores.size()));
+                if (!errores.empty()) {
+                    resultado.diagnosticos.insert(resultado.diagnosticos.end(), errores.begin(), errores.end());
+                    return resultado;
+                }
+            }
+
+            if (opciones.cacheAst) {
+                SpanTraza span(traza, "serializarCacheAst");
+                MedicionTiempo tiempo(resultado.estadisticas.analisisNs);
+                MedicionHardware medicion(contadores, "cacheAst", entrada.size());
+                resultado.cacheAst = serializarCacheAst(sintactico.getTokens(), *ast, hashContenido(entrada));
+                span.argumento("bytes", static_cast<long long>(resultado.cacheAst.size()));
+            }
+            registrarMemoria(resultado, opciones, "AST",
+                             entrada.size() + bytesTokens + memoriaAst(*ast) + resultado.cacheAst.capacity(),
+                             resultado.estadisticas.memoriaAST);
+            terminarDocumento(entrada.size());
+        }
+
+        // Desde aqui hasta el final: dependencias, activos y los emisores
+        MedicionTiempo tiempoGeneracion(resultado.estadisticas.generacionNs);
+        auto resolverRuta = [&](const string& ruta) {
+            return opciones.directorioBase.empty() ? ruta :
+                (filesystem::path(opciones.directorioBase) / ruta).string();
+        };
+        unordered_map<string, string> rutasFiguras;
+        size_t bytesTablas = 0;
+        for (auto& hijo : ast->hijos) {
+            if (auto figura = dynamic_cast<NodoFigura*>(hijo.get())) {
+                resultado.estadisticas.figuras++;
+                resultado.dependencias.push_back(resolverRuta(figura->ruta));
+            } else if (auto tabla = dynamic_cast<NodoTablaCsv*>(hijo.get())) {
+                resultado.dependencias.push_back(resolverRuta(tabla->ruta));
+                error_code error;
+                uintmax_t bytes = filesystem::file_size(resultado.dependencias.back(), error);
+                if (!error) bytesTablas += static_cast<size_t>(bytes);
+            } else if (auto bibliografia = dynamic_cast<NodoBibliografia*>(hijo.get())) {
+                for (const auto& ruta : bibliografia->rutas) {
+                    resultado.dependencias.push_back(resolverRuta(ruta));
+                }
+            }
+        }
+        if (opciones.activos != nullptr && resultado.estadisticas.figuras > 0) {
+            SpanTraza span(traza, "activos");
+            rutasFiguras = publicarFiguras(ast.get(), opciones);
+            span.argumento("figuras", static_cast<long long>(resultado.estadisticas.figuras));
+        }
+
+        // Salida prevista: el texto del AST mas las tablas (~1.5 veces el
+        // CSV). Un bufer en memoria crece por duplicacion y al final se copia,
+        // asi que cada salida llega a ocupar unas tres veces eso; volcada a
+        // archivo, solo un bloque de tabla.
+        size_t bytesAst = memoriaAst(*ast);
+        size_t salidaPrevista = bytesAst + bytesTablas / 2 * 3 + 4096;
+        size_t prevista = entrada.size() + bytesAst + 3 * salidaPrevista * (1 + opciones.salidasAdicionales.size());
+        bool volcar = false;
+        if (opciones.memoriaMaxima != 0 && prevista > opciones.memoriaMaxima &&
+            !opciones.archivoVolcado.empty()) {
+            volcar = true;
+            prevista = prevista - 3 * salidaPrevista + BYTES_BLOQUE_TABLA;
+        }
+        comprobarMemoria(opciones, "generacion", prevista);
+
+        // Los emisores adicionales recorren el mismo AST en paralelo con el
+        // de LaTeX, cada uno en un hilo del contexto; el arbol ya no se
+        // modifica.
+        vector<unique_ptr<Emisor>> emisores;
+        for (const auto& formato : opciones.salidasAdicionales) {
+            emisores.push_back(crearEmisor(formato, opciones.directorioBase));
+            if (!emisores.back()) {
+                throw runtime_error("Formato de salida desconocido: " + formato);
+            }
+            emisores.back()->setRutasFiguras(rutasFiguras);
+        }
+        resultado.salidasAdicionales.resize(emisores.size());
+        vector<exception_ptr> errores(emisores.size());
+        vector<unique_ptr<HiloEmisor>>& hilos = analizadores->hilosEmisores;
+        while (hilos.size() < emisores.size()) {
+            hilos.push_back(make_unique<HiloEmisor>());
+        }
+        // Se espera a los hilos aunque el LaTeX falle: usan el AST y el resultado
+        struct EsperaEmisores {
+            vector<unique_ptr<HiloEmisor>>& hilos;
+            size_t lanzados = 0;
+            ~EsperaEmisores() {
+                for (size_t i = 0; i < lanzados; i++) hilos[i]->esperar();
+            }
+        } espera{hilos};
+        for (size_t i = 0; i < emisores.size(); i++) {
+            HiloEmisor& hilo = *hilos[i];
+            hilo.lanzar([&, i]() {
+                try {
+                    string nombreEnTraza = string("emisor ") + emisores[i]->nombre();
+                    if (traza != nullptr && (hilo.trazaNombrada != traza || hilo.nombreEnTraza != nombreEnTraza)) {
+                        traza->nombrarHilo(nombreEnTraza);
+                        hilo.trazaNombrada = traza;
+                        hilo.nombreEnTraza = move(nombreEnTraza);
+                    }
+                    SpanTraza span(traza, emisores[i]->nombre());
+                    MedicionHardware medicion(contadores, emisores[i]->nombre(), entrada.size());
+                    SalidaAdicional& salida = resultado.salidasAdicionales[i];
+                    salida.formato = emisores[i]->nombre();
+                    salida.extension = emisores[i]->extension();
+                    salida.contenido = emisores[i]->emitir(ast.get());
+                    span.argumento("bytes", static_cast<long long>(salida.contenido.size()));
+                } catch (...) {
+                    errores[i] = current_exception();
+                }
+            });
+            espera.lanzados++;
+        }
+
+        GeneradorLatex generador(opciones.directorioBase);
+        if (opciones.formatos != nullptr) {
+            SpanTraza span(traza, "formato");
+            generador.setFormato(opciones.formatos->formatoPara(GeneradorLatex::preambulo(ast.get())));
+        }
+
+        {
+            SpanTraza span(traza, "GeneradorLatex::generar");
+            MedicionHardware medicion(contadores, "generacion", entrada.size());
+            generador.setRutasFiguras(move(rutasFiguras));
+            if (volcar) {
+                ofstream archivo(opciones.archivoVolcado, ios::binary);
+                if (!archivo.is_open()) {
+                    throw runtime_error("No se pudo crear el archivo: " + opciones.archivoVolcado);
+                }
+                volcadoIniciado = true;
+                generador.generar(ast.get(), archivo);
+                archivo.close();
+                if (!archivo) {
+                    throw runtime_error("No se pudo escribir el archivo: " + opciones.archivoVolcado);
+                }
+                resultado.latexVolcado = true;
+            } else {
+                resultado.latex = generador.generar(ast.get());
+            }
+            span.argumento("nodos", static_cast<long long>(ast->hijos.size()));
+            span.argumento("bytes", static_cast<long long>(resultado.latex.size()));
+
+            const EstadisticasTablas& tablas = generador.getEstadisticasTablas();
+            resultado.estadisticas.filasTabla = tablas.filas;
+            resultado.estadisticas.bytesTabla = tablas.bytes;
+            if (tablas.segundos > 0.0) {
+                resultado.estadisticas.filasTablaPorSegundo = tablas.filas / tablas.segundos;
+            }
+            if (tablas.filas > 0) {
+                span.argumento("filas_tabla", static_cast<long long>(tablas.filas));
+            }
+        }
+        resultado.estadisticas.lineasLatex =
+            count(resultado.latex.begin(), resultado.latex.end(), '\n');
+
+        for (size_t i = 0; i < espera.lanzados; i++) hilos[i]->esperar();
+        espera.lanzados = 0;
+        for (auto& error : errores) {
+            if (error) rethrow_exception(error);
+        }
+
+        size_t bytesSalidas = resultado.latex.capacity();
+        for (const auto& salida : resultado.salidasAdicionales) {
+            bytesSalidas += salida.contenido.capacity();
+        }
+        registrarMemoria(resultado, opciones, "generacion", entrada.size() + bytesAst + bytesSalidas,
+                         resultado.estadisticas.memoriaGeneracion);
+        resultado.exito = true;
+    } catch (const exception& e) {
+        resultado.diagnosticos.emplace_back(Severidad::ERROR, 0, 0, e.what());
+        if (volcadoIniciado) {
+            error_code error;
+            filesystem::remove(opciones.archivoVolcado, error);
+            resultado.latexVolcado = false;
+        }
+    }
+
+    return resultado;
+}
+
+// ===============================
+// FUNCIONES UTILITARIAS
+// ===============================
+
+string leerArchivo(const string& nombreArchivo) {
+    ifstream archivo(nombreArchivo);
+    if (!archivo.is_open()) {
+        throw runtime_error("No se pudo abrir el archivo: " + nombreArchivo);
+    }
+
+    stringstream buffer;
+    buffer << archivo.rdbuf();
+    return buffer.str();
+}
+
+void escribirArchivo(const string& nombreArchivo, const string& contenido) {
+    ofstream archivo(nombreArchivo);
+    if (!archivo.is_open()) {
+        throw runtime_error("No se pudo crear el archivo: " + nombreArchivo);
+    }
+
+    archivo << contenido;
+}
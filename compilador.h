@@ -0,0 +1,186 @@
+#ifndef COMPILADOR_H
+#define COMPILADOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "diagnostico.h"
+
+using namespace std;
+
+class AlmacenActivos;
+class BibliotecaMacros;
+class CacheFormatos;
+class ContadoresHardware;
+class Traza;
+
+// ===============================
+// API DE LA BIBLIOTECA DEL COMPILADOR
+// ===============================
+//
+// compilar() es reentrante: no escribe en consola ni usa estado global
+// mutable, asi que puede llamarse desde varios hilos a la vez. Para muchos
+// documentos seguidos conviene un ContextoCompilacion por hilo.
+
+struct OpcionesCompilacion {
+    // Ejecutar el automata de la tabla de transiciones antes de construir
+    // el arbol. Si falla, no se genera LaTeX.
+    bool validarSintaxis = true;
+
+    // Revisar llaves, \left/\right, entornos y caracteres prohibidos en
+    // ecuacion() y formula() (validador_matematicas.h). Si hay errores, no se
+    // genera LaTeX.
+    bool validarMatematicas = true;
+
+    // Carpeta desde la que se resuelven las rutas relativas del documento
+    // (archivos de tabla_csv). Vacia: directorio actual.
+    string directorioBase;
+
+    // Si no es nulo, las imagenes de figura() se publican (deduplicadas) en
+    // el almacen de activos y el .tex las incluye desde alli.
+    AlmacenActivos* activos = nullptr;
+
+    // Si no es nula, el .tex empieza con una linea %& que apunta al formato
+    // precompilado de su preambulo (construido la primera vez que se pide).
+    CacheFormatos* formatos = nullptr;
+
+    // Si no es nula, usar() encuentra tambien las macros de esta biblioteca
+    // precargada, compartida por todos los documentos (macros.h).
+    const BibliotecaMacros* macros = nullptr;
+
+    // Si no es nula, cada fase se registra como un intervalo de la traza.
+    Traza* traza = nullptr;
+
+    // Si no es nulo, cada fase suma sus contadores de hardware (ciclos,
+    // instrucciones, fallos de salto y de cache; contadores.h).
+    ContadoresHardware* contadores = nullptr;
+
+    // Formatos que se emiten ademas del LaTeX a partir del mismo AST
+    // ("html", "markdown"). Cada uno se emite en su propio hilo.
+    vector<string> salidasAdicionales;
+
+    // Serializar tokens y AST en el formato binario de cache_ast.h.
+    bool cacheAst = false;
+
+    // Limite en bytes para las estructuras del documento (entrada, tokens,
+    // tabla de simbolos, AST y salidas); 0: sin limite. Antes de cada fase se
+    // estima lo que ocupara y, si no cabe, la compilacion falla con un
+    // diagnostico en lugar de agotar la memoria.
+    size_t memoriaMaxima = 0;
+
+    // Si la salida LaTeX prevista no cabe en memoriaMaxima, se escribe por
+    // bloques en este archivo en lugar de en ResultadoCompilacion::latex.
+    // Vacio: sin volcado; el documento falla.
+    string archivoVolcado;
+};
+
+struct EstadisticasCompilacion {
+    size_t bytesEntrada = 0;
+    size_t tokens = 0;
+    size_t nodosAST = 0;
+    size_t simbolos = 0;
+    size_t lineasLatex = 0;
+
+    size_t figuras = 0;
+    size_t usosMacros = 0;
+
+    // tabla_csv
+    size_t filasTabla = 0;
+    size_t bytesTabla = 0;
+    double filasTablaPorSegundo = 0.0;
+
+    // Memoria estimada de las estructuras vivas en cada fase (bytes,
+    // maximo de la fase) y el maximo de todas. Ver memoria.h.
+    size_t memoriaLexico = 0;
+    size_t memoriaSintaxis = 0;
+    size_t memoriaAST = 0;
+    size_t memoriaGeneracion = 0;
+    size_t memoriaPico = 0;
+
+    // Nanosegundos de cada fase (latencias.h): 'sintaxis' incluye el AST y
+    // las macros; 'analisis', referencias, bibliografia, formulas y cache
+    // del AST; 'generacion', el LaTeX y las salidas adicionales.
+    uint64_t lexicoNs = 0;
+    uint64_t sintaxisNs = 0;
+    uint64_t analisisNs = 0;
+    uint64_t generacionNs = 0;
+};
+
+struct SalidaAdicional {
+    string formato;
+    string extension; // ".html", ".md"
+    string contenido;
+};
+
+struct ResultadoCompilacion {
+    bool exito = false;
+    string latex;
+    // El LaTeX se escribio en OpcionesCompilacion::archivoVolcado y 'latex'
+    // esta vacio.
+    bool latexVolcado = false;
+    vector<Diagnostico> diagnosticos;
+    EstadisticasCompilacion estadisticas;
+
+    // Archivos que el .tex lee al compilarse (CSV e imagenes originales),
+    // resueltos contra directorioBase.
+    vector<string> dependencias;
+
+    // Una por cada formato de OpcionesCompilacion::salidasAdicionales, en
+    // el mismo orden.
+    vector<SalidaAdicional> salidasAdicionales;
+
+    // Contenido del .texast si se pidio cacheAst.
+    string cacheAst;
+};
+
+ResultadoCompilacion compilar(string_view entrada,
+                              const OpcionesCompilacion& opciones = OpcionesCompilacion());
+
+// ===============================
+// CONTEXTO DE COMPILACION REUTILIZABLE
+// ===============================
+//
+// compilar() arma en cada llamada un analizador lexico (que vuelve a
+// insertar las palabras clave en su tabla de simbolos) y uno sintactico
+// (que rellena su tabla de transiciones de 100x100), y al terminar tira
+// todos sus buferes. Con miles de documentos pequenos ese costo fijo pesa
+// tanto como el analisis. Un contexto se crea una vez por hilo y se
+// reutiliza: conserva las tablas, la copia de la entrada, el vector de
+// tokens y los nodos de la tabla de simbolos, y entre documentos solo vacia
+// lo que es de cada uno. Los buferes de un documento grande se liberan al
+// terminarlo en lugar de retenerse.
+//
+// El resultado es el mismo que el de compilar(). Un contexto no debe
+// usarse desde dos hilos a la vez.
+class ContextoCompilacion {
+public:
+    ContextoCompilacion();
+    ~ContextoCompilacion();
+    ContextoCompilacion(const ContextoCompilacion&) = delete;
+    ContextoCompilacion& operator=(const ContextoCompilacion&) = delete;
+
+    ResultadoCompilacion compilar(string_view entrada,
+                                  const OpcionesCompilacion& opciones = OpcionesCompilacion());
+
+private:
+    struct Analizadores;
+    unique_ptr<Analizadores> analizadores;
+
+    void terminarDocumento(size_t bytesEntrada);
+};
+
+// true si 'formato' es un valor valido para salidasAdicionales.
+bool esFormatoSalida(const string& formato);
+
+// ===============================
+// FUNCIONES UTILITARIAS
+// ===============================
+
+string leerArchivo(const string& nombreArchivo);
+void escribirArchivo(const string& nombreArchivo, const string& contenido);
+
+#endif
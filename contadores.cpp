@@ -0,0 +1,233 @@
+#include "contadores.h"
+
+#include <cstring>
+#include <fstream>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+// Grupo de contadores del hilo que lo crea. El primero que se abre es el
+// lider: el nucleo programa el grupo entero a la vez y una sola lectura
+// devuelve todos los valores.
+class GrupoContadores {
+private:
+    int descriptores[NUMERO_CONTADORES];
+    Contador orden[NUMERO_CONTADORES];
+    size_t abiertos = 0;
+    unsigned mascara = 0;
+    string error;
+
+public:
+    GrupoContadores();
+    ~GrupoContadores();
+
+    GrupoContadores(const GrupoContadores&) = delete;
+    GrupoContadores& operator=(const GrupoContadores&) = delete;
+
+    unsigned getMascara() const {
+        return mascara;
+    }
+
+    const string& getError() const {
+        return error;
+    }
+
+    // Valores acumulados desde que se abrio el grupo, escalados si el
+    // nucleo tuvo que repartir los contadores con otros grupos.
+    bool leer(uint64_t valores[NUMERO_CONTADORES]) const;
+};
+
+#if defined(__linux__)
+
+struct DefinicionContador {
+    uint32_t tipo;
+    uint64_t configuracion;
+};
+
+const DefinicionContador DEFINICIONES[NUMERO_CONTADORES] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+};
+
+string explicarError(int numero) {
+    if (numero == EACCES || numero == EPERM) {
+        string nivel;
+        ifstream paranoid("/proc/sys/kernel/perf_event_paranoid");
+        if (!(paranoid >> nivel)) nivel = "?";
+        return "el nucleo no permite abrirlos (kernel.perf_event_paranoid=" + nivel +
+               "; con 2 o menos basta para el propio proceso, o lo impide seccomp en un contenedor)";
+    }
+    if (numero == ENOENT || numero == EOPNOTSUPP || numero == ENODEV) {
+        return "el procesador o la maquina virtual no los expone";
+    }
+    if (numero == ENOSYS) {
+        return "este nucleo no tiene perf_event_open";
+    }
+    return strerror(numero);
+}
+
+GrupoContadores::GrupoContadores() {
+    int lider = -1;
+    int primerError = 0;
+    for (int i = 0; i < NUMERO_CONTADORES; i++) {
+        perf_event_attr atributos;
+        memset(&atributos, 0, sizeof(atributos));
+        atributos.size = sizeof(atributos);
+        atributos.type = DEFINICIONES[i].tipo;
+        atributos.config = DEFINICIONES[i].configuracion;
+        atributos.exclude_kernel = 1;
+        atributos.exclude_hv = 1;
+        atributos.read_format =
+            PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        long descriptor = syscall(__NR_perf_event_open, &atributos, 0, -1, lider, PERF_FLAG_FD_CLOEXEC);
+        if (descriptor < 0) {
+            if (primerError == 0) primerError = errno;
+            continue;
+        }
+        if (lider < 0) lider = static_cast<int>(descriptor);
+        descriptores[abiertos] = static_cast<int>(descriptor);
+        orden[abiertos] = static_cast<Contador>(i);
+        abiertos++;
+        mascara |= 1u << i;
+    }
+    if (abiertos == 0) {
+        error = explicarError(primerError);
+    }
+}
+
+GrupoContadores::~GrupoContadores() {
+    // Los miembros antes que el lider
+    for (size_t i = abiertos; i > 0; i--) {
+        close(descriptores[i - 1]);
+    }
+}
+
+bool GrupoContadores::leer(uint64_t valores[NUMERO_CONTADORES]) const {
+    if (abiertos == 0) return false;
+
+    // { nr, time_enabled, time_running, valor[nr] }
+    uint64_t lectura[3 + NUMERO_CONTADORES];
+    ssize_t leidos = read(descriptores[0], lectura, sizeof(lectura));
+    if (leidos < static_cast<ssize_t>((3 + abiertos) * sizeof(uint64_t)) || lectura[0] != abiertos) {
+        return false;
+    }
+    uint64_t habilitado = lectura[1];
+    uint64_t ejecutado = lectura[2];
+    for (size_t i = 0; i < abiertos; i++) {
+        uint64_t valor = lectura[3 + i];
+        if (ejecutado != 0 && ejecutado < habilitado) {
+            valor = static_cast<uint64_t>(static_cast<double>(valor) * habilitado / ejecutado);
+        }
+        valores[orden[i]] = valor;
+    }
+    return true;
+}
+
+#else
+
+GrupoContadores::GrupoContadores() : error("solo hay contadores de hardware en Linux (perf_event_open)") {}
+
+GrupoContadores::~GrupoContadores() {}
+
+bool GrupoContadores::leer(uint64_t[NUMERO_CONTADORES]) const {
+    return false;
+}
+
+#endif
+
+// Un grupo por hilo, abierto la primera vez que el hilo mide algo y
+// cerrado cuando el hilo termina.
+GrupoContadores& grupoDelHilo() {
+    thread_local GrupoContadores grupo;
+    return grupo;
+}
+
+} // namespace
+
+// ===============================
+// ACUMULADO
+// ===============================
+
+void ContadoresHardware::registrar(const string& nombre, size_t bytes,
+                                   const uint64_t valores[NUMERO_CONTADORES], unsigned mascara) {
+    lock_guard<mutex> bloqueo(cerrojo);
+    disponibles = medido ? (disponibles & mascara) : mascara;
+    medido = true;
+
+    auto it = indice.find(nombre);
+    if (it == indice.end()) {
+        it = indice.emplace(nombre, totales.size()).first;
+        totales.emplace_back();
+        totales.back().nombre = nombre;
+    }
+    TotalContadores& total = totales[it->second];
+    total.mediciones++;
+    total.bytes += bytes;
+    for (int i = 0; i < NUMERO_CONTADORES; i++) {
+        total.valores[i] += valores[i];
+    }
+}
+
+void ContadoresHardware::registrarError(const string& mensaje) {
+    lock_guard<mutex> bloqueo(cerrojo);
+    if (error.empty()) error = mensaje;
+}
+
+vector<TotalContadores> ContadoresHardware::getTotales() const {
+    lock_guard<mutex> bloqueo(cerrojo);
+    return totales;
+}
+
+bool ContadoresHardware::disponible(Contador contador) const {
+    lock_guard<mutex> bloqueo(cerrojo);
+    return medido && (disponibles & (1u << contador)) != 0;
+}
+
+string ContadoresHardware::getError() const {
+    lock_guard<mutex> bloqueo(cerrojo);
+    if (medido) return "";
+    return error.empty() ? "no se midio ninguna fase" : error;
+}
+
+// ===============================
+// MEDICION
+// ===============================
+
+MedicionHardware::MedicionHardware(ContadoresHardware* contadores, string nombre, size_t bytes)
+    : contadores(contadores), bytesEntrada(bytes) {
+    if (contadores == nullptr) return;
+
+    const GrupoContadores& grupo = grupoDelHilo();
+    if (grupo.getMascara() == 0) {
+        contadores->registrarError(grupo.getError());
+        return;
+    }
+    if (grupo.leer(inicio)) {
+        mascara = grupo.getMascara();
+        this->nombre = move(nombre);
+    }
+}
+
+MedicionHardware::~MedicionHardware() {
+    if (mascara == 0) return;
+
+    uint64_t fin[NUMERO_CONTADORES] = {};
+    if (!grupoDelHilo().leer(fin)) return;
+    for (int i = 0; i < NUMERO_CONTADORES; i++) {
+        fin[i] = fin[i] >= inicio[i] ? fin[i] - inicio[i] : 0;
+    }
+    contadores->registrar(nombre, bytesEntrada, fin, mascara);
+}
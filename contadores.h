@@ -0,0 +1,93 @@
+#ifndef CONTADORES_H
+#define CONTADORES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// ===============================
+// CONTADORES DE HARDWARE (--perf-counters)
+// ===============================
+//
+// El reloj dice cuanto tarda una fase, no por que: si el analizador lexico
+// esta limitado por saltos mal predichos o el sintactico por fallos de
+// cache. En Linux, cada hilo abre con perf_event_open un grupo de
+// contadores (ciclos, instrucciones, saltos fallidos, fallos de L1 de
+// datos y de ultimo nivel) solo de modo usuario, y cada fase suma la
+// diferencia entre la lectura al empezar y al terminar.
+//
+// Si el nucleo niega el acceso (perf_event_paranoid, seccomp en un
+// contenedor, una maquina virtual sin PMU) o el sistema no es Linux, las
+// mediciones no hacen nada y el informe lo explica. Un contador concreto
+// que el procesador no tenga se marca como no disponible sin afectar a los
+// demas.
+
+enum Contador {
+    CICLOS,
+    INSTRUCCIONES,
+    FALLOS_SALTO,
+    FALLOS_L1,
+    FALLOS_LLC,
+    NUMERO_CONTADORES
+};
+
+struct TotalContadores {
+    string nombre;
+    size_t mediciones = 0;
+    size_t bytes = 0; // entrada procesada en esas mediciones
+    uint64_t valores[NUMERO_CONTADORES] = {};
+};
+
+class ContadoresHardware {
+private:
+    mutable mutex cerrojo;
+    vector<TotalContadores> totales;
+    unordered_map<string, size_t> indice;
+    unsigned disponibles = 0; // bit por Contador
+    bool medido = false;
+    string error;
+
+public:
+    void registrar(const string& nombre, size_t bytes, const uint64_t valores[NUMERO_CONTADORES],
+                   unsigned mascara);
+    void registrarError(const string& mensaje);
+
+    // Totales por fase o trabajador, en el orden de la primera medicion.
+    vector<TotalContadores> getTotales() const;
+
+    bool disponible(Contador contador) const;
+
+    // Por que no hay contadores (vacio si se pudo medir).
+    string getError() const;
+};
+
+// Mide en el hilo que la crea, desde el constructor hasta el destructor, y
+// suma la diferencia a 'nombre'. Con contadores nulos no hace nada; las
+// mediciones se pueden anidar (una fase dentro de un trabajador).
+class MedicionHardware {
+private:
+    ContadoresHardware* contadores;
+    string nombre;
+    size_t bytesEntrada;
+    unsigned mascara = 0;
+    uint64_t inicio[NUMERO_CONTADORES] = {};
+
+public:
+    MedicionHardware(ContadoresHardware* contadores, string nombre, size_t bytes = 0);
+    ~MedicionHardware();
+
+    MedicionHardware(const MedicionHardware&) = delete;
+    MedicionHardware& operator=(const MedicionHardware&) = delete;
+
+    // Para cuando la entrada se conoce despues de empezar.
+    void bytes(size_t bytes) {
+        bytesEntrada = bytes;
+    }
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef DIAGNOSTICO_H
+#define DIAGNOSTICO_H
+
+#include <string>
+
+using namespace std;
+
+// ===============================
+// DIAGNOSTICOS
+// ===============================
+
+enum class Severidad {
+    ERROR,
+    ADVERTENCIA
+};
+
+struct Diagnostico {
+    Severidad severidad;
+    int linea;
+    int columna;
+    string mensaje;
+
+    Diagnostico(Severidad s, int l, int c, const string& m)
+        : severidad(s), linea(l), columna(c), mensaje(m) {}
+
+    string toString() const {
+        string prefijo = severidad == Severidad::ERROR ? "Error" : "Advertencia";
+        if (linea > 0) {
+            return prefijo + " en linea " + to_string(linea) + ", columna " +
+                   to_string(columna) + ": " + mensaje;
+        }
+        return prefijo + ": " + mensaje;
+    }
+};
+
+#endif
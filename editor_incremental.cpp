@@ -0,0 +1,265 @@
+#include "editor_incremental.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+
+using namespace std;
+
+// Estado entre los elementos de una lista (tras "lista_simple;" o un
+// "elemento ...;").
+static const int ESTADO_ENTRE_ELEMENTOS = 23;
+
+static bool esInicioSentencia(int estado) {
+    return estado == 0 || estado == AnalizadorSintactico::ESTADO_INICIO_SENTENCIA;
+}
+
+EditorIncremental::EditorIncremental() : lexico(""), sintactico(vector<Token>()) {}
+
+// Relexa tramo a tramo desde 'desde' hasta dejar atras la linea 'editada' y
+// llegar a una linea que ya empezaba un tramo (sus tokens no cambian).
+// Devuelve el final, exclusivo, de lo relexado.
+size_t EditorIncremental::relexar(size_t desde, size_t editada) {
+    size_t j = desde;
+    while (j < lineas.size()) {
+        // Un tramo crece mientras tenga una cadena sin cerrar. Se duplica en
+        // cada intento para que una cadena abierta hasta el final cueste
+        // O(n log n) y no O(n^2); el tramo puede quedar algo mas largo de lo
+        // necesario, lo que no cambia los tokens.
+        size_t cantidad = 1;
+        string texto = lineas[j].texto;
+        vector<Token> tokens;
+        string errorLexico;
+        while (true) {
+            lexico.reiniciar(texto);
+            try {
+                tokens = lexico.analizar();
+                tokens.pop_back(); // FIN_ARCHIVO
+                break;
+            } catch (const exception& e) {
+                // Un byte no valido no se arregla con mas lineas
+                if (validarUtf8(texto).invalido != string_view::npos) {
+                    tokens.clear();
+                    errorLexico = e.what();
+                    break;
+                }
+                if (j + cantidad >= lineas.size()) {
+                    tokens.clear();
+                    errorLexico = "Cadena sin cerrar hasta el final del documento";
+                    break;
+                }
+                size_t nuevaCantidad = min(cantidad * 2, lineas.size() - j);
+                for (; cantidad < nuevaCantidad; cantidad++) {
+                    texto += '\n';
+                    texto += lineas[j + cantidad].texto;
+                }
+            }
+        }
+
+        LineaEditor& inicio = lineas[j];
+        inicio.tokens = move(tokens);
+        inicio.continuacion = false;
+        inicio.errorLexico = errorLexico;
+        for (size_t k = 1; k < cantidad; k++) {
+            LineaEditor& siguiente = lineas[j + k];
+            siguiente.tokens.clear();
+            siguiente.continuacion = true;
+            siguiente.errorLexico.clear();
+        }
+
+        j += cantidad;
+        if (j > editada && (j == lineas.size() || !lineas[j].continuacion)) break;
+    }
+    return j;
+}
+
+// Un paso del automata con recuperacion: tras un error se descartan tokens
+// hasta el siguiente ';'.
+int EditorIncremental::avanzarAutomata(int estado, const Token& token, string& error) const {
+    if (estado == ESTADO_RECUPERACION) {
+        return token.tipo == TipoToken::PUNTO_COMA ? AnalizadorSintactico::ESTADO_INICIO_SENTENCIA
+                                                  : ESTADO_RECUPERACION;
+    }
+
+    int siguiente = sintactico.transicion(estado, token);
+    if (siguiente != ERROR_SINTACTICO) return siguiente;
+
+    if (estado == AnalizadorSintactico::ESTADO_FINAL) {
+        error = "Contenido despues de documento_fin (" + token.toString() + ")";
+        return estado;
+    }
+    error = "Transicion no definida (estado " + to_string(estado) + ", token " +
+            to_string(token.getTokenValue()) + " - " + token.toString() + ")";
+    return token.tipo == TipoToken::PUNTO_COMA ? AnalizadorSintactico::ESTADO_INICIO_SENTENCIA
+                                              : ESTADO_RECUPERACION;
+}
+
+// Recorre el automata desde el estado guardado de 'desde'. Pasado 'hasta'
+// (lineas con los mismos tokens que antes), se detiene en la primera linea
+// que empieza en el mismo estado que en la pasada anterior. Devuelve el
+// numero de lineas recorridas.
+size_t EditorIncremental::reanalizar(size_t desde, size_t hasta, vector<Diagnostico>& diagnosticos) {
+    int estado = desde == 0 ? 0 : lineas[desde].estadoInicio;
+
+    size_t i = desde;
+    for (; i < lineas.size(); i++) {
+        LineaEditor& linea = lineas[i];
+        if (i >= hasta && linea.estadoInicio == estado) break;
+
+        linea.estadoInicio = estado;
+        linea.error.clear();
+        for (const Token& token : linea.tokens) {
+            string error;
+            estado = avanzarAutomata(estado, token, error);
+            if (!error.empty() && linea.error.empty()) {
+                linea.error = error;
+                linea.lineaError = token.linea;
+                linea.columnaError = token.columna;
+            }
+        }
+
+        if (!linea.errorLexico.empty()) {
+            diagnosticos.emplace_back(Severidad::ERROR, static_cast<int>(i + 1), 0, linea.errorLexico);
+        }
+        if (!linea.error.empty()) {
+            diagnosticos.emplace_back(Severidad::ERROR, static_cast<int>(i) + linea.lineaError,
+                                      linea.columnaError, linea.error);
+        }
+    }
+
+    return i - desde;
+}
+
+// LaTeX de las sentencias que empiezan o terminan en la linea 'indice'. Se
+// retrocede hasta un limite de sentencia con los estados guardados y se
+// avanza con el automata hasta el siguiente; una lista abierta se cierra
+// para poder mostrarla mientras se escriben sus elementos.
+void EditorIncremental::vistaPrevia(size_t indice, ResultadoEdicion& resultado) {
+    size_t linea = indice;
+    while (linea > 0 && lineas[linea].continuacion) linea--;
+    if (!lineas[linea].errorLexico.empty()) {
+        resultado.avisoVistaPrevia = "(" + lineas[linea].errorLexico + ")";
+        return;
+    }
+    if (lineas[linea].tokens.empty()) {
+        resultado.avisoVistaPrevia = "(linea sin sentencias)";
+        return;
+    }
+
+    size_t inicio = linea;
+    while (inicio > 0 && !esInicioSentencia(lineas[inicio].estadoInicio)) inicio--;
+
+    vector<Token> sentencia;
+    int estado = lineas[inicio].estadoInicio;
+    bool conError = false;
+    bool cerrada = false;
+    for (size_t i = inicio; i < lineas.size() && !cerrada; i++) {
+        const vector<Token>& tokens = lineas[i].tokens;
+        for (size_t k = 0; k < tokens.size(); k++) {
+            bool limite = esInicioSentencia(estado) || estado == AnalizadorSintactico::ESTADO_FINAL;
+            if (limite && i > linea) {
+                cerrada = true;
+                break;
+            }
+            if (limite && (i < linea || k == 0)) {
+                sentencia.clear();
+                conError = false;
+            }
+
+            string error;
+            estado = avanzarAutomata(estado, tokens[k], error);
+            conError = conError || !error.empty();
+
+            Token token = tokens[k];
+            token.linea += static_cast<int>(i);
+            sentencia.push_back(token);
+        }
+    }
+
+    if (conError) {
+        resultado.avisoVistaPrevia = "(sentencia con errores)";
+        return;
+    }
+    if (estado == ESTADO_ENTRE_ELEMENTOS) {
+        // Entre elementos de una lista sin fin_lista todavia
+        int ultimaLinea = sentencia.back().linea;
+        sentencia.emplace_back(TipoToken::FIN_LISTA, "fin_lista", ultimaLinea, 0);
+        sentencia.emplace_back(TipoToken::PUNTO_COMA, ";", ultimaLinea, 0);
+    } else if (!cerrada && !esInicioSentencia(estado) && estado != AnalizadorSintactico::ESTADO_FINAL) {
+        resultado.avisoVistaPrevia = "(sentencia incompleta)";
+        return;
+    }
+
+    sentencia.emplace_back(TipoToken::FIN_ARCHIVO, "", sentencia.back().linea, 0);
+    try {
+        AnalizadorSintactico analizador(move(sentencia));
+        unique_ptr<NodoDocumento> fragmento = analizador.analizar();
+        resultado.vistaPrevia = generador.generarFragmento(fragmento.get());
+    } catch (const exception& e) {
+        resultado.avisoVistaPrevia = string("(") + e.what() + ")";
+    }
+}
+
+ResultadoEdicion EditorIncremental::actualizar(size_t indice, bool mostrarVista) {
+    auto inicio = chrono::steady_clock::now();
+    ResultadoEdicion resultado;
+
+    if (!lineas.empty()) {
+        // Se empieza una linea antes: borrar o insertar puede cerrar o
+        // partir el tramo de la anterior
+        size_t editada = min(indice, lineas.size() - 1);
+        size_t desde = indice > 0 ? min(indice - 1, lineas.size() - 1) : 0;
+        while (desde > 0 && lineas[desde].continuacion) desde--;
+
+        size_t hasta = relexar(desde, editada);
+        resultado.lineasRelexadas = hasta - desde;
+        resultado.lineasReanalizadas = reanalizar(desde, hasta, resultado.diagnosticos);
+        if (mostrarVista) vistaPrevia(editada, resultado);
+    }
+
+    resultado.milisegundos =
+        chrono::duration<double, milli>(chrono::steady_clock::now() - inicio).count();
+    return resultado;
+}
+
+ResultadoEdicion EditorIncremental::agregar(const string& texto) {
+    return insertar(lineas.size(), texto);
+}
+
+ResultadoEdicion EditorIncremental::insertar(size_t indice, const string& texto) {
+    if (indice > lineas.size()) {
+        throw runtime_error("Linea fuera del documento: " + to_string(indice + 1));
+    }
+    LineaEditor nueva;
+    nueva.texto = texto;
+    // Dentro de un tramo, la nueva linea lo parte: se relexa desde su inicio
+    nueva.continuacion = indice < lineas.size() && lineas[indice].continuacion;
+    lineas.insert(lineas.begin() + indice, move(nueva));
+    return actualizar(indice, true);
+}
+
+ResultadoEdicion EditorIncremental::reemplazar(size_t indice, const string& texto) {
+    if (indice >= lineas.size()) {
+        throw runtime_error("Linea fuera del documento: " + to_string(indice + 1));
+    }
+    lineas[indice].texto = texto;
+    return actualizar(indice, true);
+}
+
+ResultadoEdicion EditorIncremental::borrar(size_t indice) {
+    if (indice >= lineas.size()) {
+        throw runtime_error("Linea fuera del documento: " + to_string(indice + 1));
+    }
+    lineas.erase(lineas.begin() + indice);
+    return actualizar(indice, false);
+}
+
+string EditorIncremental::texto() const {
+    string resultado;
+    for (const auto& linea : lineas) {
+        resultado += linea.texto;
+        resultado += '\n';
+    }
+    return resultado;
+}
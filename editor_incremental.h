@@ -0,0 +1,97 @@
+#ifndef EDITOR_INCREMENTAL_H
+#define EDITOR_INCREMENTAL_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "analizador_lexico.h"
+#include "analizador_sintactico.h"
+#include "diagnostico.h"
+#include "generador_latex.h"
+#include "token.h"
+
+using namespace std;
+
+// ===============================
+// EDITOR INTERACTIVO INCREMENTAL
+// ===============================
+//
+// Mantiene el documento linea a linea con los tokens de cada una y el estado
+// del automata al empezar cada linea. Al editar una linea:
+//
+//   - se relexa desde el inicio de su tramo (una cadena abierta puede
+//     continuar en las lineas siguientes) hasta que los tramos vuelven a
+//     coincidir con los de antes;
+//   - se vuelve a recorrer el automata desde el estado guardado de la primera
+//     linea relexada y se para en cuanto una linea sin cambios empieza en el
+//     mismo estado que antes: de ahi en adelante nada cambia.
+//
+// Tras un error el automata se resincroniza en el siguiente ';' (estado
+// ESTADO_INICIO_SENTENCIA), asi que un error solo afecta a su sentencia.
+
+struct LineaEditor {
+    string texto;
+    // Tokens del tramo que empieza en esta linea, con la linea relativa al
+    // tramo (1 = esta linea). Vacio en las lineas de continuacion.
+    vector<Token> tokens;
+    bool continuacion = false; // sigue una cadena abierta en una linea anterior
+    int estadoInicio = 0;      // estado del automata antes de sus tokens
+    string errorLexico;        // cadena sin cerrar hasta el final o UTF-8 no valido
+    // Primer error sintactico de la linea (vacio si no hay).
+    string error;
+    int lineaError = 0;        // relativa al tramo, como los tokens
+    int columnaError = 0;
+};
+
+struct ResultadoEdicion {
+    size_t lineasRelexadas = 0;
+    size_t lineasReanalizadas = 0;
+    // Errores de las lineas reanalizadas (el resto no cambio).
+    vector<Diagnostico> diagnosticos;
+    // LaTeX de la sentencia que contiene la linea editada, o el motivo por
+    // el que no se puede mostrar.
+    string vistaPrevia;
+    string avisoVistaPrevia;
+    double milisegundos = 0.0;
+};
+
+class EditorIncremental {
+private:
+    // Estado del automata mientras se salta hasta el siguiente ';' tras un
+    // error.
+    static const int ESTADO_RECUPERACION = -1;
+
+    vector<LineaEditor> lineas;
+    AnalizadorLexico lexico;
+    AnalizadorSintactico sintactico; // solo se usa su tabla de transiciones
+    GeneradorLatex generador;
+
+    size_t relexar(size_t desde, size_t editada);
+    size_t reanalizar(size_t desde, size_t hasta, vector<Diagnostico>& diagnosticos);
+    int avanzarAutomata(int estado, const Token& token, string& error) const;
+    void vistaPrevia(size_t indice, ResultadoEdicion& resultado);
+    ResultadoEdicion actualizar(size_t indice, bool mostrarVista);
+
+public:
+    EditorIncremental();
+
+    // Agrega la linea al final, o la inserta antes de 'indice' (base 0).
+    ResultadoEdicion agregar(const string& texto);
+    ResultadoEdicion insertar(size_t indice, const string& texto);
+    ResultadoEdicion reemplazar(size_t indice, const string& texto);
+    ResultadoEdicion borrar(size_t indice);
+
+    size_t numeroLineas() const {
+        return lineas.size();
+    }
+
+    const string& linea(size_t indice) const {
+        return lineas[indice].texto;
+    }
+
+    // El documento completo, para la compilacion final.
+    string texto() const;
+};
+
+#endif
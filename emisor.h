@@ -0,0 +1,60 @@
+#ifndef EMISOR_H
+#define EMISOR_H
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+#include "ast.h"
+
+using namespace std;
+
+// ===============================
+// INTERFAZ DE LOS EMISORES DE SALIDA
+// ===============================
+//
+// Un emisor recorre el AST ya resuelto y devuelve el documento en su
+// formato. Solo lee el arbol, asi que varios emisores pueden recorrer el
+// mismo AST a la vez desde hilos distintos; cada emisor, en cambio, se usa
+// desde un solo hilo.
+
+// Las filas de una tabla_csv se acumulan en un bloque de este tamano antes de
+// pasar a la salida, para no escribir en el stringstream celda a celda.
+const size_t BYTES_BLOQUE_TABLA = 64 * 1024;
+
+class Emisor {
+protected:
+    string directorioBase;
+    unordered_map<string, string> rutasFiguras;
+
+    string resolverRuta(const string& ruta) const {
+        if (directorioBase.empty()) return ruta;
+        return (filesystem::path(directorioBase) / ruta).string();
+    }
+
+    const string& rutaFigura(const NodoFigura* nodo) const {
+        auto it = rutasFiguras.find(nodo->ruta);
+        return it != rutasFiguras.end() ? it->second : nodo->ruta;
+    }
+
+public:
+    // directorioBase: carpeta desde la que se resuelven las rutas relativas
+    // de los archivos referenciados (p. ej. tabla_csv).
+    explicit Emisor(const string& base = "") : directorioBase(base) {}
+    virtual ~Emisor() = default;
+
+    // Nombre del formato ("latex", "html"...) y extension del archivo.
+    virtual const char* nombre() const = 0;
+    virtual const char* extension() const = 0;
+
+    virtual string emitir(NodoDocumento* ast) = 0;
+
+    // Ruta con la que se incluye cada imagen de figura() en lugar de la
+    // escrita en el documento (p. ej. el activo deduplicado).
+    void setRutasFiguras(unordered_map<string, string> rutas) {
+        rutasFiguras = move(rutas);
+    }
+};
+
+#endif
@@ -0,0 +1,308 @@
+#ifndef EMISOR_HTML_H
+#define EMISOR_HTML_H
+
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "archivo_mapeado.h"
+#include "ast.h"
+#include "bibliografia.h"
+#include "emisor.h"
+#include "lector_csv.h"
+
+using namespace std;
+
+// ===============================
+// EMISOR HTML
+// ===============================
+//
+// Pagina autocontenida para el LMS. Las ecuaciones se dejan en notacion TeX
+// y las compone MathJax en el navegador; el resto del documento sigue la
+// misma estructura que el .tex (titulo, secciones numeradas, indice...).
+
+class EmisorHtml : public Emisor {
+private:
+    stringstream salida;
+    string titulo, autor, fecha;
+
+    static void escapar(string_view texto, string& destino) {
+        for (char c : texto) {
+            switch (c) {
+                case '&': destino += "&amp;"; break;
+                case '<': destino += "&lt;"; break;
+                case '>': destino += "&gt;"; break;
+                case '"': destino += "&quot;"; break;
+                default: destino += c; break;
+            }
+        }
+    }
+
+    static string escapar(string_view texto) {
+        string destino;
+        escapar(texto, destino);
+        return destino;
+    }
+
+    static int nivelEncabezado(const string& nivel) {
+        if (nivel == "capitulo") return 1;
+        if (nivel == "seccion") return 2;
+        if (nivel == "subseccion") return 3;
+        return 4;
+    }
+
+    void emitirNodo(NodoAST* nodo) {
+        if (auto seccion = dynamic_cast<NodoSeccion*>(nodo)) {
+            emitirSeccion(seccion);
+        } else if (auto texto = dynamic_cast<NodoTexto*>(nodo)) {
+            emitirTexto(texto);
+        } else if (auto lista = dynamic_cast<NodoLista*>(nodo)) {
+            emitirLista(lista);
+        } else if (auto ecuacion = dynamic_cast<NodoEcuacion*>(nodo)) {
+            emitirEcuacion(ecuacion);
+        } else if (auto comando = dynamic_cast<NodoComando*>(nodo)) {
+            emitirComando(comando);
+        } else if (auto tabla = dynamic_cast<NodoTablaCsv*>(nodo)) {
+            emitirTablaCsv(tabla);
+        } else if (auto figura = dynamic_cast<NodoFigura*>(nodo)) {
+            emitirFigura(figura);
+        } else if (auto etiqueta = dynamic_cast<NodoEtiqueta*>(nodo)) {
+            salida << "<span id=\"" << escapar(etiqueta->clave) << "\"></span>\n";
+        } else if (auto referencia = dynamic_cast<NodoReferencia*>(nodo)) {
+            emitirReferencia(referencia);
+        } else if (auto indice = dynamic_cast<NodoIndice*>(nodo)) {
+            emitirIndice(indice);
+        } else if (auto cita = dynamic_cast<NodoCita*>(nodo)) {
+            emitirCita(cita);
+        } else if (auto bibliografia = dynamic_cast<NodoBibliografia*>(nodo)) {
+            emitirBibliografia(bibliografia);
+        }
+    }
+
+    void emitirSeccion(NodoSeccion* nodo) {
+        int nivel = nivelEncabezado(nodo->nivel);
+        salida << "<h" << nivel << " id=\"sec-" << nodo->numero << "\">";
+        if (!nodo->numero.empty()) {
+            salida << nodo->numero << " ";
+        }
+        salida << escapar(nodo->titulo) << "</h" << nivel << ">\n";
+    }
+
+    void emitirTexto(NodoTexto* nodo) {
+        const char* etiqueta = nullptr;
+        if (nodo->estilo == "negrita") etiqueta = "strong";
+        else if (nodo->estilo == "cursiva") etiqueta = "em";
+        else if (nodo->estilo == "subrayado") etiqueta = "u";
+        else if (nodo->estilo == "tachado") etiqueta = "s";
+
+        salida << "<p>";
+        if (etiqueta) salida << "<" << etiqueta << ">";
+        salida << escapar(nodo->contenido);
+        if (etiqueta) salida << "</" << etiqueta << ">";
+        salida << "</p>\n";
+    }
+
+    void emitirLista(NodoLista* nodo) {
+        const char* etiqueta = nodo->tipo == "simple" ? "ul" : "ol";
+        salida << "<" << etiqueta << ">\n";
+        for (auto& elemento : nodo->elementos) {
+            if (auto textoElemento = dynamic_cast<NodoTexto*>(elemento.get())) {
+                salida << "  <li>" << escapar(textoElemento->contenido) << "</li>\n";
+            }
+        }
+        salida << "</" << etiqueta << ">\n";
+    }
+
+    void emitirEcuacion(NodoEcuacion* nodo) {
+        if (nodo->tipo == "ecuacion") {
+            salida << "<div class=\"ecuacion\">\\[" << escapar(nodo->contenido);
+            if (!nodo->numero.empty()) {
+                salida << " \\tag{" << nodo->numero << "}";
+            }
+            salida << "\\]</div>\n";
+        } else {
+            salida << "<p>\\(" << escapar(nodo->contenido) << "\\)</p>\n";
+        }
+    }
+
+    void emitirComando(NodoComando* nodo) {
+        if (nodo->comando == "nueva_linea") {
+            salida << "<br>\n";
+        } else if (nodo->comando == "salto_pagina" || nodo->comando == "nueva_pagina") {
+            salida << "<hr class=\"salto-pagina\">\n";
+        } else if (nodo->comando == "inicio_documento" &&
+                   !(titulo.empty() && autor.empty() && fecha.empty())) {
+            // Equivalente a \maketitle
+            salida << "<header>\n";
+            if (!titulo.empty()) salida << "<h1 class=\"titulo\">" << escapar(titulo) << "</h1>\n";
+            if (!autor.empty()) salida << "<p class=\"autor\">" << escapar(autor) << "</p>\n";
+            if (!fecha.empty()) salida << "<p class=\"fecha\">" << escapar(fecha) << "</p>\n";
+            salida << "</header>\n";
+        }
+    }
+
+    static void agregarFila(string& bloque, const vector<string>& celdas, size_t numeroCeldas,
+                            size_t columnas, const char* celda) {
+        bloque += "<tr>";
+        for (size_t i = 0; i < columnas; i++) {
+            bloque += "<";
+            bloque += celda;
+            bloque += ">";
+            if (i < numeroCeldas) escapar(celdas[i], bloque);
+            bloque += "</";
+            bloque += celda;
+            bloque += ">";
+        }
+        bloque += "</tr>\n";
+    }
+
+    // Igual que en GeneradorLatex, el CSV se recorre fila a fila sobre el
+    // archivo mapeado y se emite por bloques.
+    void emitirTablaCsv(NodoTablaCsv* nodo) {
+        OpcionesTablaCsv opciones = leerOpcionesTablaCsv(nodo->opciones);
+        ArchivoMapeado archivo(resolverRuta(nodo->ruta));
+        LectorCsv lector(archivo.contenido(), opciones.separador);
+
+        vector<string> celdas;
+        size_t numeroCeldas = 0;
+        bool hayFila = lector.siguienteFila(celdas, numeroCeldas);
+        while (hayFila && numeroCeldas == 1 && celdas[0].empty()) {
+            hayFila = lector.siguienteFila(celdas, numeroCeldas);
+        }
+        if (!hayFila) {
+            salida << "<!-- tabla_csv vacia: " << escapar(nodo->ruta) << " -->\n";
+            return;
+        }
+
+        size_t columnas = numeroCeldas;
+        string bloque;
+        bloque.reserve(BYTES_BLOQUE_TABLA + 1024);
+        bloque += "<table>\n";
+        if (opciones.encabezado) {
+            bloque += "<thead>\n";
+            agregarFila(bloque, celdas, numeroCeldas, columnas, "th");
+            bloque += "</thead>\n<tbody>\n";
+        } else {
+            bloque += "<tbody>\n";
+            agregarFila(bloque, celdas, numeroCeldas, columnas, "td");
+        }
+
+        while (lector.siguienteFila(celdas, numeroCeldas)) {
+            if (numeroCeldas == 1 && celdas[0].empty()) continue;
+            agregarFila(bloque, celdas, numeroCeldas, columnas, "td");
+            if (bloque.size() >= BYTES_BLOQUE_TABLA) {
+                salida << bloque;
+                bloque.clear();
+            }
+        }
+
+        salida << bloque;
+        salida << "</tbody>\n</table>\n";
+    }
+
+    void emitirFigura(NodoFigura* nodo) {
+        salida << "<figure>\n";
+        salida << "<img src=\"" << escapar(rutaFigura(nodo)) << "\" alt=\"" << escapar(nodo->leyenda) << "\">\n";
+        if (!nodo->leyenda.empty()) {
+            salida << "<figcaption>Figura " << nodo->numero << ": " << escapar(nodo->leyenda)
+                   << "</figcaption>\n";
+        }
+        salida << "</figure>\n";
+    }
+
+    void emitirReferencia(NodoReferencia* nodo) {
+        if (nodo->numero.empty()) {
+            salida << "??\n";
+        } else {
+            salida << "<a href=\"#" << escapar(nodo->clave) << "\">" << nodo->numero << "</a>\n";
+        }
+    }
+
+    void emitirIndice(NodoIndice* nodo) {
+        if (nodo->entradas.empty()) return;
+
+        salida << "<nav class=\"indice\">\n<h2>&Iacute;ndice</h2>\n<ul>\n";
+        for (const auto& entrada : nodo->entradas) {
+            salida << "  <li class=\"" << entrada.nivel << "\"><a href=\"#sec-" << entrada.numero << "\">"
+                   << entrada.numero << " " << escapar(entrada.titulo) << "</a></li>\n";
+        }
+        salida << "</ul>\n</nav>\n";
+    }
+
+    // Un enlace por clave citada; las que no existen quedan como "?"
+    void emitirCita(NodoCita* nodo) {
+        vector<string> claves = separarClaves(nodo->claves);
+        vector<string> numeros = separarClaves(nodo->numero);
+        salida << "[";
+        if (numeros.empty()) salida << "?";
+        for (size_t i = 0; i < numeros.size(); i++) {
+            if (i > 0) salida << ", ";
+            if (numeros[i] == "?" || i >= claves.size()) {
+                salida << numeros[i];
+            } else {
+                salida << "<a href=\"#" << escapar(anclaBib(claves[i])) << "\">" << numeros[i] << "</a>";
+            }
+        }
+        if (!nodo->nota.empty()) salida << ", " << escapar(nodo->nota);
+        salida << "]\n";
+    }
+
+    void emitirBibliografia(NodoBibliografia* nodo) {
+        if (nodo->entradas.empty()) return;
+
+        salida << "<section class=\"bibliografia\">\n<h2>Referencias</h2>\n<ol>\n";
+        for (const auto& entrada : nodo->entradas) {
+            salida << "  <li id=\"" << escapar(anclaBib(entrada.clave)) << "\">"
+                   << escapar(textoPlanoBib(entrada.antes));
+            if (!entrada.enfasis.empty()) salida << "<em>" << escapar(textoPlanoBib(entrada.enfasis)) << "</em>";
+            salida << escapar(textoPlanoBib(entrada.despues)) << "</li>\n";
+        }
+        salida << "</ol>\n</section>\n";
+    }
+
+public:
+    EmisorHtml(const string& base = "") : Emisor(base) {}
+
+    const char* nombre() const override {
+        return "html";
+    }
+
+    const char* extension() const override {
+        return ".html";
+    }
+
+    string emitir(NodoDocumento* ast) override {
+        salida.str("");
+        salida.clear();
+        titulo.clear();
+        autor.clear();
+        fecha.clear();
+
+        bool hayEcuaciones = false;
+        for (auto& hijo : ast->hijos) {
+            if (auto metadatos = dynamic_cast<NodoMetadatos*>(hijo.get())) {
+                if (metadatos->tipo == "titulo") titulo = metadatos->contenido;
+                else if (metadatos->tipo == "autor") autor = metadatos->contenido;
+                else if (metadatos->tipo == "fecha") fecha = metadatos->contenido;
+            }
+            hayEcuaciones = hayEcuaciones || dynamic_cast<NodoEcuacion*>(hijo.get()) != nullptr;
+        }
+
+        salida << "<!DOCTYPE html>\n<html lang=\"es\">\n<head>\n<meta charset=\"utf-8\">\n";
+        salida << "<title>" << escapar(titulo) << "</title>\n";
+        if (hayEcuaciones) {
+            salida << "<script src=\"https://cdn.jsdelivr.net/npm/mathjax@3/es5/tex-mml-chtml.js\" async></script>\n";
+        }
+        salida << "</head>\n<body>\n";
+
+        for (auto& hijo : ast->hijos) {
+            emitirNodo(hijo.get());
+        }
+
+        salida << "</body>\n</html>\n";
+        return salida.str();
+    }
+};
+
+#endif
@@ -0,0 +1,296 @@
+#ifndef EMISOR_MARKDOWN_H
+#define EMISOR_MARKDOWN_H
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "archivo_mapeado.h"
+#include "ast.h"
+#include "bibliografia.h"
+#include "emisor.h"
+#include "lector_csv.h"
+
+using namespace std;
+
+// ===============================
+// EMISOR MARKDOWN
+// ===============================
+//
+// Markdown con las extensiones de GitHub (tablas, ~~tachado~~) y metadatos
+// en un bloque YAML inicial, que entienden pandoc y la mayoria de los
+// generadores de sitios. Las ecuaciones van entre $ y $$.
+
+class EmisorMarkdown : public Emisor {
+private:
+    stringstream salida;
+
+    static void escapar(string_view texto, string& destino) {
+        for (char c : texto) {
+            switch (c) {
+                case '\\': case '*': case '_': case '`': case '[': case ']': case '<':
+                    destino += '\\';
+                    destino += c;
+                    break;
+                default: destino += c; break;
+            }
+        }
+    }
+
+    static string escapar(string_view texto) {
+        string destino;
+        escapar(texto, destino);
+        return destino;
+    }
+
+    static void escaparCelda(string_view texto, string& destino) {
+        for (char c : texto) {
+            if (c == '|') destino += "\\|";
+            else if (c == '\n' || c == '\r') destino += ' ';
+            else destino += c;
+        }
+    }
+
+    static string comillasYaml(const string& texto) {
+        string resultado = "\"";
+        for (char c : texto) {
+            if (c == '"' || c == '\\') resultado += '\\';
+            resultado += c;
+        }
+        return resultado + "\"";
+    }
+
+    static int nivelEncabezado(const string& nivel) {
+        if (nivel == "capitulo") return 1;
+        if (nivel == "seccion") return 2;
+        if (nivel == "subseccion") return 3;
+        return 4;
+    }
+
+    void emitirNodo(NodoAST* nodo) {
+        if (auto seccion = dynamic_cast<NodoSeccion*>(nodo)) {
+            salida << string(nivelEncabezado(seccion->nivel), '#') << " ";
+            if (!seccion->numero.empty()) salida << seccion->numero << " ";
+            salida << escapar(seccion->titulo) << "\n\n";
+        } else if (auto texto = dynamic_cast<NodoTexto*>(nodo)) {
+            emitirTexto(texto);
+        } else if (auto lista = dynamic_cast<NodoLista*>(nodo)) {
+            emitirLista(lista);
+        } else if (auto ecuacion = dynamic_cast<NodoEcuacion*>(nodo)) {
+            emitirEcuacion(ecuacion);
+        } else if (auto comando = dynamic_cast<NodoComando*>(nodo)) {
+            if (comando->comando == "nueva_linea") {
+                salida << "<br>\n\n";
+            } else if (comando->comando == "salto_pagina" || comando->comando == "nueva_pagina") {
+                salida << "---\n\n";
+            }
+        } else if (auto tabla = dynamic_cast<NodoTablaCsv*>(nodo)) {
+            emitirTablaCsv(tabla);
+        } else if (auto figura = dynamic_cast<NodoFigura*>(nodo)) {
+            salida << "![" << escapar(figura->leyenda) << "](" << rutaFigura(figura) << ")\n";
+            if (!figura->leyenda.empty()) {
+                salida << "\n*Figura " << figura->numero << ": " << escapar(figura->leyenda) << "*\n";
+            }
+            salida << "\n";
+        } else if (auto etiqueta = dynamic_cast<NodoEtiqueta*>(nodo)) {
+            salida << "<a id=\"" << etiqueta->clave << "\"></a>\n\n";
+        } else if (auto referencia = dynamic_cast<NodoReferencia*>(nodo)) {
+            if (referencia->numero.empty()) {
+                salida << "??\n\n";
+            } else {
+                salida << "[" << referencia->numero << "](#" << referencia->clave << ")\n\n";
+            }
+        } else if (auto indice = dynamic_cast<NodoIndice*>(nodo)) {
+            emitirIndice(indice);
+        } else if (auto cita = dynamic_cast<NodoCita*>(nodo)) {
+            emitirCita(cita);
+        } else if (auto bibliografia = dynamic_cast<NodoBibliografia*>(nodo)) {
+            emitirBibliografia(bibliografia);
+        }
+    }
+
+    void emitirTexto(NodoTexto* nodo) {
+        string contenido = escapar(nodo->contenido);
+        if (nodo->estilo == "negrita") {
+            salida << "**" << contenido << "**";
+        } else if (nodo->estilo == "cursiva") {
+            salida << "*" << contenido << "*";
+        } else if (nodo->estilo == "subrayado") {
+            salida << "<u>" << contenido << "</u>";
+        } else if (nodo->estilo == "tachado") {
+            salida << "~~" << contenido << "~~";
+        } else {
+            salida << contenido;
+        }
+        salida << "\n\n";
+    }
+
+    void emitirLista(NodoLista* nodo) {
+        int numero = 1;
+        for (auto& elemento : nodo->elementos) {
+            if (auto textoElemento = dynamic_cast<NodoTexto*>(elemento.get())) {
+                if (nodo->tipo == "simple") {
+                    salida << "- ";
+                } else {
+                    salida << numero++ << ". ";
+                }
+                salida << escapar(textoElemento->contenido) << "\n";
+            }
+        }
+        salida << "\n";
+    }
+
+    void emitirEcuacion(NodoEcuacion* nodo) {
+        if (nodo->tipo == "ecuacion") {
+            salida << "$$\n" << nodo->contenido;
+            if (!nodo->numero.empty()) {
+                salida << " \\tag{" << nodo->numero << "}";
+            }
+            salida << "\n$$\n\n";
+        } else {
+            salida << "$" << nodo->contenido << "$\n\n";
+        }
+    }
+
+    static void agregarFila(string& bloque, const vector<string>& celdas, size_t numeroCeldas,
+                            size_t columnas) {
+        bloque += "|";
+        for (size_t i = 0; i < columnas; i++) {
+            bloque += " ";
+            if (i < numeroCeldas) escaparCelda(celdas[i], bloque);
+            bloque += " |";
+        }
+        bloque += "\n";
+    }
+
+    // Las tablas de Markdown siempre tienen encabezado: sin encabezado en el
+    // CSV se dejan los titulos vacios.
+    void emitirTablaCsv(NodoTablaCsv* nodo) {
+        OpcionesTablaCsv opciones = leerOpcionesTablaCsv(nodo->opciones);
+        ArchivoMapeado archivo(resolverRuta(nodo->ruta));
+        LectorCsv lector(archivo.contenido(), opciones.separador);
+
+        vector<string> celdas;
+        size_t numeroCeldas = 0;
+        bool hayFila = lector.siguienteFila(celdas, numeroCeldas);
+        while (hayFila && numeroCeldas == 1 && celdas[0].empty()) {
+            hayFila = lector.siguienteFila(celdas, numeroCeldas);
+        }
+        if (!hayFila) {
+            salida << "<!-- tabla_csv vacia: " << nodo->ruta << " -->\n\n";
+            return;
+        }
+
+        size_t columnas = numeroCeldas;
+        string bloque;
+        bloque.reserve(BYTES_BLOQUE_TABLA + 1024);
+
+        string separador = "|";
+        for (size_t i = 0; i < columnas; i++) separador += " --- |";
+        separador += "\n";
+
+        if (opciones.encabezado) {
+            agregarFila(bloque, celdas, numeroCeldas, columnas);
+            bloque += separador;
+        } else {
+            agregarFila(bloque, {}, 0, columnas);
+            bloque += separador;
+            agregarFila(bloque, celdas, numeroCeldas, columnas);
+        }
+
+        while (lector.siguienteFila(celdas, numeroCeldas)) {
+            if (numeroCeldas == 1 && celdas[0].empty()) continue;
+            agregarFila(bloque, celdas, numeroCeldas, columnas);
+            if (bloque.size() >= BYTES_BLOQUE_TABLA) {
+                salida << bloque;
+                bloque.clear();
+            }
+        }
+
+        salida << bloque << "\n";
+    }
+
+    void emitirIndice(NodoIndice* nodo) {
+        if (nodo->entradas.empty()) return;
+
+        int base = 4;
+        for (const auto& entrada : nodo->entradas) {
+            base = min(base, nivelEncabezado(entrada.nivel));
+        }
+
+        salida << "**Índice**\n\n";
+        for (const auto& entrada : nodo->entradas) {
+            salida << string(2 * (nivelEncabezado(entrada.nivel) - base), ' ') << "- "
+                   << entrada.numero << " " << escapar(entrada.titulo) << "\n";
+        }
+        salida << "\n";
+    }
+
+    void emitirCita(NodoCita* nodo) {
+        vector<string> claves = separarClaves(nodo->claves);
+        vector<string> numeros = separarClaves(nodo->numero);
+        salida << "\\[";
+        if (numeros.empty()) salida << "?";
+        for (size_t i = 0; i < numeros.size(); i++) {
+            if (i > 0) salida << ", ";
+            if (numeros[i] == "?" || i >= claves.size()) {
+                salida << numeros[i];
+            } else {
+                salida << "[" << numeros[i] << "](#" << anclaBib(claves[i]) << ")";
+            }
+        }
+        if (!nodo->nota.empty()) salida << ", " << escapar(nodo->nota);
+        salida << "\\]\n\n";
+    }
+
+    void emitirBibliografia(NodoBibliografia* nodo) {
+        if (nodo->entradas.empty()) return;
+
+        salida << "**Referencias**\n\n";
+        for (const auto& entrada : nodo->entradas) {
+            salida << entrada.numero << ". <a id=\"" << anclaBib(entrada.clave) << "\"></a>"
+                   << escapar(textoPlanoBib(entrada.antes));
+            if (!entrada.enfasis.empty()) salida << "*" << escapar(textoPlanoBib(entrada.enfasis)) << "*";
+            salida << escapar(textoPlanoBib(entrada.despues)) << "\n";
+        }
+        salida << "\n";
+    }
+
+public:
+    EmisorMarkdown(const string& base = "") : Emisor(base) {}
+
+    const char* nombre() const override {
+        return "markdown";
+    }
+
+    const char* extension() const override {
+        return ".md";
+    }
+
+    string emitir(NodoDocumento* ast) override {
+        salida.str("");
+        salida.clear();
+
+        string metadatos;
+        for (auto& hijo : ast->hijos) {
+            if (auto nodo = dynamic_cast<NodoMetadatos*>(hijo.get())) {
+                const char* clave = nodo->tipo == "titulo" ? "title" :
+                                    nodo->tipo == "autor" ? "author" :
+                                    nodo->tipo == "fecha" ? "date" : nullptr;
+                if (clave) metadatos += string(clave) + ": " + comillasYaml(nodo->contenido) + "\n";
+            }
+        }
+        if (!metadatos.empty()) {
+            salida << "---\n" << metadatos << "---\n\n";
+        }
+
+        for (auto& hijo : ast->hijos) {
+            emitirNodo(hijo.get());
+        }
+        return salida.str();
+    }
+};
+
+#endif
@@ -0,0 +1,569 @@
+#include "entrada_salida.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#include "compilador.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define USAR_IO_URING 1
+#endif
+#endif
+
+#if defined(USAR_IO_URING)
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+// ===============================
+// ESTADO COMUN DE LAS SOLICITUDES
+// ===============================
+
+// Lecturas terminadas a la espera de su trabajador y escrituras en vuelo.
+// Lo comparten los dos motores; solo cambia quien hace la E/S.
+class MotorBase : public MotorEntradaSalida {
+private:
+    struct Lectura {
+        bool lista = false;
+        string contenido;
+        string error;
+    };
+
+    mutex cerrojo;
+    condition_variable cambio;
+    unordered_map<size_t, Lectura> lecturas;
+    size_t escriturasEnVuelo = 0;
+    size_t maximoEscrituras;
+    vector<pair<size_t, string>> erroresEscritura;
+
+protected:
+    explicit MotorBase(size_t maximoEscrituras) : maximoEscrituras(max<size_t>(1, maximoEscrituras)) {}
+
+    void registrarLectura(size_t id) {
+        lock_guard<mutex> bloqueo(cerrojo);
+        lecturas[id] = Lectura();
+    }
+
+    void lecturaTerminada(size_t id, string contenido, string error) {
+        {
+            lock_guard<mutex> bloqueo(cerrojo);
+            Lectura& lectura = lecturas[id];
+            lectura.lista = true;
+            lectura.contenido = move(contenido);
+            lectura.error = move(error);
+        }
+        cambio.notify_all();
+    }
+
+    // Contrapresion: el contenido de cada escritura en vuelo sigue en
+    // memoria, asi que no se aceptan mas de maximoEscrituras.
+    void reservarEscritura() {
+        unique_lock<mutex> bloqueo(cerrojo);
+        cambio.wait(bloqueo, [&] { return escriturasEnVuelo < maximoEscrituras; });
+        escriturasEnVuelo++;
+    }
+
+    void escrituraTerminada(size_t id, string error) {
+        {
+            lock_guard<mutex> bloqueo(cerrojo);
+            escriturasEnVuelo--;
+            if (!error.empty()) erroresEscritura.emplace_back(id, move(error));
+        }
+        cambio.notify_all();
+    }
+
+public:
+    string esperarLectura(size_t id) override {
+        unique_lock<mutex> bloqueo(cerrojo);
+        auto it = lecturas.find(id);
+        if (it == lecturas.end()) {
+            throw logic_error("Lectura no solicitada: " + to_string(id));
+        }
+        cambio.wait(bloqueo, [&] { return it->second.lista; });
+        Lectura lectura = move(it->second);
+        lecturas.erase(it);
+        if (!lectura.error.empty()) {
+            throw runtime_error(lectura.error);
+        }
+        return move(lectura.contenido);
+    }
+
+    vector<pair<size_t, string>> terminarEscrituras() override {
+        unique_lock<mutex> bloqueo(cerrojo);
+        cambio.wait(bloqueo, [&] { return escriturasEnVuelo == 0; });
+        return move(erroresEscritura);
+    }
+};
+
+// escribirArchivo() no informa si la escritura falla a medias (disco
+// lleno, cuota del directorio de red); aqui el error se comprueba al cerrar.
+void escribirCompleto(const string& ruta, const string& contenido, bool binario) {
+    ofstream archivo(ruta, binario ? ios::binary : ios::out);
+    if (!archivo.is_open()) {
+        throw runtime_error("No se pudo crear el archivo: " + ruta);
+    }
+    archivo.write(contenido.data(), static_cast<streamsize>(contenido.size()));
+    archivo.close();
+    if (!archivo) {
+        throw runtime_error("No se pudo escribir el archivo: " + ruta);
+    }
+}
+
+// ===============================
+// MOTOR DE HILOS
+// ===============================
+
+class MotorHilos : public MotorBase {
+private:
+    mutex cerrojoCola;
+    condition_variable hayTrabajo;
+    deque<function<void()>> cola;
+    bool detener = false;
+    vector<thread> hilos;
+
+    void encolar(function<void()> tarea) {
+        {
+            lock_guard<mutex> bloqueo(cerrojoCola);
+            cola.push_back(move(tarea));
+        }
+        hayTrabajo.notify_one();
+    }
+
+    void trabajar() {
+        while (true) {
+            function<void()> tarea;
+            {
+                unique_lock<mutex> bloqueo(cerrojoCola);
+                hayTrabajo.wait(bloqueo, [&] { return detener || !cola.empty(); });
+                if (cola.empty()) return;
+                tarea = move(cola.front());
+                cola.pop_front();
+            }
+            tarea();
+        }
+    }
+
+public:
+    explicit MotorHilos(unsigned enVuelo) : MotorBase(2 * enVuelo) {
+        unsigned numero = max(1u, min(enVuelo, 32u));
+        for (unsigned i = 0; i < numero; i++) {
+            hilos.emplace_back([this] { trabajar(); });
+        }
+    }
+
+    ~MotorHilos() override {
+        {
+            lock_guard<mutex> bloqueo(cerrojoCola);
+            detener = true;
+        }
+        hayTrabajo.notify_all();
+        for (auto& hilo : hilos) hilo.join();
+    }
+
+    const char* nombre() const override {
+        return "hilos";
+    }
+
+    void leer(size_t id, const string& ruta) override {
+        registrarLectura(id);
+        encolar([this, id, ruta] {
+            try {
+                lecturaTerminada(id, leerArchivo(ruta), "");
+            } catch (const exception& e) {
+                lecturaTerminada(id, "", e.what());
+            }
+        });
+    }
+
+    void escribir(size_t id, const string& ruta, string contenido, bool binario) override {
+        reservarEscritura();
+        auto datos = make_shared<string>(move(contenido));
+        encolar([this, id, ruta, datos, binario] {
+            try {
+                escribirCompleto(ruta, *datos, binario);
+                escrituraTerminada(id, "");
+            } catch (const exception& e) {
+                escrituraTerminada(id, e.what());
+            }
+        });
+    }
+};
+
+// ===============================
+// MOTOR IO_URING
+// ===============================
+
+#if defined(USAR_IO_URING)
+
+// Cada archivo es una solicitud que pasa por abrir, transferir (una o mas
+// lecturas o escrituras) y cerrar, con una sola operacion en vuelo a la
+// vez. Los trabajadores encolan la primera operacion; el hilo recolector
+// recoge las terminaciones y encola la siguiente de cada solicitud.
+// Se usan las llamadas al sistema directamente (sin liburing).
+class MotorIoUring : public MotorBase {
+private:
+    enum class Etapa { ABRIR, TRANSFERIR, CERRAR };
+
+    struct Solicitud {
+        bool escritura;
+        size_t id;
+        string ruta;
+        string datos;
+        int descriptor = -1;
+        size_t hecho = 0;
+        Etapa etapa = Etapa::ABRIR;
+        string error;
+
+        Solicitud(bool escritura, size_t id, string ruta, string datos)
+            : escritura(escritura), id(id), ruta(move(ruta)), datos(move(datos)) {}
+    };
+
+    int anillo = -1;
+    void* mapaSq = MAP_FAILED;
+    size_t tamanoMapaSq = 0;
+    void* mapaCq = MAP_FAILED;
+    size_t tamanoMapaCq = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t tamanoSqes = 0;
+
+    unsigned* sqCabeza;
+    unsigned* sqCola;
+    unsigned sqMascara;
+    unsigned* sqIndices;
+    unsigned* cqCabeza;
+    unsigned* cqCola;
+    unsigned cqMascara;
+    io_uring_cqe* cqes;
+
+    // Solicitudes con una operacion en vuelo; una entrada del anillo queda
+    // libre para despertar al recolector al cerrar.
+    unsigned capacidad = 0;
+    unsigned activas = 0;
+    unsigned porEnviar = 0;
+    deque<Solicitud*> esperando;
+    bool detener = false;
+    mutex cerrojoAnillo;
+    thread recolector;
+
+    static int entrar(int anillo, unsigned enviar, unsigned esperar, unsigned banderas) {
+        return static_cast<int>(syscall(__NR_io_uring_enter, anillo, enviar, esperar, banderas, nullptr, 0));
+    }
+
+    void liberarAnillo() {
+        if (sqes != MAP_FAILED) munmap(sqes, tamanoSqes);
+        if (mapaCq != MAP_FAILED && mapaCq != mapaSq) munmap(mapaCq, tamanoMapaCq);
+        if (mapaSq != MAP_FAILED) munmap(mapaSq, tamanoMapaSq);
+        if (anillo >= 0) close(anillo);
+    }
+
+    // Requiere cerrojoAnillo. Siempre hay hueco: cada solicitud activa
+    // ocupa a lo sumo una entrada y se envia enseguida.
+    io_uring_sqe* nuevaSqe(uint64_t datosUsuario) {
+        unsigned cola = *sqCola;
+        unsigned indice = cola & sqMascara;
+        io_uring_sqe* sqe = &sqes[indice];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->user_data = datosUsuario;
+        sqIndices[indice] = indice;
+        return sqe;
+    }
+
+    void publicarSqe() {
+        __atomic_store_n(sqCola, *sqCola + 1, __ATOMIC_RELEASE);
+        porEnviar++;
+    }
+
+    void enviar() {
+        while (porEnviar > 0) {
+            int enviadas = entrar(anillo, porEnviar, 0, 0);
+            if (enviadas < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+                throw runtime_error(string("io_uring_enter: ") + strerror(errno));
+            }
+            porEnviar -= static_cast<unsigned>(enviadas);
+        }
+    }
+
+    void encolarOperacion(Solicitud* solicitud) {
+        io_uring_sqe* sqe = nuevaSqe(reinterpret_cast<uint64_t>(solicitud));
+        switch (solicitud->etapa) {
+            case Etapa::ABRIR:
+                sqe->opcode = IORING_OP_OPENAT;
+                sqe->fd = AT_FDCWD;
+                sqe->addr = reinterpret_cast<uint64_t>(solicitud->ruta.c_str());
+                sqe->open_flags = solicitud->escritura ? (O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC)
+                                                       : (O_RDONLY | O_CLOEXEC);
+                sqe->len = 0666;
+                break;
+            case Etapa::TRANSFERIR:
+                sqe->opcode = solicitud->escritura ? IORING_OP_WRITE : IORING_OP_READ;
+                sqe->fd = solicitud->descriptor;
+                sqe->addr = reinterpret_cast<uint64_t>(&solicitud->datos[solicitud->hecho]);
+                sqe->len = static_cast<uint32_t>(min<size_t>(solicitud->datos.size() - solicitud->hecho, 1u << 30));
+                sqe->off = solicitud->hecho;
+                break;
+            case Etapa::CERRAR:
+                sqe->opcode = IORING_OP_CLOSE;
+                sqe->fd = solicitud->descriptor;
+                break;
+        }
+        publicarSqe();
+    }
+
+    // Requiere cerrojoAnillo.
+    void iniciar(Solicitud* solicitud) {
+        if (activas >= capacidad) {
+            esperando.push_back(solicitud);
+            return;
+        }
+        activas++;
+        encolarOperacion(solicitud);
+    }
+
+    void terminar(Solicitud* solicitud) {
+        activas--;
+        if (solicitud->escritura) {
+            escrituraTerminada(solicitud->id, move(solicitud->error));
+        } else {
+            lecturaTerminada(solicitud->id, move(solicitud->datos), move(solicitud->error));
+        }
+        delete solicitud;
+    }
+
+    // Resultado de la operacion en vuelo de 'solicitud': encola la
+    // siguiente o la da por terminada.
+    void avanzar(Solicitud* solicitud, int resultado) {
+        if (resultado == -EINTR || resultado == -EAGAIN) {
+            encolarOperacion(solicitud);
+            return;
+        }
+        switch (solicitud->etapa) {
+            case Etapa::ABRIR:
+                if (resultado < 0) {
+                    solicitud->error = (solicitud->escritura ? "No se pudo crear el archivo: "
+                                                             : "No se pudo abrir el archivo: ") + solicitud->ruta;
+                    solicitud->datos.clear();
+                    terminar(solicitud);
+                    return;
+                }
+                solicitud->descriptor = resultado;
+                solicitud->etapa = Etapa::TRANSFERIR;
+                if (!solicitud->escritura) {
+                    struct stat info;
+                    if (fstat(resultado, &info) != 0) {
+                        solicitud->error = "No se pudo consultar el archivo: " + solicitud->ruta;
+                        solicitud->etapa = Etapa::CERRAR;
+                    } else {
+                        solicitud->datos.resize(static_cast<size_t>(info.st_size));
+                    }
+                }
+                if (solicitud->datos.empty()) solicitud->etapa = Etapa::CERRAR;
+                break;
+            case Etapa::TRANSFERIR:
+                if (resultado < 0 || (resultado == 0 && solicitud->escritura)) {
+                    solicitud->error = (solicitud->escritura ? "No se pudo escribir el archivo: "
+                                                             : "No se pudo leer el archivo: ") + solicitud->ruta;
+                    solicitud->etapa = Etapa::CERRAR;
+                } else if (resultado == 0) {
+                    // El archivo se acorto desde fstat
+                    solicitud->datos.resize(solicitud->hecho);
+                    solicitud->etapa = Etapa::CERRAR;
+                } else {
+                    solicitud->hecho += static_cast<size_t>(resultado);
+                    if (solicitud->hecho == solicitud->datos.size()) solicitud->etapa = Etapa::CERRAR;
+                }
+                break;
+            case Etapa::CERRAR:
+                // En un sistema de archivos de red, close() informa los
+                // errores de escritura diferidos
+                if (resultado < 0 && solicitud->escritura && solicitud->error.empty()) {
+                    solicitud->error = "No se pudo escribir el archivo: " + solicitud->ruta;
+                }
+                terminar(solicitud);
+                return;
+        }
+        encolarOperacion(solicitud);
+    }
+
+    void recolectar() {
+        while (true) {
+            int resultado = entrar(anillo, 0, 1, IORING_ENTER_GETEVENTS);
+            if (resultado < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                // No deberia ocurrir con un anillo valido; se reintenta tras
+                // ceder el procesador para no girar en vacio
+                this_thread::yield();
+            }
+
+            lock_guard<mutex> bloqueo(cerrojoAnillo);
+            unsigned cabeza = *cqCabeza;
+            unsigned cola = __atomic_load_n(cqCola, __ATOMIC_ACQUIRE);
+            for (; cabeza != cola; cabeza++) {
+                const io_uring_cqe& cqe = cqes[cabeza & cqMascara];
+                if (cqe.user_data != 0) {
+                    avanzar(reinterpret_cast<Solicitud*>(cqe.user_data), cqe.res);
+                }
+            }
+            __atomic_store_n(cqCabeza, cabeza, __ATOMIC_RELEASE);
+
+            while (!esperando.empty() && activas < capacidad) {
+                Solicitud* solicitud = esperando.front();
+                esperando.pop_front();
+                iniciar(solicitud);
+            }
+            try {
+                enviar();
+            } catch (const exception&) {
+                // Quedan en porEnviar y se reintentan en la siguiente vuelta
+            }
+            if (detener && activas == 0 && esperando.empty()) return;
+        }
+    }
+
+    void encolarSolicitud(Solicitud* solicitud) {
+        lock_guard<mutex> bloqueo(cerrojoAnillo);
+        iniciar(solicitud);
+        enviar();
+    }
+
+public:
+    // Lanza runtime_error si el nucleo no permite io_uring o no tiene las
+    // operaciones necesarias.
+    explicit MotorIoUring(unsigned enVuelo) : MotorBase(2 * enVuelo) {
+        io_uring_params parametros;
+        memset(&parametros, 0, sizeof(parametros));
+        unsigned entradas = 8;
+        while (entradas < enVuelo + 1 && entradas < 4096) entradas *= 2;
+        anillo = static_cast<int>(syscall(__NR_io_uring_setup, entradas, &parametros));
+        if (anillo < 0) {
+            throw runtime_error(string("io_uring_setup: ") + strerror(errno));
+        }
+
+        // openat, read, write y close llegaron en Linux 5.6, junto con
+        // IORING_REGISTER_PROBE
+        vector<char> memoriaSonda(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+        io_uring_probe* sonda = reinterpret_cast<io_uring_probe*>(memoriaSonda.data());
+        bool soportado = syscall(__NR_io_uring_register, anillo, IORING_REGISTER_PROBE, sonda, 256) == 0;
+        for (int operacion : {IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_WRITE, IORING_OP_CLOSE}) {
+            soportado = soportado && operacion <= sonda->last_op &&
+                        (sonda->ops[operacion].flags & IO_URING_OP_SUPPORTED);
+        }
+        if (!soportado || !(parametros.features & IORING_FEAT_NODROP)) {
+            liberarAnillo();
+            throw runtime_error("io_uring sin openat/read/write/close (Linux 5.6 o posterior)");
+        }
+
+        tamanoMapaSq = parametros.sq_off.array + parametros.sq_entries * sizeof(unsigned);
+        tamanoMapaCq = parametros.cq_off.cqes + parametros.cq_entries * sizeof(io_uring_cqe);
+        if (parametros.features & IORING_FEAT_SINGLE_MMAP) {
+            tamanoMapaSq = tamanoMapaCq = max(tamanoMapaSq, tamanoMapaCq);
+        }
+        mapaSq = mmap(nullptr, tamanoMapaSq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, anillo,
+                      IORING_OFF_SQ_RING);
+        if (mapaSq != MAP_FAILED) {
+            mapaCq = (parametros.features & IORING_FEAT_SINGLE_MMAP)
+                ? mapaSq
+                : mmap(nullptr, tamanoMapaCq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, anillo,
+                       IORING_OFF_CQ_RING);
+        }
+        tamanoSqes = parametros.sq_entries * sizeof(io_uring_sqe);
+        if (mapaCq != MAP_FAILED) {
+            sqes = static_cast<io_uring_sqe*>(mmap(nullptr, tamanoSqes, PROT_READ | PROT_WRITE,
+                                                   MAP_SHARED | MAP_POPULATE, anillo, IORING_OFF_SQES));
+        }
+        if (sqes == MAP_FAILED) {
+            liberarAnillo();
+            throw runtime_error("No se pudo proyectar el anillo de io_uring");
+        }
+
+        char* sq = static_cast<char*>(mapaSq);
+        char* cq = static_cast<char*>(mapaCq);
+        sqCabeza = reinterpret_cast<unsigned*>(sq + parametros.sq_off.head);
+        sqCola = reinterpret_cast<unsigned*>(sq + parametros.sq_off.tail);
+        sqMascara = *reinterpret_cast<unsigned*>(sq + parametros.sq_off.ring_mask);
+        sqIndices = reinterpret_cast<unsigned*>(sq + parametros.sq_off.array);
+        cqCabeza = reinterpret_cast<unsigned*>(cq + parametros.cq_off.head);
+        cqCola = reinterpret_cast<unsigned*>(cq + parametros.cq_off.tail);
+        cqMascara = *reinterpret_cast<unsigned*>(cq + parametros.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + parametros.cq_off.cqes);
+        capacidad = parametros.sq_entries - 1;
+
+        recolector = thread([this] { recolectar(); });
+    }
+
+    ~MotorIoUring() override {
+        {
+            // Una operacion vacia despierta al recolector para que vea
+            // 'detener'
+            lock_guard<mutex> bloqueo(cerrojoAnillo);
+            detener = true;
+            io_uring_sqe* sqe = nuevaSqe(0);
+            sqe->opcode = IORING_OP_NOP;
+            publicarSqe();
+            try {
+                enviar();
+            } catch (const exception&) {
+            }
+        }
+        recolector.join();
+        liberarAnillo();
+    }
+
+    const char* nombre() const override {
+        return "io_uring";
+    }
+
+    void leer(size_t id, const string& ruta) override {
+        registrarLectura(id);
+        encolarSolicitud(new Solicitud(false, id, ruta, string()));
+    }
+
+    void escribir(size_t id, const string& ruta, string contenido, bool) override {
+        reservarEscritura();
+        encolarSolicitud(new Solicitud(true, id, ruta, move(contenido)));
+    }
+};
+
+#endif
+
+} // namespace
+
+unique_ptr<MotorEntradaSalida> crearMotorEntradaSalida(TipoMotorES tipo, unsigned enVuelo) {
+    if (tipo == TipoMotorES::SINCRONO) return nullptr;
+    enVuelo = max(1u, enVuelo);
+#if defined(USAR_IO_URING)
+    if (tipo == TipoMotorES::AUTOMATICO || tipo == TipoMotorES::IO_URING) {
+        try {
+            return make_unique<MotorIoUring>(enVuelo);
+        } catch (const exception&) {
+            // seccomp, nucleo antiguo o io_uring desactivado: se usan hilos
+        }
+    }
+#endif
+    return make_unique<MotorHilos>(enVuelo);
+}
+
+TipoMotorES leerTipoMotorES(const string& texto) {
+    if (texto == "auto") return TipoMotorES::AUTOMATICO;
+    if (texto == "io_uring") return TipoMotorES::IO_URING;
+    if (texto == "hilos") return TipoMotorES::HILOS;
+    if (texto == "sincrono") return TipoMotorES::SINCRONO;
+    throw invalid_argument("Motor de E/S desconocido: " + texto);
+}
@@ -0,0 +1,75 @@
+#ifndef ENTRADA_SALIDA_H
+#define ENTRADA_SALIDA_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// ===============================
+// E/S ASINCRONA DEL LOTE
+// ===============================
+//
+// Con los .texes en un directorio de red, cada leerArchivo() o
+// escribirArchivo() deja al hilo trabajador bloqueado mientras la CPU no
+// hace nada. El motor de E/S mantiene muchas lecturas y escrituras en
+// vuelo: compilarLote pide por adelantado los documentos que vienen
+// mientras analiza y genera los anteriores, y entrega cada salida al motor
+// sin esperar a que llegue al disco.
+//
+// Hay dos motores:
+//   - io_uring (Linux 5.6 o posterior): un hilo recoge las terminaciones y
+//     encadena abrir -> leer/escribir -> cerrar de cada archivo; ninguna
+//     operacion bloquea a un trabajador.
+//   - hilos: un grupo de hilos de E/S que llaman a leerArchivo() y
+//     escribirArchivo(). Es el respaldo portable (Windows, nucleos sin
+//     io_uring o contenedores que lo bloquean con seccomp).
+//
+// Las solicitudes se identifican con un numero que elige quien llama (el
+// indice del documento en el lote).
+
+enum class TipoMotorES {
+    AUTOMATICO, // io_uring si el nucleo lo permite, si no hilos
+    IO_URING,
+    HILOS,
+    SINCRONO    // sin motor: cada trabajador lee y escribe por su cuenta
+};
+
+class MotorEntradaSalida {
+public:
+    virtual ~MotorEntradaSalida() = default;
+
+    // "io_uring" o "hilos"
+    virtual const char* nombre() const = 0;
+
+    // Empieza a leer el archivo completo. No bloquea.
+    virtual void leer(size_t id, const string& ruta) = 0;
+
+    // Espera a que termine la lectura 'id' y entrega su contenido. Lanza
+    // runtime_error (el mismo mensaje que leerArchivo) si fallo.
+    virtual string esperarLectura(size_t id) = 0;
+
+    // Crea o reemplaza el archivo con 'contenido', que pasa a ser del
+    // motor. Solo bloquea si ya hay demasiadas escrituras en vuelo.
+    // 'binario': sin conversion de fin de linea (solo cambia algo en
+    // Windows).
+    virtual void escribir(size_t id, const string& ruta, string contenido, bool binario) = 0;
+
+    // Espera todas las escrituras y devuelve las que fallaron (id y
+    // mensaje).
+    virtual vector<pair<size_t, string>> terminarEscrituras() = 0;
+};
+
+// 'enVuelo': operaciones simultaneas (tamano del anillo o numero de hilos
+// de E/S). Con IO_URING, si el nucleo no lo permite se usa el motor de
+// hilos; SINCRONO devuelve nullptr.
+unique_ptr<MotorEntradaSalida> crearMotorEntradaSalida(TipoMotorES tipo, unsigned enVuelo);
+
+// "auto", "io_uring", "hilos", "sincrono". Lanza invalid_argument si no es
+// valido.
+TipoMotorES leerTipoMotorES(const string& texto);
+
+#endif
@@ -0,0 +1,109 @@
+#include "formatos.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "hash.h"
+#include "proceso.h"
+
+using namespace std;
+
+CacheFormatos::CacheFormatos(const string& dir, const string& motorTex)
+    : directorio(filesystem::absolute(dir).string()), motor(motorTex) {}
+
+// Vuelca el preambulo con "<motor> -ini &<motor> mylatexformat.ltx" en un
+// temporal y mueve el .fmt al directorio. Lanza runtime_error si falla.
+string CacheFormatos::construir(const string& nombre, const string& preambulo) {
+    string temporal = crearDirectorioTemporal();
+    struct Limpieza {
+        string ruta;
+        ~Limpieza() {
+            error_code error;
+            filesystem::remove_all(ruta, error);
+        }
+    } limpieza{temporal};
+
+    {
+        ofstream archivo(filesystem::path(temporal) / "preambulo.tex");
+        archivo << preambulo << "\\begin{document}\n\\end{document}\n";
+    }
+
+    // El formato base se llama como el motor: pdflatex, lualatex, xelatex...
+    string base = filesystem::path(motor).stem().string();
+    string salida = (filesystem::path(temporal) / "motor.txt").string();
+    int codigo = ejecutarProceso({motor, "-ini", "-interaction=nonstopmode", "-halt-on-error",
+                                  "-jobname=" + nombre, "&" + base, "mylatexformat.ltx",
+                                  "preambulo.tex"},
+                                 temporal, salida);
+
+    filesystem::path generado = filesystem::path(temporal) / (nombre + ".fmt");
+    if (codigo != 0 || !filesystem::exists(generado)) {
+        throw runtime_error("No se pudo construir el formato " + nombre + " (codigo " +
+                            to_string(codigo) + ")\n" + ultimasLineas(salida, 8));
+    }
+
+    filesystem::create_directories(directorio);
+    filesystem::path destino = filesystem::path(directorio) / (nombre + ".fmt");
+    error_code error;
+    filesystem::rename(generado, destino, error);
+    if (error) {
+        // Otro sistema de archivos: copiar a un temporal del destino y renombrar
+        filesystem::path copia = destino;
+        copia += ".tmp";
+        filesystem::copy_file(generado, copia, filesystem::copy_options::overwrite_existing);
+        filesystem::rename(copia, destino);
+    }
+    return nombre;
+}
+
+string CacheFormatos::formatoPara(const string& preambulo) {
+    string nombre = "latexes-" + hashHex(hashContenido(motor + '\n' + preambulo));
+
+    shared_ptr<Variante> variante;
+    {
+        lock_guard<mutex> bloqueo(cerrojo);
+        auto& entrada = variantes[nombre];
+        if (!entrada) {
+            entrada = make_shared<Variante>();
+            estadisticas.variantes++;
+        }
+        variante = entrada;
+    }
+
+    call_once(variante->construida, [&]() {
+        if (filesystem::exists(filesystem::path(directorio) / (nombre + ".fmt"))) {
+            variante->nombre = nombre;
+            lock_guard<mutex> bloqueo(cerrojo);
+            estadisticas.desdeCache++;
+            return;
+        }
+
+        auto inicio = chrono::steady_clock::now();
+        string error;
+        try {
+            variante->nombre = construir(nombre, preambulo);
+        } catch (const exception& e) {
+            variante->nombre.clear();
+            error = e.what();
+        }
+        double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+
+        lock_guard<mutex> bloqueo(cerrojo);
+        if (error.empty()) {
+            estadisticas.construidos++;
+        } else {
+            estadisticas.fallidos++;
+            estadisticas.ultimoError = error;
+        }
+        estadisticas.segundos += segundos;
+    });
+
+    return variante->nombre;
+}
+
+EstadisticasFormatos CacheFormatos::getEstadisticas() {
+    lock_guard<mutex> bloqueo(cerrojo);
+    return estadisticas;
+}
@@ -0,0 +1,65 @@
+#ifndef FORMATOS_H
+#define FORMATOS_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+// ===============================
+// FORMATOS PRECOMPILADOS DEL PREAMBULO
+// ===============================
+//
+// Cargar babel y los paquetes AMS domina el arranque de pdflatex en
+// documentos cortos. Para cada preambulo distinto se vuelca una vez un
+// formato (.fmt) con mylatexformat y los .tex empiezan con "%&<formato>".
+//
+// El nombre del formato es el hash del preambulo y del motor, asi que un
+// preambulo que cambia produce otro formato y el anterior deja de usarse.
+// Los formatos quedan en el directorio y se reutilizan entre ejecuciones.
+
+struct EstadisticasFormatos {
+    size_t variantes = 0;   // preambulos distintos pedidos
+    size_t desdeCache = 0;  // ya estaban en el directorio
+    size_t construidos = 0;
+    size_t fallidos = 0;
+    double segundos = 0.0;  // tiempo total construyendo
+    string ultimoError;
+};
+
+class CacheFormatos {
+private:
+    struct Variante {
+        once_flag construida;
+        string nombre; // vacio si no se pudo construir
+    };
+
+    string directorio;
+    string motor;
+
+    mutex cerrojo;
+    unordered_map<string, shared_ptr<Variante>> variantes;
+    EstadisticasFormatos estadisticas;
+
+    string construir(const string& nombre, const string& preambulo);
+
+public:
+    // directorio: carpeta de los .fmt; motor: el mismo que ejecutara --pdf.
+    CacheFormatos(const string& directorio, const string& motor);
+
+    // Nombre del formato para 'preambulo', construyendolo la primera vez.
+    // Documentos con el mismo preambulo comparten el formato y, si se piden
+    // a la vez desde varios hilos, solo uno lo construye. Devuelve "" si el
+    // motor no pudo volcarlo: el documento se compila sin formato.
+    string formatoPara(const string& preambulo);
+
+    const string& getDirectorio() const {
+        return directorio;
+    }
+
+    EstadisticasFormatos getEstadisticas();
+};
+
+#endif
@@ -0,0 +1,447 @@
+// ===============================
+// ARNES DE FUZZING DEL ANALIZADOR LEXICO Y SINTACTICO
+// ===============================
+//
+// Ejecuta AnalizadorLexico, AnalizadorSintactico y la expansion de macros
+// sobre cada entrada y mide el coste por byte. Cuando una entrada es sospechosamente cara se repite
+// duplicando su tamano; si el tiempo crece mas que linealmente se guarda en
+// el directorio de regresiones (LATEXES_REGRESIONES, por defecto
+// "fuzz/regresiones/") para reproducirla despues.
+//
+// Con libFuzzer:
+//   clang++ -std=c++17 -O1 -g -pthread -fsanitize=fuzzer,address -DLATEXES_LIBFUZZER
+//           fuzz/fuzz_compilador.cpp macros.cpp memoria.cpp validador_matematicas.cpp
+//           -o fuzz_compilador
+//   ./fuzz_compilador corpus/
+//
+// Independiente (sin libFuzzer):
+//   g++ -std=c++17 -O2 -pthread fuzz/fuzz_compilador.cpp macros.cpp memoria.cpp
+//       validador_matematicas.cpp -o fuzz_compilador
+//   ./fuzz_compilador fuzz/regresiones/*.texes reproduce entradas guardadas
+//   ./fuzz_compilador --iteraciones=100000     entradas aleatorias
+//   ./fuzz_compilador --escalado               prueba de complejidad lineal
+//   ./fuzz_compilador --asignaciones           asignaciones de memoria por KB
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../analizador_lexico.h"
+#include "../analizador_sintactico.h"
+#include "../macros.h"
+
+using namespace std;
+
+// Por encima de esta razon entre t(2n) y t(n) el coste se considera
+// superlineal (lineal = 2, cuadratico = 4).
+const double RAZON_SUPERLINEAL = 2.8;
+
+// Tamano minimo de la entrada repetida para que el tiempo medido no sea ruido.
+const size_t BYTES_MINIMOS_ESCALADO = 64 * 1024;
+
+// Una entrada se revisa con la prueba de duplicacion si su coste por byte
+// supera en este factor a la media observada hasta el momento.
+const double FACTOR_SOSPECHA = 4.0;
+
+// Asignaciones de memoria dinamica por KB del documento de referencia que
+// --asignaciones tolera antes de fallar (lexico, sintaxis y AST). Si un
+// cambio las reduce, conviene bajar el limite para fijar la mejora.
+const double ASIGNACIONES_MAXIMAS_POR_KB = 95;
+
+// ===============================
+// EJECUCION Y MEDICION
+// ===============================
+
+// El arnes no enlaza compilador.cpp; solo BibliotecaMacros::cargar() la usa.
+string leerArchivo(const string& nombreArchivo) {
+    ifstream archivo(nombreArchivo, ios::binary);
+    if (!archivo.is_open()) {
+        throw runtime_error("No se pudo abrir el archivo: " + nombreArchivo);
+    }
+    return string(istreambuf_iterator<char>(archivo), istreambuf_iterator<char>());
+}
+
+static void ejecutarCompilador(const string& entrada) {
+    try {
+        AnalizadorLexico lexico(entrada);
+        vector<Token> tokens = lexico.analizar();
+
+        AnalizadorSintactico sintactico(move(tokens));
+        if (sintactico.analizarSintaxis()) {
+            unique_ptr<NodoDocumento> documento = sintactico.analizar(true);
+            unique_ptr<AnalizadorSintactico> sintacticoMacros;
+            size_t usos = 0;
+            expandirMacros(documento.get(), nullptr, sintacticoMacros, usos);
+        }
+    } catch (const exception&) {
+        // Los errores de compilacion son resultados validos para el arnes.
+    }
+}
+
+static double medirNs(const string& entrada, int repeticiones) {
+    double mejor = 1e300;
+    for (int i = 0; i < repeticiones; i++) {
+        auto inicio = chrono::steady_clock::now();
+        ejecutarCompilador(entrada);
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - inicio).count();
+        mejor = min(mejor, ns);
+    }
+    return mejor;
+}
+
+static string repetirHasta(const string& semilla, size_t bytes) {
+    string resultado;
+    resultado.reserve(bytes + semilla.size());
+    while (resultado.size() < bytes) {
+        resultado += semilla;
+    }
+    return resultado;
+}
+
+// Razon de tiempos al duplicar la entrada repetida, medida en dos pasos
+// (x1 -> x2 -> x4). Se devuelve la menor de las dos razones: un paso ruidoso
+// aislado no basta para declarar superlinealidad.
+static double razonDuplicacion(const string& semilla) {
+    if (semilla.empty()) return 0.0;
+    string base = repetirHasta(semilla, BYTES_MINIMOS_ESCALADO);
+    string doble = base + base;
+    string cuadruple = doble + doble;
+
+    double tBase = medirNs(base, 3);
+    double tDoble = medirNs(doble, 3);
+    double tCuadruple = medirNs(cuadruple, 3);
+    if (tBase <= 0.0 || tDoble <= 0.0) return 0.0;
+    return min(tDoble / tBase, tCuadruple / tDoble);
+}
+
+static void guardarRegresion(const string& entrada) {
+    const char* variable = getenv("LATEXES_REGRESIONES");
+    string directorio = variable != nullptr ? variable : "fuzz/regresiones";
+    error_code error;
+    filesystem::create_directories(directorio, error);
+
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : entrada) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+
+    string nombre = directorio + "/superlineal-" + to_string(hash) + ".texes";
+    ofstream archivo(nombre, ios::binary);
+    if (archivo.is_open()) {
+        archivo << entrada;
+        cerr << "Entrada superlineal guardada en " << nombre << "\n";
+    } else {
+        cerr << "Entrada superlineal (no se pudo guardar en " << directorio << ")\n";
+    }
+}
+
+// Coste medio por byte de las entradas vistas, para detectar anomalias.
+static double sumaNsPorByte = 0.0;
+static double entradasMedidas = 0.0;
+
+// Devuelve true si la entrada escala de forma superlineal.
+static bool revisarEntrada(const string& entrada) {
+    double ns = medirNs(entrada, 1);
+    if (entrada.size() < 16) return false;
+
+    double nsPorByte = ns / entrada.size();
+    double media = entradasMedidas > 0.0 ? sumaNsPorByte / entradasMedidas : nsPorByte;
+    sumaNsPorByte += nsPorByte;
+    entradasMedidas += 1.0;
+
+    if (nsPorByte < media * FACTOR_SOSPECHA) return false;
+
+    double razon = razonDuplicacion(entrada);
+    if (razon > RAZON_SUPERLINEAL) {
+        cerr << "Coste superlineal: " << entrada.size() << " bytes, "
+             << nsPorByte << " ns/byte, t(2n)/t(n) = " << razon << "\n";
+        guardarRegresion(entrada);
+        return true;
+    }
+    return false;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* datos, size_t tamano) {
+    string entrada(reinterpret_cast<const char*>(datos), tamano);
+    revisarEntrada(entrada);
+    return 0;
+}
+
+#ifndef LATEXES_LIBFUZZER
+
+// ===============================
+// MODO INDEPENDIENTE
+// ===============================
+
+static string leerBinario(const string& nombre) {
+    ifstream archivo(nombre, ios::binary);
+    return string(istreambuf_iterator<char>(archivo), istreambuf_iterator<char>());
+}
+
+// Genera documentos con fragmentos del lenguaje para explorar el lexico.
+static string entradaAleatoria(mt19937& generador) {
+    static const char* fragmentos[] = {
+        "documento_inicio", "documento_fin", "parrafo", "negrita", "seccion",
+        "lista_simple", "elemento", "fin_lista", "ecuacion", "configurar",
+        "(", ")", ";", ",", "{", "}", "[", "]", "=", "%", "$", "&",
+        "\"", "\"texto\"", "\\\"", "\\n", "palabra", "123", "4.5", " ",
+        "\t", "\n", "\xc3\xb1", "@", "_"
+    };
+    const size_t total = sizeof(fragmentos) / sizeof(fragmentos[0]);
+    uniform_int_distribution<size_t> fragmento(0, total - 1);
+    uniform_int_distribution<int> longitud(1, 400);
+
+    string entrada;
+    int piezas = longitud(generador);
+    for (int i = 0; i < piezas; i++) {
+        entrada += fragmentos[fragmento(generador)];
+    }
+    return entrada;
+}
+
+struct FormaEscalado {
+    const char* nombre;
+    function<string(size_t)> generar;
+};
+
+static string documentoDe(const string& linea, size_t bytes) {
+    return "documento_inicio;\n" + repetirHasta(linea, bytes) + "documento_fin;\n";
+}
+
+// Prueba de escalado: cada forma se compila con tamanos que se duplican y la
+// razon de tiempos entre pasos consecutivos debe mantenerse cerca de 2.
+static bool pruebaEscalado() {
+    vector<FormaEscalado> formas = {
+        {"texto_simple", [](size_t bytes) {
+            string cuerpo;
+            for (size_t i = 0; cuerpo.size() < bytes; i++) {
+                cuerpo += "parrafo palabra" + to_string(i) + " un parrafo mas;\n";
+            }
+            return "documento_inicio;\n" + cuerpo + "documento_fin;\n";
+        }},
+        {"identificadores", [](size_t bytes) {
+            string cuerpo = "lista_simple;\n";
+            for (size_t i = 0; cuerpo.size() < bytes; i++) {
+                cuerpo += "elemento id" + to_string(i) + ";\n";
+            }
+            return "documento_inicio;\n" + cuerpo + "fin_lista;\ndocumento_fin;\n";
+        }},
+        {"cadenas", [](size_t bytes) {
+            return documentoDe("parrafo(\"texto con \\\"escapes\\\" y \\n saltos\");\n", bytes);
+        }},
+        {"cadena_larga", [](size_t bytes) {
+            return "documento_inicio;\nparrafo(\"" + string(bytes, 'a') + "\");\ndocumento_fin;\n";
+        }},
+        {"linea_larga", [](size_t bytes) {
+            return "documento_inicio;\nparrafo " + repetirHasta("palabra parrafo otra ", bytes) +
+                   ";\ndocumento_fin;\n";
+        }},
+        {"simbolos", [](size_t bytes) {
+            return documentoDe("(){}[]=,;$&\n", bytes);
+        }},
+        // m7 son 10^7 sentencias: la expansion tiene que fallar al pasar de
+        // SENTENCIAS_MAXIMAS_EXPANSION, y los demas usos, salir de la memoria
+        {"macros_anidadas", [](size_t bytes) {
+            string cuerpo = "definir(\"m1\", \"" + repetirHasta("parrafo diez veces; ", 200) + "\");\n";
+            for (int nivel = 2; nivel <= 7; nivel++) {
+                string anterior = "usar(\\\"m" + to_string(nivel - 1) + "\\\"); ";
+                cuerpo += "definir(\"m" + to_string(nivel) + "\", \"" + repetirHasta(anterior, 10 * anterior.size()) +
+                          "\");\n";
+            }
+            return "documento_inicio;\n" + cuerpo + repetirHasta("usar(\"m7\");\n", bytes) + "documento_fin;\n";
+        }},
+    };
+
+    const size_t tamanoInicial = 64 * 1024;
+    const int pasos = 5;
+    bool correcto = true;
+
+    for (const auto& forma : formas) {
+        cout << forma.nombre << ":\n";
+        double anterior = 0.0;
+        vector<double> razones;
+        for (int paso = 0; paso < pasos; paso++) {
+            string entrada = forma.generar(tamanoInicial << paso);
+            double ns = medirNs(entrada, 3);
+            cout << "  " << entrada.size() << " bytes  " << ns / 1e6 << " ms  "
+                 << ns / entrada.size() << " ns/byte";
+            if (anterior > 0.0) {
+                razones.push_back(ns / anterior);
+                cout << "  x" << ns / anterior;
+            }
+            cout << "\n";
+            anterior = ns;
+        }
+
+        // La mediana tolera un paso ruidoso.
+        sort(razones.begin(), razones.end());
+        double mediana = razones[razones.size() / 2];
+        if (mediana > RAZON_SUPERLINEAL) {
+            cout << "  FALLO: crecimiento superlineal (razon mediana " << mediana << ")\n";
+            correcto = false;
+        }
+    }
+
+    return correcto;
+}
+
+// ===============================
+// CONTEO DE ASIGNACIONES
+// ===============================
+//
+// Los operadores globales new y delete se reemplazan para contar las
+// asignaciones mientras 'contandoAsignaciones' esta activo. libFuzzer y los
+// sanitizadores traen sus propios operadores, por eso solo se hace en el modo
+// independiente.
+
+static atomic<bool> contandoAsignaciones{false};
+static atomic<size_t> asignaciones{0};
+static atomic<size_t> bytesAsignados{0};
+
+#if defined(__GNUC__) && !defined(__clang__)
+// El reemplazo de new con malloc y delete con free es correcto; GCC no lo
+// reconoce al expandir delete en linea.
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t bytes) {
+    if (contandoAsignaciones.load(memory_order_relaxed)) {
+        asignaciones.fetch_add(1, memory_order_relaxed);
+        bytesAsignados.fetch_add(bytes, memory_order_relaxed);
+    }
+    if (bytes == 0) bytes = 1;
+    if (void* memoria = malloc(bytes)) return memoria;
+    throw bad_alloc();
+}
+
+void* operator new[](size_t bytes) {
+    return operator new(bytes);
+}
+
+void operator delete(void* memoria) noexcept {
+    free(memoria);
+}
+
+void operator delete[](void* memoria) noexcept {
+    free(memoria);
+}
+
+void operator delete(void* memoria, size_t) noexcept {
+    free(memoria);
+}
+
+void operator delete[](void* memoria, size_t) noexcept {
+    free(memoria);
+}
+
+// Documento de referencia: todas las sentencias del lenguaje, con cadenas,
+// texto simple, identificadores y numeros en proporciones de un apunte real.
+static string documentoReferencia() {
+    string cuerpo = "documento_inicio();\ntitulo(\"Apuntes de referencia\");\nautor(\"Catedra\");\n"
+                    "configurar(\"clase\", \"article\");\nindice();\n";
+    for (int i = 0; cuerpo.size() < 256 * 1024; i++) {
+        string n = to_string(i);
+        cuerpo += "seccion(\"Tema " + n + "\");\n";
+        cuerpo += "etiqueta(\"tema" + n + "\");\n";
+        cuerpo += "parrafo(\"Este parrafo explica el tema " + n +
+                  " con una frase bastante mas larga que un bufer corto de cadena.\");\n";
+        cuerpo += "parrafo Texto sin comillas del tema " + n + " que sigue hasta el punto y coma;\n";
+        cuerpo += "negrita(\"importante\");\ncursiva cursiva corta;\n";
+        cuerpo += "lista_numerada();\nelemento(\"primero\");\nelemento segundo punto de la lista;\nfin_lista();\n";
+        cuerpo += "ecuacion(\"\\\\sum_{k=1}^{" + n + "} k = \\\\frac{n(n+1)}{2}\");\n";
+        cuerpo += "formula(\"a^2 + b^2 = c^2\");\n";
+        cuerpo += "figura(\"imagenes/grafico" + n + ".png\", \"Resultado " + n + "\");\n";
+        cuerpo += "referencia(\"tema" + n + "\");\n";
+        cuerpo += "cita(\"autor" + n + ", otro\", \"p. " + n + "\");\nsalto_linea();\n";
+    }
+    return cuerpo + "bibliografia(\"referencias.bib\");\ndocumento_fin();\n";
+}
+
+// Cuenta las asignaciones de analizar el documento de referencia y falla si
+// pasan del limite por KB.
+static bool pruebaAsignaciones(double limite) {
+    string entrada = documentoReferencia();
+    ejecutarCompilador(entrada); // calentamiento: iostreams, locale
+
+    asignaciones = 0;
+    bytesAsignados = 0;
+    contandoAsignaciones = true;
+    ejecutarCompilador(entrada);
+    contandoAsignaciones = false;
+
+    double kb = entrada.size() / 1024.0;
+    double porKb = asignaciones / kb;
+    cout << "documento de referencia: " << entrada.size() << " bytes\n"
+         << "  " << asignaciones << " asignaciones (" << porKb << " por KB), "
+         << bytesAsignados / 1024 << " KB asignados (" << bytesAsignados / kb / 1024 << " KB por KB)\n";
+    if (porKb > limite) {
+        cout << "  FALLO: mas de " << limite << " asignaciones por KB\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    bool escalado = false;
+    bool contarAsignaciones = false;
+    double limiteAsignaciones = ASIGNACIONES_MAXIMAS_POR_KB;
+    long iteraciones = 0;
+    vector<string> archivos;
+
+    for (int i = 1; i < argc; i++) {
+        string argumento = argv[i];
+        if (argumento == "--escalado") {
+            escalado = true;
+        } else if (argumento == "--asignaciones") {
+            contarAsignaciones = true;
+        } else if (argumento.rfind("--asignaciones=", 0) == 0) {
+            contarAsignaciones = true;
+            limiteAsignaciones = stod(argumento.substr(15));
+        } else if (argumento.rfind("--iteraciones=", 0) == 0) {
+            iteraciones = stol(argumento.substr(14));
+        } else {
+            archivos.push_back(argumento);
+        }
+    }
+
+    bool correcto = true;
+
+    for (const auto& archivo : archivos) {
+        string entrada = leerBinario(archivo);
+        double razon = razonDuplicacion(entrada);
+        cout << archivo << ": t(2n)/t(n) = " << razon << "\n";
+        if (razon > RAZON_SUPERLINEAL) correcto = false;
+    }
+
+    mt19937 generador(12345);
+    long superlineales = 0;
+    for (long i = 0; i < iteraciones; i++) {
+        if (revisarEntrada(entradaAleatoria(generador))) superlineales++;
+    }
+    if (iteraciones > 0) {
+        cout << iteraciones << " entradas aleatorias, " << superlineales << " superlineales\n";
+        if (superlineales > 0) correcto = false;
+    }
+
+    if (escalado && !pruebaEscalado()) {
+        correcto = false;
+    }
+
+    if (contarAsignaciones && !pruebaAsignaciones(limiteAsignaciones)) {
+        correcto = false;
+    }
+
+    return correcto ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,420 @@
+#ifndef GENERADOR_LATEX_H
+#define GENERADOR_LATEX_H
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "archivo_mapeado.h"
+#include "ast.h"
+#include "emisor.h"
+#include "lector_csv.h"
+#include "referencias.h"
+
+using namespace std;
+
+// ===============================
+// GENERADOR DE LATEX
+// ===============================
+
+struct EstadisticasTablas {
+    size_t tablas = 0;
+    size_t filas = 0;
+    size_t bytes = 0;
+    double segundos = 0.0;
+};
+
+class GeneradorLatex : public Emisor {
+private:
+    ostringstream bufer;
+    ostream* salida = &bufer; // bufer, o el flujo de generar(ast, destino)
+    int nivelIndentacion;
+    EstadisticasTablas estadisticasTablas;
+    string formato;
+    bool capitulos = false; // la clase tiene \chapter (report, book)
+
+    void indentar() {
+        for (int i = 0; i < nivelIndentacion; i++) {
+            *salida << "  ";
+        }
+    }
+
+    void generarNodo(NodoAST* nodo) {
+        if (auto seccion = dynamic_cast<NodoSeccion*>(nodo)) {
+            generarSeccion(seccion);
+        } else if (auto texto = dynamic_cast<NodoTexto*>(nodo)) {
+            generarTexto(texto);
+        } else if (auto lista = dynamic_cast<NodoLista*>(nodo)) {
+            generarLista(lista);
+        } else if (auto ecuacion = dynamic_cast<NodoEcuacion*>(nodo)) {
+            generarEcuacion(ecuacion);
+        } else if (auto metadatos = dynamic_cast<NodoMetadatos*>(nodo)) {
+            generarMetadatos(metadatos);
+        } else if (auto comando = dynamic_cast<NodoComando*>(nodo)) {
+            generarComando(comando);
+        } else if (auto tabla = dynamic_cast<NodoTablaCsv*>(nodo)) {
+            generarTablaCsv(tabla);
+        } else if (auto figura = dynamic_cast<NodoFigura*>(nodo)) {
+            generarFigura(figura);
+        } else if (auto referencia = dynamic_cast<NodoReferencia*>(nodo)) {
+            generarReferencia(referencia);
+        } else if (auto indice = dynamic_cast<NodoIndice*>(nodo)) {
+            generarIndice(indice);
+        } else if (auto cita = dynamic_cast<NodoCita*>(nodo)) {
+            generarCita(cita);
+        } else if (auto bibliografia = dynamic_cast<NodoBibliografia*>(nodo)) {
+            generarBibliografia(bibliografia);
+        }
+    }
+
+    static const char* comandoSeccion(const string& nivel) {
+        if (nivel == "capitulo") return "chapter";
+        if (nivel == "subseccion") return "subsection";
+        if (nivel == "subsubseccion") return "subsubsection";
+        return "section";
+    }
+
+    void generarSeccion(NodoSeccion* nodo) {
+        *salida << "\\" << comandoSeccion(nodo->nivel) << "{" << nodo->titulo << "}\n";
+        *salida << "\n";
+    }
+
+    void generarTexto(NodoTexto* nodo) {
+        if (nodo->estilo == "negrita") {
+            *salida << "\\textbf{" << nodo->contenido << "}";
+        } else if (nodo->estilo == "cursiva") {
+            *salida << "\\textit{" << nodo->contenido << "}";
+        } else if (nodo->estilo == "subrayado") {
+            *salida << "\\underline{" << nodo->contenido << "}";
+        } else if (nodo->estilo == "tachado") {
+            *salida << "\\sout{" << nodo->contenido << "}";
+        } else {
+            *salida << nodo->contenido;
+        }
+        *salida << "\n\n";
+    }
+
+    void generarLista(NodoLista* nodo) {
+        if (nodo->tipo == "simple") {
+            *salida << "\\begin{itemize}\n";
+        } else {
+            *salida << "\\begin{enumerate}\n";
+        }
+
+        nivelIndentacion++;
+        for (auto& elemento : nodo->elementos) {
+            indentar();
+            if (auto textoElemento = dynamic_cast<NodoTexto*>(elemento.get())) {
+                *salida << "\\item " << textoElemento->contenido << "\n";
+            }
+        }
+        nivelIndentacion--;
+
+        if (nodo->tipo == "simple") {
+            *salida << "\\end{itemize}\n";
+        } else {
+            *salida << "\\end{enumerate}\n";
+        }
+        *salida << "\n";
+    }
+
+    void generarEcuacion(NodoEcuacion* nodo) {
+        if (nodo->tipo == "ecuacion") {
+            *salida << "\\begin{equation}\n";
+            *salida << nodo->contenido << "\n";
+            *salida << "\\end{equation}\n";
+        } else {
+            *salida << "$" << nodo->contenido << "$";
+        }
+        *salida << "\n\n";
+    }
+
+    static void agregarFila(string& bloque, const vector<string>& celdas, size_t numeroCeldas,
+                            size_t columnas) {
+        for (size_t i = 0; i < columnas; i++) {
+            if (i > 0) bloque += " & ";
+            if (i < numeroCeldas) escaparLatex(celdas[i], bloque);
+        }
+        bloque += " \\\\\n";
+    }
+
+    // La tabla nunca se carga en el AST: el CSV se recorre fila a fila sobre
+    // el archivo mapeado y se emite como longtable por bloques.
+    void generarTablaCsv(NodoTablaCsv* nodo) {
+        auto inicio = chrono::steady_clock::now();
+
+        OpcionesTablaCsv opciones = leerOpcionesTablaCsv(nodo->opciones);
+
+        string ruta = resolverRuta(nodo->ruta);
+        ArchivoMapeado archivo(ruta);
+        LectorCsv lector(archivo.contenido(), opciones.separador);
+
+        vector<string> celdas;
+        size_t numeroCeldas = 0;
+        bool hayFila = lector.siguienteFila(celdas, numeroCeldas);
+        while (hayFila && numeroCeldas == 1 && celdas[0].empty()) {
+            hayFila = lector.siguienteFila(celdas, numeroCeldas);
+        }
+        if (!hayFila) {
+            *salida << "% tabla_csv vacia: " << nodo->ruta << "\n\n";
+            return;
+        }
+
+        size_t columnas = numeroCeldas;
+        string especificacion = opciones.columnas;
+        if (especificacion.empty()) {
+            especificacion = "|";
+            for (size_t i = 0; i < columnas; i++) especificacion += "l|";
+        }
+
+        *salida << "\\begin{longtable}{" << especificacion << "}\n";
+        *salida << "\\hline\n";
+
+        string bloque;
+        bloque.reserve(BYTES_BLOQUE_TABLA + 1024);
+        size_t filas = 0;
+
+        // Con encabezado, la primera fila se repite en cada pagina
+        agregarFila(bloque, celdas, numeroCeldas, columnas);
+        if (opciones.encabezado) {
+            bloque += "\\hline\n\\endhead\n";
+        } else {
+            filas++;
+        }
+
+        while (lector.siguienteFila(celdas, numeroCeldas)) {
+            if (numeroCeldas == 1 && celdas[0].empty()) continue;
+            agregarFila(bloque, celdas, numeroCeldas, columnas);
+            filas++;
+            if (bloque.size() >= BYTES_BLOQUE_TABLA) {
+                *salida << bloque;
+                bloque.clear();
+            }
+        }
+
+        *salida << bloque;
+        *salida << "\\hline\n";
+        *salida << "\\end{longtable}\n\n";
+
+        estadisticasTablas.tablas++;
+        estadisticasTablas.filas += filas;
+        estadisticasTablas.bytes += lector.bytesLeidos();
+        estadisticasTablas.segundos +=
+            chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    }
+
+    void generarFigura(NodoFigura* nodo) {
+        const string& ruta = rutaFigura(nodo);
+
+        *salida << "\\begin{figure}[htbp]\n";
+        *salida << "\\centering\n";
+        *salida << "\\includegraphics[width=0.8\\textwidth]{" << ruta << "}\n";
+        if (!nodo->leyenda.empty()) {
+            *salida << "\\caption{" << nodo->leyenda << "}\n";
+        }
+        *salida << "\\end{figure}\n\n";
+    }
+
+    // Las referencias ya vienen resueltas: se escribe el numero literal en
+    // lugar de \\ref, que necesitaria una segunda pasada de pdflatex.
+    void generarReferencia(NodoReferencia* nodo) {
+        *salida << (nodo->numero.empty() ? "??" : nodo->numero) << "\n";
+    }
+
+    // Como las referencias: los numeros de cita ya vienen resueltos, sin
+    // \\cite ni BibTeX.
+    void generarCita(NodoCita* nodo) {
+        *salida << "[" << (nodo->numero.empty() ? "?" : nodo->numero);
+        if (!nodo->nota.empty()) *salida << ", " << nodo->nota;
+        *salida << "]\n";
+    }
+
+    // Entradas ya formateadas, en orden de cita. \\bibitem sin etiqueta
+    // numera igual que el compilador.
+    void generarBibliografia(NodoBibliografia* nodo) {
+        if (nodo->entradas.empty()) return;
+
+        *salida << "\\begin{thebibliography}{" << string(to_string(nodo->entradas.size()).size(), '9') << "}\n";
+        for (const auto& entrada : nodo->entradas) {
+            *salida << "\\bibitem{" << entrada.clave << "} " << entrada.antes;
+            if (!entrada.enfasis.empty()) *salida << "\\emph{" << entrada.enfasis << "}";
+            *salida << entrada.despues << "\n";
+        }
+        *salida << "\\end{thebibliography}\n\n";
+    }
+
+    // Indice prearmado a partir de las secciones del AST (sin numeros de
+    // pagina, que solo conoce TeX tras componer el documento).
+    void generarIndice(NodoIndice* nodo) {
+        if (nodo->entradas.empty()) return;
+
+        int base = 3;
+        for (const auto& entrada : nodo->entradas) {
+            base = min(base, nivelSeccion(entrada.nivel));
+        }
+
+        *salida << (capitulos ? "\\chapter*{\\contentsname}\n" : "\\section*{\\contentsname}\n");
+        *salida << "\\begin{flushleft}\n";
+        for (size_t i = 0; i < nodo->entradas.size(); i++) {
+            const EntradaIndice& entrada = nodo->entradas[i];
+            int sangria = nivelSeccion(entrada.nivel) - base;
+            if (sangria > 0) {
+                *salida << "\\hspace*{" << (sangria * 1.5) << "em}";
+            }
+            *salida << entrada.numero << "\\quad " << entrada.titulo;
+            *salida << (i + 1 < nodo->entradas.size() ? "\\\\\n" : "\n");
+        }
+        *salida << "\\end{flushleft}\n\n";
+    }
+
+    void generarMetadatos(NodoMetadatos* nodo) {
+        if (nodo->tipo == "titulo") {
+            *salida << "\\title{" << nodo->contenido << "}\n";
+        } else if (nodo->tipo == "autor") {
+            *salida << "\\author{" << nodo->contenido << "}\n";
+        } else if (nodo->tipo == "fecha") {
+            *salida << "\\date{" << nodo->contenido << "}\n";
+        }
+    }
+
+    void generarComando(NodoComando* nodo) {
+        if (nodo->comando == "nueva_linea") {
+            *salida << "\\\\\n";
+        } else if (nodo->comando == "salto_pagina") {
+            *salida << "\\pagebreak\n";
+        } else if (nodo->comando == "nueva_pagina") {
+            *salida << "\\newpage\n";
+        } else if (nodo->comando == "inicio_documento") {
+            *salida << "\\begin{document}\n";
+            *salida << "\\maketitle\n\n";
+        } else if (nodo->comando == "fin_documento") {
+            *salida << "\\end{document}\n";
+        } else if (nodo->comando == "fin_lista") {
+            // Ya manejado en generarLista
+        }
+    }
+
+public:
+    GeneradorLatex(const string& base = "") : Emisor(base), nivelIndentacion(0) {}
+
+    const char* nombre() const override {
+        return "latex";
+    }
+
+    const char* extension() const override {
+        return ".tex";
+    }
+
+    string emitir(NodoDocumento* ast) override {
+        return generar(ast);
+    }
+
+    const EstadisticasTablas& getEstadisticasTablas() const {
+        return estadisticasTablas;
+    }
+
+    // Clase y paquetes del documento: todo lo que cabe en un formato
+    // precompilado. Los metadatos (\title...) van despues y no forman parte.
+    // configurar(idioma/codificacion) ya esta cubierto por los paquetes fijos;
+    // configurar(tipo_documento) cambia la clase (ver claseDocumento).
+    static string preambulo(NodoDocumento* ast) {
+        string clase = claseDocumento(ast);
+        bool hayTablas = false;
+        bool hayFiguras = false;
+        for (auto& hijo : ast->hijos) {
+            hayTablas = hayTablas || dynamic_cast<NodoTablaCsv*>(hijo.get()) != nullptr;
+            hayFiguras = hayFiguras || dynamic_cast<NodoFigura*>(hijo.get()) != nullptr;
+        }
+
+        string texto = "\\documentclass{" + clase + "}\n";
+        texto += "\\usepackage[utf8]{inputenc}\n";
+        texto += "\\usepackage[spanish]{babel}\n";
+        texto += "\\usepackage{amsmath}\n";
+        texto += "\\usepackage{amssymb}\n";
+        texto += "\\usepackage{ulem}\n";
+        if (hayTablas) texto += "\\usepackage{longtable}\n";
+        if (hayFiguras) texto += "\\usepackage{graphicx}\n";
+        return texto;
+    }
+
+    // Nombre del formato precompilado con el que se procesa el documento; se
+    // escribe como linea %& al comienzo. Vacio: sin formato.
+    void setFormato(const string& nombre) {
+        formato = nombre;
+    }
+
+    // Solo las sentencias dadas, en orden y sin preambulo: la vista previa
+    // del editor interactivo.
+    string generarFragmento(NodoDocumento* ast) {
+        bufer.str("");
+        bufer.clear();
+        salida = &bufer;
+        for (auto& hijo : ast->hijos) {
+            if (auto configuracion = dynamic_cast<NodoConfiguracion*>(hijo.get())) {
+                *salida << "% configurar " << configuracion->clave << " = " << configuracion->valor << "\n";
+            } else if (auto definicion = dynamic_cast<NodoDefinicion*>(hijo.get())) {
+                *salida << "% definir " << definicion->nombre << "\n";
+            } else if (auto uso = dynamic_cast<NodoUso*>(hijo.get())) {
+                *salida << "% usar " << uso->nombre << " (se expande al compilar)\n";
+            } else {
+                generarNodo(hijo.get());
+            }
+        }
+        return bufer.str();
+    }
+
+    string generar(NodoDocumento* ast) {
+        bufer.str("");
+        bufer.clear();
+        generar(ast, bufer);
+
+        // El bufer se descarta para no tener el documento dos veces en memoria
+        string resultado = bufer.str();
+        ostringstream().swap(bufer);
+        return resultado;
+    }
+
+    // Escribe el documento directamente en 'destino' (p. ej. un archivo) sin
+    // acumularlo en memoria; las tablas se escriben por bloques.
+    void generar(NodoDocumento* ast, ostream& destino) {
+        salida = &destino;
+        capitulos = numeracionDeClase(claseDocumento(ast)).capitulos;
+
+        if (!formato.empty()) {
+            *salida << "%&" << formato << "\n";
+        }
+        *salida << preambulo(ast);
+        if (!formato.empty()) {
+            // Con el formato precompilado (mylatexformat) TeX salta el preambulo
+            // hasta aqui; sin el, \csname de un comando inexistente es \relax
+            *salida << "\\csname endofdump\\endcsname\n";
+        }
+        *salida << "\n";
+
+        // Primero los metadatos
+        bool tieneTitulo = false;
+        for (auto& hijo : ast->hijos) {
+            if (auto metadatos = dynamic_cast<NodoMetadatos*>(hijo.get())) {
+                generarNodo(metadatos);
+                if (metadatos->tipo == "titulo") tieneTitulo = true;
+            }
+        }
+
+        // Luego el contenido del documento
+        for (auto& hijo : ast->hijos) {
+            if (!dynamic_cast<NodoConfiguracion*>(hijo.get()) &&
+                !dynamic_cast<NodoMetadatos*>(hijo.get())) {
+                generarNodo(hijo.get());
+            }
+        }
+
+        salida = &bufer;
+    }
+};
+
+#endif
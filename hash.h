@@ -0,0 +1,121 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// ===============================
+// HASH DE CONTENIDO (XXH64)
+// ===============================
+//
+// Implementacion directa de XXH64: procesa 32 bytes por iteracion y es
+// varias veces mas rapida que FNV sobre archivos grandes. Se usa para
+// identificar contenido (activos, preambulos, caches), no para seguridad.
+
+namespace detalle_hash {
+
+const uint64_t PRIMO1 = 11400714785074694791ULL;
+const uint64_t PRIMO2 = 14029467366897019727ULL;
+const uint64_t PRIMO3 = 1609587929392839161ULL;
+const uint64_t PRIMO4 = 9650029242287828579ULL;
+const uint64_t PRIMO5 = 2870177450012600261ULL;
+
+inline uint64_t rotar(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t leer64(const char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t leer32(const char* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t ronda(uint64_t acumulador, uint64_t entrada) {
+    acumulador += entrada * PRIMO2;
+    acumulador = rotar(acumulador, 31);
+    return acumulador * PRIMO1;
+}
+
+inline uint64_t mezclar(uint64_t acumulador, uint64_t valor) {
+    acumulador ^= ronda(0, valor);
+    return acumulador * PRIMO1 + PRIMO4;
+}
+
+}
+
+inline uint64_t hashContenido(string_view datos, uint64_t semilla = 0) {
+    using namespace detalle_hash;
+
+    const char* p = datos.data();
+    const char* fin = p + datos.size();
+    uint64_t h;
+
+    if (datos.size() >= 32) {
+        uint64_t v1 = semilla + PRIMO1 + PRIMO2;
+        uint64_t v2 = semilla + PRIMO2;
+        uint64_t v3 = semilla;
+        uint64_t v4 = semilla - PRIMO1;
+        const char* limite = fin - 32;
+        do {
+            v1 = ronda(v1, leer64(p)); p += 8;
+            v2 = ronda(v2, leer64(p)); p += 8;
+            v3 = ronda(v3, leer64(p)); p += 8;
+            v4 = ronda(v4, leer64(p)); p += 8;
+        } while (p <= limite);
+
+        h = rotar(v1, 1) + rotar(v2, 7) + rotar(v3, 12) + rotar(v4, 18);
+        h = mezclar(h, v1);
+        h = mezclar(h, v2);
+        h = mezclar(h, v3);
+        h = mezclar(h, v4);
+    } else {
+        h = semilla + PRIMO5;
+    }
+
+    h += static_cast<uint64_t>(datos.size());
+
+    while (p + 8 <= fin) {
+        h ^= ronda(0, leer64(p));
+        h = rotar(h, 27) * PRIMO1 + PRIMO4;
+        p += 8;
+    }
+    if (p + 4 <= fin) {
+        h ^= static_cast<uint64_t>(leer32(p)) * PRIMO1;
+        h = rotar(h, 23) * PRIMO2 + PRIMO3;
+        p += 4;
+    }
+    while (p < fin) {
+        h ^= static_cast<uint64_t>(static_cast<unsigned char>(*p)) * PRIMO5;
+        h = rotar(h, 11) * PRIMO1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= PRIMO2;
+    h ^= h >> 29;
+    h *= PRIMO3;
+    h ^= h >> 32;
+    return h;
+}
+
+inline string hashHex(uint64_t h) {
+    static const char digitos[] = "0123456789abcdef";
+    string hex(16, '0');
+    for (int i = 15; i >= 0; i--) {
+        hex[i] = digitos[h & 0xF];
+        h >>= 4;
+    }
+    return hex;
+}
+
+#endif
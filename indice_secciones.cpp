@@ -0,0 +1,457 @@
+#include "indice_secciones.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "archivo_mapeado.h"
+#include "token.h"
+#include "utf8.h"
+
+using namespace std;
+
+namespace {
+
+int64_t fechaArchivo(const string& ruta) {
+    error_code error;
+    auto fecha = filesystem::last_write_time(ruta, error);
+    return error ? 0 : static_cast<int64_t>(fecha.time_since_epoch().count());
+}
+
+// ===============================
+// RECORRIDO DEL .texes
+// ===============================
+
+// Lo mismo que el analizador lexico considera letra de una palabra, sin
+// suponer que el texto ya es UTF-8 valido.
+size_t longitudCaracterPalabra(string_view texto, size_t i) {
+    if (i >= texto.size()) return 0;
+    unsigned char c = static_cast<unsigned char>(texto[i]);
+    if (c < 0x80) return isalnum(c) || c == '_' ? 1 : 0;
+    size_t longitud = detalle_utf8::longitudSecuencia(texto, i);
+    if (longitud == 0) return 0;
+    size_t decodificados;
+    return esLetraUtf8(decodificarUtf8(texto, i, decodificados)) ? longitud : 0;
+}
+
+bool iniciaPalabra(string_view texto, size_t i) {
+    if (i >= texto.size()) return false;
+    unsigned char c = static_cast<unsigned char>(texto[i]);
+    if (c < 0x80) return isalpha(c) || c == '_';
+    return longitudCaracterPalabra(texto, i) > 0;
+}
+
+size_t finPalabra(string_view texto, size_t i) {
+    while (size_t longitud = longitudCaracterPalabra(texto, i)) {
+        i += longitud;
+    }
+    return i;
+}
+
+size_t saltarBlancos(string_view texto, size_t i) {
+    while (i < texto.size() && (texto[i] == ' ' || texto[i] == '\t' || texto[i] == '\r')) i++;
+    return i;
+}
+
+// Palabra clave de la palabra (con tildes o mayusculas); false si no es.
+bool buscarPalabraClave(string_view palabra, string& plegada, TipoToken& tipo) {
+    plegarPalabra(palabra, plegada);
+    for (const PalabraReservada& reservada : PALABRAS_RESERVADAS) {
+        if (plegada == reservada.lexema) {
+            tipo = reservada.tipo;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool aceptaTextoSimple(TipoToken tipo) {
+    return tipo == TipoToken::PARRAFO || tipo == TipoToken::NEGRITA || tipo == TipoToken::CURSIVA ||
+           tipo == TipoToken::SUBRAYADO || tipo == TipoToken::TACHADO || tipo == TipoToken::ELEMENTO;
+}
+
+// Desde la comilla inicial hasta despues de la final. Con 'valor', deja la
+// cadena sin escapes, como leerCadena().
+size_t finCadena(string_view texto, size_t i, string* valor) {
+    i++;
+    while (i < texto.size() && texto[i] != '"') {
+        if (texto[i] == '\\' && i + 1 < texto.size()) {
+            if (valor != nullptr) {
+                switch (texto[i + 1]) {
+                    case 'n': *valor += '\n'; break;
+                    case 't': *valor += '\t'; break;
+                    case '"': *valor += '"'; break;
+                    case '\\': *valor += '\\'; break;
+                    default: *valor += '\\'; *valor += texto[i + 1]; break;
+                }
+            }
+            i += 2;
+        } else {
+            if (valor != nullptr) *valor += texto[i];
+            i++;
+        }
+    }
+    return min(i + 1, texto.size());
+}
+
+// Desde '(' hasta despues del ')' que lo cierra. Un ';' fuera de las
+// cadenas termina la sentencia aunque falte el ')'. 'titulo' recibe la
+// primera cadena.
+size_t finArgumentos(string_view texto, size_t i, string* titulo) {
+    int profundidad = 0;
+    bool hayTitulo = false;
+    while (i < texto.size()) {
+        char c = texto[i];
+        if (c == '"') {
+            i = finCadena(texto, i, hayTitulo ? nullptr : titulo);
+            hayTitulo = true;
+        } else if (c == '%') {
+            while (i < texto.size() && texto[i] != '\n') i++;
+        } else if (c == ';') {
+            return i;
+        } else {
+            if (c == '(') profundidad++;
+            i++;
+            if (c == ')' && --profundidad == 0) return i;
+        }
+    }
+    return i;
+}
+
+// Texto sin comillas tras parrafo, negrita...: hasta ';', fin de linea o una
+// palabra clave que empieza otra sentencia, como leerTextoSimple().
+size_t finTextoSimple(string_view texto, size_t i, string& plegada) {
+    while (i < texto.size() && texto[i] != ';' && texto[i] != '\n') {
+        if (iniciaPalabra(texto, i)) {
+            size_t fin = finPalabra(texto, i);
+            TipoToken tipo;
+            size_t siguiente = saltarBlancos(texto, fin);
+            if (buscarPalabraClave(texto.substr(i, fin - i), plegada, tipo) && siguiente < texto.size() &&
+                (texto[siguiente] == '(' || texto[siguiente] == ';')) {
+                return i;
+            }
+            i = fin;
+        } else {
+            size_t longitud = 1;
+            if (static_cast<unsigned char>(texto[i]) >= 0x80) {
+                longitud = max<size_t>(1, detalle_utf8::longitudSecuencia(texto, i));
+            }
+            i += longitud;
+        }
+    }
+    return i;
+}
+
+bool tipoIndice(TipoToken tipo, TipoSentenciaIndice& destino) {
+    switch (tipo) {
+        case TipoToken::DOCUMENTO_INICIO: destino = SENTENCIA_INICIO; return true;
+        case TipoToken::DOCUMENTO_FIN: destino = SENTENCIA_FIN; return true;
+        case TipoToken::CAPITULO: destino = SENTENCIA_CAPITULO; return true;
+        case TipoToken::SECCION: destino = SENTENCIA_SECCION; return true;
+        case TipoToken::CONFIGURAR:
+        case TipoToken::TITULO:
+        case TipoToken::AUTOR:
+        case TipoToken::FECHA:
+        case TipoToken::DEFINIR: destino = SENTENCIA_CABECERA; return true;
+        case TipoToken::BIBLIOGRAFIA: destino = SENTENCIA_BIBLIOGRAFIA; return true;
+        default: return false;
+    }
+}
+
+vector<SentenciaIndice> recorrerTexes(string_view texto) {
+    vector<SentenciaIndice> sentencias;
+    string plegada;
+    size_t i = texto.compare(0, 3, "\xEF\xBB\xBF") == 0 ? 3 : 0;
+    size_t linea = 1;
+    auto avanzarHasta = [&](size_t fin) {
+        linea += static_cast<size_t>(count(texto.begin() + i, texto.begin() + fin, '\n'));
+        i = fin;
+    };
+
+    while (i < texto.size()) {
+        char c = texto[i];
+        if (c == '"') {
+            avanzarHasta(finCadena(texto, i, nullptr));
+        } else if (c == '%') {
+            size_t fin = texto.find('\n', i);
+            avanzarHasta(fin == string_view::npos ? texto.size() : fin);
+        } else if (iniciaPalabra(texto, i)) {
+            size_t inicio = i;
+            size_t finClave = finPalabra(texto, i);
+            TipoToken tipo = TipoToken::IDENTIFICADOR;
+            bool esClave = buscarPalabraClave(texto.substr(i, finClave - i), plegada, tipo);
+
+            // Solo es una sentencia si sigue '(' o ';' (como en iniciaSentencia):
+            // "titulo" dentro de un texto suelto no lo es
+            string titulo;
+            size_t fin = saltarBlancos(texto, finClave);
+            bool esSentencia = fin < texto.size() && (texto[fin] == '(' || texto[fin] == ';');
+            if (fin < texto.size() && texto[fin] == '(') {
+                bool conTitulo = tipo == TipoToken::SECCION || tipo == TipoToken::CAPITULO;
+                fin = finArgumentos(texto, fin, conTitulo ? &titulo : nullptr);
+            } else if (esClave && aceptaTextoSimple(tipo) && fin < texto.size() && texto[fin] != ';' &&
+                       texto[fin] != '\n') {
+                fin = finTextoSimple(texto, fin, plegada);
+            } else if (fin >= texto.size() || texto[fin] != ';') {
+                fin = finClave;
+            }
+            size_t punto = saltarBlancos(texto, fin);
+            if (punto < texto.size() && texto[punto] == ';') fin = punto + 1;
+
+            TipoSentenciaIndice tipoSentencia;
+            if (esClave && esSentencia && tipoIndice(tipo, tipoSentencia)) {
+                sentencias.push_back(SentenciaIndice{tipoSentencia, inicio,
+                                                     static_cast<uint32_t>(min<size_t>(fin - inicio, UINT32_MAX)),
+                                                     static_cast<uint32_t>(min<size_t>(linea, UINT32_MAX)),
+                                                     move(titulo)});
+            }
+            avanzarHasta(fin);
+        } else {
+            avanzarHasta(i + 1);
+        }
+    }
+    return sentencias;
+}
+
+bool igualesSinTildes(const string& a, const string& b) {
+    if (validarUtf8(a).invalido != string_view::npos || validarUtf8(b).invalido != string_view::npos) {
+        return false;
+    }
+    return plegarPalabra(a) == plegarPalabra(b);
+}
+
+string leerTramo(ifstream& archivo, const SentenciaIndice& desde, uint64_t hasta, const string& ruta) {
+    string tramo(static_cast<size_t>(hasta - desde.desplazamiento), '\0');
+    archivo.seekg(static_cast<streamoff>(desde.desplazamiento));
+    archivo.read(&tramo[0], static_cast<streamsize>(tramo.size()));
+    if (!archivo) {
+        throw runtime_error("No se pudo leer el archivo: " + ruta);
+    }
+    return tramo;
+}
+
+} // namespace
+
+string nombreIndiceSecciones(const string& rutaTexes) {
+    return rutaTexes + ".idx";
+}
+
+string nombreArchivoSeccion(const string& archivoEntrada) {
+    return archivoEntrada.substr(0, archivoEntrada.find(".texes")) + ".seccion.tex";
+}
+
+// ===============================
+// INDICE EN DISCO
+// ===============================
+
+IndiceSecciones::IndiceSecciones(const string& rutaTexes) : ruta(rutaTexes) {
+    // Como en bibliografia.cpp: la fecha se toma antes de leer
+    int64_t fecha = fechaArchivo(ruta);
+    error_code error;
+    uintmax_t tamano = filesystem::file_size(ruta, error);
+    if (error) {
+        throw runtime_error("No se pudo abrir el archivo: " + ruta);
+    }
+    if (!cargar(tamano, fecha)) {
+        reconstruir(tamano, fecha);
+    }
+}
+
+bool IndiceSecciones::cargar(uint64_t tamano, int64_t fecha) {
+    string rutaIndice = nombreIndiceSecciones(ruta);
+    error_code error;
+    if (!filesystem::exists(rutaIndice, error)) return false;
+    unique_ptr<ArchivoMapeado> archivo;
+    try {
+        archivo = make_unique<ArchivoMapeado>(rutaIndice);
+    } catch (const runtime_error&) {
+        return false;
+    }
+
+    string_view datos = archivo->contenido();
+    if (datos.size() < sizeof(CabeceraIndiceSecciones)) return false;
+    CabeceraIndiceSecciones cabecera;
+    memcpy(&cabecera, datos.data(), sizeof(cabecera));
+    if (memcmp(cabecera.magia, "LATEXSEC", 8) != 0 || cabecera.version != VERSION_INDICE_SECCIONES ||
+        cabecera.ordenBytes != ORDEN_BYTES_INDICE_SECCIONES || cabecera.tamanoTexes != tamano ||
+        cabecera.fechaTexes != fecha) {
+        return false;
+    }
+    uint64_t numero = cabecera.numeroSentencias;
+    size_t disponibles = datos.size() - sizeof(CabeceraIndiceSecciones);
+    if (numero > disponibles / sizeof(RegistroIndiceSecciones) ||
+        cabecera.bytesTitulos != disponibles - numero * sizeof(RegistroIndiceSecciones)) {
+        return false;
+    }
+
+    const char* registros = datos.data() + sizeof(CabeceraIndiceSecciones);
+    string_view titulos = datos.substr(sizeof(CabeceraIndiceSecciones) + numero * sizeof(RegistroIndiceSecciones));
+    vector<SentenciaIndice> leidas;
+    leidas.reserve(static_cast<size_t>(numero));
+    for (uint64_t i = 0; i < numero; i++) {
+        RegistroIndiceSecciones registro;
+        memcpy(&registro, registros + i * sizeof(RegistroIndiceSecciones), sizeof(registro));
+        if (registro.tipo > SENTENCIA_BIBLIOGRAFIA || registro.desplazamiento + registro.longitud > tamano ||
+            static_cast<uint64_t>(registro.titulo) + registro.longitudTitulo > titulos.size()) {
+            return false;
+        }
+        leidas.push_back(SentenciaIndice{static_cast<TipoSentenciaIndice>(registro.tipo), registro.desplazamiento,
+                                         registro.longitud, registro.linea,
+                                         string(titulos.substr(registro.titulo, registro.longitudTitulo))});
+    }
+    sentencias = move(leidas);
+    return true;
+}
+
+void IndiceSecciones::reconstruir(uint64_t tamano, int64_t fecha) {
+    reconstruido = true;
+    {
+        ArchivoMapeado texes(ruta);
+        sentencias = recorrerTexes(texes.contenido());
+    }
+
+    vector<RegistroIndiceSecciones> registros;
+    string titulos;
+    for (const auto& sentencia : sentencias) {
+        RegistroIndiceSecciones registro;
+        memset(&registro, 0, sizeof(registro));
+        registro.desplazamiento = sentencia.desplazamiento;
+        registro.longitud = sentencia.longitud;
+        registro.linea = sentencia.linea;
+        registro.tipo = sentencia.tipo;
+        registro.titulo = static_cast<uint32_t>(titulos.size());
+        registro.longitudTitulo = static_cast<uint32_t>(sentencia.titulo.size());
+        titulos += sentencia.titulo;
+        registros.push_back(registro);
+    }
+    if (titulos.size() > UINT32_MAX) return;
+
+    CabeceraIndiceSecciones cabecera;
+    memset(&cabecera, 0, sizeof(cabecera));
+    memcpy(cabecera.magia, "LATEXSEC", 8);
+    cabecera.version = VERSION_INDICE_SECCIONES;
+    cabecera.ordenBytes = ORDEN_BYTES_INDICE_SECCIONES;
+    cabecera.tamanoTexes = tamano;
+    cabecera.fechaTexes = fecha;
+    cabecera.numeroSentencias = registros.size();
+    cabecera.bytesTitulos = titulos.size();
+
+    // Temporal y renombrado, como el indice de la bibliografia
+    string rutaIndice = nombreIndiceSecciones(ruta);
+    ostringstream temporal;
+    temporal << rutaIndice << ".tmp" << this_thread::get_id();
+    {
+        ofstream archivo(temporal.str(), ios::binary);
+        if (!archivo.is_open()) return;
+        archivo.write(reinterpret_cast<const char*>(&cabecera), sizeof(cabecera));
+        archivo.write(reinterpret_cast<const char*>(registros.data()),
+                      static_cast<streamsize>(registros.size() * sizeof(RegistroIndiceSecciones)));
+        archivo.write(titulos.data(), static_cast<streamsize>(titulos.size()));
+        archivo.close();
+        if (!archivo) {
+            error_code error;
+            filesystem::remove(temporal.str(), error);
+            return;
+        }
+    }
+    error_code error;
+    filesystem::rename(temporal.str(), rutaIndice, error);
+    if (error) filesystem::remove(temporal.str(), error);
+}
+
+// ===============================
+// DOCUMENTO REDUCIDO A UNA SECCION
+// ===============================
+
+void FragmentoSeccion::corregirLineas(vector<Diagnostico>& diagnosticos) const {
+    for (auto& diagnostico : diagnosticos) {
+        if (diagnostico.linea <= 0) continue;
+        size_t linea = static_cast<size_t>(diagnostico.linea);
+        auto tramo = upper_bound(tramos.begin(), tramos.end(), linea,
+                                 [](size_t valor, const TramoFragmento& t) { return valor < t.lineaFragmento; });
+        if (tramo == tramos.begin()) continue;
+        --tramo;
+        diagnostico.linea = static_cast<int>(tramo->lineaOriginal + (linea - tramo->lineaFragmento));
+    }
+}
+
+FragmentoSeccion extraerSeccion(const string& rutaTexes, const string& titulo) {
+    IndiceSecciones indice(rutaTexes);
+    const vector<SentenciaIndice>& sentencias = indice.getSentencias();
+
+    auto esSeccion = [](const SentenciaIndice& s) {
+        return s.tipo == SENTENCIA_SECCION || s.tipo == SENTENCIA_CAPITULO;
+    };
+    auto buscada = find_if(sentencias.begin(), sentencias.end(),
+                           [&](const SentenciaIndice& s) { return esSeccion(s) && s.titulo == titulo; });
+    if (buscada == sentencias.end()) {
+        buscada = find_if(sentencias.begin(), sentencias.end(), [&](const SentenciaIndice& s) {
+            return esSeccion(s) && igualesSinTildes(s.titulo, titulo);
+        });
+    }
+    if (buscada == sentencias.end()) {
+        string mensaje = "No hay ninguna seccion ni capitulo \"" + titulo + "\" en " + rutaTexes;
+        string disponibles;
+        for (const auto& sentencia : sentencias) {
+            if (!esSeccion(sentencia)) continue;
+            disponibles += (disponibles.empty() ? "" : ", ") + ("\"" + sentencia.titulo + "\"");
+        }
+        throw runtime_error(mensaje + (disponibles.empty() ? " (no tiene secciones)" : "; hay " + disponibles));
+    }
+
+    // Un capitulo llega hasta el siguiente capitulo; una seccion, hasta la
+    // siguiente seccion o capitulo. Los dos, como mucho hasta documento_fin.
+    bool esCapitulo = buscada->tipo == SENTENCIA_CAPITULO;
+    auto siguiente = find_if(buscada + 1, sentencias.end(), [&](const SentenciaIndice& s) {
+        return s.tipo == SENTENCIA_FIN || s.tipo == SENTENCIA_CAPITULO || (!esCapitulo && s.tipo == SENTENCIA_SECCION);
+    });
+    uint64_t finSeccion = siguiente != sentencias.end() ? siguiente->desplazamiento : UINT64_MAX;
+
+    ifstream archivo(rutaTexes, ios::binary);
+    if (!archivo.is_open()) {
+        throw runtime_error("No se pudo abrir el archivo: " + rutaTexes);
+    }
+    if (finSeccion == UINT64_MAX) {
+        archivo.seekg(0, ios::end);
+        finSeccion = static_cast<uint64_t>(archivo.tellg());
+    }
+
+    FragmentoSeccion fragmento;
+    fragmento.indiceReconstruido = indice.indiceReconstruido();
+    size_t lineaFragmento = 1;
+    auto agregar = [&](const SentenciaIndice& desde, uint64_t hasta) {
+        string tramo = leerTramo(archivo, desde, hasta, rutaTexes);
+        fragmento.tramos.push_back(TramoFragmento{lineaFragmento, desde.linea});
+        lineaFragmento += static_cast<size_t>(count(tramo.begin(), tramo.end(), '\n')) + 1;
+        fragmento.texto += tramo;
+        fragmento.texto += '\n';
+    };
+    auto dentroDeSeccion = [&](const SentenciaIndice& s) {
+        return s.desplazamiento >= buscada->desplazamiento && s.desplazamiento < finSeccion;
+    };
+
+    for (const auto& sentencia : sentencias) {
+        if (sentencia.tipo == SENTENCIA_INICIO ||
+            (sentencia.tipo == SENTENCIA_CABECERA && !dentroDeSeccion(sentencia))) {
+            agregar(sentencia, sentencia.desplazamiento + sentencia.longitud);
+        }
+    }
+    agregar(*buscada, finSeccion);
+    for (const auto& sentencia : sentencias) {
+        if (sentencia.tipo == SENTENCIA_BIBLIOGRAFIA && !dentroDeSeccion(sentencia)) {
+            agregar(sentencia, sentencia.desplazamiento + sentencia.longitud);
+        }
+    }
+    if (siguiente != sentencias.end()) {
+        auto fin = find_if(siguiente, sentencias.end(),
+                           [](const SentenciaIndice& s) { return s.tipo == SENTENCIA_FIN; });
+        if (fin != sentencias.end()) agregar(*fin, fin->desplazamiento + fin->longitud);
+    }
+    return fragmento;
+}
@@ -0,0 +1,133 @@
+#ifndef INDICE_SECCIONES_H
+#define INDICE_SECCIONES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "diagnostico.h"
+
+using namespace std;
+
+// ===============================
+// INDICE DE SECCIONES (--solo-seccion)
+// ===============================
+//
+// Para ver una seccion de un documento largo no hace falta analizar el
+// documento entero. Junto al .texes se guarda un indice ("doc.texes.idx")
+// con la posicion en bytes y la linea de cada seccion() y capitulo(), de
+// las sentencias de cabecera (configurar, titulo, autor, fecha, definir),
+// de bibliografia() y de documento_inicio/documento_fin. Con el se leen del
+// archivo solo esos tramos: la cabecera, la seccion pedida (hasta la
+// siguiente seccion o capitulo) y la bibliografia. Asi la vista previa
+// cuesta lo mismo aunque el documento crezca.
+//
+// El indice se arma con una pasada que reconoce lo justo del lexico
+// (cadenas, comentarios, parentesis, texto sin comillas y palabras clave con
+// tildes o mayusculas) y se reconstruye solo cuando cambian el tamano o la
+// fecha del .texes; si el directorio no admite escritura, se arma en memoria.
+//
+//   CabeceraIndiceSecciones
+//   RegistroIndiceSecciones[numeroSentencias]
+//   titulos (UTF-8, sin terminador)
+
+const uint32_t VERSION_INDICE_SECCIONES = 1;
+const uint32_t ORDEN_BYTES_INDICE_SECCIONES = 0x01020304;
+
+enum TipoSentenciaIndice : uint32_t {
+    SENTENCIA_INICIO,       // documento_inicio
+    SENTENCIA_FIN,          // documento_fin
+    SENTENCIA_CAPITULO,
+    SENTENCIA_SECCION,
+    SENTENCIA_CABECERA,     // configurar, titulo, autor, fecha, definir
+    SENTENCIA_BIBLIOGRAFIA
+};
+
+struct CabeceraIndiceSecciones {
+    char magia[8];           // "LATEXSEC"
+    uint32_t version;
+    uint32_t ordenBytes;
+    uint64_t tamanoTexes;
+    int64_t fechaTexes;      // last_write_time del .texes
+    uint64_t numeroSentencias;
+    uint64_t bytesTitulos;
+};
+
+struct RegistroIndiceSecciones {
+    uint64_t desplazamiento; // de la palabra clave dentro del .texes
+    uint32_t longitud;       // hasta el ';' que cierra la sentencia, incluido
+    uint32_t linea;
+    uint32_t tipo;           // TipoSentenciaIndice
+    uint32_t titulo;         // posicion del titulo en el bloque de titulos
+    uint32_t longitudTitulo; // 0 salvo en secciones y capitulos
+    uint32_t reservado;
+};
+
+static_assert(sizeof(CabeceraIndiceSecciones) == 48, "CabeceraIndiceSecciones debe ocupar 48 bytes");
+static_assert(sizeof(RegistroIndiceSecciones) == 32, "RegistroIndiceSecciones debe ocupar 32 bytes");
+
+struct SentenciaIndice {
+    TipoSentenciaIndice tipo;
+    uint64_t desplazamiento;
+    uint32_t longitud;
+    uint32_t linea;
+    string titulo; // ya sin escapes
+};
+
+// "doc.texes" -> "doc.texes.idx"
+string nombreIndiceSecciones(const string& rutaTexes);
+
+// "doc.texes" -> "doc.seccion.tex"
+string nombreArchivoSeccion(const string& archivoEntrada);
+
+class IndiceSecciones {
+private:
+    string ruta;
+    vector<SentenciaIndice> sentencias;
+    bool reconstruido = false;
+
+    bool cargar(uint64_t tamano, int64_t fecha);
+    void reconstruir(uint64_t tamano, int64_t fecha);
+
+public:
+    // Lanza runtime_error si el .texes no se puede abrir.
+    explicit IndiceSecciones(const string& rutaTexes);
+
+    // En el orden del archivo.
+    const vector<SentenciaIndice>& getSentencias() const {
+        return sentencias;
+    }
+
+    // true si el indice del disco no servia y se volvio a construir.
+    bool indiceReconstruido() const {
+        return reconstruido;
+    }
+};
+
+// Un tramo del texto reducido empieza en la linea 'lineaFragmento' y viene
+// de la linea 'lineaOriginal' del .texes.
+struct TramoFragmento {
+    size_t lineaFragmento;
+    size_t lineaOriginal;
+};
+
+// Documento reducido a una seccion: documento_inicio, la cabecera, la
+// seccion, la bibliografia y documento_fin, en ese orden.
+struct FragmentoSeccion {
+    string texto;
+    vector<TramoFragmento> tramos;
+    bool indiceReconstruido = false;
+
+    // Lleva las lineas de los diagnosticos (del texto reducido) a las del
+    // .texes.
+    void corregirLineas(vector<Diagnostico>& diagnosticos) const;
+};
+
+// Busca la seccion o el capitulo con ese titulo (primero exacto y si no,
+// sin distinguir mayusculas ni tildes) y lee sus tramos del .texes. Lanza
+// runtime_error si el archivo no se puede leer o no hay ninguno con ese
+// titulo; el mensaje lista los que hay.
+FragmentoSeccion extraerSeccion(const string& rutaTexes, const string& titulo);
+
+#endif
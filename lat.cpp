@@ -1,991 +1,142 @@
 #include <iostream>
 #include <fstream>
+#include <iomanip>
 #include <sstream>
 #include <string>
 #include <vector>
-#include <unordered_map>
-#include <memory>
-#include <stdexcept>
-#include <cctype>
 #include <algorithm>
-#include <map>
-#include <list>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+
+#include "activos.h"
+#include "analizador_lexico.h"
+#include "compilador.h"
+#include "contadores.h"
+#include "editor_incremental.h"
+#include "formatos.h"
+#include "latencias.h"
+#include "lote.h"
+#include "macros.h"
+#include "memoria.h"
+#include "paquete.h"
+#include "proceso.h"
+#include "trabajos_pdf.h"
+#include "traza.h"
+#include "verificador.h"
 
 using namespace std;
 
 // ===============================
-// ENUMERACIONES Y ESTRUCTURAS
+// SALIDA EN CONSOLA
 // ===============================
 
-enum class TipoToken {
-    DOCUMENTO_INICIO, DOCUMENTO_FIN, CONFIGURAR,
-    SECCION, SUBSECCION, SUBSUBSECCION, CAPITULO,
-    NEGRITA, CURSIVA, SUBRAYADO, PARRAFO, TACHADO,
-    LISTA_SIMPLE, LISTA_NUMERADA, ELEMENTO, FIN_LISTA,
-    ECUACION, FORMULA, TABLA, FILA, COLUMNA, FIN_TABLA,
-    FIGURA, LEYENDA, REFERENCIA, TITULO, AUTOR, FECHA,
-    CENTRAR, IZQUIERDA, DERECHA, JUSTIFICAR,
-    SALTO_LINEA, SALTO_PAGINA, NUEVA_PAGINA,
-    
-    PARENTESIS_IZQ, PARENTESIS_DER, LLAVE_IZQ, LLAVE_DER,
-    CORCHETE_IZQ, CORCHETE_DER, COMA, PUNTO_COMA, IGUAL,
-    PORCENTAJE, DOLAR, AMPERSAND,
-    
-    IDENTIFICADOR, CADENA, NUMERO, TEXTO_SIMPLE,
-    
-    FIN_ARCHIVO
-};
-
-// Constantes para la tabla de transiciones
-const int FIN = 666;
-const int ERROR_SINTACTICO = 999;
-
-struct Token {
-    TipoToken tipo;
-    string valor;
-    int linea;
-    int columna;
-    
-    Token(TipoToken t, const string& v, int l, int c) 
-        : tipo(t), valor(v), linea(l), columna(c) {}
-    
-    string toString() const {
-        static map<TipoToken, string> nombresTipo = {
-            {TipoToken::DOCUMENTO_INICIO, "DOCUMENTO_INICIO"},
-            {TipoToken::DOCUMENTO_FIN, "DOCUMENTO_FIN"},
-            {TipoToken::CONFIGURAR, "CONFIGURAR"},
-            {TipoToken::SECCION, "SECCION"},
-            {TipoToken::SUBSECCION, "SUBSECCION"},
-            {TipoToken::SUBSUBSECCION, "SUBSUBSECCION"},
-            {TipoToken::CAPITULO, "CAPITULO"},
-            {TipoToken::NEGRITA, "NEGRITA"},
-            {TipoToken::CURSIVA, "CURSIVA"},
-            {TipoToken::SUBRAYADO, "SUBRAYADO"},
-            {TipoToken::TACHADO, "TACHADO"},
-            {TipoToken::PARRAFO, "PARRAFO"},
-            {TipoToken::LISTA_SIMPLE, "LISTA_SIMPLE"},
-            {TipoToken::LISTA_NUMERADA, "LISTA_NUMERADA"},
-            {TipoToken::ELEMENTO, "ELEMENTO"},
-            {TipoToken::FIN_LISTA, "FIN_LISTA"},
-            {TipoToken::ECUACION, "ECUACION"},
-            {TipoToken::FORMULA, "FORMULA"},
-            {TipoToken::TEXTO_SIMPLE, "TEXTO_SIMPLE"}
-        };
-        
-        auto it = nombresTipo.find(tipo);
-        if (it != nombresTipo.end()) {
-            return it->second + "('" + valor + "')";
-        }
-        return "TOKEN('" + valor + "')";
-    }
-    
-    // Para usar en tabla de transiciones
-    int getTokenValue() const {
-        return static_cast<int>(tipo);
-    }
-};
-
-// ===============================
-// TABLA DE SIMBOLOS
-// ===============================
-
-class Atributos {
-public:
-    string lexema;
-    int token;
-    string tipo;
-    string valor;
-    string estado;
-    
-    Atributos() {
-        lexema = "";
-        token = -999;
-        tipo = "";
-        valor = "nulo";
-        estado = "";
-    }
-    
-    Atributos(string lex, int tok, string tip, string val, string est) {
-        lexema = lex;
-        token = tok;
-        tipo = tip;
-        valor = val;
-        estado = est;
-    }
-    
-    void Mostrar() {
-        cout << "Tipo(" << tipo << ") \t";
-        cout << "Lexema(" << lexema << ") \t";
-        cout << "Token(" << token << ") \t";
-        cout << "Valor(" << valor << ") \t";
-        cout << "Estado(" << estado << ")" << endl;
-    }
-};
-
-class TablaSimbolos {
-private:
-    list<Atributos> tabla;
-
-public:
-    void Insertar(string lex, int tok, string tip, string val, string est) {
-        Atributos attr(lex, tok, tip, val, est);
-        tabla.push_back(attr);
-    }
-    
-    bool ActualizarValor(string lex, string val) {
-        for (auto &item : tabla) {
-            if (item.lexema == lex) {
-                item.valor = val;
-                return true;
-            }
-        }
-        return false;
-    }
-    
-    bool ActualizarTipo(string lex, string tipo) {
-        for (auto &item : tabla) {
-            if (item.lexema == lex) {
-                item.tipo = tipo;
-                return true;
-            }
-        }
-        return false;
-    }
-    
-    bool ActualizarEstado(string lex, string est) {
-        for (auto &item : tabla) {
-            if (item.lexema == lex) {
-                item.estado = est;
-                return true;
-            }
-        }
-        return false;
-    }
-    
-    void Mostrar() {
-        cout << "\nTABLA DE SIMBOLOS:\n";
-        cout << "==================\n";
-        for (auto item : tabla) {
-            item.Mostrar();
-        }
-    }
-    
-    bool Buscar(string lex, Atributos& attr) {
-        for (auto item : tabla) {
-            if (item.lexema == lex) {
-                attr = item;
-                return true;
-            }
-        }
-        return false;
-    }
-    
-    bool BuscarPalabraClave(string lex, Atributos& attr) {
-        for (auto item : tabla) {
-            if (item.lexema == lex && item.tipo == "pclave") {
-                attr = item;
-                return true;
-            }
-        }
-        return false;
-    }
-    
-    list<Atributos> getTabla() {
-        return tabla;
-    }
-};
-
-// ===============================
-// ESTRUCTURAS DEL ARBOL SINTACTICO
-// ===============================
-
-struct NodoAST {
-    virtual ~NodoAST() = default;
-    virtual string toString() const = 0;
-};
-
-struct NodoDocumento : public NodoAST {
-    vector<unique_ptr<NodoAST>> hijos;
-    
-    string toString() const override {
-        return "Documento(" + to_string(hijos.size()) + " hijos)";
-    }
-};
-
-struct NodoConfiguracion : public NodoAST {
-    string clave;
-    string valor;
-    NodoConfiguracion(const string& k, const string& v) : clave(k), valor(v) {}
-    
-    string toString() const override {
-        return "Configurar(" + clave + " = " + valor + ")";
-    }
-};
-
-struct NodoSeccion : public NodoAST {
-    string nivel;
-    string titulo;
-    NodoSeccion(const string& l, const string& t) : nivel(l), titulo(t) {}
-    
-    string toString() const override {
-        return nivel + "(\"" + titulo + "\")";
-    }
-};
-
-struct NodoTexto : public NodoAST {
-    string contenido;
-    string estilo;
-    string alineacion;
-    NodoTexto(const string& c, const string& s = "normal", const string& a = "justificar") 
-        : contenido(c), estilo(s), alineacion(a) {}
-    
-    string toString() const override {
-        return "Texto[" + estilo + "](\"" + contenido + "\")";
-    }
-};
-
-struct NodoLista : public NodoAST {
-    string tipo;
-    vector<unique_ptr<NodoAST>> elementos;
-    
-    string toString() const override {
-        return "Lista[" + tipo + "](" + to_string(elementos.size()) + " elementos)";
-    }
-};
-
-struct NodoEcuacion : public NodoAST {
-    string contenido;
-    string tipo;
-    NodoEcuacion(const string& c, const string& t = "ecuacion") : contenido(c), tipo(t) {}
-    
-    string toString() const override {
-        return "Ecuacion[" + tipo + "](" + contenido + ")";
-    }
-};
-
-struct NodoMetadatos : public NodoAST {
-    string tipo;
-    string contenido;
-    NodoMetadatos(const string& t, const string& c) : tipo(t), contenido(c) {}
-    
-    string toString() const override {
-        return tipo + "(\"" + contenido + "\")";
+void mostrarDiagnosticos(const vector<Diagnostico>& diagnosticos) {
+    for (const auto& diagnostico : diagnosticos) {
+        cout << diagnostico.toString() << "\n";
     }
-};
-
-struct NodoComando : public NodoAST {
-    string comando;
-    string contenido;
-    NodoComando(const string& cmd, const string& c = "") : comando(cmd), contenido(c) {}
-    
-    string toString() const override {
-        return "Comando(" + comando + ")";
-    }
-};
-
-// ===============================
-// ANALIZADOR LEXICO
-// ===============================
-
-class AnalizadorLexico {
-private:
-    string entrada;
-    size_t posicion;
-    int linea;
-    int columna;
-    TablaSimbolos tablaSimbolos;
-    
-    char mirarSiguiente() {
-        return posicion < entrada.length() ? entrada[posicion] : '\0';
-    }
-    
-    char avanzar() {
-        if (posicion >= entrada.length()) return '\0';
-        char c = entrada[posicion++];
-        if (c == '\n') {
-            linea++;
-            columna = 1;
-        } else {
-            columna++;
-        }
-        return c;
-    }
-    
-    void saltarEspacios() {
-        while (isspace(mirarSiguiente()) && mirarSiguiente() != '\n') {
-            avanzar();
-        }
-    }
-    
-    void saltarComentario() {
-        while (mirarSiguiente() != '\n' && mirarSiguiente() != '\0') {
-            avanzar();
-        }
-    }
-    
-    Token leerCadena() {
-        avanzar(); // saltar comilla inicial
-        string valor;
-        int lineaInicio = linea;
-        int columnaInicio = columna;
-        
-        while (mirarSiguiente() != '"' && mirarSiguiente() != '\0') {
-            if (mirarSiguiente() == '\\') {
-                avanzar(); // saltar barra invertida
-                switch (mirarSiguiente()) {
-                    case 'n': valor += '\n'; break;
-                    case 't': valor += '\t'; break;
-                    case '"': valor += '"'; break;
-                    case '\\': valor += '\\'; break;
-                    default: valor += '\\'; valor += mirarSiguiente(); break;
-                }
-                avanzar();
-            } else {
-                valor += avanzar();
-            }
-        }
-        
-        if (mirarSiguiente() == '"') {
-            avanzar();
-        } else {
-            throw runtime_error("Cadena sin cerrar en linea " + to_string(lineaInicio));
-        }
-        
-        return Token(TipoToken::CADENA, valor, lineaInicio, columnaInicio);
-    }
-    
-    Token leerIdentificador() {
-        string valor;
-        int lineaInicio = linea;
-        int columnaInicio = columna;
-        
-        while (isalnum(mirarSiguiente()) || mirarSiguiente() == '_') {
-            valor += avanzar();
-        }
-        
-        // Convertir a minusculas
-        string valorMinusculas = valor;
-        transform(valorMinusculas.begin(), valorMinusculas.end(), valorMinusculas.begin(), ::tolower);
-        
-        Atributos attr;
-        if (tablaSimbolos.BuscarPalabraClave(valorMinusculas, attr)) {
-            return Token(static_cast<TipoToken>(attr.token), valor, lineaInicio, columnaInicio);
-        }
-        
-        // Si no es palabra clave, es identificador
-        tablaSimbolos.Insertar(valor, static_cast<int>(TipoToken::IDENTIFICADOR), "identificador", "nulo", "no_asignado");
-        return Token(TipoToken::IDENTIFICADOR, valor, lineaInicio, columnaInicio);
-    }
-    
-    Token leerNumero() {
-        string valor;
-        int lineaInicio = linea;
-        int columnaInicio = columna;
-        
-        while (isdigit(mirarSiguiente()) || mirarSiguiente() == '.') {
-            valor += avanzar();
-        }
-        
-        tablaSimbolos.Insertar(valor, static_cast<int>(TipoToken::NUMERO), "numero", valor, "asignado");
-        return Token(TipoToken::NUMERO, valor, lineaInicio, columnaInicio);
-    }
-    
-    Token leerTextoSimple() {
-        string valor;
-        int lineaInicio = linea;
-        int columnaInicio = columna;
-        
-        while (mirarSiguiente() != ';' && mirarSiguiente() != '\n' && mirarSiguiente() != '\0') {
-            if (isalpha(mirarSiguiente())) {
-                size_t posicionGuardada = posicion;
-                int lineaGuardada = linea;
-                int columnaGuardada = columna;
-                
-                string posiblePalabraClave;
-                while (isalnum(mirarSiguiente()) || mirarSiguiente() == '_') {
-                    posiblePalabraClave += avanzar();
-                }
-                
-                string palabraMinusculas = posiblePalabraClave;
-                transform(palabraMinusculas.begin(), palabraMinusculas.end(), palabraMinusculas.begin(), ::tolower);
-                
-                Atributos attr;
-                if (tablaSimbolos.BuscarPalabraClave(palabraMinusculas, attr)) {
-                    posicion = posicionGuardada;
-                    linea = lineaGuardada;
-                    columna = columnaGuardada;
-                    break;
-                } else {
-                    valor += posiblePalabraClave;
-                }
-            } else {
-                valor += avanzar();
-            }
-        }
-        
-        while (!valor.empty() && isspace(valor.back())) {
-            valor.pop_back();
-        }
-        
-        if (!valor.empty()) {
-            tablaSimbolos.Insertar(valor, static_cast<int>(TipoToken::TEXTO_SIMPLE), "texto", valor, "asignado");
-        }
-        
-        return Token(TipoToken::TEXTO_SIMPLE, valor, lineaInicio, columnaInicio);
-    }
-
-    bool esElemento(char c) {
-        string elementos = "(){}[]=,;.%$&";
-        return elementos.find(c) != string::npos;
-    }
-
-public:
-    AnalizadorLexico(const string& entrada) 
-        : entrada(entrada), posicion(0), linea(1), columna(1) {
-        
-        // Inicializar tabla de simbolos con palabras reservadas
-        tablaSimbolos.Insertar("documento_inicio", static_cast<int>(TipoToken::DOCUMENTO_INICIO), "pclave", "-", "-");
-        tablaSimbolos.Insertar("documento_fin", static_cast<int>(TipoToken::DOCUMENTO_FIN), "pclave", "-", "-");
-        tablaSimbolos.Insertar("configurar", static_cast<int>(TipoToken::CONFIGURAR), "pclave", "-", "-");
-        tablaSimbolos.Insertar("seccion", static_cast<int>(TipoToken::SECCION), "pclave", "-", "-");
-        tablaSimbolos.Insertar("subseccion", static_cast<int>(TipoToken::SUBSECCION), "pclave", "-", "-");
-        tablaSimbolos.Insertar("subsubseccion", static_cast<int>(TipoToken::SUBSUBSECCION), "pclave", "-", "-");
-        tablaSimbolos.Insertar("capitulo", static_cast<int>(TipoToken::CAPITULO), "pclave", "-", "-");
-        tablaSimbolos.Insertar("negrita", static_cast<int>(TipoToken::NEGRITA), "pclave", "-", "-");
-        tablaSimbolos.Insertar("cursiva", static_cast<int>(TipoToken::CURSIVA), "pclave", "-", "-");
-        tablaSimbolos.Insertar("subrayado", static_cast<int>(TipoToken::SUBRAYADO), "pclave", "-", "-");
-        tablaSimbolos.Insertar("tachado", static_cast<int>(TipoToken::TACHADO), "pclave", "-", "-");
-        tablaSimbolos.Insertar("parrafo", static_cast<int>(TipoToken::PARRAFO), "pclave", "-", "-");
-        tablaSimbolos.Insertar("lista_simple", static_cast<int>(TipoToken::LISTA_SIMPLE), "pclave", "-", "-");
-        tablaSimbolos.Insertar("lista_numerada", static_cast<int>(TipoToken::LISTA_NUMERADA), "pclave", "-", "-");
-        tablaSimbolos.Insertar("elemento", static_cast<int>(TipoToken::ELEMENTO), "pclave", "-", "-");
-        tablaSimbolos.Insertar("fin_lista", static_cast<int>(TipoToken::FIN_LISTA), "pclave", "-", "-");
-        tablaSimbolos.Insertar("ecuacion", static_cast<int>(TipoToken::ECUACION), "pclave", "-", "-");
-        tablaSimbolos.Insertar("formula", static_cast<int>(TipoToken::FORMULA), "pclave", "-", "-");
-        tablaSimbolos.Insertar("titulo", static_cast<int>(TipoToken::TITULO), "pclave", "-", "-");
-        tablaSimbolos.Insertar("autor", static_cast<int>(TipoToken::AUTOR), "pclave", "-", "-");
-        tablaSimbolos.Insertar("fecha", static_cast<int>(TipoToken::FECHA), "pclave", "-", "-");
-        tablaSimbolos.Insertar("salto_linea", static_cast<int>(TipoToken::SALTO_LINEA), "pclave", "-", "-");
-        tablaSimbolos.Insertar("salto_pagina", static_cast<int>(TipoToken::SALTO_PAGINA), "pclave", "-", "-");
-        tablaSimbolos.Insertar("nueva_pagina", static_cast<int>(TipoToken::NUEVA_PAGINA), "pclave", "-", "-");
-        
-        // Simbolos
-        tablaSimbolos.Insertar("(", static_cast<int>(TipoToken::PARENTESIS_IZQ), "pclave", "-", "-");
-        tablaSimbolos.Insertar(")", static_cast<int>(TipoToken::PARENTESIS_DER), "pclave", "-", "-");
-        tablaSimbolos.Insertar("{", static_cast<int>(TipoToken::LLAVE_IZQ), "pclave", "-", "-");
-        tablaSimbolos.Insertar("}", static_cast<int>(TipoToken::LLAVE_DER), "pclave", "-", "-");
-        tablaSimbolos.Insertar("[", static_cast<int>(TipoToken::CORCHETE_IZQ), "pclave", "-", "-");
-        tablaSimbolos.Insertar("]", static_cast<int>(TipoToken::CORCHETE_DER), "pclave", "-", "-");
-        tablaSimbolos.Insertar(",", static_cast<int>(TipoToken::COMA), "pclave", "-", "-");
-        tablaSimbolos.Insertar(";", static_cast<int>(TipoToken::PUNTO_COMA), "pclave", "-", "-");
-        tablaSimbolos.Insertar("=", static_cast<int>(TipoToken::IGUAL), "pclave", "-", "-");
-        tablaSimbolos.Insertar("%", static_cast<int>(TipoToken::PORCENTAJE), "pclave", "-", "-");
-        tablaSimbolos.Insertar("$", static_cast<int>(TipoToken::DOLAR), "pclave", "-", "-");
-        tablaSimbolos.Insertar("&", static_cast<int>(TipoToken::AMPERSAND), "pclave", "-", "-");
-    }
-    
-    vector<Token> analizar() {
-        vector<Token> tokens;
-        
-        while (posicion < entrada.length()) {
-            saltarEspacios();
-            
-            char c = mirarSiguiente();
-            if (c == '\0') break;
-            
-            int lineaActual = linea;
-            int columnaActual = columna;
-            
-            if (c == '"') {
-                tokens.push_back(leerCadena());
-            } else if (isalpha(c) || c == '_') {
-                tokens.push_back(leerIdentificador());
-            } else if (isdigit(c)) {
-                tokens.push_back(leerNumero());
-            } else if (c == '%') {
-                saltarComentario();
-            } else if (esElemento(c)) {
-                string simbolo(1, c);
-                Atributos attr;
-                if (tablaSimbolos.BuscarPalabraClave(simbolo, attr)) {
-                    tokens.push_back(Token(static_cast<TipoToken>(attr.token), simbolo, lineaActual, columnaActual));
-                    avanzar();
-                } else {
-                    avanzar();
-                }
-            } else if (c == '\n') {
-                avanzar();
-            } else {
-                Token tokenTexto = leerTextoSimple();
-                if (!tokenTexto.valor.empty()) {
-                    tokens.push_back(tokenTexto);
-                } else {
-                    avanzar();
-                }
-            }
-        }
-        
-        tokens.push_back(Token(TipoToken::FIN_ARCHIVO, "", linea, columna));
-        return tokens;
-    }
-    
-    void mostrarTablaSimbolos() {
-        tablaSimbolos.Mostrar();
-    }
-    
-    TablaSimbolos& getTablaSimbolos() {
-        return tablaSimbolos;
-    }
-};
-
-// ===============================
-// ANALIZADOR SINTACTICO CON TABLA DE TRANSICIONES
-// ===============================
-
-class AnalizadorSintactico {
-private:
-    vector<Token> tokens;
-    size_t actual;
-    int estado;
-    int tTransicion[100][100];
-    
-    void inicializarTablaTransiciones() {
-        // Inicializar toda la tabla con ERROR
-        for (int i = 0; i < 100; i++) {
-            for (int j = 0; j < 100; j++) {
-                tTransicion[i][j] = ERROR_SINTACTICO;
-            }
-        }
-
-        // ===============================
-        // TABLA DE TRANSICIONES - ESTILO INGENIERO
-        // ===============================
-
-        // documento_inicio ;
-        tTransicion[0][static_cast<int>(TipoToken::DOCUMENTO_INICIO)] = 1;
-        tTransicion[1][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
-
-        // titulo|autor|fecha ("texto") ;
-        tTransicion[2][static_cast<int>(TipoToken::TITULO)] = 3;
-        tTransicion[2][static_cast<int>(TipoToken::AUTOR)] = 3;
-        tTransicion[2][static_cast<int>(TipoToken::FECHA)] = 3;
-        tTransicion[3][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 4;
-        tTransicion[4][static_cast<int>(TipoToken::CADENA)] = 5;
-        tTransicion[5][static_cast<int>(TipoToken::PARENTESIS_DER)] = 6;
-        tTransicion[6][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
-
-        // configurar ("clave", "valor") ;
-        tTransicion[2][static_cast<int>(TipoToken::CONFIGURAR)] = 7;
-        tTransicion[7][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 8;
-        tTransicion[8][static_cast<int>(TipoToken::CADENA)] = 9;
-        tTransicion[9][static_cast<int>(TipoToken::COMA)] = 10;
-        tTransicion[10][static_cast<int>(TipoToken::CADENA)] = 11;
-        tTransicion[11][static_cast<int>(TipoToken::PARENTESIS_DER)] = 12;
-        tTransicion[12][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
-
-        // seccion|subseccion|etc ("titulo") ;
-        tTransicion[2][static_cast<int>(TipoToken::SECCION)] = 13;
-        tTransicion[2][static_cast<int>(TipoToken::SUBSECCION)] = 13;
-        tTransicion[2][static_cast<int>(TipoToken::SUBSUBSECCION)] = 13;
-        tTransicion[2][static_cast<int>(TipoToken::CAPITULO)] = 13;
-        tTransicion[13][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 14;
-        tTransicion[14][static_cast<int>(TipoToken::CADENA)] = 15;
-        tTransicion[15][static_cast<int>(TipoToken::PARENTESIS_DER)] = 16;
-        tTransicion[16][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
-
-        // parrafo|negrita|cursiva ("texto") ;
-        tTransicion[2][static_cast<int>(TipoToken::PARRAFO)] = 17;
-        tTransicion[2][static_cast<int>(TipoToken::NEGRITA)] = 17;
-        tTransicion[2][static_cast<int>(TipoToken::CURSIVA)] = 17;
-        tTransicion[2][static_cast<int>(TipoToken::SUBRAYADO)] = 17;
-        tTransicion[2][static_cast<int>(TipoToken::TACHADO)] = 17;
-        tTransicion[17][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 18;
-        tTransicion[18][static_cast<int>(TipoToken::CADENA)] = 19;
-        tTransicion[19][static_cast<int>(TipoToken::PARENTESIS_DER)] = 20;
-        tTransicion[20][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
-
-        // parrafo|negrita|cursiva texto_simple ;
-        tTransicion[17][static_cast<int>(TipoToken::TEXTO_SIMPLE)] = 21;
-        tTransicion[21][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
-
-        // lista_simple|lista_numerada ;
-        tTransicion[2][static_cast<int>(TipoToken::LISTA_SIMPLE)] = 22;
-        tTransicion[2][static_cast<int>(TipoToken::LISTA_NUMERADA)] = 22;
-        tTransicion[22][static_cast<int>(TipoToken::PUNTO_COMA)] = 23;
-
-        // elemento ("texto") ;
-        tTransicion[23][static_cast<int>(TipoToken::ELEMENTO)] = 24;
-        tTransicion[24][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 25;
-        tTransicion[25][static_cast<int>(TipoToken::CADENA)] = 26;
-        tTransicion[26][static_cast<int>(TipoToken::PARENTESIS_DER)] = 27;
-        tTransicion[27][static_cast<int>(TipoToken::PUNTO_COMA)] = 23;
-
-        // elemento texto_simple ;
-        tTransicion[24][static_cast<int>(TipoToken::TEXTO_SIMPLE)] = 28;
-        tTransicion[28][static_cast<int>(TipoToken::PUNTO_COMA)] = 23;
-
-        // fin_lista ;
-        tTransicion[23][static_cast<int>(TipoToken::FIN_LISTA)] = 29;
-        tTransicion[29][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
-
-        // ecuacion|formula ("contenido") ;
-        tTransicion[2][static_cast<int>(TipoToken::ECUACION)] = 30;
-        tTransicion[2][static_cast<int>(TipoToken::FORMULA)] = 30;
-        tTransicion[30][static_cast<int>(TipoToken::PARENTESIS_IZQ)] = 31;
-        tTransicion[31][static_cast<int>(TipoToken::CADENA)] = 32;
-        tTransicion[32][static_cast<int>(TipoToken::PARENTESIS_DER)] = 33;
-        tTransicion[33][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
-
-        // salto_linea|salto_pagina|nueva_pagina ;
-        tTransicion[2][static_cast<int>(TipoToken::SALTO_LINEA)] = 34;
-        tTransicion[2][static_cast<int>(TipoToken::SALTO_PAGINA)] = 34;
-        tTransicion[2][static_cast<int>(TipoToken::NUEVA_PAGINA)] = 34;
-        tTransicion[34][static_cast<int>(TipoToken::PUNTO_COMA)] = 2;
-
-        // documento_fin ;
-        tTransicion[2][static_cast<int>(TipoToken::DOCUMENTO_FIN)] = 35;
-        tTransicion[35][static_cast<int>(TipoToken::PUNTO_COMA)] = 36; // ESTADO FINAL
-    }
-
-    Token& mirarSiguiente() {
-        return tokens[actual];
-    }
-    
-    Token& avanzar() {
-        if (!estaAlFinal()) actual++;
-        return tokens[actual - 1];
-    }
-    
-    bool estaAlFinal() {
-        return mirarSiguiente().tipo == TipoToken::FIN_ARCHIVO;
-    }
-    
-    // Método para análisis con tabla de transiciones
-    bool analizarConTablaTransiciones() {
-        estado = 0;
-        actual = 0;
-        
-        cout << "Iniciando analisis sintactico con tabla de transiciones..." << endl;
-        
-        while (!estaAlFinal()) {
-            Token& token = mirarSiguiente();
-            int tokenType = token.getTokenValue();
-            
-            //cout << "(e" << estado << ", t" << tokenType << ")" << endl;
-            
-            int nuevoEstado = tTransicion[estado][tokenType];
-            
-            if (nuevoEstado == ERROR_SINTACTICO) {
-                cout << "Error sintactico en linea " << token.linea 
-                      << ": Transicion no definida (estado " << estado 
-                      << ", token " << tokenType << " - " << token.toString() << ")" << endl;
-                return false;
-            }
-            
-            estado = nuevoEstado;
-            avanzar();
-            
-            // Estado final aceptado
-            if (estado == 36) {
-                cout << "Analisis sintactico completado exitosamente." << endl;
-                return true;
-            }
-        }
-        
-        if (estado != 36) {
-            cout << "Error: Documento incompleto - estado final no alcanzado" << endl;
-            return false;
-        }
-        
-        return true;
-    }
-
-    // Métodos originales del parser (se mantienen para compatibilidad)
-    unique_ptr<NodoAST> analizarDeclaracion() {
-        // Implementación simplificada para mantener funcionalidad
-        try {
-            if (mirarSiguiente().tipo == TipoToken::DOCUMENTO_INICIO) {
-                avanzar();
-                return make_unique<NodoComando>("inicio_documento");
-            }
-            // ... resto de implementación original
-            return nullptr;
-        } catch (const runtime_error& e) {
-            cerr << "Error de analisis: " << e.what() << endl;
-            return nullptr;
-        }
-    }
-
-public:
-    AnalizadorSintactico(const vector<Token>& tokens) 
-        : tokens(tokens), actual(0), estado(0) {
-        inicializarTablaTransiciones();
-    }
-    
-    // Método principal que usa la tabla de transiciones
-    bool analizarSintaxis() {
-        return analizarConTablaTransiciones();
-    }
-    
-    // Método original para mantener compatibilidad
-    unique_ptr<NodoDocumento> analizar() {
-        auto documento = make_unique<NodoDocumento>();
-        // Implementación simplificada
-        cout << "Analisis sintactico completado." << endl;
-        return documento;
-    }
-    
-    void mostrarTokens() {
-        cout << "\nTOKENS RECONOCIDOS:\n";
-        cout << "===================\n";
-        for (size_t i = 0; i < tokens.size() && i < 50; ++i) {
-            cout << "Linea " << tokens[i].linea << ", Col " << tokens[i].columna 
-                      << ": " << tokens[i].toString() << endl;
-        }
-        if (tokens.size() > 50) {
-            cout << "... y " << (tokens.size() - 50) << " tokens mas.\n";
-        }
-    }
-};
+}
 
 // ===============================
-// GENERADOR DE LATEX
+// EDITOR INTERACTIVO EN CONSOLA
 // ===============================
 
-class GeneradorLatex {
-private:
-    stringstream salida;
-    int nivelIndentacion;
-    
-    void indentar() {
-        for (int i = 0; i < nivelIndentacion; i++) {
-            salida << "  ";
-        }
-    }
-    
-    void generarNodo(NodoAST* nodo) {
-        if (auto config = dynamic_cast<NodoConfiguracion*>(nodo)) {
-            generarConfiguracion(config);
-        } else if (auto seccion = dynamic_cast<NodoSeccion*>(nodo)) {
-            generarSeccion(seccion);
-        } else if (auto texto = dynamic_cast<NodoTexto*>(nodo)) {
-            generarTexto(texto);
-        } else if (auto lista = dynamic_cast<NodoLista*>(nodo)) {
-            generarLista(lista);
-        } else if (auto ecuacion = dynamic_cast<NodoEcuacion*>(nodo)) {
-            generarEcuacion(ecuacion);
-        } else if (auto metadatos = dynamic_cast<NodoMetadatos*>(nodo)) {
-            generarMetadatos(metadatos);
-        } else if (auto comando = dynamic_cast<NodoComando*>(nodo)) {
-            generarComando(comando);
-        }
-    }
-    
-    void generarConfiguracion(NodoConfiguracion* nodo) {
-        if (nodo->clave == "idioma" && nodo->valor == "espanol") {
-            salida << "\\usepackage[spanish]{babel}\n";
-        } else if (nodo->clave == "codificacion" && nodo->valor == "UTF-8") {
-            salida << "\\usepackage[utf8]{inputenc}\n";
-        } else if (nodo->clave == "tipo_documento") {
-            salida << "\\documentclass{" << nodo->valor << "}\n";
-        }
-    }
-    
-    void generarSeccion(NodoSeccion* nodo) {
-        salida << "\\" << nodo->nivel << "{" << nodo->titulo << "}\n";
-        salida << "\n";
-    }
-    
-    void generarTexto(NodoTexto* nodo) {
-        if (nodo->estilo == "negrita") {
-            salida << "\\textbf{" << nodo->contenido << "}";
-        } else if (nodo->estilo == "cursiva") {
-            salida << "\\textit{" << nodo->contenido << "}";
-        } else if (nodo->estilo == "subrayado") {
-            salida << "\\underline{" << nodo->contenido << "}";
-        } else if (nodo->estilo == "tachado") {
-            salida << "\\sout{" << nodo->contenido << "}";
-        } else {
-            salida << nodo->contenido;
-        }
-        salida << "\n\n";
-    }
-    
-    void generarLista(NodoLista* nodo) {
-        if (nodo->tipo == "simple") {
-            salida << "\\begin{itemize}\n";
-        } else {
-            salida << "\\begin{enumerate}\n";
-        }
-        
-        nivelIndentacion++;
-        for (auto& elemento : nodo->elementos) {
-            indentar();
-            if (auto textoElemento = dynamic_cast<NodoTexto*>(elemento.get())) {
-                salida << "\\item " << textoElemento->contenido << "\n";
-            }
-        }
-        nivelIndentacion--;
-        
-        if (nodo->tipo == "simple") {
-            salida << "\\end{itemize}\n";
-        } else {
-            salida << "\\end{enumerate}\n";
-        }
-        salida << "\n";
-    }
-    
-    void generarEcuacion(NodoEcuacion* nodo) {
-        if (nodo->tipo == "ecuacion") {
-            salida << "\\begin{equation}\n";
-            salida << nodo->contenido << "\n";
-            salida << "\\end{equation}\n";
-        } else {
-            salida << "$" << nodo->contenido << "$";
-        }
-        salida << "\n\n";
-    }
-    
-    void generarMetadatos(NodoMetadatos* nodo) {
-        if (nodo->tipo == "titulo") {
-            salida << "\\title{" << nodo->contenido << "}\n";
-        } else if (nodo->tipo == "autor") {
-            salida << "\\author{" << nodo->contenido << "}\n";
-        } else if (nodo->tipo == "fecha") {
-            salida << "\\date{" << nodo->contenido << "}\n";
-        }
-    }
-    
-    void generarComando(NodoComando* nodo) {
-        if (nodo->comando == "nueva_linea") {
-            salida << "\\\\\n";
-        } else if (nodo->comando == "salto_pagina") {
-            salida << "\\pagebreak\n";
-        } else if (nodo->comando == "nueva_pagina") {
-            salida << "\\newpage\n";
-        } else if (nodo->comando == "inicio_documento") {
-            salida << "\\begin{document}\n";
-            salida << "\\maketitle\n\n";
-        } else if (nodo->comando == "fin_documento") {
-            salida << "\\end{document}\n";
-        } else if (nodo->comando == "fin_lista") {
-            // Ya manejado en generarLista
-        }
-    }
-    
-public:
-    GeneradorLatex() : nivelIndentacion(0) {}
-    
-    string generar(NodoDocumento* ast) {
-        salida.str("");
-        salida.clear();
-        
-        // Encabezado del documento LaTeX
-        salida << "\\documentclass{article}\n";
-        salida << "\\usepackage[utf8]{inputenc}\n";
-        salida << "\\usepackage[spanish]{babel}\n";
-        salida << "\\usepackage{amsmath}\n";
-        salida << "\\usepackage{amssymb}\n";
-        salida << "\\usepackage{ulem}\n";
-        salida << "\n";
-        
-        // Primero procesar configuraciones y metadatos
-        bool tieneTitulo = false;
-        for (auto& hijo : ast->hijos) {
-            if (auto metadatos = dynamic_cast<NodoMetadatos*>(hijo.get())) {
-                generarNodo(metadatos);
-                if (metadatos->tipo == "titulo") tieneTitulo = true;
-            }
-        }
-        
-        for (auto& hijo : ast->hijos) {
-            if (dynamic_cast<NodoConfiguracion*>(hijo.get())) {
-                generarNodo(hijo.get());
-            }
-        }
-        
-        // Luego el contenido del documento
-        for (auto& hijo : ast->hijos) {
-            if (!dynamic_cast<NodoConfiguracion*>(hijo.get()) && 
-                !dynamic_cast<NodoMetadatos*>(hijo.get())) {
-                generarNodo(hijo.get());
+// Resultado de cada linea: errores de las lineas que cambiaron y vista
+// previa LaTeX de la sentencia en curso.
+void mostrarEdicion(const ResultadoEdicion& edicion) {
+    mostrarDiagnosticos(edicion.diagnosticos);
+
+    const size_t maximoLineas = 12;
+    if (!edicion.vistaPrevia.empty()) {
+        istringstream vista(edicion.vistaPrevia);
+        string linea;
+        size_t mostradas = 0;
+        while (getline(vista, linea)) {
+            if (mostradas++ == maximoLineas) {
+                cout << "    ...\n";
+                break;
             }
+            cout << "    | " << linea << "\n";
         }
-        
-        return salida.str();
+    } else if (!edicion.avisoVistaPrevia.empty()) {
+        cout << "    " << edicion.avisoVistaPrevia << "\n";
     }
-};
 
-// ===============================
-// FUNCIONES UTILITARIAS
-// ===============================
-
-string leerArchivo(const string& nombreArchivo) {
-    ifstream archivo(nombreArchivo);
-    if (!archivo.is_open()) {
-        throw runtime_error("No se pudo abrir el archivo: " + nombreArchivo);
-    }
-    
-    stringstream buffer;
-    buffer << archivo.rdbuf();
-    return buffer.str();
+    cout << "    [" << fixed << setprecision(3) << edicion.milisegundos << " ms, "
+         << edicion.lineasRelexadas << " relexadas, " << edicion.lineasReanalizadas
+         << " reanalizadas]\n";
+    cout.unsetf(ios::fixed);
 }
 
-void escribirArchivo(const string& nombreArchivo, const string& contenido) {
-    ofstream archivo(nombreArchivo);
-    if (!archivo.is_open()) {
-        throw runtime_error("No se pudo crear el archivo: " + nombreArchivo);
-    }
-    
-    archivo << contenido;
-}
-
-// ===============================
-// EDITOR INTERACTIVO EN CONSOLA
-// ===============================
-
 void compilarInteractivo() {
     cout << "\nEDITOR INTERACTIVO LATEX\n";
     cout << "========================\n";
     cout << "Escribe tu documento linea por linea.\n";
+    cout << "Cada linea se valida al momento y se muestra su LaTeX.\n";
+    cout << "  :N texto    reemplaza la linea N\n";
+    cout << "  :+N texto   inserta antes de la linea N\n";
+    cout << "  :-N         borra la linea N\n";
+    cout << "  :ver        muestra el documento\n";
     cout << "Escribe 'FIN' en una linea nueva para terminar.\n\n";
-    
-    stringstream entrada;
+
+    EditorIncremental editor;
     string linea;
-    int numeroLinea = 1;
-    
+
     while (true) {
-        cout << "[" << numeroLinea << "] ";
-        getline(cin, linea);
-        
-        if (linea == "FIN" || linea == "fin") {
+        cout << "[" << editor.numeroLineas() + 1 << "] ";
+        if (!getline(cin, linea) || linea == "FIN" || linea == "fin") {
             break;
         }
-        
-        entrada << linea << "\n";
-        numeroLinea++;
+
+        try {
+            if (linea == ":ver") {
+                for (size_t i = 0; i < editor.numeroLineas(); i++) {
+                    cout << setw(4) << i + 1 << "  " << editor.linea(i) << "\n";
+                }
+                continue;
+            }
+            if (linea.size() > 1 && linea[0] == ':') {
+                char orden = linea[1] == '+' || linea[1] == '-' ? linea[1] : '=';
+                size_t inicioNumero = orden == '=' ? 1 : 2;
+                size_t finNumero = linea.find(' ', inicioNumero);
+                size_t numero = stoul(linea.substr(inicioNumero, finNumero - inicioNumero));
+                string texto = finNumero == string::npos ? "" : linea.substr(finNumero + 1);
+                if (numero == 0) throw runtime_error("Las lineas se numeran desde 1");
+
+                if (orden == '+') {
+                    mostrarEdicion(editor.insertar(numero - 1, texto));
+                } else if (orden == '-') {
+                    mostrarEdicion(editor.borrar(numero - 1));
+                } else {
+                    mostrarEdicion(editor.reemplazar(numero - 1, texto));
+                }
+                continue;
+            }
+            mostrarEdicion(editor.agregar(linea));
+        } catch (const exception& e) {
+            cout << "    Orden no valida: " << e.what() << "\n";
+        }
     }
-    
+
     try {
-        string contenido = entrada.str();
+        string contenido = editor.texto();
         if (contenido.empty()) {
             cout << "No se ingreso ningun contenido.\n";
             return;
         }
         
         cout << "\nProcesando documento..." << endl;
-        
-        AnalizadorLexico lexico(contenido);
-        auto tokens = lexico.analizar();
-        
-        AnalizadorSintactico sintactico(tokens);
-        sintactico.mostrarTokens();
-        
-        auto ast = sintactico.analizar();
-        
-        GeneradorLatex generador;
-        string salidaLatex = generador.generar(ast.get());
-        
+
+        ResultadoCompilacion resultado = compilar(contenido);
+        mostrarDiagnosticos(resultado.diagnosticos);
+        if (!resultado.exito) {
+            cout << "\nLa compilacion fallo.\n";
+            return;
+        }
+        const string& salidaLatex = resultado.latex;
+
         string nombreArchivoSalida = "documento_interactivo.tex";
         escribirArchivo(nombreArchivoSalida, salidaLatex);
         
@@ -1034,6 +185,25 @@ void mostrarEjemplos() {
     cout << "ecuacion(\"E = mc^2\");\n";
     cout << "formula(\"a^2 + b^2 = c^2\");\n\n";
     
+    cout << "Tablas desde CSV (opciones: separador, encabezado, columnas):\n";
+    cout << "tabla_csv(\"datos.csv\");\n";
+    cout << "tabla_csv(\"notas.csv\", \"separador=;\", \"encabezado=no\");\n\n";
+
+    cout << "Figuras (la leyenda es opcional):\n";
+    cout << "figura(\"imagenes/grafico.png\", \"Resultados del experimento\");\n\n";
+
+    cout << "Referencias cruzadas e indice (resueltos por el compilador):\n";
+    cout << "indice();\n";
+    cout << "seccion(\"Resultados\");\n";
+    cout << "etiqueta(\"resultados\");\n";
+    cout << "parrafo(\"Como se explica en la seccion\");\n";
+    cout << "referencia(\"resultados\");\n\n";
+
+    cout << "Bibliografia desde un archivo .bib (sin BibTeX):\n";
+    cout << "cita(\"knuth84\");\n";
+    cout << "cita(\"knuth84, lamport94\", \"cap. 3\");\n";
+    cout << "bibliografia(\"referencias.bib\");\n\n";
+
     cout << "Texto simple (sin comillas):\n";
     cout << "parrafo Este es un parrafo sin comillas;\n";
     cout << "negrita Texto en negrita sin comillas;\n\n";
@@ -1153,17 +323,17 @@ void compilarArchivo() {
         string entrada = leerArchivo(nombreArchivo);
         cout << "Compilando " << nombreArchivo << "...\n";
         
-        AnalizadorLexico lexico(entrada);
-        auto tokens = lexico.analizar();
-        
-        AnalizadorSintactico sintactico(tokens);
-        sintactico.mostrarTokens();
-        
-        auto ast = sintactico.analizar();
-        
-        GeneradorLatex generador;
-        string salidaLatex = generador.generar(ast.get());
-        
+        OpcionesCompilacion opciones;
+        opciones.directorioBase = filesystem::path(nombreArchivo).parent_path().string();
+
+        ResultadoCompilacion resultado = compilar(entrada, opciones);
+        mostrarDiagnosticos(resultado.diagnosticos);
+        if (!resultado.exito) {
+            cout << "\nLa compilacion fallo.\n";
+            return;
+        }
+        const string& salidaLatex = resultado.latex;
+
         string nombreArchivoSalida = nombreArchivo.substr(0, nombreArchivo.find(".texes")) + ".tex";
         escribirArchivo(nombreArchivoSalida, salidaLatex);
         
@@ -1173,9 +343,19 @@ void compilarArchivo() {
         
         // Estadisticas
         cout << "\nESTADISTICAS:\n";
-        cout << "• Tokens reconocidos: " << tokens.size() << "\n";
-        cout << "• Nodos AST: " << ast->hijos.size() << "\n";
-        cout << "• Lineas LaTeX generadas: " << count(salidaLatex.begin(), salidaLatex.end(), '\n') << "\n";
+        cout << "• Tokens reconocidos: " << resultado.estadisticas.tokens << "\n";
+        cout << "• Nodos AST: " << resultado.estadisticas.nodosAST << "\n";
+        cout << "• Lineas LaTeX generadas: " << resultado.estadisticas.lineasLatex << "\n";
+        if (resultado.estadisticas.filasTabla > 0) {
+            cout << "• Filas de tabla_csv: " << resultado.estadisticas.filasTabla << " ("
+                 << static_cast<long long>(resultado.estadisticas.filasTablaPorSegundo)
+                 << " filas/s)\n";
+        }
+        cout << "• Memoria por fase: lexico " << formatearBytes(resultado.estadisticas.memoriaLexico)
+             << ", sintaxis " << formatearBytes(resultado.estadisticas.memoriaSintaxis)
+             << ", AST " << formatearBytes(resultado.estadisticas.memoriaAST)
+             << ", generacion " << formatearBytes(resultado.estadisticas.memoriaGeneracion) << "\n";
+        cout << "• Pico de memoria residente: " << formatearBytes(memoriaResidentePico()) << "\n";
         
     } catch (const exception& e) {
         cout << "Error: " << e.what() << "\n";
@@ -1196,11 +376,505 @@ void mostrarMenu() {
     cout << "Selecciona una opcion: ";
 }
 
+// ===============================
+// MODO LINEA DE COMANDOS
+// ===============================
+
+void mostrarUso() {
+    cout << "Uso: lat [opciones] archivo.texes... paquete.tar...\n";
+    cout << "Sin argumentos se abre el menu interactivo.\n";
+    cout << "Los .texes de un paquete.tar se compilan en paquete.tex.tar.\n\n";
+    cout << "Opciones:\n";
+    cout << "  -j N, --hilos=N      Hilos trabajadores (por defecto, uno por nucleo)\n";
+    cout << "  --trace=salida.json  Traza de fases en formato Chrome/Perfetto\n";
+    cout << "  --activos=DIR        Publica las imagenes de figura() deduplicadas en DIR\n";
+    cout << "  --salidas=html,md    Emite tambien HTML y/o Markdown desde el mismo analisis\n";
+    cout << "  --cache-ast          Guarda tokens y AST en binario (doc.texast) junto al .tex\n";
+    cout << "  --pdf                Ejecuta el motor TeX sobre cada .tex que cambio\n";
+    cout << "  --formatos=DIR       Precompila en DIR un formato por cada preambulo distinto\n";
+    cout << "  --macros=ARCHIVO     Carga las macros de un .texes con solo definir(); se\n";
+    cout << "                       comparten en todo el lote (se puede repetir)\n";
+    cout << "  --motor=CMD          Motor para --pdf (por defecto $LATEXES_MOTOR o pdflatex)\n";
+    cout << "  --max-memory=N[K|M|G] Limite de memoria: los documentos esperan su turno, la\n";
+    cout << "                       salida grande se escribe por bloques en disco y lo que\n";
+    cout << "                       no cabe falla con un diagnostico\n";
+    cout << "  --io=MOTOR           E/S del lote: auto (io_uring si se puede), io_uring,\n";
+    cout << "                       hilos o sincrono\n";
+    cout << "  --perf-counters      Ciclos, IPC y fallos de salto y de cache por fase y por\n";
+    cout << "                       trabajador (Linux, perf_event_open)\n";
+    cout << "  --solo-seccion=TITULO Compila solo esa seccion o capitulo (con la cabecera del\n";
+    cout << "                       documento) en doc.seccion.tex, leyendo solo sus bytes\n";
+    cout << "  --latencias          p50, p90, p99 y maximo por documento, en total y por fase\n";
+    cout << "  --lentos=MS          Anota los documentos que tardan mas de MS milisegundos\n";
+    cout << "                       (tamano, tokens, fase dominante); implica --latencias\n";
+    cout << "  --registro-lentos=ARCHIVO  Donde se anotan (por defecto lentos.log)\n";
+    cout << "  --check              Solo valida lexico y sintaxis, sin generar nada; lista\n";
+    cout << "                       los archivos con errores (codigo de salida 1)\n";
+    cout << "  -h, --ayuda          Muestra esta ayuda\n";
+}
+
+// --check: solo los archivos con errores y un resumen.
+int verificarArchivos(const vector<string>& archivos, unsigned hilos) {
+    auto inicio = chrono::steady_clock::now();
+    vector<ResultadoVerificacion> resultados = verificarLote(archivos, hilos);
+    double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+
+    size_t fallidos = 0;
+    size_t bytes = 0;
+    for (const auto& resultado : resultados) {
+        bytes += resultado.bytes;
+        if (resultado.valido) continue;
+        fallidos++;
+        for (const auto& diagnostico : resultado.diagnosticos) {
+            cout << resultado.archivo << ": " << diagnostico.toString() << "\n";
+        }
+    }
+    cout << (resultados.size() - fallidos) << " de " << resultados.size() << " documentos validos ("
+         << formatearBytes(bytes) << " en " << fixed << setprecision(1) << segundos * 1000.0 << " ms, "
+         << formatearBytes(segundos > 0.0 ? static_cast<size_t>(bytes / segundos) : 0) << "/s)\n";
+    return fallidos == 0 ? 0 : 1;
+}
+
+// --perf-counters: IPC y fallos por KB de entrada de cada fase y trabajador.
+void mostrarContadores(const ContadoresHardware& contadores) {
+    string error = contadores.getError();
+    if (!error.empty()) {
+        cout << "Contadores de hardware no disponibles: " << error << "\n";
+        return;
+    }
+
+    auto porKb = [&](const TotalContadores& total, Contador contador) {
+        ostringstream texto;
+        if (!contadores.disponible(contador)) {
+            texto << "n/d";
+        } else if (total.bytes > 0) {
+            texto << fixed << setprecision(1) << total.valores[contador] * 1024.0 / total.bytes;
+        } else {
+            texto << "-";
+        }
+        return texto.str();
+    };
+
+    cout << "Contadores de hardware (modo usuario; fallos por KB de entrada):\n";
+    cout << "  " << left << setw(16) << "fase" << right << setw(12) << "entrada" << setw(14) << "Mciclos"
+         << setw(7) << "IPC" << setw(12) << "saltos/KB" << setw(12) << "L1d/KB" << setw(12) << "LLC/KB" << "\n";
+    for (const auto& total : contadores.getTotales()) {
+        ostringstream ciclos, ipc;
+        ciclos << fixed << setprecision(1);
+        ipc << fixed << setprecision(2);
+        if (contadores.disponible(CICLOS)) {
+            ciclos << total.valores[CICLOS] / 1e6;
+        } else {
+            ciclos << "n/d";
+        }
+        if (contadores.disponible(CICLOS) && contadores.disponible(INSTRUCCIONES) && total.valores[CICLOS] > 0) {
+            ipc << static_cast<double>(total.valores[INSTRUCCIONES]) / total.valores[CICLOS];
+        } else {
+            ipc << "n/d";
+        }
+        cout << "  " << left << setw(16) << total.nombre << right << setw(12) << formatearBytes(total.bytes)
+             << setw(14) << ciclos.str() << setw(7) << ipc.str() << setw(12) << porKb(total, FALLOS_SALTO)
+             << setw(12) << porKb(total, FALLOS_L1) << setw(12) << porKb(total, FALLOS_LLC) << "\n";
+    }
+}
+
+// Milisegundos con tres decimales.
+string formatearMs(uint64_t nanosegundos) {
+    ostringstream texto;
+    texto << fixed << setprecision(3) << nanosegundos / 1e6;
+    return texto.str();
+}
+
+// --latencias: histograma del total y de cada fase de los documentos.
+void mostrarLatencias(const vector<ResultadoDocumento>& resultados) {
+    HistogramaLatencias total;
+    vector<HistogramaLatencias> fases(NUMERO_FASES_DOCUMENTO);
+    for (const auto& documento : resultados) {
+        total.registrar(documento.tiempos.totalNs);
+        for (int fase = 0; fase < NUMERO_FASES_DOCUMENTO; fase++) {
+            fases[fase].registrar(documento.tiempos.fasesNs[fase]);
+        }
+    }
+
+    cout << "Latencias por documento (" << total.getCantidad() << " documentos, ms):\n";
+    cout << "  " << left << setw(12) << "fase" << right << setw(10) << "p50" << setw(10) << "p90"
+         << setw(10) << "p99" << setw(10) << "max" << setw(10) << "media" << "\n";
+    auto fila = [](const char* nombre, const HistogramaLatencias& histograma) {
+        cout << "  " << left << setw(12) << nombre << right << setw(10) << formatearMs(histograma.percentil(50))
+             << setw(10) << formatearMs(histograma.percentil(90)) << setw(10)
+             << formatearMs(histograma.percentil(99)) << setw(10) << formatearMs(histograma.getMaximo())
+             << setw(10) << formatearMs(static_cast<uint64_t>(histograma.media())) << "\n";
+    };
+    fila("total", total);
+    for (int fase = 0; fase < NUMERO_FASES_DOCUMENTO; fase++) {
+        fila(nombreFaseDocumento(fase), fases[fase]);
+    }
+}
+
+// --lentos: una linea por documento que supera el umbral, del mas lento al
+// mas rapido, separada por tabuladores. Devuelve cuantos se anotaron.
+size_t escribirRegistroLentos(const vector<ResultadoDocumento>& resultados, uint64_t umbralNs,
+                              const string& archivo) {
+    vector<const ResultadoDocumento*> lentos;
+    for (const auto& documento : resultados) {
+        if (documento.tiempos.totalNs > umbralNs) lentos.push_back(&documento);
+    }
+    sort(lentos.begin(), lentos.end(), [](const ResultadoDocumento* a, const ResultadoDocumento* b) {
+        return a->tiempos.totalNs > b->tiempos.totalNs;
+    });
+
+    ostringstream registro;
+    registro << "# ms\tbytes\ttokens\tfase dominante";
+    for (int fase = 0; fase < NUMERO_FASES_DOCUMENTO; fase++) {
+        registro << "\t" << nombreFaseDocumento(fase);
+    }
+    registro << "\testado\tarchivo\n";
+    for (const ResultadoDocumento* documento : lentos) {
+        const TiemposDocumento& tiempos = documento->tiempos;
+        registro << formatearMs(tiempos.totalNs) << "\t" << documento->estadisticas.bytesEntrada << "\t"
+                 << documento->estadisticas.tokens << "\t" << nombreFaseDocumento(tiempos.faseDominante());
+        for (int fase = 0; fase < NUMERO_FASES_DOCUMENTO; fase++) {
+            registro << "\t" << formatearMs(tiempos.fasesNs[fase]);
+        }
+        registro << "\t" << (documento->exito ? "ok" : "error") << "\t" << documento->archivoEntrada << "\n";
+    }
+    escribirArchivo(archivo, registro.str());
+    return lentos.size();
+}
+
+// -j N / --hilos=N: un entero positivo que quepa en unsigned. Lanza
+// invalid_argument si no lo es (stoul acepta "-1" y lo da la vuelta).
+unsigned leerHilos(const string& texto) {
+    size_t fin = 0;
+    unsigned long valor = 0;
+    if (!texto.empty() && texto[0] != '-' && texto[0] != '+') {
+        valor = stoul(texto, &fin);
+    }
+    if (fin == 0 || fin != texto.size() || valor == 0 || valor > UINT_MAX) {
+        throw invalid_argument(texto);
+    }
+    return static_cast<unsigned>(valor);
+}
+
+int ejecutarLineaComandos(int argc, char* argv[]) {
+    OpcionesLote opciones;
+    string archivoTraza;
+    string directorioActivos;
+    string directorioFormatos;
+    vector<string> archivosMacros;
+    bool generarPdf = false;
+    bool soloVerificar = false;
+    bool medirContadores = false;
+    bool mostrarLatenciasLote = false;
+    double umbralLentosMs = -1.0;
+    string archivoLentos = "lentos.log";
+    OpcionesPdf opcionesPdf;
+    vector<string> archivos;
+
+    for (int i = 1; i < argc; i++) {
+        string argumento = argv[i];
+        if (argumento == "-h" || argumento == "--ayuda") {
+            mostrarUso();
+            return 0;
+        } else if ((argumento == "-j" && i + 1 < argc) || argumento.rfind("--hilos=", 0) == 0) {
+            string valor = argumento == "-j" ? argv[++i] : argumento.substr(8);
+            try {
+                opciones.hilos = leerHilos(valor);
+            } catch (const exception&) {
+                cerr << "Numero de hilos no valido: " << valor << "\n";
+                return 2;
+            }
+        } else if (argumento == "--solo-seccion" && i + 1 < argc) {
+            opciones.soloSeccion = argv[++i];
+        } else if (argumento.rfind("--solo-seccion=", 0) == 0) {
+            opciones.soloSeccion = argumento.substr(15);
+        } else if (argumento.rfind("--trace=", 0) == 0) {
+            archivoTraza = argumento.substr(8);
+        } else if (argumento.rfind("--activos=", 0) == 0) {
+            directorioActivos = argumento.substr(10);
+        } else if (argumento.rfind("--formatos=", 0) == 0) {
+            directorioFormatos = argumento.substr(11);
+        } else if (argumento.rfind("--macros=", 0) == 0) {
+            archivosMacros.push_back(argumento.substr(9));
+        } else if (argumento.rfind("--salidas=", 0) == 0) {
+            stringstream lista(argumento.substr(10));
+            string formato;
+            while (getline(lista, formato, ',')) {
+                if (!esFormatoSalida(formato)) {
+                    cerr << "Formato de salida desconocido: " << formato << "\n";
+                    return 2;
+                }
+                opciones.compilacion.salidasAdicionales.push_back(formato);
+            }
+        } else if (argumento == "--cache-ast") {
+            opciones.compilacion.cacheAst = true;
+        } else if (argumento == "--pdf") {
+            generarPdf = true;
+        } else if (argumento.rfind("--io=", 0) == 0) {
+            try {
+                opciones.motorES = leerTipoMotorES(argumento.substr(5));
+            } catch (const exception& e) {
+                cerr << e.what() << "\n";
+                return 2;
+            }
+        } else if (argumento == "--perf-counters") {
+            medirContadores = true;
+        } else if (argumento == "--latencias") {
+            mostrarLatenciasLote = true;
+        } else if (argumento.rfind("--lentos=", 0) == 0) {
+            // Se pasa a nanosegundos en un uint64_t: nan, inf o un valor
+            // mayor no tienen conversion
+            string valor = argumento.substr(9);
+            size_t fin = 0;
+            try {
+                umbralLentosMs = stod(valor, &fin);
+            } catch (const exception&) {
+                umbralLentosMs = -1.0;
+            }
+            if (fin != valor.size() || !isfinite(umbralLentosMs) || umbralLentosMs < 0.0 ||
+                umbralLentosMs * 1e6 >= static_cast<double>(UINT64_MAX)) {
+                cerr << "Umbral de --lentos no valido: " << valor << "\n";
+                return 2;
+            }
+            mostrarLatenciasLote = true;
+        } else if (argumento.rfind("--registro-lentos=", 0) == 0) {
+            archivoLentos = argumento.substr(18);
+        } else if (argumento == "--check") {
+            soloVerificar = true;
+        } else if (argumento.rfind("--motor=", 0) == 0) {
+            opcionesPdf.motor = argumento.substr(8);
+        } else if (argumento.rfind("--max-memory=", 0) == 0) {
+            try {
+                opciones.compilacion.memoriaMaxima = leerTamanoMemoria(argumento.substr(13));
+            } catch (const exception&) {
+                cerr << "Tamano de memoria no valido: " << argumento.substr(13) << "\n";
+                return 2;
+            }
+        } else if (!argumento.empty() && argumento[0] == '-') {
+            cerr << "Opcion desconocida: " << argumento << "\n";
+            mostrarUso();
+            return 2;
+        } else {
+            archivos.push_back(argumento);
+        }
+    }
+
+    if (archivos.empty()) {
+        mostrarUso();
+        return 2;
+    }
+
+    if (soloVerificar) {
+        return verificarArchivos(archivos, opciones.hilos);
+    }
+
+    vector<string> paquetes;
+    auto finArchivos = stable_partition(archivos.begin(), archivos.end(),
+                                        [](const string& archivo) { return !esArchivoPaquete(archivo); });
+    paquetes.assign(finArchivos, archivos.end());
+    archivos.erase(finArchivos, archivos.end());
+    if (!opciones.soloSeccion.empty() && !paquetes.empty()) {
+        cerr << "--solo-seccion no admite paquetes .tar\n";
+        return 2;
+    }
+    if (generarPdf && !paquetes.empty()) {
+        cerr << "--pdf no admite paquetes .tar: sus .tex no quedan en disco\n";
+        return 2;
+    }
+
+    unique_ptr<Traza> traza;
+    if (!archivoTraza.empty()) {
+        traza = make_unique<Traza>();
+        opciones.compilacion.traza = traza.get();
+    }
+
+    unique_ptr<ContadoresHardware> contadores;
+    if (medirContadores) {
+        contadores = make_unique<ContadoresHardware>();
+        opciones.compilacion.contadores = contadores.get();
+    }
+
+    unique_ptr<AlmacenActivos> activos;
+    if (!directorioActivos.empty()) {
+        activos = make_unique<AlmacenActivos>(directorioActivos, opciones.hilos);
+        opciones.compilacion.activos = activos.get();
+    }
+
+    unique_ptr<CacheFormatos> formatos;
+    if (!directorioFormatos.empty()) {
+        formatos = make_unique<CacheFormatos>(directorioFormatos, resolverMotor(opcionesPdf.motor));
+        opciones.compilacion.formatos = formatos.get();
+        opcionesPdf.directorioFormatos = directorioFormatos;
+    }
+
+    unique_ptr<BibliotecaMacros> macros;
+    if (!archivosMacros.empty()) {
+        macros = make_unique<BibliotecaMacros>();
+        try {
+            for (const auto& archivo : archivosMacros) {
+                macros->cargar(archivo);
+            }
+        } catch (const exception& e) {
+            cerr << "Error: " << e.what() << "\n";
+            return 2;
+        }
+        opciones.compilacion.macros = macros.get();
+    }
+
+    vector<ResultadoDocumento> resultados = compilarLote(archivos, opciones);
+
+    size_t paquetesFallidos = 0;
+    for (const auto& paquete : paquetes) {
+        try {
+            vector<ResultadoDocumento> documentos = compilarPaquete(paquete, nombrePaqueteSalida(paquete), opciones);
+            move(documentos.begin(), documentos.end(), back_inserter(resultados));
+        } catch (const exception& e) {
+            paquetesFallidos++;
+            cout << paquete << ": " << e.what() << "\n";
+        }
+    }
+
+    size_t fallidos = paquetesFallidos;
+    for (const auto& documento : resultados) {
+        if (documento.exito) {
+            cout << documento.archivoEntrada << " -> " << documento.archivoSalida;
+            for (const auto& adicional : documento.archivosAdicionales) {
+                cout << ", " << adicional;
+            }
+            if (documento.estadisticas.filasTabla > 0) {
+                cout << " (" << documento.estadisticas.filasTabla << " filas de tabla, "
+                     << static_cast<long long>(documento.estadisticas.filasTablaPorSegundo)
+                     << " filas/s)";
+            }
+            cout << "\n";
+        } else {
+            fallidos++;
+            cout << documento.archivoEntrada << ": la compilacion fallo\n";
+        }
+        for (const auto& diagnostico : documento.diagnosticos) {
+            cout << "  " << diagnostico.toString() << "\n";
+        }
+    }
+    cout << (resultados.size() + paquetesFallidos - fallidos) << " de " << resultados.size()
+         << " documentos compilados.\n";
+
+    // El documento que mas memoria uso, fase por fase
+    const ResultadoDocumento* mayor = nullptr;
+    for (const auto& documento : resultados) {
+        if (mayor == nullptr || documento.estadisticas.memoriaPico > mayor->estadisticas.memoriaPico) {
+            mayor = &documento;
+        }
+    }
+    cout << "Memoria: pico residente " << formatearBytes(memoriaResidentePico());
+    if (mayor != nullptr && mayor->estadisticas.memoriaPico > 0) {
+        const EstadisticasCompilacion& e = mayor->estadisticas;
+        cout << "; " << mayor->archivoEntrada << " (lexico " << formatearBytes(e.memoriaLexico)
+             << ", sintaxis " << formatearBytes(e.memoriaSintaxis) << ", AST "
+             << formatearBytes(e.memoriaAST) << ", generacion " << formatearBytes(e.memoriaGeneracion) << ")";
+    }
+    cout << "\n";
+
+    if (mostrarLatenciasLote) {
+        mostrarLatencias(resultados);
+    }
+
+    if (umbralLentosMs >= 0.0) {
+        try {
+            size_t lentos = escribirRegistroLentos(resultados, static_cast<uint64_t>(umbralLentosMs * 1e6),
+                                                   archivoLentos);
+            cout << "Documentos lentos: " << lentos << " de " << resultados.size() << " tardaron mas de "
+                 << umbralLentosMs << " ms (" << archivoLentos << ")\n";
+        } catch (const exception& e) {
+            cerr << "Error: " << e.what() << "\n";
+        }
+    }
+
+    if (contadores) {
+        mostrarContadores(*contadores);
+    }
+
+    if (activos) {
+        try {
+            activos->guardarCache();
+        } catch (const exception& e) {
+            cerr << "Error: " << e.what() << "\n";
+        }
+        EstadisticasActivos estadisticas = activos->getEstadisticas();
+        cout << "Activos: " << estadisticas.resueltos << " figuras, "
+             << estadisticas.desdeCache << " sin cambios, " << estadisticas.hasheados
+             << " hasheadas (" << estadisticas.bytesHasheados << " bytes), "
+             << estadisticas.clonados << " clonadas, " << estadisticas.copiados << " copiadas\n";
+    }
+
+    if (macros) {
+        EstadisticasMacros estadisticas = macros->getEstadisticas();
+        cout << "Macros: " << estadisticas.macros << " definidas, " << estadisticas.usos << " usos, "
+             << estadisticas.desdeMemoria << " desde la memoria de expansiones\n";
+    }
+
+    if (formatos) {
+        EstadisticasFormatos estadisticas = formatos->getEstadisticas();
+        cout << "Formatos: " << estadisticas.variantes << " preambulos distintos, "
+             << estadisticas.desdeCache << " ya precompilados, " << estadisticas.construidos
+             << " construidos, " << estadisticas.fallidos << " fallidos\n";
+        if (!estadisticas.ultimoError.empty()) {
+            cout << "  " << estadisticas.ultimoError << "\n";
+        }
+    }
+
+    if (generarPdf) {
+        vector<TrabajoPdf> trabajos;
+        for (const auto& documento : resultados) {
+            if (documento.exito) {
+                trabajos.push_back(TrabajoPdf{documento.archivoSalida, documento.dependencias});
+            }
+        }
+        opcionesPdf.trabajos = opciones.hilos;
+        vector<ResultadoPdf> pdfs = generarPdfs(trabajos, opcionesPdf);
+
+        size_t generados = 0, alDia = 0;
+        for (const auto& pdf : pdfs) {
+            cout << fixed << setprecision(2);
+            switch (pdf.estado) {
+                case EstadoPdf::GENERADO:
+                    generados++;
+                    cout << pdf.archivoTex << " -> " << pdf.archivoPdf << " (" << pdf.segundos << " s)\n";
+                    break;
+                case EstadoPdf::AL_DIA:
+                    alDia++;
+                    cout << pdf.archivoPdf << ": al dia\n";
+                    break;
+                case EstadoPdf::FALLIDO:
+                    fallidos++;
+                    cout << pdf.archivoTex << ": el PDF fallo (" << pdf.segundos << " s): " << pdf.error << "\n";
+                    break;
+            }
+        }
+        cout << "PDF: " << generados << " generados, " << alDia << " al dia, "
+             << (pdfs.size() - generados - alDia) << " fallidos.\n";
+    }
+
+    if (traza) {
+        try {
+            traza->escribir(archivoTraza);
+            cout << "Traza escrita en " << archivoTraza << "\n";
+        } catch (const exception& e) {
+            cerr << "Error: " << e.what() << "\n";
+        }
+    }
+
+    return fallidos == 0 ? 0 : 1;
+}
+
 // ===============================
 // FUNCION PRINCIPAL
 // ===============================
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        return ejecutarLineaComandos(argc, argv);
+    }
+
     cout << "COMPILADOR LATEX EN ESPANOL v3\n";
     cout << "   Con analisis lexico y sintactico aceptable xd\n";
     
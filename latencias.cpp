@@ -0,0 +1,92 @@
+#include "latencias.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+const char* nombreFaseDocumento(int fase) {
+    switch (fase) {
+        case FASE_LECTURA: return "lectura";
+        case FASE_LEXICO: return "lexico";
+        case FASE_SINTAXIS: return "sintaxis";
+        case FASE_ANALISIS: return "analisis";
+        case FASE_GENERACION: return "generacion";
+        case FASE_ESCRITURA: return "escritura";
+        default: return "?";
+    }
+}
+
+int TiemposDocumento::faseDominante() const {
+    return static_cast<int>(max_element(fasesNs, fasesNs + NUMERO_FASES_DOCUMENTO) - fasesNs);
+}
+
+namespace {
+
+// Los valores menores que 2 * SUBCUBETAS tienen una cubeta cada uno; de ahi
+// en adelante, cada potencia de dos se parte en SUBCUBETAS cubetas iguales.
+const int BITS_SUBCUBETA = 6;
+const uint64_t SUBCUBETAS = uint64_t(1) << BITS_SUBCUBETA;
+const size_t NUMERO_CUBETAS = 2 * SUBCUBETAS + (64 - BITS_SUBCUBETA - 1) * SUBCUBETAS;
+
+int bitsSignificativos(uint64_t valor) {
+    int bits = 0;
+    while (valor != 0) {
+        valor >>= 1;
+        bits++;
+    }
+    return bits;
+}
+
+size_t indiceCubeta(uint64_t valor) {
+    if (valor < 2 * SUBCUBETAS) return static_cast<size_t>(valor);
+    // valor >> desplazamiento queda en [SUBCUBETAS, 2 * SUBCUBETAS)
+    int desplazamiento = bitsSignificativos(valor) - BITS_SUBCUBETA - 1;
+    return static_cast<size_t>(2 * SUBCUBETAS + (desplazamiento - 1) * SUBCUBETAS +
+                               ((valor >> desplazamiento) - SUBCUBETAS));
+}
+
+// Mayor valor que cae en la cubeta.
+uint64_t bordeSuperior(size_t indice) {
+    if (indice < 2 * SUBCUBETAS) return indice;
+    size_t resto = indice - 2 * SUBCUBETAS;
+    int desplazamiento = static_cast<int>(resto / SUBCUBETAS) + 1;
+    uint64_t mantisa = resto % SUBCUBETAS + SUBCUBETAS;
+    return ((mantisa + 1) << desplazamiento) - 1;
+}
+
+} // namespace
+
+HistogramaLatencias::HistogramaLatencias() : cubetas(NUMERO_CUBETAS, 0) {}
+
+void HistogramaLatencias::registrar(uint64_t valorNs) {
+    cubetas[indiceCubeta(valorNs)]++;
+    cantidad++;
+    suma += valorNs;
+    minimo = min(minimo, valorNs);
+    maximo = max(maximo, valorNs);
+}
+
+void HistogramaLatencias::combinar(const HistogramaLatencias& otro) {
+    for (size_t i = 0; i < NUMERO_CUBETAS; i++) {
+        cubetas[i] += otro.cubetas[i];
+    }
+    cantidad += otro.cantidad;
+    suma += otro.suma;
+    minimo = min(minimo, otro.minimo);
+    maximo = max(maximo, otro.maximo);
+}
+
+uint64_t HistogramaLatencias::percentil(double percentil) const {
+    if (cantidad == 0) return 0;
+    percentil = min(max(percentil, 0.0), 100.0);
+    uint64_t objetivo = max<uint64_t>(1, static_cast<uint64_t>(ceil(percentil / 100.0 * cantidad)));
+    uint64_t acumulado = 0;
+    for (size_t i = 0; i < NUMERO_CUBETAS; i++) {
+        acumulado += cubetas[i];
+        if (acumulado >= objetivo) {
+            return min(bordeSuperior(i), maximo);
+        }
+    }
+    return maximo;
+}
@@ -0,0 +1,101 @@
+#ifndef LATENCIAS_H
+#define LATENCIAS_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// ===============================
+// LATENCIAS POR DOCUMENTO (--latencias, --lentos)
+// ===============================
+//
+// En un lote de miles de archivos el total dice que algo tarda, no que.
+// Cada documento registra cuanto tardo en total y en cada fase; al terminar
+// el lote se resumen en histogramas (p50, p90, p99, maximo) y los que pasan
+// de un umbral van al registro de lentos con su tamano, sus tokens y la
+// fase que se llevo mas tiempo.
+
+enum FaseDocumento {
+    FASE_LECTURA,    // leer el .texes (o esperar la lectura por adelantado)
+    FASE_LEXICO,
+    FASE_SINTAXIS,   // automata, AST y expansion de macros
+    FASE_ANALISIS,   // referencias, bibliografia, formulas y cache del AST
+    FASE_GENERACION, // LaTeX y salidas adicionales
+    FASE_ESCRITURA,  // escribir las salidas (o entregarlas al motor de E/S)
+    NUMERO_FASES_DOCUMENTO
+};
+
+const char* nombreFaseDocumento(int fase);
+
+// Nanosegundos de un documento. 'totalNs' incluye lo que no es de ninguna
+// fase (esperar memoria con --max-memory, armar el resultado).
+struct TiemposDocumento {
+    uint64_t fasesNs[NUMERO_FASES_DOCUMENTO] = {};
+    uint64_t totalNs = 0;
+
+    // La fase mas larga.
+    int faseDominante() const;
+};
+
+// Histograma de latencias al estilo de HdrHistogram: cubetas log-lineales
+// con 64 subcubetas por potencia de dos, asi que cualquier percentil se da
+// con un error relativo menor que 1/64 (~1.6%) sin guardar las muestras,
+// desde 1 ns hasta el maximo de uint64_t, en unos 30 KB.
+class HistogramaLatencias {
+private:
+    vector<uint64_t> cubetas;
+    uint64_t cantidad = 0;
+    uint64_t suma = 0;
+    uint64_t minimo = UINT64_MAX;
+    uint64_t maximo = 0;
+
+public:
+    HistogramaLatencias();
+
+    void registrar(uint64_t valorNs);
+
+    // Suma las muestras de otro histograma (p. ej. el de otro hilo).
+    void combinar(const HistogramaLatencias& otro);
+
+    // Menor valor tal que al menos 'percentil'% de las muestras no lo
+    // superan (redondeado al borde superior de su cubeta y nunca mayor que
+    // el maximo). 0 si no hay muestras.
+    uint64_t percentil(double percentil) const;
+
+    uint64_t getCantidad() const {
+        return cantidad;
+    }
+    uint64_t getMinimo() const {
+        return cantidad == 0 ? 0 : minimo;
+    }
+    uint64_t getMaximo() const {
+        return maximo;
+    }
+    double media() const {
+        return cantidad == 0 ? 0.0 : static_cast<double>(suma) / cantidad;
+    }
+};
+
+// Suma a 'destinoNs' los nanosegundos que pasan desde su construccion
+// hasta su destruccion.
+class MedicionTiempo {
+private:
+    uint64_t& destinoNs;
+    chrono::steady_clock::time_point inicio;
+
+public:
+    explicit MedicionTiempo(uint64_t& destinoNs) : destinoNs(destinoNs), inicio(chrono::steady_clock::now()) {}
+
+    MedicionTiempo(const MedicionTiempo&) = delete;
+    MedicionTiempo& operator=(const MedicionTiempo&) = delete;
+
+    ~MedicionTiempo() {
+        destinoNs += static_cast<uint64_t>(
+            chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - inicio).count());
+    }
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include "lector_csv.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+bool LectorCsv::siguienteFila(vector<string>& celdas, size_t& numeroCeldas) {
+    numeroCeldas = 0;
+    if (posicion >= datos.size()) {
+        return false;
+    }
+
+    while (true) {
+        if (numeroCeldas == celdas.size()) {
+            celdas.emplace_back();
+        }
+        string& celda = celdas[numeroCeldas++];
+        celda.clear();
+
+        // Campo entre comillas: puede contener separadores y saltos de linea
+        if (posicion < datos.size() && datos[posicion] == '"') {
+            posicion++;
+            while (posicion < datos.size()) {
+                size_t fin = datos.find('"', posicion);
+                if (fin == string_view::npos) {
+                    celda.append(datos.substr(posicion));
+                    posicion = datos.size();
+                    break;
+                }
+                celda.append(datos.substr(posicion, fin - posicion));
+                posicion = fin + 1;
+                if (posicion < datos.size() && datos[posicion] == '"') {
+                    celda += '"';
+                    posicion++;
+                } else {
+                    break;
+                }
+            }
+        }
+
+        // Resto del campo sin comillas
+        size_t inicio = posicion;
+        while (posicion < datos.size()) {
+            char c = datos[posicion];
+            if (c == separador || c == '\n' || c == '\r') break;
+            posicion++;
+        }
+        celda.append(datos.substr(inicio, posicion - inicio));
+
+        if (posicion >= datos.size()) {
+            return true;
+        }
+        if (datos[posicion] == separador) {
+            posicion++;
+            continue;
+        }
+
+        // Fin de fila: \n, \r\n o \r
+        if (datos[posicion] == '\r') posicion++;
+        if (posicion < datos.size() && datos[posicion] == '\n') posicion++;
+        return true;
+    }
+}
+
+OpcionesTablaCsv leerOpcionesTablaCsv(const vector<string>& opciones) {
+    OpcionesTablaCsv resultado;
+    for (const auto& opcion : opciones) {
+        size_t igual = opcion.find('=');
+        string clave = opcion.substr(0, igual);
+        string valor = igual == string::npos ? "" : opcion.substr(igual + 1);
+        if (clave == "separador" && valor == "tab") {
+            resultado.separador = '\t';
+        } else if (clave == "separador" && valor.size() == 1) {
+            resultado.separador = valor[0];
+        } else if (clave == "encabezado") {
+            resultado.encabezado = valor != "no";
+        } else if (clave == "columnas") {
+            resultado.columnas = valor;
+        } else {
+            throw runtime_error("Opcion no valida en tabla_csv: " + opcion);
+        }
+    }
+    return resultado;
+}
+
+void escaparLatex(string_view texto, string& salida) {
+    for (char c : texto) {
+        switch (c) {
+            case '&': case '%': case '$': case '#': case '_': case '{': case '}':
+                salida += '\\';
+                salida += c;
+                break;
+            case '\\': salida += "\\textbackslash{}"; break;
+            case '~': salida += "\\textasciitilde{}"; break;
+            case '^': salida += "\\textasciicircum{}"; break;
+            case '\n': case '\r': salida += ' '; break;
+            default: salida += c; break;
+        }
+    }
+}
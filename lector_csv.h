@@ -0,0 +1,56 @@
+#ifndef LECTOR_CSV_H
+#define LECTOR_CSV_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// ===============================
+// LECTOR CSV INCREMENTAL
+// ===============================
+//
+// Recorre un CSV (RFC 4180: campos entre comillas, "" como comilla escapada,
+// saltos de linea dentro de comillas, CRLF) fila a fila sobre una vista del
+// archivo. Solo vive en memoria la fila actual y las celdas se reutilizan
+// entre filas, asi que el consumo no depende del numero de filas.
+
+class LectorCsv {
+private:
+    string_view datos;
+    size_t posicion;
+    char separador;
+
+public:
+    LectorCsv(string_view d, char sep = ',') : datos(d), posicion(0), separador(sep) {
+        // Saltar la marca BOM de UTF-8 que agregan algunas exportaciones.
+        if (datos.substr(0, 3) == "\xEF\xBB\xBF") {
+            posicion = 3;
+        }
+    }
+
+    // Llena 'celdas' con la siguiente fila; devuelve false al final.
+    bool siguienteFila(vector<string>& celdas, size_t& numeroCeldas);
+
+    size_t bytesLeidos() const {
+        return posicion;
+    }
+};
+
+// Opciones "clave=valor" de tabla_csv: separador (un caracter o "tab"),
+// encabezado ("no" para desactivarlo) y columnas (especificacion LaTeX).
+struct OpcionesTablaCsv {
+    char separador = ',';
+    bool encabezado = true;
+    string columnas;
+};
+
+// Lanza runtime_error ante una opcion desconocida.
+OpcionesTablaCsv leerOpcionesTablaCsv(const vector<string>& opciones);
+
+// Escapa los caracteres especiales de LaTeX en el texto de una celda.
+void escaparLatex(string_view texto, string& salida);
+
+#endif
@@ -0,0 +1,357 @@
+#include "lote.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "cache_ast.h"
+#include "contadores.h"
+#include "indice_secciones.h"
+#include "memoria.h"
+#include "paquete.h"
+#include "traza.h"
+
+using namespace std;
+
+string nombreArchivoSalida(const string& archivoEntrada) {
+    return archivoEntrada.substr(0, archivoEntrada.find(".texes")) + ".tex";
+}
+
+namespace {
+
+// Un archivo producido por un documento: el .tex y las salidas adicionales
+struct ArchivoGenerado {
+    string nombre;
+    string contenido;
+    bool binario = false;
+};
+
+vector<ArchivoGenerado> archivosGenerados(ResultadoCompilacion& resultado, const string& archivoSalida,
+                                          vector<string>& archivosAdicionales) {
+    vector<ArchivoGenerado> archivos;
+    if (!resultado.latexVolcado) {
+        archivos.push_back(ArchivoGenerado{archivoSalida, move(resultado.latex)});
+    }
+    for (auto& salida : resultado.salidasAdicionales) {
+        string nombre = filesystem::path(archivoSalida).replace_extension(salida.extension).string();
+        archivos.push_back(ArchivoGenerado{nombre, move(salida.contenido)});
+        archivosAdicionales.push_back(nombre);
+    }
+    if (!resultado.cacheAst.empty()) {
+        string nombre = nombreArchivoCacheAst(archivoSalida);
+        archivos.push_back(ArchivoGenerado{nombre, move(resultado.cacheAst), true});
+        archivosAdicionales.push_back(nombre);
+    }
+    return archivos;
+}
+
+void copiarTiempos(const EstadisticasCompilacion& estadisticas, TiemposDocumento& tiempos) {
+    tiempos.fasesNs[FASE_LEXICO] = estadisticas.lexicoNs;
+    tiempos.fasesNs[FASE_SINTAXIS] = estadisticas.sintaxisNs;
+    tiempos.fasesNs[FASE_ANALISIS] = estadisticas.analisisNs;
+    tiempos.fasesNs[FASE_GENERACION] = estadisticas.generacionNs;
+}
+
+// Con --max-memory, el documento espera a que quepa su analisis en el
+// presupuesto comun antes de leerse
+struct Reserva {
+    PresupuestoMemoria* presupuesto;
+    size_t bytes = 0;
+
+    Reserva(PresupuestoMemoria* presupuesto, size_t bytesEntrada, Traza* traza) : presupuesto(presupuesto) {
+        if (presupuesto != nullptr) {
+            SpanTraza span(traza, "esperarMemoria");
+            bytes = presupuesto->reservar(min(memoriaPrevistaAnalisis(bytesEntrada), presupuesto->getLimite()));
+        }
+    }
+    ~Reserva() {
+        if (presupuesto != nullptr) presupuesto->liberar(bytes);
+    }
+};
+
+// Con 'motor', el documento 'indice' se lee y se escribe a traves de el; si
+// no se pidio su lectura por adelantado, se pide despues de reservar
+// memoria.
+void compilarDocumento(const string& archivo, const OpcionesLote& opciones, ContextoCompilacion& contexto,
+                       PresupuestoMemoria* presupuesto, MotorEntradaSalida* motor, size_t indice,
+                       bool leidoPorAdelantado, ResultadoDocumento& documento) {
+    Traza* traza = opciones.compilacion.traza;
+    MedicionTiempo tiempoTotal(documento.tiempos.totalNs);
+    documento.archivoEntrada = archivo;
+    documento.archivoSalida = opciones.soloSeccion.empty() ? nombreArchivoSalida(archivo)
+                                                           : nombreArchivoSeccion(archivo);
+
+    FragmentoSeccion fragmento;
+    try {
+        error_code error;
+        uintmax_t bytesEntrada = presupuesto != nullptr ? filesystem::file_size(archivo, error) : 0;
+        Reserva reserva(presupuesto, error ? 0 : static_cast<size_t>(bytesEntrada), traza);
+
+        string entrada;
+        if (!opciones.soloSeccion.empty()) {
+            // Solo los tramos del .texes que necesita la seccion
+            SpanTraza span(traza, "extraerSeccion");
+            MedicionTiempo tiempo(documento.tiempos.fasesNs[FASE_LECTURA]);
+            fragmento = extraerSeccion(archivo, opciones.soloSeccion);
+            entrada = move(fragmento.texto);
+            span.argumento("bytes", static_cast<long long>(entrada.size()));
+            span.argumento("indiceReconstruido", fragmento.indiceReconstruido ? 1 : 0);
+        } else if (motor != nullptr) {
+            if (!leidoPorAdelantado) motor->leer(indice, archivo);
+            SpanTraza span(traza, "esperarLectura");
+            MedicionTiempo tiempo(documento.tiempos.fasesNs[FASE_LECTURA]);
+            entrada = motor->esperarLectura(indice);
+            span.argumento("bytes", static_cast<long long>(entrada.size()));
+        } else {
+            SpanTraza span(traza, "leerArchivo");
+            MedicionTiempo tiempo(documento.tiempos.fasesNs[FASE_LECTURA]);
+            entrada = leerArchivo(archivo);
+            span.argumento("bytes", static_cast<long long>(entrada.size()));
+        }
+
+        OpcionesCompilacion opcionesDocumento = opciones.compilacion;
+        opcionesDocumento.directorioBase = filesystem::path(archivo).parent_path().string();
+        if (opcionesDocumento.memoriaMaxima != 0) {
+            opcionesDocumento.archivoVolcado = documento.archivoSalida + ".parcial";
+        }
+
+        ResultadoCompilacion resultado = contexto.compilar(entrada, opcionesDocumento);
+        documento.diagnosticos = move(resultado.diagnosticos);
+        fragmento.corregirLineas(documento.diagnosticos);
+        documento.estadisticas = resultado.estadisticas;
+        documento.dependencias = move(resultado.dependencias);
+        copiarTiempos(resultado.estadisticas, documento.tiempos);
+        if (!resultado.exito) {
+            return;
+        }
+
+        MedicionTiempo tiempoEscritura(documento.tiempos.fasesNs[FASE_ESCRITURA]);
+        if (resultado.latexVolcado) {
+            // Generado por bloques directamente en disco
+            filesystem::rename(opcionesDocumento.archivoVolcado, documento.archivoSalida);
+        }
+        for (auto& generado : archivosGenerados(resultado, documento.archivoSalida, documento.archivosAdicionales)) {
+            if (motor != nullptr) {
+                motor->escribir(indice, generado.nombre, move(generado.contenido), generado.binario);
+                continue;
+            }
+            SpanTraza span(traza, "escribirArchivo");
+            if (generado.binario) {
+                ofstream archivo(generado.nombre, ios::binary);
+                if (!archivo.is_open()) {
+                    throw runtime_error("No se pudo crear el archivo: " + generado.nombre);
+                }
+                archivo.write(generado.contenido.data(), static_cast<streamsize>(generado.contenido.size()));
+            } else {
+                escribirArchivo(generado.nombre, generado.contenido);
+            }
+            span.argumento("bytes", static_cast<long long>(generado.contenido.size()));
+        }
+        documento.exito = true;
+    } catch (const exception& e) {
+        documento.diagnosticos.emplace_back(Severidad::ERROR, 0, 0, e.what());
+    }
+}
+
+// Reparte los indices [0, total) entre los hilos trabajadores; el hilo que
+// llama es uno de ellos. Cada trabajador tiene su ContextoCompilacion, que
+// reutiliza en todos sus documentos. Con contadores de hardware, cada
+// trabajador mide todo lo que hace ("trabajador N"); 'tarea(i, contexto)'
+// devuelve los bytes de entrada que proceso.
+template <typename Tarea>
+void repartir(size_t total, const OpcionesLote& opciones, Tarea tarea) {
+    unsigned hilos = opciones.hilos != 0 ? opciones.hilos : thread::hardware_concurrency();
+    hilos = max(1u, min<unsigned>(hilos, static_cast<unsigned>(min<size_t>(total, UINT_MAX))));
+
+    atomic<size_t> siguiente(0);
+    auto trabajador = [&](unsigned numero) {
+        if (opciones.compilacion.traza != nullptr) {
+            opciones.compilacion.traza->nombrarHilo("trabajador " + to_string(numero));
+        }
+        MedicionHardware medicion(opciones.compilacion.contadores, "trabajador " + to_string(numero));
+        ContextoCompilacion contexto;
+        size_t bytes = 0;
+        for (size_t i = siguiente++; i < total; i = siguiente++) {
+            bytes += tarea(i, contexto);
+        }
+        medicion.bytes(bytes);
+    };
+
+    vector<thread> trabajadores;
+    for (unsigned i = 1; i < hilos; i++) {
+        trabajadores.emplace_back(trabajador, i + 1);
+    }
+    trabajador(1);
+
+    for (auto& t : trabajadores) {
+        t.join();
+    }
+}
+
+} // namespace
+
+vector<ResultadoDocumento> compilarLote(const vector<string>& archivos, const OpcionesLote& opciones) {
+    vector<ResultadoDocumento> resultados(archivos.size());
+
+    unique_ptr<PresupuestoMemoria> presupuesto;
+    if (opciones.compilacion.memoriaMaxima != 0) {
+        presupuesto = make_unique<PresupuestoMemoria>(opciones.compilacion.memoriaMaxima);
+    }
+
+    // Lectura por adelantado: al tomar el documento i se pide el
+    // i + ventana. Con --max-memory no se lee nada antes de reservar, y con
+    // soloSeccion cada documento lee solo sus tramos.
+    unsigned hilos = opciones.hilos != 0 ? opciones.hilos : thread::hardware_concurrency();
+    unsigned enVuelo = max(8u, 4 * max(1u, hilos));
+    unique_ptr<MotorEntradaSalida> motor;
+    if (!archivos.empty()) {
+        motor = crearMotorEntradaSalida(opciones.motorES, enVuelo);
+    }
+    bool porAdelantado = motor && !presupuesto && opciones.soloSeccion.empty();
+    size_t ventana = porAdelantado ? min<size_t>(archivos.size(), enVuelo) : 0;
+    for (size_t i = 0; i < ventana; i++) {
+        motor->leer(i, archivos[i]);
+    }
+
+    repartir(archivos.size(), opciones, [&](size_t i, ContextoCompilacion& contexto) {
+        if (ventana > 0 && i + ventana < archivos.size()) {
+            motor->leer(i + ventana, archivos[i + ventana]);
+        }
+        SpanTraza span(opciones.compilacion.traza, "documento");
+        compilarDocumento(archivos[i], opciones, contexto, presupuesto.get(), motor.get(), i, ventana > 0,
+                          resultados[i]);
+        span.argumento("bytes", static_cast<long long>(resultados[i].estadisticas.bytesEntrada));
+        span.argumento("tokens", static_cast<long long>(resultados[i].estadisticas.tokens));
+        return resultados[i].estadisticas.bytesEntrada;
+    });
+
+    if (motor) {
+        SpanTraza span(opciones.compilacion.traza, "esperarEscrituras");
+        for (auto& error : motor->terminarEscrituras()) {
+            resultados[error.first].exito = false;
+            resultados[error.first].diagnosticos.emplace_back(Severidad::ERROR, 0, 0, error.second);
+        }
+    }
+
+    return resultados;
+}
+
+vector<ResultadoDocumento> compilarPaquete(const string& paqueteEntrada, const string& paqueteSalida,
+                                           const OpcionesLote& opciones) {
+    Traza* traza = opciones.compilacion.traza;
+
+    unique_ptr<LectorPaquete> lector;
+    vector<const EntradaPaquete*> documentos;
+    {
+        SpanTraza span(traza, "leerPaquete");
+        lector = make_unique<LectorPaquete>(paqueteEntrada);
+        for (const auto& entrada : lector->getEntradas()) {
+            if (entrada.nombre.size() > 6 && entrada.nombre.compare(entrada.nombre.size() - 6, 6, ".texes") == 0) {
+                documentos.push_back(&entrada);
+            }
+        }
+        span.argumento("documentos", static_cast<long long>(documentos.size()));
+    }
+
+    vector<ResultadoDocumento> resultados(documentos.size());
+    EscritorPaquete escritor(paqueteSalida);
+
+    unique_ptr<PresupuestoMemoria> presupuesto;
+    if (opciones.compilacion.memoriaMaxima != 0) {
+        presupuesto = make_unique<PresupuestoMemoria>(opciones.compilacion.memoriaMaxima);
+    }
+
+    // Las salidas se escriben en el orden del paquete de entrada: lo que
+    // termina antes que un documento anterior espera en 'pendientes'.
+    mutex cerrojo;
+    vector<vector<ArchivoGenerado>> pendientes(documentos.size());
+    vector<bool> terminados(documentos.size(), false);
+    size_t siguienteEscritura = 0;
+    exception_ptr errorEscritura;
+
+    // Las rutas relativas (tabla_csv, figura) se resuelven como si el
+    // paquete estuviera extraido en su carpeta
+    filesystem::path carpetaPaquete = filesystem::path(paqueteEntrada).parent_path();
+
+    repartir(documentos.size(), opciones, [&](size_t i, ContextoCompilacion& contexto) {
+        SpanTraza span(traza, "documento");
+        const EntradaPaquete& entrada = *documentos[i];
+        ResultadoDocumento& documento = resultados[i];
+        MedicionTiempo tiempoTotal(documento.tiempos.totalNs);
+        string nombreSalida = nombreArchivoSalida(entrada.nombre);
+        documento.archivoEntrada = paqueteEntrada + ":" + entrada.nombre;
+        documento.archivoSalida = paqueteSalida + ":" + nombreSalida;
+
+        vector<ArchivoGenerado> generados;
+        try {
+            Reserva reserva(presupuesto.get(), entrada.contenido.size(), traza);
+
+            OpcionesCompilacion opcionesDocumento = opciones.compilacion;
+            opcionesDocumento.directorioBase = (carpetaPaquete / filesystem::path(entrada.nombre).parent_path()).string();
+
+            ResultadoCompilacion resultado = contexto.compilar(entrada.contenido, opcionesDocumento);
+            documento.diagnosticos = move(resultado.diagnosticos);
+            documento.estadisticas = resultado.estadisticas;
+            documento.dependencias = move(resultado.dependencias);
+            copiarTiempos(resultado.estadisticas, documento.tiempos);
+            if (resultado.exito) {
+                vector<string> adicionales;
+                generados = archivosGenerados(resultado, nombreSalida, adicionales);
+                for (const auto& adicional : adicionales) {
+                    documento.archivosAdicionales.push_back(paqueteSalida + ":" + adicional);
+                }
+                documento.exito = true;
+            }
+        } catch (const exception& e) {
+            documento.diagnosticos.emplace_back(Severidad::ERROR, 0, 0, e.what());
+        }
+        if (!documento.exito) {
+            // Sin .tex: los diagnosticos viajan en el paquete de salida
+            string errores;
+            for (const auto& diagnostico : documento.diagnosticos) {
+                errores += diagnostico.toString() + "\n";
+            }
+            generados.push_back(ArchivoGenerado{nombreSalida.substr(0, nombreSalida.size() - 4) + ".errores", errores});
+        }
+        span.argumento("bytes", static_cast<long long>(entrada.contenido.size()));
+        span.argumento("tokens", static_cast<long long>(documento.estadisticas.tokens));
+
+        lock_guard<mutex> bloqueo(cerrojo);
+        pendientes[i] = move(generados);
+        terminados[i] = true;
+        if (errorEscritura) return entrada.contenido.size();
+        try {
+            // Escribe tambien las salidas de los anteriores que lo esperaban
+            SpanTraza spanEscritura(traza, "escribirPaquete");
+            MedicionTiempo tiempoEscritura(documento.tiempos.fasesNs[FASE_ESCRITURA]);
+            size_t bytes = 0;
+            for (; siguienteEscritura < documentos.size() && terminados[siguienteEscritura]; siguienteEscritura++) {
+                for (const auto& generado : pendientes[siguienteEscritura]) {
+                    escritor.agregar(generado.nombre, generado.contenido, documentos[siguienteEscritura]->fecha);
+                    bytes += generado.contenido.size();
+                }
+                pendientes[siguienteEscritura] = vector<ArchivoGenerado>();
+            }
+            spanEscritura.argumento("bytes", static_cast<long long>(bytes));
+        } catch (const exception&) {
+            errorEscritura = current_exception();
+        }
+        return entrada.contenido.size();
+    });
+
+    if (errorEscritura) {
+        rethrow_exception(errorEscritura);
+    }
+    {
+        SpanTraza span(traza, "escribirPaquete");
+        escritor.cerrar();
+    }
+    return resultados;
+}
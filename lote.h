@@ -0,0 +1,68 @@
+#ifndef LOTE_H
+#define LOTE_H
+
+#include <string>
+#include <vector>
+
+#include "compilador.h"
+#include "entrada_salida.h"
+#include "latencias.h"
+
+using namespace std;
+
+// ===============================
+// COMPILACION POR LOTES
+// ===============================
+
+struct OpcionesLote {
+    // Numero de hilos trabajadores; 0 usa hardware_concurrency().
+    unsigned hilos = 0;
+
+    // Como se leen los .texes y se escriben las salidas (entrada_salida.h).
+    // Con un motor asincrono se leen por adelantado los documentos que
+    // vienen y las escrituras terminan en segundo plano; un error de
+    // escritura hace fallar el documento.
+    TipoMotorES motorES = TipoMotorES::AUTOMATICO;
+
+    // Si no esta vacio, de cada archivo se compila solo la seccion o el
+    // capitulo con este titulo, leido a traves del indice de secciones
+    // (indice_secciones.h), y la salida es "doc.seccion.tex".
+    string soloSeccion;
+
+    OpcionesCompilacion compilacion;
+};
+
+struct ResultadoDocumento {
+    string archivoEntrada;
+    string archivoSalida;
+    vector<string> archivosAdicionales; // .html, .md, .texast... junto al .tex
+    bool exito = false;
+    vector<Diagnostico> diagnosticos;
+    EstadisticasCompilacion estadisticas;
+    vector<string> dependencias;
+    // Cuanto tardo el documento en el hilo trabajador, por fase. Con un
+    // motor de E/S asincrono, la lectura es lo que se espero por ella y la
+    // escritura lo que costo entregar las salidas al motor.
+    TiemposDocumento tiempos;
+};
+
+// "doc.texes" -> "doc.tex"
+string nombreArchivoSalida(const string& archivoEntrada);
+
+// Compila cada archivo en un hilo trabajador. El resultado conserva el
+// orden de 'archivos'.
+vector<ResultadoDocumento> compilarLote(const vector<string>& archivos, const OpcionesLote& opciones);
+
+// Compila en paralelo cada .texes de un tar sin comprimir (paquete.h) y
+// escribe sus salidas en otro tar, en el orden del de entrada: un documento
+// que falla deja "doc.errores" con sus diagnosticos en lugar de "doc.tex".
+// Los nombres de ResultadoDocumento son "paquete.tar:ruta/doc.texes". Las
+// rutas de tabla_csv y figura se resuelven como si el paquete estuviera
+// extraido en su carpeta. Con memoriaMaxima, una salida que no cabe hace
+// fallar el documento (no hay volcado a disco).
+// Lanza runtime_error si no se puede leer el paquete de entrada o escribir
+// el de salida.
+vector<ResultadoDocumento> compilarPaquete(const string& paqueteEntrada, const string& paqueteSalida,
+                                           const OpcionesLote& opciones);
+
+#endif
@@ -0,0 +1,360 @@
+#include "macros.h"
+
+#include <cctype>
+#include <stdexcept>
+
+#include "analizador_lexico.h"
+#include "compilador.h"
+#include "memoria.h"
+#include "validador_matematicas.h"
+
+using namespace std;
+
+namespace {
+
+// Copia de una sentencia del arbol, con sus elementos si es una lista.
+unique_ptr<NodoAST> clonarNodo(const NodoAST* nodo) {
+    if (auto n = dynamic_cast<const NodoConfiguracion*>(nodo)) return make_unique<NodoConfiguracion>(*n);
+    if (auto n = dynamic_cast<const NodoSeccion*>(nodo)) return make_unique<NodoSeccion>(*n);
+    if (auto n = dynamic_cast<const NodoTexto*>(nodo)) return make_unique<NodoTexto>(*n);
+    if (auto n = dynamic_cast<const NodoEcuacion*>(nodo)) return make_unique<NodoEcuacion>(*n);
+    if (auto n = dynamic_cast<const NodoMetadatos*>(nodo)) return make_unique<NodoMetadatos>(*n);
+    if (auto n = dynamic_cast<const NodoComando*>(nodo)) return make_unique<NodoComando>(*n);
+    if (auto n = dynamic_cast<const NodoTablaCsv*>(nodo)) return make_unique<NodoTablaCsv>(*n);
+    if (auto n = dynamic_cast<const NodoFigura*>(nodo)) return make_unique<NodoFigura>(*n);
+    if (auto n = dynamic_cast<const NodoEtiqueta*>(nodo)) return make_unique<NodoEtiqueta>(*n);
+    if (auto n = dynamic_cast<const NodoReferencia*>(nodo)) return make_unique<NodoReferencia>(*n);
+    if (auto n = dynamic_cast<const NodoIndice*>(nodo)) return make_unique<NodoIndice>(*n);
+    if (auto n = dynamic_cast<const NodoCita*>(nodo)) return make_unique<NodoCita>(*n);
+    if (auto n = dynamic_cast<const NodoBibliografia*>(nodo)) return make_unique<NodoBibliografia>(*n);
+    if (auto n = dynamic_cast<const NodoLista*>(nodo)) {
+        auto lista = make_unique<NodoLista>();
+        lista->linea = n->linea;
+        lista->columna = n->columna;
+        lista->expandido = n->expandido;
+        lista->tipo = n->tipo;
+        for (const auto& elemento : n->elementos) {
+            lista->elementos.push_back(clonarNodo(elemento.get()));
+        }
+        return lista;
+    }
+    throw runtime_error("Sentencia sin copia para macros: " + nodo->toString());
+}
+
+// Solo las cadenas y el texto sin comillas llevan marcadores
+bool admiteMarcadores(TipoToken tipo) {
+    return tipo == TipoToken::CADENA || tipo == TipoToken::TEXTO_SIMPLE;
+}
+
+int mayorMarcador(const string& texto) {
+    int mayor = 0;
+    for (size_t i = texto.find('#'); i != string::npos && i + 1 < texto.size(); i = texto.find('#', i + 1)) {
+        char siguiente = texto[i + 1];
+        if (siguiente == '#') {
+            i++;
+        } else if (siguiente >= '1' && siguiente <= '9') {
+            mayor = max(mayor, siguiente - '0');
+        }
+    }
+    return mayor;
+}
+
+// #n -> argumentos[n - 1], ## -> #
+string sustituir(const string& texto, const vector<string>& argumentos) {
+    if (texto.find('#') == string::npos) return texto;
+    string resultado;
+    resultado.reserve(texto.size());
+    for (size_t i = 0; i < texto.size(); i++) {
+        char c = texto[i];
+        if (c == '#' && i + 1 < texto.size()) {
+            char siguiente = texto[i + 1];
+            if (siguiente == '#') {
+                resultado += '#';
+                i++;
+                continue;
+            }
+            if (siguiente >= '1' && siguiente <= '9') {
+                resultado += argumentos[static_cast<size_t>(siguiente - '1')];
+                i++;
+                continue;
+            }
+        }
+        resultado += c;
+    }
+    return resultado;
+}
+
+// Clave de la memoria: limite de memoria, nombre y argumentos con su
+// longitud delante, para que ningun argumento pueda confundirse con el
+// separador. El limite va en la clave porque decide si la expansion cabe.
+string claveMemoria(const string& nombre, const vector<string>& argumentos, size_t memoriaMaxima) {
+    string clave = to_string(memoriaMaxima) + ':' + nombre;
+    for (const auto& argumento : argumentos) {
+        clave += '\0';
+        clave += to_string(argumento.size());
+        clave += ':';
+        clave += argumento;
+    }
+    return clave;
+}
+
+// Error de un usar() que insertaria 'sentencias' sentencias de 'bytes'
+// bytes; vacio si caben en los limites.
+string excesoExpansion(size_t sentencias, size_t bytes, size_t memoriaMaxima) {
+    if (sentencias > SENTENCIAS_MAXIMAS_EXPANSION) {
+        return "la expansion pasa de " + to_string(SENTENCIAS_MAXIMAS_EXPANSION) + " sentencias";
+    }
+    if (memoriaMaxima != 0 && bytes > memoriaMaxima) {
+        return "la expansion ocuparia " + formatearBytes(bytes) + " y el limite es " + formatearBytes(memoriaMaxima);
+    }
+    return "";
+}
+
+} // namespace
+
+BibliotecaMacros::BibliotecaMacros(const BibliotecaMacros* padre) : padre(padre) {}
+
+bool BibliotecaMacros::definir(const string& nombre, const string& cuerpo) {
+    if (macros.count(nombre) != 0) return false;
+
+    Macro macro;
+    AnalizadorLexico lexico(cuerpo);
+    macro.tokens = lexico.analizar();
+    for (const auto& token : macro.tokens) {
+        if (admiteMarcadores(token.tipo)) {
+            macro.parametros = max(macro.parametros, mayorMarcador(token.valor));
+        }
+    }
+    macros.emplace(nombre, move(macro));
+    return true;
+}
+
+void BibliotecaMacros::cargar(const string& ruta) {
+    unique_ptr<NodoDocumento> documento;
+    try {
+        AnalizadorLexico lexico(leerArchivo(ruta));
+        AnalizadorSintactico sintactico(lexico.analizar());
+        documento = sintactico.analizar(true);
+    } catch (const exception& e) {
+        throw runtime_error(ruta + ": " + e.what());
+    }
+
+    for (const auto& hijo : documento->hijos) {
+        auto definicion = dynamic_cast<const NodoDefinicion*>(hijo.get());
+        if (definicion == nullptr) {
+            throw runtime_error(ruta + ": linea " + to_string(hijo->linea) +
+                                ": una biblioteca de macros solo puede contener definir()");
+        }
+        try {
+            if (!definir(definicion->nombre, definicion->cuerpo)) {
+                throw runtime_error("macro definida dos veces");
+            }
+        } catch (const exception& e) {
+            throw runtime_error(ruta + ": linea " + to_string(definicion->linea) + ": macro \"" +
+                                definicion->nombre + "\": " + e.what());
+        }
+    }
+}
+
+shared_ptr<const ExpansionMacro> BibliotecaMacros::expandir(const string& nombre, const vector<string>& argumentos,
+                                                            unique_ptr<AnalizadorSintactico>& analizador,
+                                                            size_t memoriaMaxima, int profundidad) const {
+    auto it = macros.find(nombre);
+    if (it == macros.end()) {
+        return padre != nullptr ? padre->expandir(nombre, argumentos, analizador, memoriaMaxima, profundidad)
+                                : nullptr;
+    }
+    usos++;
+
+    string clave = claveMemoria(nombre, argumentos, memoriaMaxima);
+    {
+        lock_guard<mutex> bloqueo(cerrojo);
+        auto guardada = memoria.find(clave);
+        if (guardada != memoria.end()) {
+            desdeMemoria++;
+            return guardada->second;
+        }
+    }
+
+    // Se analiza fuera del cerrojo; si otro hilo llega antes con la misma
+    // clave, se queda la suya. Un error dentro de un usar() anidado puede
+    // deberse a la profundidad a la que se llego, asi que no se guarda.
+    shared_ptr<const ExpansionMacro> expansion =
+        analizarUso(nombre, it->second, argumentos, analizador, memoriaMaxima, profundidad);
+    lock_guard<mutex> bloqueo(cerrojo);
+    if (memoria.size() < EXPANSIONES_MAXIMAS_MEMORIA && (profundidad == 0 || expansion->error.empty())) {
+        return memoria.emplace(move(clave), move(expansion)).first->second;
+    }
+    return expansion;
+}
+
+shared_ptr<const ExpansionMacro> BibliotecaMacros::analizarUso(const string& nombre, const Macro& macro,
+                                                               const vector<string>& argumentos,
+                                                               unique_ptr<AnalizadorSintactico>& analizador,
+                                                               size_t memoriaMaxima, int profundidad) const {
+    auto expansion = make_shared<ExpansionMacro>();
+    string prefijo = "Macro \"" + nombre + "\": ";
+
+    if (static_cast<size_t>(macro.parametros) > argumentos.size()) {
+        expansion->error = prefijo + "usa #" + to_string(macro.parametros) + " y recibio " +
+                           to_string(argumentos.size()) + (argumentos.size() == 1 ? " argumento" : " argumentos");
+        return expansion;
+    }
+
+    vector<Token> tokens = macro.tokens;
+    for (auto& token : tokens) {
+        if (admiteMarcadores(token.tipo)) token.valor = sustituir(token.valor, argumentos);
+    }
+
+    unique_ptr<NodoDocumento> cuerpo;
+    try {
+        if (!analizador) analizador = make_unique<AnalizadorSintactico>(vector<Token>());
+        analizador->reiniciar(move(tokens));
+        cuerpo = analizador->analizar(true);
+    } catch (const exception& e) {
+        expansion->error = prefijo + e.what() + " del cuerpo";
+        return expansion;
+    }
+
+    for (auto& sentencia : cuerpo->hijos) {
+        if (auto uso = dynamic_cast<NodoUso*>(sentencia.get())) {
+            if (profundidad + 1 >= PROFUNDIDAD_MAXIMA_MACROS) {
+                expansion->error = prefijo + "usar() anidado demasiadas veces (¿macro recursiva?)";
+                return expansion;
+            }
+            // Los usar() del cuerpo se buscan donde esta definida la macro,
+            // nunca en el documento que la usa: asi la expansion guardada
+            // vale para todos
+            shared_ptr<const ExpansionMacro> anidada =
+                expandir(uso->nombre, uso->argumentos, analizador, memoriaMaxima, profundidad + 1);
+            if (!anidada) {
+                expansion->error = prefijo + "macro no definida: \"" + uso->nombre + "\"";
+                return expansion;
+            }
+            if (!anidada->error.empty()) {
+                expansion->error = anidada->error; // ya nombra la macro anidada
+                return expansion;
+            }
+            string exceso = excesoExpansion(expansion->sentencias.size() + anidada->sentencias.size(),
+                                            expansion->bytes + anidada->bytes, memoriaMaxima);
+            if (!exceso.empty()) {
+                expansion->error = prefijo + exceso;
+                return expansion;
+            }
+            for (const auto& anidadaSentencia : anidada->sentencias) {
+                expansion->sentencias.push_back(clonarNodo(anidadaSentencia.get()));
+            }
+            expansion->bytes += anidada->bytes;
+            continue;
+        }
+
+        if (dynamic_cast<NodoDefinicion*>(sentencia.get())) {
+            expansion->error = prefijo + "definir() no puede ir dentro de una macro";
+            return expansion;
+        }
+        if (auto comando = dynamic_cast<NodoComando*>(sentencia.get())) {
+            if (comando->comando == "inicio_documento" || comando->comando == "fin_documento") {
+                expansion->error = prefijo + "documento_inicio y documento_fin no pueden ir dentro de una macro";
+                return expansion;
+            }
+        }
+        // Las formulas se validan aqui, una vez por expansion; el validador
+        // del documento salta las sentencias expandidas
+        if (auto ecuacion = dynamic_cast<NodoEcuacion*>(sentencia.get())) {
+            ErrorMatematico error;
+            if (!validarFormula(ecuacion->contenido, ecuacion->tipo == "formula", error)) {
+                expansion->error = prefijo + error.mensaje;
+                return expansion;
+            }
+        }
+        expansion->bytes += memoriaNodo(sentencia.get());
+        expansion->sentencias.push_back(move(sentencia));
+    }
+    return expansion;
+}
+
+EstadisticasMacros BibliotecaMacros::getEstadisticas() const {
+    EstadisticasMacros estadisticas;
+    estadisticas.macros = macros.size();
+    estadisticas.usos = usos;
+    estadisticas.desdeMemoria = desdeMemoria;
+    return estadisticas;
+}
+
+vector<Diagnostico> expandirMacros(NodoDocumento* documento, const BibliotecaMacros* compartida,
+                                   unique_ptr<AnalizadorSintactico>& analizador, size_t& usos,
+                                   size_t memoriaMaxima) {
+    vector<Diagnostico> diagnosticos;
+    usos = 0;
+
+    bool hayMacros = false;
+    for (const auto& hijo : documento->hijos) {
+        if (dynamic_cast<NodoDefinicion*>(hijo.get()) || dynamic_cast<NodoUso*>(hijo.get())) {
+            hayMacros = true;
+            break;
+        }
+    }
+    if (!hayMacros) return diagnosticos;
+
+    // Las definiciones valen en todo el documento, antes o despues del usar()
+    BibliotecaMacros locales(compartida);
+    for (const auto& hijo : documento->hijos) {
+        auto definicion = dynamic_cast<NodoDefinicion*>(hijo.get());
+        if (definicion == nullptr) continue;
+        try {
+            if (!locales.definir(definicion->nombre, definicion->cuerpo)) {
+                diagnosticos.emplace_back(Severidad::ADVERTENCIA, definicion->linea, definicion->columna,
+                    "Macro definida dos veces: \"" + definicion->nombre + "\" (se usa la primera definicion)");
+            }
+        } catch (const exception& e) {
+            diagnosticos.emplace_back(Severidad::ERROR, definicion->linea, definicion->columna,
+                "Macro \"" + definicion->nombre + "\": " + e.what());
+        }
+    }
+
+    // Lo que ocupara el documento expandido, para cortar antes de copiar
+    size_t insertadas = 0;
+    size_t bytesDocumento = memoriaAst(*documento);
+
+    vector<unique_ptr<NodoAST>> hijos;
+    hijos.reserve(documento->hijos.size());
+    for (auto& hijo : documento->hijos) {
+        if (dynamic_cast<NodoDefinicion*>(hijo.get())) continue;
+        auto uso = dynamic_cast<NodoUso*>(hijo.get());
+        if (uso == nullptr) {
+            hijos.push_back(move(hijo));
+            continue;
+        }
+
+        usos++;
+        shared_ptr<const ExpansionMacro> expansion =
+            locales.expandir(uso->nombre, uso->argumentos, analizador, memoriaMaxima);
+        if (!expansion) {
+            diagnosticos.emplace_back(Severidad::ERROR, uso->linea, uso->columna,
+                "Macro no definida: \"" + uso->nombre + "\"");
+            continue;
+        }
+        if (!expansion->error.empty()) {
+            diagnosticos.emplace_back(Severidad::ERROR, uso->linea, uso->columna, expansion->error);
+            continue;
+        }
+        string exceso = excesoExpansion(insertadas + expansion->sentencias.size(),
+                                        bytesDocumento + expansion->bytes, memoriaMaxima);
+        if (!exceso.empty()) {
+            diagnosticos.emplace_back(Severidad::ERROR, uso->linea, uso->columna,
+                "Macro \"" + uso->nombre + "\": " + exceso + " en el documento");
+            continue;
+        }
+        insertadas += expansion->sentencias.size();
+        bytesDocumento += expansion->bytes;
+        for (const auto& sentencia : expansion->sentencias) {
+            unique_ptr<NodoAST> copia = clonarNodo(sentencia.get());
+            copia->linea = uso->linea;
+            copia->columna = uso->columna;
+            copia->expandido = true;
+            hijos.push_back(move(copia));
+        }
+    }
+    documento->hijos = move(hijos);
+    return diagnosticos;
+}
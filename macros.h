@@ -0,0 +1,136 @@
+#ifndef MACROS_H
+#define MACROS_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "analizador_sintactico.h"
+#include "ast.h"
+#include "diagnostico.h"
+#include "token.h"
+
+using namespace std;
+
+// ===============================
+// MACROS (definir() Y usar())
+// ===============================
+//
+// definir("nombre", "cuerpo") guarda un bloque de sentencias y
+// usar("nombre", "arg1", ...) lo inserta en el documento, con #1, #2...
+// reemplazados por los argumentos (## es un # literal). Los marcadores van
+// dentro de las cadenas o del texto sin comillas del cuerpo:
+//
+//   definir("encabezado", "titulo(\"#1\"); autor(\"#2\"); parrafo Curso #1;");
+//   usar("encabezado", "Algebra I", "Prof. Ruiz");
+//
+// La expansion es sobre el arbol. El cuerpo se analiza lexicamente una sola
+// vez, al definirse, y los argumentos se sustituyen en sus tokens (no hace
+// falta escapar comillas en ellos). Cada combinacion de macro y argumentos
+// se analiza una sola vez: sus usar() anidados se expanden, sus formulas se
+// validan y el resultado queda en una memoria. Cada usar() inserta una copia
+// de esas sentencias, asi que la numeracion, las referencias y las citas se
+// resuelven despues como si se hubieran escrito a mano.
+//
+// Una biblioteca (--macros=plantillas.texes, un archivo con solo definir())
+// se carga una vez y la comparten todos los documentos e hilos de un lote,
+// con su memoria de expansiones. Las macros que define un documento valen
+// solo para el y tapan a las de la biblioteca con el mismo nombre.
+
+// Profundidad maxima de usar() anidados; mas alla se supone una macro
+// recursiva.
+const int PROFUNDIDAD_MAXIMA_MACROS = 16;
+
+// Expansiones que guarda la memoria de cada biblioteca; las que no caben se
+// analizan en cada uso.
+const size_t EXPANSIONES_MAXIMAS_MEMORIA = 4096;
+
+// Sentencias que pueden insertar entre todos los usar() de un documento (y
+// cada expansion por si sola). Unas pocas macros que usan varias veces la
+// anterior crecen de forma exponencial: el usar() que pasaria de aqui, o de
+// --max-memory segun la estimacion de memoriaAst, falla antes de copiar
+// nada.
+const size_t SENTENCIAS_MAXIMAS_EXPANSION = 500000;
+
+// Sentencias de un usar() con sus argumentos, ya expandidas. No se
+// modifica despues de crearse: cada uso inserta una copia.
+struct ExpansionMacro {
+    vector<unique_ptr<NodoAST>> sentencias;
+    size_t bytes = 0; // memoria estimada de las sentencias
+    string error;     // vacio si la expansion es valida
+};
+
+struct EstadisticasMacros {
+    size_t macros = 0;
+    size_t usos = 0;
+    size_t desdeMemoria = 0;
+};
+
+class BibliotecaMacros {
+private:
+    struct Macro {
+        vector<Token> tokens; // el cuerpo, con FIN_ARCHIVO al final
+        int parametros = 0;   // mayor #n del cuerpo
+    };
+
+    const BibliotecaMacros* padre;
+    unordered_map<string, Macro> macros;
+
+    mutable mutex cerrojo;
+    mutable unordered_map<string, shared_ptr<const ExpansionMacro>> memoria;
+    mutable atomic<size_t> usos{0};
+    mutable atomic<size_t> desdeMemoria{0};
+
+    shared_ptr<const ExpansionMacro> analizarUso(const string& nombre, const Macro& macro,
+                                                 const vector<string>& argumentos,
+                                                 unique_ptr<AnalizadorSintactico>& analizador,
+                                                 size_t memoriaMaxima, int profundidad) const;
+
+public:
+    // Las macros que no estan aqui se buscan en 'padre' (la biblioteca
+    // compartida, para las de un documento).
+    explicit BibliotecaMacros(const BibliotecaMacros* padre = nullptr);
+
+    BibliotecaMacros(const BibliotecaMacros&) = delete;
+    BibliotecaMacros& operator=(const BibliotecaMacros&) = delete;
+
+    // Analiza el cuerpo y guarda la macro. Devuelve false (y conserva la
+    // primera) si ya habia una con ese nombre. Lanza runtime_error si el
+    // cuerpo no se puede analizar (cadena sin cerrar, UTF-8 no valido).
+    bool definir(const string& nombre, const string& cuerpo);
+
+    // Carga las macros de un .texes que solo contiene definir(). Lanza
+    // runtime_error si no se puede leer o tiene otra cosa.
+    void cargar(const string& ruta);
+
+    // Sentencias de usar(nombre, argumentos): de la memoria, o analizadas
+    // ahora con 'analizador' (que se crea si es nulo y se conserva para la
+    // proxima). nullptr si la macro no existe ni aqui ni en el padre. La
+    // expansion falla si pasa de SENTENCIAS_MAXIMAS_EXPANSION o de
+    // 'memoriaMaxima' bytes (0 = sin limite). Se puede llamar desde varios
+    // hilos a la vez.
+    shared_ptr<const ExpansionMacro> expandir(const string& nombre, const vector<string>& argumentos,
+                                              unique_ptr<AnalizadorSintactico>& analizador,
+                                              size_t memoriaMaxima = 0, int profundidad = 0) const;
+
+    EstadisticasMacros getEstadisticas() const;
+};
+
+// Reemplaza cada usar() del documento por las sentencias de su macro y
+// quita los definir(). 'compartida' (puede ser nula) es la biblioteca
+// precargada; 'analizador' se reutiliza entre documentos. Devuelve los
+// errores (macro inexistente, faltan argumentos, cuerpo mal formado,
+// formula invalida, recursion, expansion demasiado grande) en la posicion
+// del usar() o del definir(), y una advertencia por cada macro definida dos
+// veces. 'usos' recibe el numero de usar() del documento. 'memoriaMaxima'
+// (0 = sin limite) acota el documento ya expandido, estimado como en
+// memoriaAst.
+vector<Diagnostico> expandirMacros(NodoDocumento* documento, const BibliotecaMacros* compartida,
+                                   unique_ptr<AnalizadorSintactico>& analizador, size_t& usos,
+                                   size_t memoriaMaxima = 0);
+
+#endif
@@ -0,0 +1,169 @@
+#include "memoria.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+size_t memoriaResidentePico() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS contadores;
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &contadores, sizeof(contadores))) return 0;
+    return contadores.PeakWorkingSetSize;
+#else
+    struct rusage uso;
+    if (getrusage(RUSAGE_SELF, &uso) != 0) return 0;
+#if defined(__APPLE__)
+    return static_cast<size_t>(uso.ru_maxrss);        // bytes
+#else
+    return static_cast<size_t>(uso.ru_maxrss) * 1024; // KB
+#endif
+#endif
+}
+
+size_t memoriaTokens(const vector<Token>& tokens) {
+    size_t bytes = tokens.capacity() * sizeof(Token);
+    for (const auto& token : tokens) {
+        bytes += bytesCadena(token.valor);
+    }
+    return bytes;
+}
+
+size_t memoriaNodo(const NodoAST* nodo) {
+    size_t bytes = sizeof(unique_ptr<NodoAST>);
+    if (auto seccion = dynamic_cast<const NodoSeccion*>(nodo)) {
+        bytes += sizeof(NodoSeccion) + bytesCadena(seccion->nivel) + bytesCadena(seccion->titulo) +
+                 bytesCadena(seccion->numero);
+    } else if (auto texto = dynamic_cast<const NodoTexto*>(nodo)) {
+        bytes += sizeof(NodoTexto) + bytesCadena(texto->contenido) + bytesCadena(texto->estilo) +
+                 bytesCadena(texto->alineacion);
+    } else if (auto lista = dynamic_cast<const NodoLista*>(nodo)) {
+        bytes += sizeof(NodoLista) + bytesCadena(lista->tipo);
+        for (const auto& elemento : lista->elementos) bytes += memoriaNodo(elemento.get());
+    } else if (auto ecuacion = dynamic_cast<const NodoEcuacion*>(nodo)) {
+        bytes += sizeof(NodoEcuacion) + bytesCadena(ecuacion->contenido) + bytesCadena(ecuacion->tipo) +
+                 bytesCadena(ecuacion->numero);
+    } else if (auto metadatos = dynamic_cast<const NodoMetadatos*>(nodo)) {
+        bytes += sizeof(NodoMetadatos) + bytesCadena(metadatos->tipo) + bytesCadena(metadatos->contenido);
+    } else if (auto comando = dynamic_cast<const NodoComando*>(nodo)) {
+        bytes += sizeof(NodoComando) + bytesCadena(comando->comando) + bytesCadena(comando->contenido);
+    } else if (auto configuracion = dynamic_cast<const NodoConfiguracion*>(nodo)) {
+        bytes += sizeof(NodoConfiguracion) + bytesCadena(configuracion->clave) +
+                 bytesCadena(configuracion->valor);
+    } else if (auto tabla = dynamic_cast<const NodoTablaCsv*>(nodo)) {
+        bytes += sizeof(NodoTablaCsv) + bytesCadena(tabla->ruta) + tabla->opciones.capacity() * sizeof(string);
+        for (const auto& opcion : tabla->opciones) bytes += bytesCadena(opcion);
+    } else if (auto figura = dynamic_cast<const NodoFigura*>(nodo)) {
+        bytes += sizeof(NodoFigura) + bytesCadena(figura->ruta) + bytesCadena(figura->leyenda) +
+                 bytesCadena(figura->numero);
+    } else if (auto etiqueta = dynamic_cast<const NodoEtiqueta*>(nodo)) {
+        bytes += sizeof(NodoEtiqueta) + bytesCadena(etiqueta->clave);
+    } else if (auto referencia = dynamic_cast<const NodoReferencia*>(nodo)) {
+        bytes += sizeof(NodoReferencia) + bytesCadena(referencia->clave) + bytesCadena(referencia->numero);
+    } else if (auto indice = dynamic_cast<const NodoIndice*>(nodo)) {
+        bytes += sizeof(NodoIndice) + indice->entradas.capacity() * sizeof(EntradaIndice);
+        for (const auto& entrada : indice->entradas) {
+            bytes += bytesCadena(entrada.nivel) + bytesCadena(entrada.numero) + bytesCadena(entrada.titulo);
+        }
+    } else if (auto cita = dynamic_cast<const NodoCita*>(nodo)) {
+        bytes += sizeof(NodoCita) + bytesCadena(cita->claves) + bytesCadena(cita->nota) +
+                 bytesCadena(cita->numero);
+    } else if (auto bibliografia = dynamic_cast<const NodoBibliografia*>(nodo)) {
+        bytes += sizeof(NodoBibliografia) + bibliografia->rutas.capacity() * sizeof(string) +
+                 bibliografia->entradas.capacity() * sizeof(EntradaBibliografia);
+        for (const auto& ruta : bibliografia->rutas) bytes += bytesCadena(ruta);
+        for (const auto& entrada : bibliografia->entradas) {
+            bytes += bytesCadena(entrada.clave) + bytesCadena(entrada.numero) + bytesCadena(entrada.antes) +
+                     bytesCadena(entrada.enfasis) + bytesCadena(entrada.despues);
+        }
+    } else if (auto definicion = dynamic_cast<const NodoDefinicion*>(nodo)) {
+        bytes += sizeof(NodoDefinicion) + bytesCadena(definicion->nombre) + bytesCadena(definicion->cuerpo);
+    } else if (auto uso = dynamic_cast<const NodoUso*>(nodo)) {
+        bytes += sizeof(NodoUso) + bytesCadena(uso->nombre) + uso->argumentos.capacity() * sizeof(string);
+        for (const auto& argumento : uso->argumentos) bytes += bytesCadena(argumento);
+    }
+    return bytes;
+}
+
+size_t memoriaAst(const NodoDocumento& documento) {
+    size_t bytes = sizeof(NodoDocumento) + documento.hijos.capacity() * sizeof(unique_ptr<NodoAST>);
+    for (const auto& hijo : documento.hijos) {
+        bytes += memoriaNodo(hijo.get()) - sizeof(unique_ptr<NodoAST>);
+    }
+    return bytes;
+}
+
+size_t memoriaPrevistaAnalisis(size_t bytes) {
+    // Medido sobre documentos de texto corrido: ~4 tokens por cada 40 bytes
+    // (sizeof(Token) y su cadena) mas la entrada por duplicado. Se redondea
+    // hacia arriba; las tablas CSV no cuentan, se leen sin cargarlas.
+    return bytes * 8 + 64 * 1024;
+}
+
+size_t leerTamanoMemoria(const string& texto) {
+    // stoull acepta "-5" (y espacios delante) y le da la vuelta: solo se
+    // admiten digitos al principio
+    if (texto.empty() || !isdigit(static_cast<unsigned char>(texto[0]))) {
+        throw invalid_argument("Tamano de memoria no valido: " + texto);
+    }
+    size_t fin = 0;
+    unsigned long long valor = stoull(texto, &fin);
+    string sufijo = texto.substr(fin);
+    transform(sufijo.begin(), sufijo.end(), sufijo.begin(), ::toupper);
+    int desplazamiento;
+    if (sufijo == "" || sufijo == "B") {
+        desplazamiento = 0;
+    } else if (sufijo == "K" || sufijo == "KB") {
+        desplazamiento = 10;
+    } else if (sufijo == "M" || sufijo == "MB") {
+        desplazamiento = 20;
+    } else if (sufijo == "G" || sufijo == "GB") {
+        desplazamiento = 30;
+    } else {
+        throw invalid_argument("Tamano de memoria no valido: " + texto);
+    }
+    // 0 seria "sin limite" en OpcionesCompilacion: quien lo pide no lo espera
+    if (valor == 0 || valor > (static_cast<unsigned long long>(SIZE_MAX) >> desplazamiento)) {
+        throw invalid_argument("Tamano de memoria no valido: " + texto);
+    }
+    return static_cast<size_t>(valor << desplazamiento);
+}
+
+string formatearBytes(size_t bytes) {
+    const char* unidades[] = {"B", "KB", "MB", "GB", "TB"};
+    double valor = static_cast<double>(bytes);
+    size_t unidad = 0;
+    while (valor >= 1024.0 && unidad < 4) {
+        valor /= 1024.0;
+        unidad++;
+    }
+    char texto[32];
+    snprintf(texto, sizeof(texto), unidad == 0 ? "%.0f %s" : "%.1f %s", valor, unidades[unidad]);
+    return texto;
+}
+
+size_t PresupuestoMemoria::reservar(size_t bytes) {
+    unique_lock<mutex> bloqueo(cerrojo);
+    // Quien espera no tiene nada reservado, asi que no hay bloqueo mutuo
+    liberada.wait(bloqueo, [&]() { return enUso == 0 || enUso + bytes <= limite; });
+    enUso += bytes;
+    return bytes;
+}
+
+void PresupuestoMemoria::liberar(size_t bytes) {
+    {
+        lock_guard<mutex> bloqueo(cerrojo);
+        enUso -= bytes;
+    }
+    liberada.notify_all();
+}
@@ -0,0 +1,79 @@
+#ifndef MEMORIA_H
+#define MEMORIA_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ast.h"
+#include "token.h"
+
+using namespace std;
+
+// ===============================
+// CONTABILIDAD DE MEMORIA
+// ===============================
+//
+// Estimaciones de los bytes que ocupa cada estructura del compilador
+// (objeto mas lo que reserva en el heap), para informar el maximo de cada
+// fase y aplicar --max-memory antes de que el sistema mate el proceso.
+
+// Pico de memoria residente del proceso en bytes; 0 si el sistema no lo
+// informa.
+size_t memoriaResidentePico();
+
+// Bytes que una cadena reserva en el heap (0 si cabe en el bufer interno).
+inline size_t bytesCadena(const string& cadena) {
+    const char* objeto = reinterpret_cast<const char*>(&cadena);
+    if (cadena.data() >= objeto && cadena.data() < objeto + sizeof(string)) return 0;
+    return cadena.capacity() + 1;
+}
+
+size_t memoriaTokens(const vector<Token>& tokens);
+size_t memoriaAst(const NodoDocumento& documento);
+
+// Una sentencia del arbol (con sus elementos si es una lista) y el
+// unique_ptr que la apunta.
+size_t memoriaNodo(const NodoAST* nodo);
+
+// Memoria que se espera para analizar una entrada de 'bytes' bytes: la
+// entrada, su copia en el analizador lexico, los tokens y la tabla de
+// simbolos. Sirve para rechazar (o poner en espera) un documento antes de
+// leerlo.
+size_t memoriaPrevistaAnalisis(size_t bytes);
+
+// "512M", "2G", "800000" -> bytes. Lanza invalid_argument si no es valido:
+// negativo, 0 o mayor de lo que cabe en size_t.
+size_t leerTamanoMemoria(const string& texto);
+
+// 1536 -> "1.5 KB"
+string formatearBytes(size_t bytes);
+
+// Presupuesto compartido entre los documentos de un lote. Cada documento
+// reserva su memoria prevista antes de empezar; si los que ya estan en
+// curso ocupan el presupuesto, espera a que terminen en lugar de
+// compilarse a la vez. Un documento que no cabe ni con el presupuesto
+// libre entra solo (y compilar() lo rechaza con un diagnostico si de
+// verdad lo supera).
+class PresupuestoMemoria {
+private:
+    size_t limite;
+    size_t enUso = 0;
+    mutex cerrojo;
+    condition_variable liberada;
+
+public:
+    explicit PresupuestoMemoria(size_t limite) : limite(limite) {}
+
+    size_t getLimite() const {
+        return limite;
+    }
+
+    // Devuelve los bytes reservados (lo que hay que pasar a liberar()).
+    size_t reservar(size_t bytes);
+    void liberar(size_t bytes);
+};
+
+#endif
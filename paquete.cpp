@@ -0,0 +1,311 @@
+#include "paquete.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+const size_t BLOQUE = 512;
+const size_t BUFER_ESCRITURA = 1 << 20;
+
+// Desplazamientos de la cabecera ustar
+const size_t CAMPO_NOMBRE = 0;
+const size_t CAMPO_MODO = 100;
+const size_t CAMPO_UID = 108;
+const size_t CAMPO_GID = 116;
+const size_t CAMPO_TAMANO = 124;
+const size_t CAMPO_FECHA = 136;
+const size_t CAMPO_SUMA = 148;
+const size_t CAMPO_TIPO = 156;
+const size_t CAMPO_MAGIA = 257;
+const size_t CAMPO_VERSION = 263;
+const size_t CAMPO_PREFIJO = 345;
+
+size_t redondearBloque(size_t bytes) {
+    return (bytes + BLOQUE - 1) / BLOQUE * BLOQUE;
+}
+
+// Texto de un campo terminado en NUL (o que ocupa todo el campo)
+string leerCampo(const char* cabecera, size_t desplazamiento, size_t longitud) {
+    const char* inicio = cabecera + desplazamiento;
+    return string(inicio, strnlen(inicio, longitud));
+}
+
+// Numero octal con espacios o NUL alrededor; si el primer byte tiene el
+// bit alto, binario big-endian (extension de GNU para mas de 8 GB).
+bool leerNumero(const char* cabecera, size_t desplazamiento, size_t longitud, uint64_t& valor) {
+    const unsigned char* campo = reinterpret_cast<const unsigned char*>(cabecera + desplazamiento);
+    valor = 0;
+    if (campo[0] & 0x80) {
+        if (campo[0] != 0x80) return false; // negativo o desmedido
+        for (size_t i = 1; i < longitud; i++) {
+            if (valor >> 56) return false;
+            valor = (valor << 8) | campo[i];
+        }
+        return true;
+    }
+    size_t i = 0;
+    while (i < longitud && campo[i] == ' ') i++;
+    bool digitos = false;
+    for (; i < longitud && campo[i] >= '0' && campo[i] <= '7'; i++) {
+        valor = (valor << 3) | static_cast<uint64_t>(campo[i] - '0');
+        digitos = true;
+    }
+    for (; i < longitud; i++) {
+        if (campo[i] != ' ' && campo[i] != '\0') return false;
+    }
+    return digitos;
+}
+
+bool sumaValida(const char* cabecera) {
+    uint64_t guardada;
+    if (!leerNumero(cabecera, CAMPO_SUMA, 8, guardada)) return false;
+    // La suma se calcula con el campo de la suma lleno de espacios. Algunos
+    // tar antiguos suman los bytes con signo.
+    int64_t sinSigno = 8 * ' ';
+    int64_t conSigno = 8 * ' ';
+    for (size_t i = 0; i < BLOQUE; i++) {
+        if (i >= CAMPO_SUMA && i < CAMPO_SUMA + 8) continue;
+        sinSigno += static_cast<unsigned char>(cabecera[i]);
+        conSigno += static_cast<signed char>(cabecera[i]);
+    }
+    return static_cast<int64_t>(guardada) == sinSigno || static_cast<int64_t>(guardada) == conSigno;
+}
+
+bool bloqueVacio(const char* cabecera) {
+    return all_of(cabecera, cabecera + BLOQUE, [](char c) { return c == '\0'; });
+}
+
+// Registros pax: "<longitud> <clave>=<valor>\n"
+void leerPax(string_view registros, string& ruta, uint64_t& tamano, bool& hayTamano) {
+    size_t i = 0;
+    while (i < registros.size()) {
+        size_t espacio = registros.find(' ', i);
+        if (espacio == string_view::npos) return;
+        size_t longitud = 0;
+        for (size_t j = i; j < espacio; j++) {
+            if (registros[j] < '0' || registros[j] > '9') return;
+            longitud = longitud * 10 + static_cast<size_t>(registros[j] - '0');
+        }
+        if (longitud == 0 || i + longitud > registros.size()) return;
+        string_view registro = registros.substr(espacio + 1, i + longitud - espacio - 2);
+        size_t igual = registro.find('=');
+        if (igual != string_view::npos) {
+            string_view clave = registro.substr(0, igual);
+            string_view valor = registro.substr(igual + 1);
+            if (clave == "path") {
+                ruta = string(valor);
+            } else if (clave == "size") {
+                tamano = 0;
+                for (char c : valor) tamano = tamano * 10 + static_cast<uint64_t>(c - '0');
+                hayTamano = true;
+            }
+        }
+        i += longitud;
+    }
+}
+
+void escribirOctal(char* cabecera, size_t desplazamiento, size_t longitud, uint64_t valor) {
+    // longitud - 1 digitos y un NUL
+    char* campo = cabecera + desplazamiento;
+    campo[longitud - 1] = '\0';
+    for (size_t i = longitud - 1; i > 0; i--) {
+        campo[i - 1] = static_cast<char>('0' + (valor & 7));
+        valor >>= 3;
+    }
+}
+
+void escribirNumero(char* cabecera, size_t desplazamiento, size_t longitud, uint64_t valor) {
+    if (valor >> (3 * (longitud - 1)) == 0) {
+        escribirOctal(cabecera, desplazamiento, longitud, valor);
+        return;
+    }
+    unsigned char* campo = reinterpret_cast<unsigned char*>(cabecera + desplazamiento);
+    for (size_t i = longitud; i > 1; i--) {
+        campo[i - 1] = static_cast<unsigned char>(valor & 0xff);
+        valor >>= 8;
+    }
+    campo[0] = 0x80;
+}
+
+// Reparte una ruta en prefijo (155) y nombre (100) por una '/'.
+bool dividirNombre(const string& nombre, string& prefijo, string& base) {
+    if (nombre.size() <= 100) {
+        prefijo.clear();
+        base = nombre;
+        return true;
+    }
+    size_t barra = nombre.size();
+    while ((barra = nombre.rfind('/', barra - 1)) != string::npos) {
+        if (barra <= 155 && nombre.size() - barra - 1 <= 100 && barra > 0) {
+            prefijo = nombre.substr(0, barra);
+            base = nombre.substr(barra + 1);
+            return !base.empty();
+        }
+        if (barra == 0) break;
+    }
+    return false;
+}
+
+} // namespace
+
+// ===============================
+// LECTURA
+// ===============================
+
+LectorPaquete::LectorPaquete(const string& ruta) : archivo(ruta) {
+    indexar(ruta);
+}
+
+void LectorPaquete::indexar(const string& ruta) {
+    string_view datos = archivo.contenido();
+    string rutaLarga;
+    uint64_t tamanoPax = 0;
+    bool hayTamanoPax = false;
+
+    size_t posicion = 0;
+    while (posicion + BLOQUE <= datos.size()) {
+        const char* cabecera = datos.data() + posicion;
+        if (bloqueVacio(cabecera)) break; // fin del paquete
+
+        if (!sumaValida(cabecera)) {
+            throw runtime_error("Paquete no valido (cabecera danada en el byte " + to_string(posicion) +
+                                "): " + ruta);
+        }
+        uint64_t tamano;
+        if (!leerNumero(cabecera, CAMPO_TAMANO, 12, tamano)) {
+            throw runtime_error("Paquete no valido (tamano ilegible en el byte " + to_string(posicion) +
+                                "): " + ruta);
+        }
+        char tipo = cabecera[CAMPO_TIPO];
+        if (hayTamanoPax && tipo != 'x' && tipo != 'g' && tipo != 'L') {
+            tamano = tamanoPax;
+        }
+
+        size_t inicio = posicion + BLOQUE;
+        if (tamano > datos.size() - inicio) {
+            throw runtime_error("Paquete truncado: " + ruta);
+        }
+        string_view contenido = datos.substr(inicio, static_cast<size_t>(tamano));
+        posicion = inicio + redondearBloque(static_cast<size_t>(tamano));
+
+        if (tipo == 'L') {
+            rutaLarga = string(contenido.substr(0, contenido.find('\0')));
+            continue;
+        }
+        if (tipo == 'x') {
+            leerPax(contenido, rutaLarga, tamanoPax, hayTamanoPax);
+            continue;
+        }
+
+        string nombre = rutaLarga;
+        if (nombre.empty()) {
+            nombre = leerCampo(cabecera, CAMPO_NOMBRE, 100);
+            if (memcmp(cabecera + CAMPO_MAGIA, "ustar", 5) == 0) {
+                string prefijo = leerCampo(cabecera, CAMPO_PREFIJO, 155);
+                if (!prefijo.empty()) nombre = prefijo + "/" + nombre;
+            }
+        }
+        rutaLarga.clear();
+        hayTamanoPax = false;
+
+        // Directorios, enlaces, cabeceras globales...: nada que compilar
+        if (tipo != '0' && tipo != '\0' && tipo != '7') continue;
+
+        if (nombre.rfind("./", 0) == 0) nombre.erase(0, 2);
+        uint64_t fecha = 0;
+        leerNumero(cabecera, CAMPO_FECHA, 12, fecha);
+        entradas.push_back(EntradaPaquete{move(nombre), contenido, static_cast<int64_t>(fecha)});
+    }
+}
+
+// ===============================
+// ESCRITURA
+// ===============================
+
+EscritorPaquete::EscritorPaquete(const string& ruta) : ruta(ruta), bufer(BUFER_ESCRITURA) {
+    archivo.rdbuf()->pubsetbuf(bufer.data(), static_cast<streamsize>(bufer.size()));
+    archivo.open(ruta, ios::binary | ios::trunc);
+    if (!archivo.is_open()) {
+        throw runtime_error("No se pudo crear el archivo: " + ruta);
+    }
+}
+
+EscritorPaquete::~EscritorPaquete() {
+    if (archivo.is_open()) {
+        try {
+            cerrar();
+        } catch (const exception&) {
+        }
+    }
+}
+
+void EscritorPaquete::escribirCabecera(const string& nombre, size_t tamano, int64_t fecha, char tipo) {
+    char cabecera[BLOQUE] = {};
+    string prefijo, base;
+    if (!dividirNombre(nombre, prefijo, base)) {
+        // Ruta que no cabe en ustar: cabecera pax con la ruta completa
+        string registro = " path=" + nombre + "\n";
+        size_t longitud = registro.size() + 1;
+        while (to_string(longitud).size() + registro.size() != longitud) longitud++;
+        string pax = to_string(longitud) + registro;
+        escribirCabecera("PaxHeader/" + nombre.substr(nombre.size() - min<size_t>(nombre.size(), 80)),
+                         pax.size(), fecha, 'x');
+        escribirContenido(pax);
+        prefijo.clear();
+        base = nombre.substr(0, 100);
+    }
+
+    memcpy(cabecera + CAMPO_NOMBRE, base.data(), base.size());
+    memcpy(cabecera + CAMPO_PREFIJO, prefijo.data(), prefijo.size());
+    escribirOctal(cabecera, CAMPO_MODO, 8, 0644);
+    escribirOctal(cabecera, CAMPO_UID, 8, 0);
+    escribirOctal(cabecera, CAMPO_GID, 8, 0);
+    escribirNumero(cabecera, CAMPO_TAMANO, 12, tamano);
+    escribirNumero(cabecera, CAMPO_FECHA, 12, static_cast<uint64_t>(max<int64_t>(fecha, 0)));
+    cabecera[CAMPO_TIPO] = tipo;
+    memcpy(cabecera + CAMPO_MAGIA, "ustar", 6);
+    memcpy(cabecera + CAMPO_VERSION, "00", 2);
+
+    memset(cabecera + CAMPO_SUMA, ' ', 8);
+    unsigned suma = 0;
+    for (char c : cabecera) suma += static_cast<unsigned char>(c);
+    escribirOctal(cabecera, CAMPO_SUMA, 7, suma);
+    cabecera[CAMPO_SUMA + 7] = ' ';
+
+    archivo.write(cabecera, BLOQUE);
+}
+
+void EscritorPaquete::escribirContenido(string_view contenido) {
+    static const char ceros[BLOQUE] = {};
+    archivo.write(contenido.data(), static_cast<streamsize>(contenido.size()));
+    archivo.write(ceros, static_cast<streamsize>(redondearBloque(contenido.size()) - contenido.size()));
+}
+
+void EscritorPaquete::agregar(const string& nombre, string_view contenido, int64_t fecha) {
+    escribirCabecera(nombre, contenido.size(), fecha, '0');
+    escribirContenido(contenido);
+    if (!archivo) {
+        throw runtime_error("No se pudo escribir el archivo: " + ruta);
+    }
+}
+
+void EscritorPaquete::cerrar() {
+    static const char ceros[2 * BLOQUE] = {};
+    archivo.write(ceros, sizeof(ceros));
+    archivo.close();
+    if (archivo.fail()) {
+        throw runtime_error("No se pudo escribir el archivo: " + ruta);
+    }
+}
+
+bool esArchivoPaquete(const string& ruta) {
+    return ruta.size() > 4 && ruta.compare(ruta.size() - 4, 4, ".tar") == 0;
+}
+
+string nombrePaqueteSalida(const string& paqueteEntrada) {
+    return paqueteEntrada.substr(0, paqueteEntrada.size() - 4) + ".tex.tar";
+}
@@ -0,0 +1,86 @@
+#ifndef PAQUETE_H
+#define PAQUETE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "archivo_mapeado.h"
+
+using namespace std;
+
+// ===============================
+// PAQUETES TAR
+// ===============================
+//
+// Un lote de miles de .texes pequenos pasa mas tiempo abriendo, leyendo,
+// escribiendo y cerrando archivos que compilando. Con un paquete (tar sin
+// comprimir, formato ustar) la entrada es un solo archivo proyectado en
+// memoria y la salida un solo archivo escrito de forma secuencial.
+//
+// LectorPaquete recorre las cabeceras una vez y deja un indice de
+// entradas cuyo contenido apunta directamente al mapa: no se copia nada.
+// Entiende nombres ustar (prefijo + nombre), nombres largos de GNU ('L') y
+// las cabeceras pax ('x') de path y size que escriben tar y bsdtar.
+//
+// EscritorPaquete agrega entradas a un tar nuevo; no es seguro para varios
+// hilos (compilarPaquete lo usa bajo un mutex).
+
+struct EntradaPaquete {
+    string nombre;
+    string_view contenido;
+    int64_t fecha = 0; // mtime en segundos desde 1970
+};
+
+class LectorPaquete {
+private:
+    ArchivoMapeado archivo;
+    vector<EntradaPaquete> entradas;
+
+    void indexar(const string& ruta);
+
+public:
+    // Lanza runtime_error si el archivo no se puede abrir o no es un tar
+    // valido (cabecera danada, entrada truncada).
+    explicit LectorPaquete(const string& ruta);
+
+    // Solo archivos regulares, en el orden del paquete.
+    const vector<EntradaPaquete>& getEntradas() const {
+        return entradas;
+    }
+};
+
+class EscritorPaquete {
+private:
+    string ruta;
+    ofstream archivo;
+    vector<char> bufer;
+
+    void escribirCabecera(const string& nombre, size_t tamano, int64_t fecha, char tipo);
+    void escribirContenido(string_view contenido);
+
+public:
+    // Lanza runtime_error si no se puede crear el archivo.
+    explicit EscritorPaquete(const string& ruta);
+    ~EscritorPaquete();
+
+    EscritorPaquete(const EscritorPaquete&) = delete;
+    EscritorPaquete& operator=(const EscritorPaquete&) = delete;
+
+    void agregar(const string& nombre, string_view contenido, int64_t fecha);
+
+    // Escribe los dos bloques vacios del final. El destructor lo hace si no
+    // se llamo antes, pero sin informar errores.
+    void cerrar();
+};
+
+// true si la ruta se trata como paquete de entrada ("*.tar").
+bool esArchivoPaquete(const string& ruta);
+
+// "entregas.tar" -> "entregas.tex.tar"
+string nombrePaqueteSalida(const string& paqueteEntrada);
+
+#endif
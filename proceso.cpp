@@ -0,0 +1,101 @@
+#include "proceso.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+int ejecutarProceso(const vector<string>& argumentos, const string& directorio, const string& salida) {
+    if (argumentos.empty()) {
+        throw runtime_error("No se indico el programa a ejecutar");
+    }
+#if defined(_WIN32)
+    string comando = "cd /d \"" + directorio + "\" &&";
+    for (const auto& argumento : argumentos) {
+        comando += " \"" + argumento + "\"";
+    }
+    comando += " < NUL > \"" + salida + "\" 2>&1";
+    return system(comando.c_str());
+#else
+    vector<char*> punteros;
+    for (const auto& argumento : argumentos) {
+        punteros.push_back(const_cast<char*>(argumento.c_str()));
+    }
+    punteros.push_back(nullptr);
+
+    // Entre fork y exec solo llamadas seguras: el proceso tiene varios hilos
+    pid_t pid = fork();
+    if (pid < 0) {
+        throw runtime_error("No se pudo crear el proceso: " + argumentos[0]);
+    }
+    if (pid == 0) {
+        int nulo = open("/dev/null", O_RDONLY);
+        int log = open(salida.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (nulo < 0 || log < 0 || chdir(directorio.c_str()) != 0) _exit(126);
+        dup2(nulo, 0);
+        dup2(log, 1);
+        dup2(log, 2);
+        execvp(punteros[0], punteros.data());
+        _exit(127);
+    }
+
+    int estado = 0;
+    while (waitpid(pid, &estado, 0) < 0) {
+        if (errno != EINTR) return -1;
+    }
+    if (WIFEXITED(estado)) return WEXITSTATUS(estado);
+    return 128 + (WIFSIGNALED(estado) ? WTERMSIG(estado) : 0);
+#endif
+}
+
+string crearDirectorioTemporal() {
+    filesystem::path base = filesystem::temp_directory_path();
+#if defined(_WIN32)
+    static atomic<unsigned> contador(0);
+    for (;;) {
+        filesystem::path directorio = base / ("latexes-" + to_string(_getpid()) + "-" + to_string(contador++));
+        if (filesystem::create_directory(directorio)) return directorio.string();
+    }
+#else
+    string plantilla = (base / "latexes-XXXXXX").string();
+    if (mkdtemp(plantilla.data()) == nullptr) {
+        throw runtime_error("No se pudo crear un directorio temporal en " + base.string());
+    }
+    return plantilla;
+#endif
+}
+
+string resolverMotor(const string& preferido) {
+    if (!preferido.empty()) return preferido;
+    const char* variable = getenv("LATEXES_MOTOR");
+    return (variable != nullptr && *variable != '\0') ? variable : "pdflatex";
+}
+
+string ultimasLineas(const string& ruta, size_t cantidad) {
+    ifstream archivo(ruta);
+    deque<string> lineas;
+    string linea;
+    while (getline(archivo, linea)) {
+        if (linea.empty()) continue;
+        lineas.push_back(linea);
+        if (lineas.size() > cantidad) lineas.pop_front();
+    }
+    string texto;
+    for (const auto& l : lineas) {
+        texto += "    " + l + "\n";
+    }
+    return texto;
+}
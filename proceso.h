@@ -0,0 +1,30 @@
+#ifndef PROCESO_H
+#define PROCESO_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// ===============================
+// SUBPROCESOS DEL MOTOR TEX
+// ===============================
+
+// Ejecuta argumentos[0] (buscado en el PATH) con 'directorio' como
+// directorio de trabajo, la entrada estandar vacia y la salida estandar y de
+// error redirigidas al archivo 'salida'. Devuelve el codigo de salida; 127 si
+// no se pudo ejecutar. Puede llamarse desde varios hilos.
+int ejecutarProceso(const vector<string>& argumentos, const string& directorio, const string& salida);
+
+// Crea un directorio vacio con nombre unico bajo el temporal del sistema.
+string crearDirectorioTemporal();
+
+// Motor TeX a usar: 'preferido' si no esta vacio, si no LATEXES_MOTOR y si
+// tampoco esta, pdflatex.
+string resolverMotor(const string& preferido);
+
+// Ultimas 'cantidad' lineas no vacias de un archivo, con sangria, para
+// mostrar por que fallo el motor.
+string ultimasLineas(const string& ruta, size_t cantidad);
+
+#endif
@@ -0,0 +1,138 @@
+#include "referencias.h"
+
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+string claseDocumento(const NodoDocumento* documento) {
+    string clase = "article";
+    for (const auto& hijo : documento->hijos) {
+        if (auto config = dynamic_cast<const NodoConfiguracion*>(hijo.get())) {
+            if (config->clave == "tipo_documento") clase = config->valor;
+        }
+    }
+    return clase;
+}
+
+NumeracionClase numeracionDeClase(const string& clase) {
+    NumeracionClase numeracion;
+    if (clase == "report" || clase == "book") {
+        numeracion.capitulos = true;
+        numeracion.secnumdepth = 2;
+        numeracion.tocdepth = 2;
+    }
+    return numeracion;
+}
+
+int nivelSeccion(const string& nivel) {
+    if (nivel == "capitulo") return 0;
+    if (nivel == "seccion") return 1;
+    if (nivel == "subseccion") return 2;
+    return 3;
+}
+
+vector<Diagnostico> resolverReferencias(NodoDocumento* documento) {
+    vector<Diagnostico> diagnosticos;
+    NumeracionClase numeracion = numeracionDeClase(claseDocumento(documento));
+
+    // Con capitulos se numera como la clase report: secciones, ecuaciones y
+    // figuras llevan el numero del capitulo delante. Un capitulo en article
+    // no compila en LaTeX; se numera igual que en report.
+    bool hayCapitulos = numeracion.capitulos;
+    for (auto& hijo : documento->hijos) {
+        auto seccion = dynamic_cast<NodoSeccion*>(hijo.get());
+        if (seccion && seccion->nivel == "capitulo") {
+            hayCapitulos = true;
+            break;
+        }
+    }
+
+    int capitulo = 0, seccion = 0, subseccion = 0, subsubseccion = 0;
+    int ecuacion = 0, figura = 0;
+    string ultimoNumero;
+
+    unordered_map<string, string> etiquetas;
+    vector<EntradaIndice> entradasIndice;
+
+    auto prefijo = [&]() {
+        return hayCapitulos ? to_string(capitulo) + "." : string();
+    };
+
+    // Primera pasada: numerar y registrar etiquetas
+    for (auto& hijo : documento->hijos) {
+        NodoAST* nodo = hijo.get();
+
+        if (auto s = dynamic_cast<NodoSeccion*>(nodo)) {
+            int nivel = nivelSeccion(s->nivel);
+            if (nivel > numeracion.secnumdepth) {
+                // Sin numero, LaTeX no avanza el contador y la etiqueta
+                // sigue apuntando al elemento anterior
+                s->numero.clear();
+            } else if (s->nivel == "capitulo") {
+                capitulo++;
+                seccion = subseccion = subsubseccion = 0;
+                ecuacion = figura = 0;
+                s->numero = to_string(capitulo);
+            } else if (s->nivel == "seccion") {
+                seccion++;
+                subseccion = subsubseccion = 0;
+                s->numero = prefijo() + to_string(seccion);
+            } else if (s->nivel == "subseccion") {
+                subseccion++;
+                subsubseccion = 0;
+                s->numero = prefijo() + to_string(seccion) + "." + to_string(subseccion);
+            } else {
+                subsubseccion++;
+                s->numero = prefijo() + to_string(seccion) + "." + to_string(subseccion) +
+                            "." + to_string(subsubseccion);
+            }
+            if (!s->numero.empty()) ultimoNumero = s->numero;
+            if (nivel <= numeracion.tocdepth) {
+                entradasIndice.push_back(EntradaIndice{s->nivel, s->numero, s->titulo});
+            }
+        } else if (auto e = dynamic_cast<NodoEcuacion*>(nodo)) {
+            // Solo el entorno equation se numera; las formulas en linea no
+            if (e->tipo == "ecuacion") {
+                ecuacion++;
+                e->numero = prefijo() + to_string(ecuacion);
+                ultimoNumero = e->numero;
+            }
+        } else if (auto f = dynamic_cast<NodoFigura*>(nodo)) {
+            // LaTeX numera la figura al procesar \caption
+            if (!f->leyenda.empty()) {
+                figura++;
+                f->numero = prefijo() + to_string(figura);
+                ultimoNumero = f->numero;
+            }
+        } else if (auto etiqueta = dynamic_cast<NodoEtiqueta*>(nodo)) {
+            // Sin seccion, ecuacion ni figura antes, sus referencias saldrian
+            // como "??" sin ningun aviso
+            if (ultimoNumero.empty()) {
+                diagnosticos.emplace_back(Severidad::ADVERTENCIA, etiqueta->linea, etiqueta->columna,
+                    "Etiqueta \"" + etiqueta->clave + "\" sin seccion, ecuacion ni figura numerada antes");
+            }
+            if (!etiquetas.emplace(etiqueta->clave, ultimoNumero).second) {
+                diagnosticos.emplace_back(Severidad::ADVERTENCIA, etiqueta->linea, etiqueta->columna,
+                    "Etiqueta duplicada: \"" + etiqueta->clave + "\"");
+            }
+        }
+    }
+
+    // Segunda pasada: referencias e indice
+    for (auto& hijo : documento->hijos) {
+        if (auto referencia = dynamic_cast<NodoReferencia*>(hijo.get())) {
+            auto it = etiquetas.find(referencia->clave);
+            if (it != etiquetas.end()) {
+                referencia->numero = it->second;
+            } else {
+                diagnosticos.emplace_back(Severidad::ADVERTENCIA, referencia->linea, referencia->columna,
+                    "Referencia a una etiqueta inexistente: \"" + referencia->clave + "\"");
+            }
+        } else if (auto indice = dynamic_cast<NodoIndice*>(hijo.get())) {
+            indice->entradas = entradasIndice;
+        }
+    }
+
+    return diagnosticos;
+}
@@ -0,0 +1,47 @@
+#ifndef REFERENCIAS_H
+#define REFERENCIAS_H
+
+#include <string>
+#include <vector>
+
+#include "ast.h"
+#include "diagnostico.h"
+
+using namespace std;
+
+// ===============================
+// RESOLUCION DE REFERENCIAS E INDICE
+// ===============================
+//
+// Numera secciones, ecuaciones y figuras igual que LaTeX, asocia cada
+// etiqueta() al ultimo elemento numerado que la precede y escribe en cada
+// referencia() e indice() los valores ya resueltos. Asi el .tex no depende
+// del archivo .aux y basta con una pasada de pdflatex.
+//
+// Las etiquetas duplicadas y las referencias sin etiqueta se informan como
+// advertencias; la referencia se imprime como "??", igual que en LaTeX.
+//
+// La numeracion depende de la clase del documento, la misma que escribe
+// GeneradorLatex::preambulo: report y book tienen capitulos (sin ninguno,
+// las secciones salen 0.1, 0.2...) y no numeran ni ponen en el indice las
+// subsubsecciones.
+
+// Clase de \documentclass: la del ultimo configurar("tipo_documento", ...)
+// o article.
+string claseDocumento(const NodoDocumento* documento);
+
+// Valores por defecto de la clase (niveles: capitulo 0, seccion 1,
+// subseccion 2, subsubseccion 3).
+struct NumeracionClase {
+    bool capitulos = false; // contador chapter, delante de secciones, ecuaciones y figuras
+    int secnumdepth = 3;    // ultimo nivel que se numera
+    int tocdepth = 3;       // ultimo nivel que va al indice
+};
+
+NumeracionClase numeracionDeClase(const string& clase);
+
+int nivelSeccion(const string& nivel);
+
+vector<Diagnostico> resolverReferencias(NodoDocumento* documento);
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef TABLA_SIMBOLOS_H
+#define TABLA_SIMBOLOS_H
+
+#include <initializer_list>
+#include <iterator>
+#include <list>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "memoria.h"
+
+using namespace std;
+
+// ===============================
+// TABLA DE SIMBOLOS
+// ===============================
+
+class Atributos {
+public:
+    string lexema;
+    int token;
+    string tipo;
+    string valor;
+    string estado;
+
+    Atributos() {
+        lexema = "";
+        token = -999;
+        tipo = "";
+        valor = "nulo";
+        estado = "";
+    }
+
+    // Las cadenas se mueven a la entrada: quien ya no las necesita las pasa
+    // con move() y no se copian.
+    Atributos(string lex, int tok, string tip, string val, string est)
+        : lexema(move(lex)), token(tok), tipo(move(tip)), valor(move(val)), estado(move(est)) {}
+
+    void Mostrar(ostream& os) const {
+        os << "Tipo(" << tipo << ") \t";
+        os << "Lexema(" << lexema << ") \t";
+        os << "Token(" << token << ") \t";
+        os << "Valor(" << valor << ") \t";
+        os << "Estado(" << estado << ")" << "\n";
+    }
+};
+
+class TablaSimbolos {
+private:
+    list<Atributos> tabla;
+
+    // Indices hash sobre la lista: primera entrada de cada lexema y primera
+    // palabra clave. Los nodos de una list no se mueven al insertar, asi que
+    // los punteros siguen siendo validos y cada busqueda cuesta O(1) aunque la
+    // tabla crezca con cada identificador o texto del documento. Las claves
+    // apuntan al lexema guardado en la lista, sin copiarlo.
+    unordered_map<string_view, Atributos*> indice;
+    unordered_map<string_view, Atributos*> indicePalabrasClave;
+
+    // Entradas que sobreviven a Vaciar() y nodos quitados que esperan a
+    // ser reutilizados.
+    size_t fijas = 0;
+    list<Atributos> libres;
+
+    static const size_t NODOS_LIBRES_MAXIMOS = 4096;
+
+    Atributos* buscarEntrada(string_view lex) const {
+        auto it = indice.find(lex);
+        return it != indice.end() ? it->second : nullptr;
+    }
+
+public:
+    TablaSimbolos() = default;
+    TablaSimbolos(const TablaSimbolos&) = delete;
+    TablaSimbolos& operator=(const TablaSimbolos&) = delete;
+
+    // Si hay nodos libres (ver Vaciar()), se reutiliza uno y sus cadenas se
+    // copian sobre la capacidad que ya tenian.
+    void Insertar(string_view lex, int tok, string_view tip, string_view val, string_view est) {
+        if (libres.empty()) {
+            tabla.emplace_back(string(lex), tok, string(tip), string(val), string(est));
+        } else {
+            tabla.splice(tabla.end(), libres, libres.begin());
+            Atributos& reutilizado = tabla.back();
+            reutilizado.lexema.assign(lex);
+            reutilizado.token = tok;
+            reutilizado.tipo.assign(tip);
+            reutilizado.valor.assign(val);
+            reutilizado.estado.assign(est);
+        }
+        Atributos* nuevo = &tabla.back();
+        indice.try_emplace(nuevo->lexema, nuevo);
+        if (nuevo->tipo == "pclave") {
+            indicePalabrasClave.try_emplace(nuevo->lexema, nuevo);
+        }
+    }
+
+    // Las entradas insertadas hasta ahora (palabras clave y simbolos) pasan
+    // a ser fijas: Vaciar() las conserva.
+    void FijarEntradas() {
+        fijas = tabla.size();
+    }
+
+    // Quita las entradas de un documento y deja solo las fijas. Los nodos
+    // quitados, con la capacidad de sus cadenas, quedan para los proximos
+    // Insertar (hasta NODOS_LIBRES_MAXIMOS; el resto se libera).
+    void Vaciar() {
+        while (tabla.size() > fijas) {
+            auto ultimo = prev(tabla.end());
+            auto it = indice.find(ultimo->lexema);
+            if (it != indice.end() && it->second == &*ultimo) indice.erase(it);
+            auto itClave = indicePalabrasClave.find(ultimo->lexema);
+            if (itClave != indicePalabrasClave.end() && itClave->second == &*ultimo) {
+                indicePalabrasClave.erase(itClave);
+            }
+            libres.splice(libres.begin(), tabla, ultimo);
+        }
+        if (libres.size() > NODOS_LIBRES_MAXIMOS) {
+            libres.resize(NODOS_LIBRES_MAXIMOS);
+        }
+    }
+
+    bool ActualizarValor(string_view lex, string val) {
+        Atributos* item = buscarEntrada(lex);
+        if (item == nullptr) return false;
+        item->valor = move(val);
+        return true;
+    }
+
+    bool ActualizarTipo(string_view lex, string tipo) {
+        Atributos* item = buscarEntrada(lex);
+        if (item == nullptr) return false;
+        item->tipo = move(tipo);
+
+        // Caso raro: reconstruir la entrada del indice de palabras clave.
+        indicePalabrasClave.erase(lex);
+        for (auto &entrada : tabla) {
+            if (entrada.lexema == lex && entrada.tipo == "pclave") {
+                indicePalabrasClave.emplace(entrada.lexema, &entrada);
+                break;
+            }
+        }
+        return true;
+    }
+
+    bool ActualizarEstado(string_view lex, string est) {
+        Atributos* item = buscarEntrada(lex);
+        if (item == nullptr) return false;
+        item->estado = move(est);
+        return true;
+    }
+
+    // Escribe la tabla en el flujo indicado; la biblioteca nunca escribe
+    // por su cuenta en la consola.
+    void Mostrar(ostream& os) const {
+        os << "\nTABLA DE SIMBOLOS:\n";
+        os << "==================\n";
+        for (const auto& item : tabla) {
+            item.Mostrar(os);
+        }
+    }
+
+    // Primera entrada del lexema, o nullptr. El puntero sigue siendo valido
+    // mientras viva la tabla.
+    const Atributos* Buscar(string_view lex) const {
+        return buscarEntrada(lex);
+    }
+
+    const Atributos* BuscarPalabraClave(string_view lex) const {
+        auto it = indicePalabrasClave.find(lex);
+        return it != indicePalabrasClave.end() ? it->second : nullptr;
+    }
+
+    const list<Atributos>& getTabla() const {
+        return tabla;
+    }
+
+    size_t tamano() const {
+        return tabla.size();
+    }
+
+    // Bytes aproximados de la lista y los dos indices, para la contabilidad
+    // de memoria del compilador.
+    size_t bytesAproximados() const {
+        size_t bytes = 0;
+        for (const auto& item : tabla) {
+            bytes += sizeof(Atributos) + 2 * sizeof(void*) + bytesCadena(item.lexema) +
+                     bytesCadena(item.tipo) + bytesCadena(item.valor) + bytesCadena(item.estado);
+        }
+        for (const auto* mapa : {&indice, &indicePalabrasClave}) {
+            bytes += mapa->bucket_count() * sizeof(void*);
+            for (const auto& entrada : *mapa) {
+                bytes += sizeof(entrada) + 2 * sizeof(void*);
+            }
+        }
+        return bytes;
+    }
+};
+
+#endif
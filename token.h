@@ -0,0 +1,153 @@
+#ifndef TOKEN_H
+#define TOKEN_H
+
+#include <string>
+
+using namespace std;
+
+// ===============================
+// ENUMERACIONES Y ESTRUCTURAS
+// ===============================
+
+enum class TipoToken {
+    DOCUMENTO_INICIO, DOCUMENTO_FIN, CONFIGURAR,
+    SECCION, SUBSECCION, SUBSUBSECCION, CAPITULO,
+    NEGRITA, CURSIVA, SUBRAYADO, PARRAFO, TACHADO,
+    LISTA_SIMPLE, LISTA_NUMERADA, ELEMENTO, FIN_LISTA,
+    ECUACION, FORMULA, TABLA, FILA, COLUMNA, FIN_TABLA,
+    FIGURA, LEYENDA, REFERENCIA, ETIQUETA, INDICE, BIBLIOGRAFIA, CITA, DEFINIR, USAR, TITULO, AUTOR, FECHA,
+    CENTRAR, IZQUIERDA, DERECHA, JUSTIFICAR,
+    SALTO_LINEA, SALTO_PAGINA, NUEVA_PAGINA,
+
+    PARENTESIS_IZQ, PARENTESIS_DER, LLAVE_IZQ, LLAVE_DER,
+    CORCHETE_IZQ, CORCHETE_DER, COMA, PUNTO_COMA, IGUAL,
+    PORCENTAJE, DOLAR, AMPERSAND,
+
+    IDENTIFICADOR, CADENA, NUMERO, TEXTO_SIMPLE,
+
+    FIN_ARCHIVO
+};
+
+// Constantes para la tabla de transiciones
+const int FIN = 666;
+const int ERROR_SINTACTICO = 999;
+
+// Nombre legible de cada tipo de token. Es una funcion pura (sin mapa
+// estatico) para que varios hilos puedan usarla sin sincronizacion.
+inline const char* nombreTipoToken(TipoToken tipo) {
+    switch (tipo) {
+        case TipoToken::DOCUMENTO_INICIO: return "DOCUMENTO_INICIO";
+        case TipoToken::DOCUMENTO_FIN: return "DOCUMENTO_FIN";
+        case TipoToken::CONFIGURAR: return "CONFIGURAR";
+        case TipoToken::SECCION: return "SECCION";
+        case TipoToken::SUBSECCION: return "SUBSECCION";
+        case TipoToken::SUBSUBSECCION: return "SUBSUBSECCION";
+        case TipoToken::CAPITULO: return "CAPITULO";
+        case TipoToken::NEGRITA: return "NEGRITA";
+        case TipoToken::CURSIVA: return "CURSIVA";
+        case TipoToken::SUBRAYADO: return "SUBRAYADO";
+        case TipoToken::TACHADO: return "TACHADO";
+        case TipoToken::PARRAFO: return "PARRAFO";
+        case TipoToken::LISTA_SIMPLE: return "LISTA_SIMPLE";
+        case TipoToken::LISTA_NUMERADA: return "LISTA_NUMERADA";
+        case TipoToken::ELEMENTO: return "ELEMENTO";
+        case TipoToken::FIN_LISTA: return "FIN_LISTA";
+        case TipoToken::ECUACION: return "ECUACION";
+        case TipoToken::FORMULA: return "FORMULA";
+        case TipoToken::TABLA: return "TABLA";
+        case TipoToken::FIGURA: return "FIGURA";
+        case TipoToken::ETIQUETA: return "ETIQUETA";
+        case TipoToken::REFERENCIA: return "REFERENCIA";
+        case TipoToken::INDICE: return "INDICE";
+        case TipoToken::BIBLIOGRAFIA: return "BIBLIOGRAFIA";
+        case TipoToken::CITA: return "CITA";
+        case TipoToken::DEFINIR: return "DEFINIR";
+        case TipoToken::USAR: return "USAR";
+        case TipoToken::TEXTO_SIMPLE: return "TEXTO_SIMPLE";
+        default: return nullptr;
+    }
+}
+
+// Palabras reservadas y simbolos con su token. El analizador lexico carga
+// con ellas la tabla de simbolos; el verificador de --check las busca
+// directamente, sin tabla.
+struct PalabraReservada {
+    const char* lexema;
+    TipoToken tipo;
+};
+
+const PalabraReservada PALABRAS_RESERVADAS[] = {
+    {"documento_inicio", TipoToken::DOCUMENTO_INICIO},
+    {"documento_fin", TipoToken::DOCUMENTO_FIN},
+    {"configurar", TipoToken::CONFIGURAR},
+    {"seccion", TipoToken::SECCION},
+    {"subseccion", TipoToken::SUBSECCION},
+    {"subsubseccion", TipoToken::SUBSUBSECCION},
+    {"capitulo", TipoToken::CAPITULO},
+    {"negrita", TipoToken::NEGRITA},
+    {"cursiva", TipoToken::CURSIVA},
+    {"subrayado", TipoToken::SUBRAYADO},
+    {"tachado", TipoToken::TACHADO},
+    {"parrafo", TipoToken::PARRAFO},
+    {"lista_simple", TipoToken::LISTA_SIMPLE},
+    {"lista_numerada", TipoToken::LISTA_NUMERADA},
+    {"elemento", TipoToken::ELEMENTO},
+    {"fin_lista", TipoToken::FIN_LISTA},
+    {"ecuacion", TipoToken::ECUACION},
+    {"formula", TipoToken::FORMULA},
+    {"titulo", TipoToken::TITULO},
+    {"autor", TipoToken::AUTOR},
+    {"fecha", TipoToken::FECHA},
+    {"salto_linea", TipoToken::SALTO_LINEA},
+    {"salto_pagina", TipoToken::SALTO_PAGINA},
+    {"nueva_pagina", TipoToken::NUEVA_PAGINA},
+    {"tabla_csv", TipoToken::TABLA},
+    {"figura", TipoToken::FIGURA},
+    {"etiqueta", TipoToken::ETIQUETA},
+    {"referencia", TipoToken::REFERENCIA},
+    {"indice", TipoToken::INDICE},
+    {"bibliografia", TipoToken::BIBLIOGRAFIA},
+    {"cita", TipoToken::CITA},
+    {"definir", TipoToken::DEFINIR},
+    {"usar", TipoToken::USAR},
+};
+
+const PalabraReservada SIMBOLOS[] = {
+    {"(", TipoToken::PARENTESIS_IZQ},
+    {")", TipoToken::PARENTESIS_DER},
+    {"{", TipoToken::LLAVE_IZQ},
+    {"}", TipoToken::LLAVE_DER},
+    {"[", TipoToken::CORCHETE_IZQ},
+    {"]", TipoToken::CORCHETE_DER},
+    {",", TipoToken::COMA},
+    {";", TipoToken::PUNTO_COMA},
+    {"=", TipoToken::IGUAL},
+    {"%", TipoToken::PORCENTAJE},
+    {"$", TipoToken::DOLAR},
+    {"&", TipoToken::AMPERSAND},
+};
+
+struct Token {
+    TipoToken tipo;
+    string valor;
+    int linea;
+    int columna;
+
+    Token(TipoToken t, string v, int l, int c)
+        : tipo(t), valor(move(v)), linea(l), columna(c) {}
+
+    string toString() const {
+        const char* nombre = nombreTipoToken(tipo);
+        if (nombre != nullptr) {
+            return string(nombre) + "('" + valor + "')";
+        }
+        return "TOKEN('" + valor + "')";
+    }
+
+    // Para usar en tabla de transiciones
+    int getTokenValue() const {
+        return static_cast<int>(tipo);
+    }
+};
+
+#endif
@@ -0,0 +1,155 @@
+#include "trabajos_pdf.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "hash.h"
+#include "proceso.h"
+
+using namespace std;
+
+static const size_t LINEAS_ERROR = 12;
+
+// Hash del .tex, del motor y del tamano/fecha de cada dependencia. Las
+// dependencias no se leen: si su fecha no cambio se considera que tampoco
+// cambio el contenido, igual que hace make.
+static string calcularSello(const TrabajoPdf& trabajo, const string& motor, const string& contenidoTex) {
+    ostringstream clave;
+    clave << motor << '\n' << hashHex(hashContenido(contenidoTex)) << '\n';
+    for (const auto& dependencia : trabajo.dependencias) {
+        error_code error;
+        uintmax_t tamano = filesystem::file_size(dependencia, error);
+        if (error) {
+            clave << dependencia << "\t-\n";
+            continue;
+        }
+        long long modificacion = static_cast<long long>(
+            filesystem::last_write_time(dependencia, error).time_since_epoch().count());
+        clave << dependencia << '\t' << tamano << '\t' << modificacion << '\n';
+    }
+    return hashHex(hashContenido(clave.str()));
+}
+
+static string archivoSello(const filesystem::path& pdf) {
+    return (pdf.parent_path() / ("." + pdf.filename().string() + ".sello")).string();
+}
+
+static string leerSello(const string& ruta) {
+    ifstream archivo(ruta);
+    string sello;
+    getline(archivo, sello);
+    return sello;
+}
+
+static void moverArchivo(const filesystem::path& origen, const filesystem::path& destino) {
+    error_code error;
+    filesystem::rename(origen, destino, error);
+    if (error) {
+        // El temporal puede estar en otro sistema de archivos
+        filesystem::copy_file(origen, destino, filesystem::copy_options::overwrite_existing);
+    }
+}
+
+static void ejecutarTrabajo(const TrabajoPdf& trabajo, const string& motor, ResultadoPdf& resultado) {
+    auto inicio = chrono::steady_clock::now();
+    filesystem::path tex = filesystem::absolute(trabajo.archivoTex);
+    filesystem::path pdf = filesystem::path(tex).replace_extension(".pdf");
+    resultado.archivoTex = trabajo.archivoTex;
+    resultado.archivoPdf = filesystem::path(trabajo.archivoTex).replace_extension(".pdf").string();
+
+    filesystem::path temporal;
+    try {
+        ifstream archivo(tex, ios::binary);
+        if (!archivo.is_open()) {
+            throw runtime_error("No se pudo abrir el archivo: " + trabajo.archivoTex);
+        }
+        stringstream buffer;
+        buffer << archivo.rdbuf();
+
+        string sello = calcularSello(trabajo, motor, buffer.str());
+        string rutaSello = archivoSello(pdf);
+        if (filesystem::exists(pdf) && leerSello(rutaSello) == sello) {
+            resultado.estado = EstadoPdf::AL_DIA;
+        } else {
+            temporal = crearDirectorioTemporal();
+            string salida = (temporal / "motor.txt").string();
+            int codigo = ejecutarProceso({motor, "-interaction=nonstopmode", "-halt-on-error",
+                                          "-output-directory=" + temporal.string(),
+                                          tex.filename().string()},
+                                         tex.parent_path().string(), salida);
+            filesystem::path generado = temporal / pdf.filename();
+
+            if (codigo == 0 && filesystem::exists(generado)) {
+                moverArchivo(generado, pdf);
+                // El sello se escribe despues del PDF: si algo falla antes, la
+                // siguiente ejecucion vuelve a intentarlo
+                ofstream(rutaSello) << sello << '\n';
+                resultado.estado = EstadoPdf::GENERADO;
+            } else {
+                resultado.estado = EstadoPdf::FALLIDO;
+                resultado.error = (codigo == 127 ? "no se pudo ejecutar '" + motor + "'"
+                                                 : motor + " termino con codigo " + to_string(codigo)) +
+                                  "\n" + ultimasLineas(salida, LINEAS_ERROR);
+            }
+        }
+    } catch (const exception& e) {
+        resultado.estado = EstadoPdf::FALLIDO;
+        resultado.error = e.what();
+    }
+
+    if (!temporal.empty()) {
+        error_code error;
+        filesystem::remove_all(temporal, error);
+    }
+    resultado.segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+}
+
+vector<ResultadoPdf> generarPdfs(const vector<TrabajoPdf>& trabajos, const OpcionesPdf& opciones) {
+    vector<ResultadoPdf> resultados(trabajos.size());
+    if (trabajos.empty()) return resultados;
+
+    string motor = resolverMotor(opciones.motor);
+
+    // Los .tex con linea %& buscan su formato en TEXFORMATS; el separador
+    // final deja tambien la ruta por defecto del motor
+    if (!opciones.directorioFormatos.empty()) {
+        string rutas = filesystem::absolute(opciones.directorioFormatos).string();
+#if defined(_WIN32)
+        rutas += ";";
+        if (const char* actual = getenv("TEXFORMATS")) rutas += actual;
+        _putenv_s("TEXFORMATS", rutas.c_str());
+#else
+        rutas += ":";
+        if (const char* actual = getenv("TEXFORMATS")) rutas += actual;
+        setenv("TEXFORMATS", rutas.c_str(), 1);
+#endif
+    }
+
+    unsigned hilos = opciones.trabajos != 0 ? opciones.trabajos : thread::hardware_concurrency();
+    hilos = max(1u, min<unsigned>(hilos, static_cast<unsigned>(trabajos.size())));
+
+    atomic<size_t> siguiente(0);
+    auto trabajador = [&]() {
+        for (size_t i = siguiente++; i < trabajos.size(); i = siguiente++) {
+            ejecutarTrabajo(trabajos[i], motor, resultados[i]);
+        }
+    };
+
+    vector<thread> trabajadores;
+    for (unsigned i = 1; i < hilos; i++) {
+        trabajadores.emplace_back(trabajador);
+    }
+    trabajador();
+    for (auto& t : trabajadores) {
+        t.join();
+    }
+
+    return resultados;
+}
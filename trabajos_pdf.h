@@ -0,0 +1,50 @@
+#ifndef TRABAJOS_PDF_H
+#define TRABAJOS_PDF_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// ===============================
+// GENERACION DE PDF (MOTOR TEX COMO SUBPROCESO)
+// ===============================
+//
+// Cada trabajo ejecuta el motor TeX sobre un .tex generado, en un
+// directorio temporal propio, y mueve el PDF junto al .tex. Un sello
+// (.<nombre>.pdf.sello) guarda el hash del .tex y de sus archivos de
+// entrada tras cada PDF correcto; si nada cambio, el trabajo se omite.
+
+struct OpcionesPdf {
+    // Ejecutable del motor; vacio: LATEXES_MOTOR o, si no esta, pdflatex.
+    // Se invoca como
+    // <motor> -interaction=nonstopmode -halt-on-error -output-directory=<tmp> <archivo.tex>
+    string motor;
+    // Carpeta de los formatos precompilados (--formatos); vacia: ninguno.
+    string directorioFormatos;
+    // Trabajos simultaneos; 0 = uno por nucleo.
+    unsigned trabajos = 0;
+};
+
+struct TrabajoPdf {
+    string archivoTex;
+    vector<string> dependencias; // imagenes, CSV... que el .tex lee
+};
+
+enum class EstadoPdf {
+    GENERADO,
+    AL_DIA,
+    FALLIDO
+};
+
+struct ResultadoPdf {
+    string archivoTex;
+    string archivoPdf;
+    EstadoPdf estado = EstadoPdf::FALLIDO;
+    double segundos = 0.0;
+    string error; // ultimas lineas de la salida del motor si fallo
+};
+
+vector<ResultadoPdf> generarPdfs(const vector<TrabajoPdf>& trabajos, const OpcionesPdf& opciones);
+
+#endif
@@ -0,0 +1,85 @@
+#include "traza.h"
+
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+
+// Requiere tener tomado el cerrojo.
+int Traza::idHiloActual() {
+    auto it = hilos.find(this_thread::get_id());
+    if (it == hilos.end()) {
+        it = hilos.emplace(this_thread::get_id(), static_cast<int>(hilos.size()) + 1).first;
+    }
+    return it->second;
+}
+
+void Traza::nombrarHilo(const string& nombre) {
+    lock_guard<mutex> bloqueo(cerrojo);
+    nombresHilo[idHiloActual()] = nombre;
+}
+
+void Traza::registrar(const char* nombre, uint64_t inicioUs, uint64_t duracionUs,
+                      vector<pair<const char*, long long>> argumentos) {
+    lock_guard<mutex> bloqueo(cerrojo);
+    eventos.push_back(EventoTraza{nombre, inicioUs, duracionUs, idHiloActual(), move(argumentos)});
+}
+
+static void escribirCadenaJson(ofstream& archivo, const string& texto) {
+    archivo << '"';
+    for (char c : texto) {
+        switch (c) {
+            case '"': archivo << "\\\""; break;
+            case '\\': archivo << "\\\\"; break;
+            case '\n': archivo << "\\n"; break;
+            case '\t': archivo << "\\t"; break;
+            default: archivo << c; break;
+        }
+    }
+    archivo << '"';
+}
+
+void Traza::escribir(const string& nombreArchivo) {
+    lock_guard<mutex> bloqueo(cerrojo);
+
+    ofstream archivo(nombreArchivo);
+    if (!archivo.is_open()) {
+        throw runtime_error("No se pudo crear el archivo de traza: " + nombreArchivo);
+    }
+
+    archivo << "{\"traceEvents\":[\n";
+    bool primero = true;
+
+    // Una pista con nombre por hilo.
+    for (const auto& hilo : hilos) {
+        if (!primero) archivo << ",\n";
+        primero = false;
+        auto nombrado = nombresHilo.find(hilo.second);
+        string nombre = nombrado != nombresHilo.end() ? nombrado->second : "hilo " + to_string(hilo.second);
+        archivo << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << hilo.second
+                << ",\"args\":{\"name\":";
+        escribirCadenaJson(archivo, nombre);
+        archivo << "}}";
+    }
+
+    for (const auto& evento : eventos) {
+        if (!primero) archivo << ",\n";
+        primero = false;
+        archivo << "{\"name\":";
+        escribirCadenaJson(archivo, evento.nombre);
+        archivo << ",\"cat\":\"compilador\",\"ph\":\"X\",\"pid\":1,\"tid\":" << evento.hilo
+                << ",\"ts\":" << evento.inicioUs << ",\"dur\":" << evento.duracionUs;
+        if (!evento.argumentos.empty()) {
+            archivo << ",\"args\":{";
+            for (size_t i = 0; i < evento.argumentos.size(); i++) {
+                if (i > 0) archivo << ",";
+                escribirCadenaJson(archivo, evento.argumentos[i].first);
+                archivo << ":" << evento.argumentos[i].second;
+            }
+            archivo << "}";
+        }
+        archivo << "}";
+    }
+
+    archivo << "\n]}\n";
+}
@@ -0,0 +1,91 @@
+#ifndef TRAZA_H
+#define TRAZA_H
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// ===============================
+// TRAZA DE EVENTOS (formato Chrome / Perfetto)
+// ===============================
+//
+// Cada fase del compilador se registra como un evento completo ("ph":"X").
+// Los hilos se numeran en orden de aparicion y cada uno tiene su propia pista.
+
+struct EventoTraza {
+    string nombre;
+    uint64_t inicioUs;
+    uint64_t duracionUs;
+    int hilo;
+    vector<pair<const char*, long long>> argumentos;
+};
+
+class Traza {
+private:
+    chrono::steady_clock::time_point origen;
+    mutex cerrojo;
+    vector<EventoTraza> eventos;
+    map<thread::id, int> hilos;
+    map<int, string> nombresHilo;
+
+    int idHiloActual();
+
+public:
+    Traza() : origen(chrono::steady_clock::now()) {}
+
+    uint64_t ahoraUs() const {
+        return chrono::duration_cast<chrono::microseconds>(
+            chrono::steady_clock::now() - origen).count();
+    }
+
+    // Da nombre a la pista del hilo que llama (p. ej. "trabajador 2").
+    void nombrarHilo(const string& nombre);
+
+    void registrar(const char* nombre, uint64_t inicioUs, uint64_t duracionUs,
+                   vector<pair<const char*, long long>> argumentos);
+
+    // Escribe {"traceEvents":[...]} en el archivo indicado.
+    void escribir(const string& nombreArchivo);
+};
+
+// Intervalo RAII. Con traza nula no consulta el reloj ni reserva memoria,
+// por lo que instrumentar una fase cuesta una comparacion cuando la traza
+// esta desactivada.
+class SpanTraza {
+private:
+    Traza* traza;
+    const char* nombre;
+    uint64_t inicioUs;
+    vector<pair<const char*, long long>> argumentos;
+
+public:
+    SpanTraza(Traza* t, const char* n) : traza(t), nombre(n), inicioUs(0) {
+        if (traza != nullptr) {
+            inicioUs = traza->ahoraUs();
+        }
+    }
+
+    SpanTraza(const SpanTraza&) = delete;
+    SpanTraza& operator=(const SpanTraza&) = delete;
+
+    void argumento(const char* clave, long long valor) {
+        if (traza != nullptr) {
+            argumentos.emplace_back(clave, valor);
+        }
+    }
+
+    ~SpanTraza() {
+        if (traza != nullptr) {
+            traza->registrar(nombre, inicioUs, traza->ahoraUs() - inicioUs, move(argumentos));
+        }
+    }
+};
+
+#endif
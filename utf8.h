@@ -0,0 +1,203 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTF8_SSE2 1
+#endif
+
+using namespace std;
+
+// ===============================
+// UTF-8
+// ===============================
+//
+// El lexico trabaja sobre bytes; solo donde aparece un byte >= 0x80 decodifica
+// el punto de codigo. La validacion recorre la entrada una vez, de 16 en 16
+// bytes (SSE2) o de 8 en 8 (palabras de 64 bits): un bloque sin ningun byte
+// alto se salta sin mirarlo byte a byte, asi que un archivo ASCII cuesta
+// practicamente lo mismo que antes.
+
+struct ValidacionUtf8 {
+    size_t invalido = string_view::npos; // primer byte no valido
+    bool soloAscii = true;
+};
+
+namespace detalle_utf8 {
+
+// Bytes de la secuencia valida que empieza en texto[i]; 0 si no es valida
+// (continuacion suelta, secuencia corta o sobrelarga, sustitutos, > U+10FFFF).
+inline size_t longitudSecuencia(string_view texto, size_t i) {
+    unsigned char c = static_cast<unsigned char>(texto[i]);
+    size_t resto = texto.size() - i;
+    auto continuacion = [&](size_t k) {
+        return (static_cast<unsigned char>(texto[i + k]) & 0xC0) == 0x80;
+    };
+    if (c < 0x80) return 1;
+    if (c >= 0xC2 && c <= 0xDF) {
+        return resto >= 2 && continuacion(1) ? 2 : 0;
+    }
+    if (c >= 0xE0 && c <= 0xEF) {
+        if (resto < 3 || !continuacion(1) || !continuacion(2)) return 0;
+        unsigned char c1 = static_cast<unsigned char>(texto[i + 1]);
+        if (c == 0xE0 && c1 < 0xA0) return 0; // sobrelarga
+        if (c == 0xED && c1 >= 0xA0) return 0; // sustituto
+        return 3;
+    }
+    if (c >= 0xF0 && c <= 0xF4) {
+        if (resto < 4 || !continuacion(1) || !continuacion(2) || !continuacion(3)) return 0;
+        unsigned char c1 = static_cast<unsigned char>(texto[i + 1]);
+        if (c == 0xF0 && c1 < 0x90) return 0;
+        if (c == 0xF4 && c1 >= 0x90) return 0;
+        return 4;
+    }
+    return 0;
+}
+
+// Hay algun byte >= 0x80 en los 16 (SSE2) u 8 bytes de p?
+#if defined(UTF8_SSE2)
+const size_t BLOQUE = 16;
+inline bool bloqueAscii(const char* p) {
+    __m128i bloque = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    return _mm_movemask_epi8(bloque) == 0;
+}
+#else
+const size_t BLOQUE = 8;
+inline bool bloqueAscii(const char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return (v & 0x8080808080808080ULL) == 0;
+}
+#endif
+
+} // namespace detalle_utf8
+
+inline ValidacionUtf8 validarUtf8(string_view texto) {
+    ValidacionUtf8 resultado;
+    const char* datos = texto.data();
+    size_t n = texto.size();
+    size_t i = 0;
+    while (i < n) {
+        if (i + detalle_utf8::BLOQUE <= n && detalle_utf8::bloqueAscii(datos + i)) {
+            i += detalle_utf8::BLOQUE;
+            continue;
+        }
+        // Bloque con bytes altos (o cola): secuencia a secuencia hasta el
+        // final del bloque; la ultima puede pasarse de el.
+        size_t fin = i + detalle_utf8::BLOQUE;
+        while (i < n && i < fin) {
+            size_t longitud = detalle_utf8::longitudSecuencia(texto, i);
+            if (longitud == 0) {
+                resultado.invalido = i;
+                return resultado;
+            }
+            if (longitud > 1) resultado.soloAscii = false;
+            i += longitud;
+        }
+    }
+    return resultado;
+}
+
+// Decodifica la secuencia (ya validada) que empieza en texto[i].
+inline char32_t decodificarUtf8(string_view texto, size_t i, size_t& longitud) {
+    unsigned char c = static_cast<unsigned char>(texto[i]);
+    auto byte = [&](size_t k) { return static_cast<char32_t>(static_cast<unsigned char>(texto[i + k]) & 0x3F); };
+    if (c < 0x80) {
+        longitud = 1;
+        return c;
+    }
+    if (c < 0xE0) {
+        longitud = 2;
+        return (static_cast<char32_t>(c & 0x1F) << 6) | byte(1);
+    }
+    if (c < 0xF0) {
+        longitud = 3;
+        return (static_cast<char32_t>(c & 0x0F) << 12) | (byte(1) << 6) | byte(2);
+    }
+    longitud = 4;
+    return (static_cast<char32_t>(c & 0x07) << 18) | (byte(1) << 12) | (byte(2) << 6) | byte(3);
+}
+
+inline void codificarUtf8(char32_t cp, string& destino) {
+    if (cp < 0x80) {
+        destino += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        destino += static_cast<char>(0xC0 | (cp >> 6));
+        destino += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        destino += static_cast<char>(0xE0 | (cp >> 12));
+        destino += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        destino += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        destino += static_cast<char>(0xF0 | (cp >> 18));
+        destino += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        destino += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        destino += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// Letra (o marca combinante) fuera de ASCII: puede formar parte de un
+// identificador o de una palabra clave. Quedan fuera los espacios, la
+// puntuacion y los simbolos de Latin-1 (¡ ¿ « » ° ×...), la puntuacion
+// general (comillas tipograficas, guiones, elipsis) y el BOM.
+inline bool esLetraUtf8(char32_t cp) {
+    if (cp < 0x80) return false;
+    if (cp <= 0xBF) return cp == 0xAA || cp == 0xB5 || cp == 0xBA; // ª µ º
+    if (cp == 0xD7 || cp == 0xF7) return false;                      // × ÷
+    if (cp >= 0x2000 && cp <= 0x2BFF) return false; // puntuacion, simbolos, flechas
+    if (cp >= 0x3000 && cp <= 0x303F) return false; // puntuacion CJK
+    if (cp == 0xFEFF) return false;
+    return true;
+}
+
+// Minuscula sin tilde de una letra latina (las de las palabras clave del
+// lenguaje): 'Á' y 'á' -> 'a', 'Ü' -> 'u'. 'ñ' y 'ç' se conservan (en
+// minuscula). Las marcas combinantes (U+0300-U+036F) devuelven 0: la
+// forma descompuesta "o" + tilde combinante se pliega igual que "ó".
+inline char32_t plegarLetra(char32_t cp) {
+    if (cp >= 0x0300 && cp <= 0x036F) return 0;
+    if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) cp += 0x20; // mayusculas Latin-1
+    switch (cp) {
+        case 0xE0: case 0xE1: case 0xE2: case 0xE3: case 0xE4: case 0xE5: return 'a';
+        case 0xE8: case 0xE9: case 0xEA: case 0xEB: return 'e';
+        case 0xEC: case 0xED: case 0xEE: case 0xEF: return 'i';
+        case 0xF2: case 0xF3: case 0xF4: case 0xF5: case 0xF6: return 'o';
+        case 0xF9: case 0xFA: case 0xFB: case 0xFC: return 'u';
+        default: return cp;
+    }
+}
+
+// Clave de busqueda de una palabra en la tabla de palabras clave:
+// minusculas y sin tildes, de modo que "Sección", "SECCIÓN" y "seccion"
+// son la misma palabra clave. Sin bytes altos es un simple tolower. Deja
+// el resultado en 'clave', que se reutiliza entre llamadas sin reservar.
+inline void plegarPalabra(string_view palabra, string& clave) {
+    clave.clear();
+    for (size_t i = 0; i < palabra.size();) {
+        unsigned char c = static_cast<unsigned char>(palabra[i]);
+        if (c < 0x80) {
+            clave += static_cast<char>(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+            i++;
+            continue;
+        }
+        size_t longitud;
+        char32_t cp = plegarLetra(decodificarUtf8(palabra, i, longitud));
+        if (cp != 0) codificarUtf8(cp, clave);
+        i += longitud;
+    }
+}
+
+inline string plegarPalabra(string_view palabra) {
+    string clave;
+    clave.reserve(palabra.size());
+    plegarPalabra(palabra, clave);
+    return clave;
+}
+
+#endif
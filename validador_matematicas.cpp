@@ -0,0 +1,462 @@
+#include "validador_matematicas.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MATEMATICAS_SSE2 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+using namespace std;
+
+// Caracteres que el validador tiene que mirar; el resto se salta.
+static bool esEspecial(char c) {
+    switch (c) {
+        case '\\': case '{': case '}': case '$': case '#': case '%': case '&': case '\n':
+            return true;
+        default:
+            return false;
+    }
+}
+
+namespace {
+
+// Recorre las posiciones de los caracteres especiales. Con SSE2 compara 16
+// bytes a la vez contra los ocho caracteres y guarda la mascara del bloque:
+// los demas especiales del mismo bloque salen de sus bits sin volver a
+// leerlo, asi que una formula densa en comandos tampoco va byte a byte.
+class EscanerEspeciales {
+private:
+    string_view texto;
+#if defined(MATEMATICAS_SSE2)
+    size_t base = 0;      // inicio del bloque de 'mascara'
+    unsigned mascara = 0; // bit k: texto[base + k] es especial
+    bool hayBloque = false;
+
+    static unsigned mascaraBloque(const char* p) {
+        __m128i bloque = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i coincide = _mm_or_si128(
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bloque, _mm_set1_epi8('\\')),
+                                      _mm_cmpeq_epi8(bloque, _mm_set1_epi8('{'))),
+                         _mm_or_si128(_mm_cmpeq_epi8(bloque, _mm_set1_epi8('}')),
+                                      _mm_cmpeq_epi8(bloque, _mm_set1_epi8('$')))),
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bloque, _mm_set1_epi8('#')),
+                                      _mm_cmpeq_epi8(bloque, _mm_set1_epi8('%'))),
+                         _mm_or_si128(_mm_cmpeq_epi8(bloque, _mm_set1_epi8('&')),
+                                      _mm_cmpeq_epi8(bloque, _mm_set1_epi8('\n')))));
+        return static_cast<unsigned>(_mm_movemask_epi8(coincide));
+    }
+
+    static size_t primerBit(unsigned m) {
+#if defined(_MSC_VER)
+        unsigned long indice;
+        _BitScanForward(&indice, m);
+        return indice;
+#else
+        return static_cast<size_t>(__builtin_ctz(m));
+#endif
+    }
+#endif
+
+public:
+    void reiniciar(string_view contenido) {
+        texto = contenido;
+#if defined(MATEMATICAS_SSE2)
+        hayBloque = false;
+#endif
+    }
+
+    // Posicion del siguiente caracter especial desde 'i' (o el final).
+    size_t siguiente(size_t i) {
+        size_t n = texto.size();
+#if defined(MATEMATICAS_SSE2)
+        while (true) {
+            if (hayBloque && i >= base && i < base + 16) {
+                unsigned pendientes = mascara & (0xFFFFu << (i - base));
+                if (pendientes != 0) return base + primerBit(pendientes);
+                i = base + 16;
+            }
+            if (i + 16 > n) break;
+            base = i;
+            mascara = mascaraBloque(texto.data() + i);
+            hayBloque = true;
+        }
+#endif
+        while (i < n && !esEspecial(texto[i])) i++;
+        return i;
+    }
+};
+
+// Entornos que abren modo display: no pueden ir dentro de una formula.
+const char* const ENTORNOS_DISPLAY[] = {
+    "equation", "equation*", "align", "align*", "alignat", "alignat*", "gather", "gather*",
+    "multline", "multline*", "flalign", "flalign*", "eqnarray", "eqnarray*", "displaymath",
+    "math", "document",
+};
+
+bool esEntornoDisplay(string_view nombre) {
+    for (const char* entorno : ENTORNOS_DISPLAY) {
+        if (nombre == entorno) return true;
+    }
+    return false;
+}
+
+// Comandos cuyo argumento esta en modo texto.
+const char* const COMANDOS_TEXTO[] = {
+    "text", "mbox", "hbox", "fbox", "textrm", "textbf", "textit", "textsf", "texttt", "textup",
+    "textsl", "textsc", "textmd", "textnormal",
+};
+
+bool esComandoTexto(string_view nombre) {
+    if (nombre[0] != 't' && nombre[0] != 'm' && nombre[0] != 'h' && nombre[0] != 'f') return false;
+    for (const char* comando : COMANDOS_TEXTO) {
+        if (nombre == comando) return true;
+    }
+    return false;
+}
+
+enum class TipoApertura {
+    LLAVE,
+    LEFT,
+    ENTORNO
+};
+
+struct Apertura {
+    TipoApertura tipo;
+    size_t posicion;
+    string_view entorno;
+};
+
+// Se reutiliza entre formulas para no reservar la pila en cada una.
+class Validador {
+private:
+    string_view texto;
+    bool enLinea = false;
+    vector<Apertura> pila;
+    size_t entornosAbiertos = 0;
+    EscanerEspeciales escaner;
+
+    bool fallar(ErrorMatematico& error, size_t posicion, const string& mensaje) const {
+        error.posicion = posicion;
+        error.mensaje = mensaje;
+        return false;
+    }
+
+    size_t saltarEspacios(size_t i) const {
+        while (i < texto.size() && (texto[i] == ' ' || texto[i] == '\t')) i++;
+        return i;
+    }
+
+    // Letras de un nombre de comando de TeX (solo ASCII)
+    static bool esLetra(char c) {
+        return static_cast<unsigned char>((c | 0x20) - 'a') < 26;
+    }
+
+    // Nombre del comando que empieza en i (tras la barra): letras, o un solo
+    // caracter si no empieza con letra.
+    size_t finComando(size_t i) const {
+        if (i >= texto.size()) return i;
+        if (!esLetra(texto[i])) return i + 1;
+        while (i < texto.size() && esLetra(texto[i])) i++;
+        return i;
+    }
+
+    // Lee "{nombre}" de \begin o \end a partir de i. Devuelve la posicion
+    // tras la llave de cierre, o npos si no hay nombre.
+    size_t leerNombreEntorno(size_t i, string_view& nombre) const {
+        i = saltarEspacios(i);
+        if (i >= texto.size() || texto[i] != '{') return string_view::npos;
+        size_t fin = texto.find('}', i + 1);
+        if (fin == string_view::npos) return string_view::npos;
+        nombre = texto.substr(i + 1, fin - i - 1);
+        return fin + 1;
+    }
+
+    // Salta el delimitador de \left, \middle o \right: un caracter o un
+    // comando (\{, \langle...). Devuelve npos si falta.
+    size_t saltarDelimitador(size_t i) const {
+        i = saltarEspacios(i);
+        if (i >= texto.size() || texto[i] == '{' || texto[i] == '}' || texto[i] == '\n') {
+            return string_view::npos;
+        }
+        if (texto[i] == '\\') return finComando(i + 1);
+        return i + 1;
+    }
+
+    // Argumento de \text, \mbox...: va en modo texto, donde $ abre una
+    // formula en linea (\text{si $x > 0$}). Se salta hasta su llave de
+    // cierre; dentro solo se exige que las llaves cierren, que los $ vayan de
+    // a pares y que no haya # ni %.
+    bool argumentoTexto(size_t& i, ErrorMatematico& error) const {
+        size_t apertura = saltarEspacios(i);
+        if (apertura >= texto.size() || texto[apertura] != '{') return true; // \text x
+        int profundidad = 0;
+        size_t dolar = string_view::npos;
+        for (size_t j = apertura; j < texto.size(); j++) {
+            switch (texto[j]) {
+                case '\\':
+                    j++;
+                    break;
+                case '{':
+                    profundidad++;
+                    break;
+                case '}':
+                    if (--profundidad > 0) break;
+                    if (dolar != string_view::npos) {
+                        return fallar(error, dolar, "$ sin cerrar dentro de \\text{...}");
+                    }
+                    i = j + 1;
+                    return true;
+                case '$':
+                    dolar = dolar == string_view::npos ? j : string_view::npos;
+                    break;
+                case '#':
+                    return fallar(error, j, "# fuera de una definicion de macro (use \\#)");
+                case '%':
+                    return fallar(error, j, "% comenta el resto de la linea (use \\%)");
+            }
+        }
+        return fallar(error, apertura, "{ sin }");
+    }
+
+    bool comando(size_t& i, ErrorMatematico& error) {
+        size_t inicio = i;
+        size_t fin = finComando(i + 1);
+        string_view nombre = texto.substr(i + 1, fin - i - 1);
+        i = fin;
+
+        if (nombre.empty()) {
+            return fallar(error, inicio, "\\ al final de la formula");
+        }
+        if (nombre.size() == 1) {
+            if (strchr("[]()", nombre[0]) != nullptr) {
+                return fallar(error, inicio, "\\" + string(nombre) + " no puede usarse dentro de una formula");
+            }
+            return true;
+        }
+        if (esComandoTexto(nombre)) return argumentoTexto(i, error);
+        // Los demas comandos que se revisan tienen de 3 a 6 letras; el resto
+        // (\frac, \alpha...) pasa sin comparar.
+        if (nombre.size() > 6) return true;
+
+        if (enLinea && nombre == "tag") {
+            return fallar(error, inicio, "\\tag solo puede usarse en ecuacion(), no en formula()");
+        }
+
+        if (nombre == "begin" || nombre == "end") {
+            string_view entorno;
+            size_t finNombre = leerNombreEntorno(i, entorno);
+            if (finNombre == string_view::npos) {
+                return fallar(error, inicio, "\\" + string(nombre) + " sin {nombre del entorno}");
+            }
+            i = finNombre;
+            if (nombre == "begin") {
+                if (esEntornoDisplay(entorno)) {
+                    return fallar(error, inicio, "El entorno " + string(entorno) +
+                                                     " no puede ir dentro de una formula");
+                }
+                pila.push_back(Apertura{TipoApertura::ENTORNO, inicio, entorno});
+                entornosAbiertos++;
+                return true;
+            }
+            if (pila.empty() || pila.back().tipo != TipoApertura::ENTORNO) {
+                return cierreInesperado(inicio, "\\end{" + string(entorno) + "}", error);
+            }
+            if (pila.back().entorno != entorno) {
+                return fallar(error, inicio, "\\end{" + string(entorno) + "} cierra \\begin{" +
+                                                 string(pila.back().entorno) + "}");
+            }
+            pila.pop_back();
+            entornosAbiertos--;
+            return true;
+        }
+
+        if (nombre == "left" || nombre == "middle" || nombre == "right") {
+            size_t finDelimitador = saltarDelimitador(i);
+            if (finDelimitador == string_view::npos) {
+                return fallar(error, inicio, "Falta el delimitador despues de \\" + string(nombre));
+            }
+            i = finDelimitador;
+            if (nombre == "left") {
+                pila.push_back(Apertura{TipoApertura::LEFT, inicio, string_view()});
+                return true;
+            }
+            if (pila.empty() || pila.back().tipo != TipoApertura::LEFT) {
+                return cierreInesperado(inicio, "\\" + string(nombre), error);
+            }
+            if (nombre == "right") pila.pop_back();
+            return true;
+        }
+
+        return true;
+    }
+
+    // Un cierre que no corresponde a la ultima apertura.
+    bool cierreInesperado(size_t posicion, const string& cierre, ErrorMatematico& error) const {
+        if (pila.empty()) {
+            string apertura = cierre == "}" ? "{" : cierre[1] == 'e' ? "\\begin" : "\\left";
+            return fallar(error, posicion, cierre + " sin " + apertura);
+        }
+        return fallar(error, posicion, cierre + " antes de cerrar " + descripcion(pila.back()));
+    }
+
+    static string descripcion(const Apertura& apertura) {
+        switch (apertura.tipo) {
+            case TipoApertura::LLAVE: return "{";
+            case TipoApertura::LEFT: return "\\left";
+            default: return "\\begin{" + string(apertura.entorno) + "}";
+        }
+    }
+
+public:
+    bool validar(string_view contenido, bool formulaEnLinea, ErrorMatematico& error) {
+        texto = contenido;
+        enLinea = formulaEnLinea;
+        pila.clear();
+        entornosAbiertos = 0;
+        escaner.reiniciar(contenido);
+
+        size_t i = 0;
+        while ((i = escaner.siguiente(i)) < texto.size()) {
+            switch (texto[i]) {
+                case '\\':
+                    if (!comando(i, error)) return false;
+                    continue;
+                case '{':
+                    pila.push_back(Apertura{TipoApertura::LLAVE, i, string_view()});
+                    break;
+                case '}':
+                    if (pila.empty() || pila.back().tipo != TipoApertura::LLAVE) {
+                        return cierreInesperado(i, "}", error);
+                    }
+                    pila.pop_back();
+                    break;
+                case '$':
+                    return fallar(error, i, "$ dentro de una formula (use \\$ para el simbolo)");
+                case '#':
+                    return fallar(error, i, "# fuera de una definicion de macro (use \\#)");
+                case '%':
+                    return fallar(error, i, "% comenta el resto de la linea (use \\%)");
+                case '&':
+                    if (entornosAbiertos == 0) {
+                        return fallar(error, i, "& fuera de un entorno de alineacion (aligned, cases, matrix...)");
+                    }
+                    break;
+                case '\n': {
+                    size_t siguiente = saltarEspacios(i + 1);
+                    if (siguiente < texto.size() && texto[siguiente] == '\n') {
+                        return fallar(error, i, "Linea en blanco dentro de una formula");
+                    }
+                    break;
+                }
+            }
+            i++;
+        }
+
+        if (!pila.empty()) {
+            const Apertura& abierta = pila.back();
+            string cierre = abierta.tipo == TipoApertura::LLAVE ? "}" :
+                            abierta.tipo == TipoApertura::LEFT ? "\\right" :
+                            "\\end{" + string(abierta.entorno) + "}";
+            return fallar(error, abierta.posicion, descripcion(abierta) + " sin " + cierre);
+        }
+        return true;
+    }
+};
+
+// Inicio (en bytes) de cada linea de la fuente; se construye la primera vez
+// que hay un error que ubicar.
+class UbicadorFuente {
+private:
+    string_view fuente;
+    vector<size_t> inicioLineas;
+
+public:
+    explicit UbicadorFuente(string_view fuente) : fuente(fuente) {}
+
+    // Linea y columna (en caracteres, como las del analizador lexico) del
+    // byte 'posicion' del contenido de la cadena de la sentencia que empieza
+    // en (linea, columna). Repite el tratamiento de escapes del analizador
+    // lexico para contar los bytes de la fuente.
+    void ubicar(int linea, int columna, size_t posicion, int& lineaError, int& columnaError) {
+        lineaError = linea;
+        columnaError = columna;
+        if (linea <= 0 || fuente.empty()) return;
+
+        if (inicioLineas.empty()) {
+            inicioLineas.push_back(0);
+            for (size_t i = 0; i < fuente.size(); i++) {
+                if (fuente[i] == '\n') inicioLineas.push_back(i + 1);
+            }
+        }
+        if (static_cast<size_t>(linea) > inicioLineas.size()) return;
+
+        auto iniciaCaracter = [](char c) { return (static_cast<unsigned char>(c) & 0xC0) != 0x80; };
+        size_t i = inicioLineas[linea - 1];
+        for (int c = 1; c < columna && i < fuente.size() && fuente[i] != '\n';) {
+            i++;
+            if (i < fuente.size() && iniciaCaracter(fuente[i])) c++;
+        }
+
+        int l = linea;
+        int c = columna;
+        auto avanzar = [&]() {
+            if (fuente[i] == '\n') {
+                l++;
+                c = 1;
+            } else if (iniciaCaracter(fuente[i])) {
+                c++;
+            }
+            i++;
+        };
+
+        // Hasta la comilla de la cadena: ecuacion ( "..."
+        while (i < fuente.size() && fuente[i] != '"') avanzar();
+        if (i >= fuente.size()) return;
+        avanzar();
+
+        size_t producidos = 0;
+        while (i < fuente.size() && fuente[i] != '"') {
+            size_t bytesFuente = 1;
+            size_t bytesContenido = 1;
+            if (fuente[i] == '\\' && i + 1 < fuente.size()) {
+                char escape = fuente[i + 1];
+                bytesFuente = 2;
+                bytesContenido = strchr("nt\"\\", escape) != nullptr ? 1 : 2;
+            }
+            if (producidos + bytesContenido > posicion) break;
+            producidos += bytesContenido;
+            for (size_t k = 0; k < bytesFuente; k++) avanzar();
+        }
+        lineaError = l;
+        columnaError = c;
+    }
+};
+
+} // namespace
+
+bool validarFormula(string_view contenido, bool enLinea, ErrorMatematico& error) {
+    return Validador().validar(contenido, enLinea, error);
+}
+
+vector<Diagnostico> validarMatematicas(const NodoDocumento* documento, string_view fuente) {
+    vector<Diagnostico> diagnosticos;
+    Validador validador;
+    UbicadorFuente ubicador(fuente);
+    for (const auto& hijo : documento->hijos) {
+        // Las de una macro ya se validaron al expandirla (macros.h)
+        auto ecuacion = dynamic_cast<const NodoEcuacion*>(hijo.get());
+        if (!ecuacion || ecuacion->expandido) continue;
+
+        ErrorMatematico error;
+        if (validador.validar(ecuacion->contenido, ecuacion->tipo == "formula", error)) continue;
+
+        int linea, columna;
+        ubicador.ubicar(ecuacion->linea, ecuacion->columna, error.posicion, linea, columna);
+        diagnosticos.emplace_back(Severidad::ERROR, linea, columna, error.mensaje);
+    }
+    return diagnosticos;
+}
@@ -0,0 +1,54 @@
+#ifndef VALIDADOR_MATEMATICAS_H
+#define VALIDADOR_MATEMATICAS_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ast.h"
+#include "diagnostico.h"
+
+using namespace std;
+
+// ===============================
+// VALIDACION DE ECUACIONES Y FORMULAS
+// ===============================
+//
+// El contenido de ecuacion() y formula() pasa tal cual al .tex. Un error en
+// el (una llave sin cerrar, un $ suelto) solo aparecia al ejecutar pdflatex,
+// y el motor lo informa lejos de la linea del .texes. Esta fase revisa cada
+// formula antes de generar:
+//
+//   - llaves {} equilibradas (sin contar \{ y \});
+//   - \left / \middle / \right emparejados y anidados con las llaves;
+//   - \begin{x} / \end{x} anidados, sin entornos de modo display (equation,
+//     align...) dentro de la formula;
+//   - caracteres que rompen el modo matematico: $, \[, \], \(, \), #, %,
+//     una linea en blanco, y & fuera de un entorno (aligned, cases, matrix).
+//
+// El argumento de \text, \mbox, \textrm... esta en modo texto: ahi $...$
+// es una formula en linea y vale; solo se revisa que cierre su llave, que
+// los $ vayan de a pares y que no tenga # ni %.
+//
+// Los corchetes y parentesis sueltos no se exigen equilibrados: un
+// intervalo como [0, 1) es valido en TeX.
+//
+// El recorrido salta de un caracter especial al siguiente; con SSE2 se
+// descartan 16 bytes por comparacion.
+
+struct ErrorMatematico {
+    size_t posicion; // byte del contenido de la formula
+    string mensaje;
+};
+
+// Primer error de la formula, o false si es valida. 'enLinea' es true para
+// formula() ($...$) y false para ecuacion() (entorno equation).
+bool validarFormula(string_view contenido, bool enLinea, ErrorMatematico& error);
+
+// Valida las ecuaciones y formulas del documento. Los errores se ubican en
+// la linea y columna de 'fuente' (el .texes del que sale el arbol) donde
+// esta el caracter culpable dentro de la cadena.
+vector<Diagnostico> validarMatematicas(const NodoDocumento* documento, string_view fuente);
+
+#endif
@@ -0,0 +1,456 @@
+#include "verificador.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <exception>
+#include <thread>
+
+#include "analizador_sintactico.h"
+#include "archivo_mapeado.h"
+#include "token.h"
+#include "utf8.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VERIFICADOR_SSE2 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+using namespace std;
+
+namespace {
+
+#if defined(VERIFICADOR_SSE2)
+size_t primerBit(unsigned m) {
+#if defined(_MSC_VER)
+    unsigned long indice;
+    _BitScanForward(&indice, m);
+    return indice;
+#else
+    return static_cast<size_t>(__builtin_ctz(m));
+#endif
+}
+#endif
+
+// Primera posicion desde 'i' con alguno de los bytes a, b, c o d (o el
+// final del texto).
+size_t buscar(string_view texto, size_t i, char a, char b, char c, char d) {
+    const char* datos = texto.data();
+    size_t n = texto.size();
+#if defined(VERIFICADOR_SSE2)
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    const __m128i vc = _mm_set1_epi8(c);
+    const __m128i vd = _mm_set1_epi8(d);
+    while (i + 16 <= n) {
+        __m128i bloque = _mm_loadu_si128(reinterpret_cast<const __m128i*>(datos + i));
+        __m128i coincide = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bloque, va), _mm_cmpeq_epi8(bloque, vb)),
+                                        _mm_or_si128(_mm_cmpeq_epi8(bloque, vc), _mm_cmpeq_epi8(bloque, vd)));
+        unsigned mascara = static_cast<unsigned>(_mm_movemask_epi8(coincide));
+        if (mascara != 0) return i + primerBit(mascara);
+        i += 16;
+    }
+#endif
+    while (i < n && datos[i] != a && datos[i] != b && datos[i] != c && datos[i] != d) i++;
+    return i;
+}
+
+bool esDigito(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool esLetraAscii(char c) {
+    return static_cast<unsigned char>((c | 0x20) - 'a') < 26;
+}
+
+bool esEspacio(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// Busqueda de palabras reservadas sin tabla de simbolos: se compara solo
+// con las de la misma longitud.
+const size_t LONGITUD_MAXIMA_RESERVADA = 24;
+
+struct Reservada {
+    string_view lexema;
+    TipoToken tipo;
+};
+
+struct TablaReservadas {
+    vector<Reservada> porLongitud[LONGITUD_MAXIMA_RESERVADA + 1];
+
+    TablaReservadas() {
+        for (const PalabraReservada& palabra : PALABRAS_RESERVADAS) {
+            string_view lexema = palabra.lexema;
+            porLongitud[lexema.size()].push_back(Reservada{lexema, palabra.tipo});
+        }
+    }
+};
+
+const TablaReservadas& tablaReservadas() {
+    static const TablaReservadas tabla;
+    return tabla;
+}
+
+bool buscarReservada(string_view clave, TipoToken& tipo) {
+    if (clave.size() > LONGITUD_MAXIMA_RESERVADA) return false;
+    for (const Reservada& reservada : tablaReservadas().porLongitud[clave.size()]) {
+        if (reservada.lexema == clave) {
+            tipo = reservada.tipo;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool tipoSimbolo(char c, TipoToken& tipo) {
+    switch (c) {
+        case '(': tipo = TipoToken::PARENTESIS_IZQ; return true;
+        case ')': tipo = TipoToken::PARENTESIS_DER; return true;
+        case '{': tipo = TipoToken::LLAVE_IZQ; return true;
+        case '}': tipo = TipoToken::LLAVE_DER; return true;
+        case '[': tipo = TipoToken::CORCHETE_IZQ; return true;
+        case ']': tipo = TipoToken::CORCHETE_DER; return true;
+        case ',': tipo = TipoToken::COMA; return true;
+        case ';': tipo = TipoToken::PUNTO_COMA; return true;
+        case '=': tipo = TipoToken::IGUAL; return true;
+        case '$': tipo = TipoToken::DOLAR; return true;
+        case '&': tipo = TipoToken::AMPERSAND; return true;
+        default: return false; // '.' no es token
+    }
+}
+
+bool esElemento(char c) {
+    return c != '\0' && strchr("(){}[]=,;.%$&", c) != nullptr;
+}
+
+bool aceptaTextoSimple(TipoToken tipo) {
+    return tipo == TipoToken::PARRAFO || tipo == TipoToken::NEGRITA ||
+           tipo == TipoToken::CURSIVA || tipo == TipoToken::SUBRAYADO ||
+           tipo == TipoToken::TACHADO || tipo == TipoToken::ELEMENTO;
+}
+
+// Mismas reglas que AnalizadorLexico::analizar(), con cada token entregado
+// al automata en cuanto se reconoce. Los comentarios remiten al metodo del
+// analizador lexico que se replica.
+class Verificador {
+private:
+    string_view texto;
+    size_t n;
+    size_t pos = 0;
+    size_t inicioContenido = 0; // 3 si hay BOM
+    const AnalizadorSintactico& automata;
+
+    int estado = 0;
+    bool aceptado = false; // ESTADO_FINAL: el resto solo se lexea
+
+    // Como en compilar(), un error lexico en cualquier parte del texto
+    // prevalece sobre uno de sintaxis anterior.
+    bool hayErrorLexico = false;
+    bool hayErrorSintactico = false;
+    size_t posicionError = 0;
+    string mensajeError;
+
+    // Linea y columna de la posicion 'p', contadas como el analizador lexico
+    // (columnas en caracteres, sin el BOM).
+    void ubicar(size_t p, int& linea, int& columna) const {
+        linea = 1 + static_cast<int>(count(texto.begin(), texto.begin() + p, '\n'));
+        size_t inicioLinea = p == 0 ? 0 : texto.rfind('\n', p - 1);
+        inicioLinea = inicioLinea == string_view::npos ? 0 : inicioLinea + 1;
+        inicioLinea = max(inicioLinea, inicioContenido);
+        columna = 1;
+        for (size_t i = inicioLinea; i < p; i++) {
+            if ((static_cast<unsigned char>(texto[i]) & 0xC0) != 0x80) columna++;
+        }
+    }
+
+    // El valor del token, solo para el mensaje de error.
+    string valorToken(TipoToken tipo, size_t inicio, size_t fin) const {
+        if (tipo != TipoToken::CADENA) return string(texto.substr(inicio, fin - inicio));
+        string valor;
+        for (size_t i = inicio; i < fin; i++) {
+            if (texto[i] != '\\' || i + 1 >= fin) {
+                valor += texto[i];
+                continue;
+            }
+            switch (texto[++i]) {
+                case 'n': valor += '\n'; break;
+                case 't': valor += '\t'; break;
+                case '"': valor += '"'; break;
+                case '\\': valor += '\\'; break;
+                default: valor += '\\'; valor += texto[i]; break;
+            }
+        }
+        return valor;
+    }
+
+    void token(TipoToken tipo, size_t inicio, size_t fin) {
+        if (aceptado || hayErrorSintactico) return;
+        int siguiente = automata.transicion(estado, tipo);
+        if (siguiente == ERROR_SINTACTICO) {
+            Token completo(tipo, valorToken(tipo, inicio, fin), 0, 0);
+            hayErrorSintactico = true;
+            posicionError = inicio;
+            mensajeError = "Transicion no definida (estado " + to_string(estado) + ", token " +
+                           to_string(static_cast<int>(tipo)) + " - " + completo.toString() + ")";
+            return;
+        }
+        estado = siguiente;
+        aceptado = estado == AnalizadorSintactico::ESTADO_FINAL;
+    }
+
+    void errorLexico(size_t p, const string& mensaje) {
+        hayErrorLexico = true;
+        posicionError = p;
+        mensajeError = mensaje;
+    }
+
+    // saltarEspacios()
+    void saltarEspacios() {
+        while (pos < n && esEspacio(texto[pos]) && texto[pos] != '\n') pos++;
+    }
+
+    // longitudCaracterPalabra(): letra, digito o '_'; fuera de ASCII, una
+    // letra UTF-8.
+    size_t longitudCaracterPalabra(size_t p) const {
+        if (p >= n) return 0;
+        char c = texto[p];
+        if (static_cast<unsigned char>(c) < 0x80) return esLetraAscii(c) || esDigito(c) || c == '_' ? 1 : 0;
+        size_t longitud;
+        return esLetraUtf8(decodificarUtf8(texto, p, longitud)) ? longitud : 0;
+    }
+
+    bool iniciaPalabra(size_t p) const {
+        if (p >= n) return false;
+        char c = texto[p];
+        if (static_cast<unsigned char>(c) < 0x80) return esLetraAscii(c) || c == '_';
+        return longitudCaracterPalabra(p) > 0;
+    }
+
+    size_t finPalabra(size_t p) const {
+        while (size_t longitud = longitudCaracterPalabra(p)) p += longitud;
+        return p;
+    }
+
+    // leerIdentificador(): palabra reservada (minusculas y sin tildes) o
+    // identificador.
+    TipoToken tipoPalabra(size_t inicio, size_t fin) const {
+        TipoToken tipo = TipoToken::IDENTIFICADOR;
+        char clave[LONGITUD_MAXIMA_RESERVADA];
+        size_t longitud = fin - inicio;
+        for (size_t i = 0; i < longitud; i++) {
+            char c = texto[inicio + i];
+            if (static_cast<unsigned char>(c) >= 0x80) {
+                buscarReservada(plegarPalabra(texto.substr(inicio, longitud)), tipo);
+                return tipo;
+            }
+            if (i >= sizeof(clave)) return tipo; // mas larga que cualquier reservada
+            clave[i] = c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+        }
+        buscarReservada(string_view(clave, longitud), tipo);
+        return tipo;
+    }
+
+    // Inicio de la palabra reservada con la que termina [inicio, fin) salvo
+    // espacios, o npos. Es la unica palabra del texto que puede cortarlo:
+    // iniciaSentencia() exige que la siga '(' o ';'.
+    size_t palabraReservadaAntes(size_t inicio, size_t fin) const {
+        size_t finPalabraFinal = fin;
+        while (finPalabraFinal > inicio && (texto[finPalabraFinal - 1] == ' ' || texto[finPalabraFinal - 1] == '\t')) {
+            finPalabraFinal--;
+        }
+        size_t tramo = finPalabraFinal;
+        while (tramo > inicio) {
+            char c = texto[tramo - 1];
+            if (static_cast<unsigned char>(c) < 0x80 && !esLetraAscii(c) && !esDigito(c) && c != '_') break;
+            tramo--;
+        }
+        // Desde el inicio del tramo, las palabras como las corta el lexico
+        for (size_t i = tramo; i < finPalabraFinal;) {
+            if (iniciaPalabra(i)) {
+                size_t f = finPalabra(i);
+                if (f == finPalabraFinal) {
+                    TipoToken tipo = tipoPalabra(i, f);
+                    return tipo != TipoToken::IDENTIFICADOR ? i : string_view::npos;
+                }
+                i = f;
+            } else {
+                size_t longitud;
+                decodificarUtf8(texto, i, longitud);
+                i += longitud;
+            }
+        }
+        return string_view::npos;
+    }
+
+    // leerTextoSimple(): hasta ';', fin de linea o una palabra reservada que
+    // inicia sentencia. Devuelve false si el texto queda vacio.
+    bool leerTextoSimple() {
+        size_t inicio = pos;
+        size_t fin = inicio;
+        size_t desde = inicio;
+        while (true) {
+            fin = buscar(texto, desde, ';', '\n', '(', '\0');
+            char c = fin < n ? texto[fin] : '\0';
+            if (c == '(' || c == ';') {
+                size_t corte = palabraReservadaAntes(inicio, fin);
+                if (corte != string_view::npos) {
+                    fin = corte;
+                    break;
+                }
+                if (c == '(') {
+                    desde = fin + 1;
+                    continue;
+                }
+            }
+            break;
+        }
+        pos = fin;
+
+        while (fin > inicio && esEspacio(texto[fin - 1])) fin--;
+        if (fin == inicio) return false;
+        token(TipoToken::TEXTO_SIMPLE, inicio, fin);
+        return true;
+    }
+
+    // leerCadena()
+    void leerCadena() {
+        size_t inicio = pos + 1;
+        size_t desde = inicio;
+        while (true) {
+            size_t fin = buscar(texto, desde, '"', '\\', '\0', '"');
+            if (fin >= n || texto[fin] == '\0') {
+                errorLexico(inicio, "Cadena sin cerrar");
+                pos = n;
+                return;
+            }
+            if (texto[fin] == '\\') {
+                desde = min(fin + 2, n);
+                continue;
+            }
+            token(TipoToken::CADENA, inicio, fin);
+            pos = fin + 1;
+            return;
+        }
+    }
+
+public:
+    Verificador(string_view texto, const AnalizadorSintactico& automata)
+        : texto(texto), n(texto.size()), automata(automata) {}
+
+    bool verificar(vector<Diagnostico>& diagnosticos) {
+        ValidacionUtf8 validacion = validarUtf8(texto);
+        if (validacion.invalido != string_view::npos) {
+            int linea, columna;
+            ubicar(validacion.invalido, linea, columna);
+            diagnosticos.emplace_back(Severidad::ERROR, linea, columna,
+                                      "Texto no valido en UTF-8 (guarde el archivo con codificacion UTF-8)");
+            return false;
+        }
+        if (texto.substr(0, 3) == "\xEF\xBB\xBF") {
+            pos = inicioContenido = 3;
+        }
+
+        while (pos < n && !hayErrorLexico) {
+            saltarEspacios();
+            if (pos >= n || texto[pos] == '\0') break;
+            char c = texto[pos];
+
+            if (c == '"') {
+                leerCadena();
+            } else if (iniciaPalabra(pos)) {
+                size_t inicio = pos;
+                pos = finPalabra(pos);
+                TipoToken tipo = tipoPalabra(inicio, pos);
+                token(tipo, inicio, pos);
+                if (aceptaTextoSimple(tipo)) {
+                    saltarEspacios();
+                    char siguiente = pos < n ? texto[pos] : '\0';
+                    if (siguiente != '(' && siguiente != ';' && siguiente != '\n' && siguiente != '\0') {
+                        leerTextoSimple();
+                    }
+                }
+            } else if (esDigito(c)) {
+                size_t inicio = pos;
+                while (pos < n && (esDigito(texto[pos]) || texto[pos] == '.')) pos++;
+                token(TipoToken::NUMERO, inicio, pos);
+            } else if (c == '%') {
+                pos = buscar(texto, pos, '\n', '\0', '\n', '\n');
+            } else if (esElemento(c)) {
+                TipoToken tipo;
+                if (tipoSimbolo(c, tipo)) token(tipo, pos, pos + 1);
+                pos++;
+            } else if (c == '\n') {
+                pos++;
+            } else if (!leerTextoSimple()) {
+                pos++;
+            }
+        }
+
+        if (!hayErrorLexico && !hayErrorSintactico && !aceptado) {
+            hayErrorSintactico = true;
+            posicionError = min(pos, n);
+            mensajeError = "Documento incompleto - estado final no alcanzado";
+        }
+        if (!hayErrorLexico && !hayErrorSintactico) return true;
+
+        int linea, columna;
+        ubicar(posicionError, linea, columna);
+        diagnosticos.emplace_back(Severidad::ERROR, linea, columna, mensajeError);
+        return false;
+    }
+};
+
+// La tabla de transiciones se construye una vez y se comparte: transicion()
+// es const.
+const AnalizadorSintactico& automataCompartido() {
+    static const AnalizadorSintactico automata{vector<Token>()};
+    return automata;
+}
+
+} // namespace
+
+bool verificarTexto(string_view texto, vector<Diagnostico>& diagnosticos) {
+    return Verificador(texto, automataCompartido()).verificar(diagnosticos);
+}
+
+vector<ResultadoVerificacion> verificarLote(const vector<string>& archivos, unsigned hilos) {
+    vector<ResultadoVerificacion> resultados(archivos.size());
+    if (archivos.empty()) return resultados;
+
+    hilos = hilos != 0 ? hilos : thread::hardware_concurrency();
+    hilos = max(1u, min<unsigned>(hilos, static_cast<unsigned>(archivos.size())));
+    automataCompartido();
+    tablaReservadas();
+
+    atomic<size_t> siguiente(0);
+    auto trabajador = [&]() {
+        for (size_t i = siguiente++; i < archivos.size(); i = siguiente++) {
+            ResultadoVerificacion& resultado = resultados[i];
+            resultado.archivo = archivos[i];
+            try {
+                ArchivoMapeado archivo(archivos[i]);
+                resultado.bytes = archivo.contenido().size();
+                resultado.valido = verificarTexto(archivo.contenido(), resultado.diagnosticos);
+            } catch (const exception& e) {
+                resultado.diagnosticos.emplace_back(Severidad::ERROR, 0, 0, e.what());
+            }
+        }
+    };
+
+    vector<thread> trabajadores;
+    for (unsigned i = 1; i < hilos; i++) {
+        trabajadores.emplace_back(trabajador);
+    }
+    trabajador();
+
+    for (auto& t : trabajadores) {
+        t.join();
+    }
+
+    return resultados;
+}
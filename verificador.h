@@ -0,0 +1,48 @@
+#ifndef VERIFICADOR_H
+#define VERIFICADOR_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "diagnostico.h"
+
+using namespace std;
+
+// ===============================
+// VERIFICACION RAPIDA (--check)
+// ===============================
+//
+// Responde solo si un .texes es lexica y sintacticamente valido: aplica las
+// mismas reglas que el analizador lexico y recorre el automata de la tabla
+// de transiciones a medida que reconoce cada token. No hay vector de
+// tokens, ni cadenas, ni tabla de simbolos, ni salida: un token es su tipo
+// y su posicion, y la linea y la columna solo se calculan para el error.
+//
+// El texto sin comillas y las cadenas se saltan buscando con SSE2 el
+// siguiente caracter que importa (';', '(', comillas, escapes...), de 16 en
+// 16 bytes.
+//
+// No revisa lo que necesita el arbol: formulas (validador_matematicas.h),
+// CSV, imagenes ni referencias.
+
+// true si el texto es valido; si no, agrega a 'diagnosticos' su primer
+// error. Un error de sintaxis lleva la misma linea, columna y mensaje que
+// daria compilar(); los errores lexicos (cadena sin cerrar, UTF-8 no
+// valido) tambien se ubican en la linea y columna donde empiezan.
+bool verificarTexto(string_view texto, vector<Diagnostico>& diagnosticos);
+
+struct ResultadoVerificacion {
+    string archivo;
+    bool valido = false;
+    vector<Diagnostico> diagnosticos;
+    size_t bytes = 0;
+};
+
+// Verifica cada archivo (proyectado en memoria) en un hilo trabajador; 0
+// hilos usa hardware_concurrency(). El resultado conserva el orden de
+// 'archivos'.
+vector<ResultadoVerificacion> verificarLote(const vector<string>& archivos, unsigned hilos);
+
+#endif